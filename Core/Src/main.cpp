@@ -108,6 +108,9 @@ int main(void)
   MX_TIM11_Init();
   MX_TIM1_Init();
   MX_ADC2_Init();
+  MX_TIM6_Init();
+  MX_TIM2_Init();
+  MX_TIM5_Init();
   /* USER CODE BEGIN 2 */
   scheduler_run();
   /* USER CODE END 2 */
@@ -2,6 +2,10 @@
  * encoder.h
  * Product: AMT10
  * Interface: Quadrature A/B inputs w/ 1 index pulse per revolution
+ *
+ * Optionally timestamps A channel rising edges: the encoder timer pulses its trigger output when channel 1 captures,
+ * and a free-running 32-bit capture timer with that trigger as its internal input captures its own count on channel 1.
+ * Both captures latch on the same edge, giving the encoder count and the time it was reached.
  */
 
 #ifndef INC_ENCODER_H_
@@ -10,12 +14,18 @@
 #include "stm32f7xx_hal.h"
 
 typedef struct encoder_data_t {
-	int32_t tick_65536s;
-	uint32_t tick_1s;
+	int64_t ticks; // Signed ticks since zeroed, extended past the 16-bit counter
+	uint32_t timestamp_us; // Time ticks were read, from timestamp_get_us()
+	int64_t edge_ticks; // Ticks at the newest captured edge
+	uint32_t edge_time; // Capture timer count at the newest captured edge
+	uint32_t capture_time; // Capture timer count when ticks were read
 } encoder_data_t;
 
 typedef struct encoder_t {
 	TIM_HandleTypeDef* htim;
+	TIM_HandleTypeDef* htim_capture; // NULL if edges aren't timestamped
+	uint32_t capture_clock_hz;
+	uint16_t last_count; // Counter value at the last read
 	encoder_data_t data;
 } encoder_t;
 
@@ -23,8 +33,9 @@ typedef struct encoder_t {
  * @brief Initializes encoder device
  * @param[out] dev: Encoder device to initialize
  * @param[in] htim: Timer handle of encoder inputs
+ * @param[in] htim_capture: Timer handle capturing edge times from htim's trigger output on channel 1, NULL to not timestamp edges
  */
-void encoder_init(encoder_t* dev, TIM_HandleTypeDef* htim);
+void encoder_init(encoder_t* dev, TIM_HandleTypeDef* htim, TIM_HandleTypeDef* htim_capture);
 
 /**
  * @brief Start counting inputs from the encoder
@@ -43,7 +54,8 @@ void encoder_stop(const encoder_t* dev);
  * @param[in] dev: Encoder device
  * @return Pointer to encoder data
  *
- * Assume this is called fast enough that any wrap around in the counter is closer to the last measurement
+ * The counter is read as a signed 16-bit change since the last read, so wrap around in either direction is exact
+ * as long as this is called before the encoder turns 32767 ticks (4 sprocket revolutions)
  */
 encoder_data_t* encoder_get_data(encoder_t* dev);
 
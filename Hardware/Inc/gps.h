@@ -3,45 +3,76 @@
  *
  * Driver for the GPS
  * Part: uBlox SAM-M8Q
- * Interface: UART
+ * Interface: UART, UBX binary protocol
  */
 
 #ifndef INC_GPS_H_
 #define INC_GPS_H_
 
+#include <stdbool.h>
+
 #include "stm32f7xx_hal.h"
-#include "minmea.h"
+#include "sample_ring.h"
+#include "ubx.h"
+
+#define GPS_RX_BUFFER_SIZE 512 // Circular DMA target. Framer runs at least every half buffer, so it must hold several frames
+#define GPS_FIX_QUEUE_SIZE 8 // Must be a power of 2
+#define GPS_TX_DATA_SIZE (UBX_CFG_PRT_PAYLOAD_LEN + UBX_FRAME_OVERHEAD) // Largest configuration frame
 
-#define RX_DATA_SIZE 200
+typedef enum {
+	GPS_INIT_PORT_DEFAULT_BAUD = 0,	// Tell GPS to switch baud rate and output only UBX, at its factory baud rate
+	GPS_INIT_PORT_FAST_BAUD,		// Same again at the new baud rate, in case the GPS was already switched
+	GPS_INIT_RATE,					// Set navigation solution rate
+	GPS_INIT_MSG,					// Enable NAV-PVT output on every solution
+	GPS_INIT_START_RX,				// Start continuous reception
+	GPS_INIT_READY,
+	GPS_INIT_FAILED
+} gps_init_step_t;
 
 typedef struct gps_data_t {
-	struct minmea_sentence_gga gga;
+	ubx_nav_pvt_t pvt; // Integer lat/lon/height/velocity and their accuracy estimates, straight from NAV-PVT
+	uint32_t timestamp_us; // Estimated time the fix was measured, from timestamp_get_us()
 } gps_data_t;
 
 typedef struct gps_t {
 	UART_HandleTypeDef* huart;
-	uint8_t rx_data[RX_DATA_SIZE];
-	gps_data_t last_data;
+	uint8_t rx_data[GPS_RX_BUFFER_SIZE]; // Written continuously by DMA
+	uint16_t rx_read_index; // Next byte of rx_data the framer hasn't seen. UART interrupt only
+	ubx_parser_t parser; // Keeps partial frames between UART events. UART interrupt only
+	gps_data_t fix_storage[GPS_FIX_QUEUE_SIZE];
+	sample_ring_t fixes; // Checksum-verified fixes, filled from the UART interrupt and emptied by gps_check_for_update()
+	bool has_peeked_fix; // Oldest fix was handed out and gets popped on the next gps_check_for_update()
+	volatile uint32_t num_rx_errors; // UART errors that stopped reception and forced a restart
+	uint8_t tx_data[GPS_TX_DATA_SIZE];
+	gps_init_step_t init_step;
+	uint32_t init_step_start_ms;
 } gps_t;
 
 /**
- * @brief Initialize GPS
+ * @brief Initialize GPS device properties. GPS isn't configured or receiving until gps_init_step() reports it's done. Only one GPS device is supported
  * @param[out] dev: GPS device to initialize
  * @param[in] huart: UART handle for communication with GPS
  */
 void gps_init(gps_t* dev, UART_HandleTypeDef* huart);
 
 /**
- * @brief Start reception of one GPS packet
+ * @brief Advance GPS configuration by one step without waiting on transmits or the GPS applying settings. Starts reception once done
+ * @param[in, out] dev: GPS device
+ * @return True once configuration is finished (successfully or not), false if it should be called again
+ */
+bool gps_init_step(gps_t* dev);
+
+/**
+ * @brief Start continuous reception of GPS data into a circular DMA buffer. Frames are checked, decoded, timestamped, and queued from the UART interrupt on idle line and half/full transfer events
  * @param[in] dev: GPS device
  */
 void gps_start_rx(gps_t* dev);
 
 /**
- * @brief Checks if new packet has arrived since this function was last called. If so, returns its data
+ * @brief Gets the oldest queued fix, if any. Call until it returns NULL to drain the queue
  * @param[in] dev: GPS device
- * @return NULL if there's no update, pointer to last data otherwise
+ * @return NULL if there's no new fix, pointer to the fix in the queue otherwise. Valid until the next call
  */
-gps_data_t* gps_check_for_update(gps_t* dev);
+const gps_data_t* gps_check_for_update(gps_t* dev);
 
 #endif /* INC_GPS_H_ */
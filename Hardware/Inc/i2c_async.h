@@ -0,0 +1,108 @@
+/*
+ * i2c_async.h
+ * Product: STM32F7 I2C
+ *
+ * Queue of I2C register transactions, each run with DMA and finished from the transfer-complete or error interrupt
+ * Reads send their register address and then read with a repeated start, each phase started from the previous one's interrupt.
+ * Callers queue a transaction and check its status later instead of waiting on the bus.
+ * Transactions that don't finish in time, and bus errors that can leave a slave holding SDA low,
+ * trigger a bus recovery: 9 SCL pulses and a STOP bit-banged on the pins, then the peripheral is reinitialized.
+ * Only one bus is supported.
+ */
+
+#ifndef INC_I2C_ASYNC_H_
+#define INC_I2C_ASYNC_H_
+
+#include <stdbool.h>
+
+#include "stm32f7xx_hal.h"
+
+#define I2C_ASYNC_QUEUE_SIZE 8 // Must be a power of 2
+#define I2C_ASYNC_MAX_WRITE_LEN 32 // Writes are copied behind their register address so they go out in one transfer
+
+typedef enum {
+	I2C_ASYNC_IDLE = 0,	// Never queued
+	I2C_ASYNC_QUEUED,
+	I2C_ASYNC_BUSY,		// On the bus
+	I2C_ASYNC_DONE,
+	I2C_ASYNC_FAILED
+} i2c_async_status_t;
+
+typedef struct i2c_async_transaction_t {
+	uint8_t dev_addr; // 7-bit device address
+	uint8_t reg_addr; // First register to read or write
+	bool is_read;
+	uint8_t* data; // Read into or written from. Must stay valid until the transaction finishes
+	uint16_t len;
+	volatile i2c_async_status_t status;
+	uint32_t queued_us; // Times from timestamp_get_us()
+	uint32_t start_us;
+	uint32_t done_us;
+} i2c_async_transaction_t;
+
+typedef struct i2c_async_stats_t {
+	uint32_t num_done;
+	uint32_t num_failed;
+	uint32_t num_timeouts;
+	uint32_t num_recoveries;
+	uint32_t latency_min_us; // Queued to finished, for successful transactions
+	uint32_t latency_max_us;
+	uint32_t latency_sum_us;
+} i2c_async_stats_t;
+
+typedef struct i2c_async_t {
+	I2C_HandleTypeDef* hi2c;
+	GPIO_TypeDef* scl_port;
+	uint16_t scl_pin;
+	GPIO_TypeDef* sda_port;
+	uint16_t sda_pin;
+	i2c_async_transaction_t* queue[I2C_ASYNC_QUEUE_SIZE];
+	volatile uint32_t head; // Total transactions queued
+	volatile uint32_t tail; // Total transactions started
+	i2c_async_transaction_t* volatile active; // Transaction on the bus, NULL if idle
+	volatile bool is_reg_phase; // Active read is still sending its register address
+	uint8_t tx_data[I2C_ASYNC_MAX_WRITE_LEN + 1];
+	volatile bool needs_recovery; // Set by errors that can leave the bus stuck
+	i2c_async_stats_t stats;
+} i2c_async_t;
+
+/**
+ * @brief Initialize transaction queue and register I2C callbacks
+ * @param[out] bus: Bus to initialize
+ * @param[in] hi2c: I2C handle, with DMA and interrupts configured
+ * @param[in] scl_port: GPIO port of SCL pin, used for bus recovery
+ * @param[in] scl_pin: GPIO pin of SCL pin
+ * @param[in] sda_port: GPIO port of SDA pin, used for bus recovery
+ * @param[in] sda_pin: GPIO pin of SDA pin
+ */
+void i2c_async_init(i2c_async_t* bus, I2C_HandleTypeDef* hi2c, GPIO_TypeDef* scl_port, uint16_t scl_pin, GPIO_TypeDef* sda_port, uint16_t sda_pin);
+
+/**
+ * @brief Queues a transaction. Starts it right away if the bus is idle
+ * @param[in, out] bus: Bus
+ * @param[in, out] txn: Transaction with address, register, direction, data, and length set. Must not already be queued or busy
+ * @return True if queued, false if the queue is full, the transaction is already pending, or a write is too long
+ */
+bool i2c_async_submit(i2c_async_t* bus, i2c_async_transaction_t* txn);
+
+/**
+ * @brief Recovers the bus if the active transaction timed out or an error left it stuck. Call regularly from the main loop
+ * @param[in, out] bus: Bus
+ */
+void i2c_async_poll(i2c_async_t* bus);
+
+/**
+ * @brief Queues a transaction and waits for it to finish, recovering the bus if it times out. For setup code that can't continue without the result
+ * @param[in, out] bus: Bus
+ * @param[in, out] txn: Transaction, same as i2c_async_submit()
+ * @return True if the transaction finished successfully, false otherwise
+ */
+bool i2c_async_transfer_wait(i2c_async_t* bus, i2c_async_transaction_t* txn);
+
+/**
+ * @brief Returns whether a transaction is queued or on the bus
+ * @param[in] txn: Transaction
+ */
+bool i2c_async_is_pending(const i2c_async_transaction_t* txn);
+
+#endif /* INC_I2C_ASYNC_H_ */
@@ -7,32 +7,122 @@
 #ifndef INC_IMU_H_
 #define INC_IMU_H_
 
+#include <stdbool.h>
+
 #include "bno055.h"
+#include "i2c_async.h"
 #include "stm32f7xx_hal.h"
 
+#define IMU_SAMPLE_LEN (BNO055_CALIB_STAT_ADDR - BNO055_GYRO_DATA_X_LSB_ADDR + 1) // Gyro, euler, quaternion, linear accel, gravity, temperature, calibration status
+#define IMU_QUATERNION_SCALE (1.0f / 16384) // Quaternion units per LSB
+#define IMU_CALIBRATION_LEN (BNO055_MAG_RADIUS_MSB_ADDR - BNO055_ACCEL_OFFSET_X_LSB_ADDR + 1) // Accel, mag, gyro offsets, accel and mag radius
+#define IMU_CALIB_STAT_FULL 0xFF // System, gyro, accel, and mag all fully calibrated
+
+typedef enum {
+	IMU_INIT_CHIP = 0,		// Read chip info and make sure IMU is in config mode
+	IMU_INIT_WAIT_CONFIG,	// Wait for IMU to settle in config mode
+	IMU_INIT_CONFIGURE,		// Set power mode and units, then start fusion mode
+	IMU_INIT_WAIT_FUSION,	// Wait for IMU to settle in fusion mode
+	IMU_INIT_READY,
+	IMU_INIT_FAILED
+} imu_init_step_t;
+
+typedef enum {
+	IMU_CALIB_READ_IDLE = 0,		// Not reading calibration
+	IMU_CALIB_READ_WAIT_CONFIG,		// Wait for IMU to settle in config mode, where offsets can be read
+	IMU_CALIB_READ_WAIT_FUSION		// Wait for IMU to settle back in fusion mode
+} imu_calib_read_step_t;
+
+/**
+ * Sensor offset and radius registers, in register order. Only valid for the IMU they were read from
+ */
+typedef struct imu_calibration_t {
+	uint8_t regs[IMU_CALIBRATION_LEN];
+} imu_calibration_t;
+
 typedef struct imu_data_t {
-	struct bno055_euler_double_t heading;
-	struct bno055_linear_accel_double_t linear_accel;
+	float heading_rad; // Clockwise from magnetic north
+	float roll_rad;
+	float pitch_rad;
+	float gyro_rps[3]; // X, Y, Z
+	float linear_accel_msq[3]; // X, Y, Z, gravity removed
+	int16_t quaternion[4]; // W, X, Y, Z, raw. Multiply by IMU_QUATERNION_SCALE for unit quaternion
+	uint8_t calib_status; // System, gyro, accel, mag calibration, 2 bits each from MSB, 3 is fully calibrated
+	uint32_t timestamp_us; // Time the read started on the bus, from timestamp_get_us()
 } imu_data_t;
 
 typedef struct imu_t {
 	struct bno055_t bno_dev;
-	I2C_HandleTypeDef* hi2c;
+	i2c_async_t bus;
 	imu_data_t imu_data;
+	i2c_async_transaction_t sample_read; // Requested one imu_get_data() call ahead of when it's used
+	uint8_t sample_raw[IMU_SAMPLE_LEN];
+	float euler_scale; // Units per LSB, from the unit selection read at configuration
+	float gyro_scale;
+	float accel_scale;
+	bool has_sample_request;
+	uint32_t num_late_samples; // Calls where the requested sample hadn't arrived yet
+	imu_init_step_t init_step;
+	uint32_t init_step_start_ms;
+	imu_calibration_t stored_calibration; // Written during configuration so fusion starts calibrated
+	bool has_stored_calibration;
+	imu_calib_read_step_t calib_read_step;
+	uint32_t calib_read_step_start_ms;
+	bool calib_read_succeeded;
 } imu_t;
 
 /**
- * @brief Initialize IMU
+ * @brief Initialize IMU device properties. IMU isn't usable until imu_init_step() reports it's done
  * @param[out] dev: Initialized IMU device
- * @param[in] hi2c: I2C handle for IMU device
+ * @param[in] hi2c: I2C handle for IMU device, with DMA and interrupts configured
+ * @param[in] scl_port: GPIO port of I2C SCL pin, for bus recovery
+ * @param[in] scl_pin: GPIO pin of I2C SCL pin
+ * @param[in] sda_port: GPIO port of I2C SDA pin, for bus recovery
+ * @param[in] sda_pin: GPIO pin of I2C SDA pin
+ */
+void imu_init(imu_t* dev, I2C_HandleTypeDef* hi2c, GPIO_TypeDef* scl_port, uint16_t scl_pin, GPIO_TypeDef* sda_port, uint16_t sda_pin);
+
+/**
+ * @brief Sets calibration to restore during configuration, before fusion starts. Call between imu_init() and the first imu_init_step()
+ * @param[in, out] dev: IMU device
+ * @param[in] calibration: Calibration previously read with imu_read_calibration_step()
+ */
+void imu_set_stored_calibration(imu_t* dev, const imu_calibration_t* calibration);
+
+/**
+ * @brief Advance IMU configuration by one step without waiting on mode switch delays
+ * @param[in, out] dev: IMU device
+ * @return True once configuration is finished (successfully or not), false if it should be called again
+ */
+bool imu_init_step(imu_t* dev);
+
+/**
+ * @brief Returns whether the IMU was successfully configured and can be read
+ * @param[in] dev: IMU device
  */
-void imu_init(imu_t* dev, I2C_HandleTypeDef* hi2c);
+bool imu_is_ready(const imu_t* dev);
 
 /**
- * @brief Read relevant IMU data
+ * @brief Gets the sample requested on the previous call and requests the next one. Never waits on the bus
  * @param[in] dev: IMU device to read from
- * @return NULL if read operation failed, acquired IMU data otherwise
+ * @return NULL if IMU isn't ready or the previous request hasn't arrived or failed, acquired IMU data otherwise
  */
 imu_data_t* imu_get_data(imu_t* dev);
 
+/**
+ * @brief Returns whether a sample reports every part of the IMU fully calibrated
+ * @param[in] data: IMU sample
+ */
+bool imu_is_fully_calibrated(const imu_data_t* data);
+
+/**
+ * @brief Advance reading calibration by one step without waiting on mode switches. Offsets can only be read in config mode,
+ * so no samples are available until this finishes
+ * @param[in, out] dev: IMU device, which must be ready
+ * @param[out] calibration: Calibration read, valid if success is set
+ * @param[out] success: Whether calibration was read, valid once finished
+ * @return True once reading is finished (successfully or not), false if it should be called again
+ */
+bool imu_read_calibration_step(imu_t* dev, imu_calibration_t* calibration, bool* success);
+
 #endif /* INC_IMU_H_ */
@@ -3,32 +3,62 @@
  * Product: XBee®-PRO 900HP
  * Interface: UART
  * Only TX is supported right now since there is no current need for RX
+ * Packets are copied into a transmit buffer and sent by DMA, each transfer started from the one before's completion
+ * interrupt, so transmitting never waits on the UART
  */
 
 #ifndef INC_RADIO_H_
 #define INC_RADIO_H_
 
+#include <stdbool.h>
+
 #include "stm32f7xx_hal.h"
 
 #define RADIO_TRANSMIT_SPEED_BPS 12500 // Radio transmit speed in bytes per second
 #define RADIO_QUEUE_SIZE 256			// How many bytes can fit in the radio's internal transmit queue
+#define RADIO_CMD_LEN 5					// "AT" + 2-letter command + 1-byte parameter
+#define RADIO_TX_BUFFER_SIZE 512		// Bytes waiting for the UART. Must be a power of 2
 
 typedef struct radio_t {
 	UART_HandleTypeDef* huart;
+	uint8_t init_cmd_num;				// Index of the setup command currently being sent
+	uint8_t init_byte_num;				// Index of the next byte to send of the current setup command
+	uint8_t init_tx_data[RADIO_CMD_LEN];
+	uint8_t tx_buffer[RADIO_TX_BUFFER_SIZE];
+	volatile uint32_t tx_head;			// Total bytes queued
+	volatile uint32_t tx_tail;			// Total bytes sent
+	volatile uint16_t tx_dma_len;		// Bytes in the transfer on the UART, 0 if idle
+	uint32_t num_dropped;				// Packets that didn't fit in the transmit buffer
 } radio_t;
 
 /**
- * @brief Initialize radio
+ * @brief Initialize radio device properties. Setup commands are sent by radio_init_step()
  * @param[out] dev: Radio device to initialize
  * @param[in] huart: UART handle corresponding to radio
  */
 void radio_init(radio_t* dev, UART_HandleTypeDef* huart);
 
 /**
- * @brief Transmit data over the radio
+ * @brief Send as much of the radio setup commands as the UART can take without waiting
+ * @param[in, out] dev: Radio device
+ * @return True once all setup commands are sent, false if it should be called again
+ */
+bool radio_init_step(radio_t* dev);
+
+/**
+ * @brief Queue data to transmit over the radio. Returns without waiting for it to be sent
+ * @param[in, out] dev: Radio device
  * @param[in] data: Data to transmit over radio
  * @param[in] len: Length of data in bytes
+ * @return True if queued, false if the transmit buffer is too full (the packet is dropped)
+ */
+bool radio_transmit(radio_t* dev, uint8_t* data, uint16_t len);
+
+/**
+ * @brief Get how many bytes are queued but not yet sent to the radio
+ * @param[in] dev: Radio device
+ * @return Bytes waiting in the transmit buffer
  */
-void radio_transmit(radio_t* dev, uint8_t* data, uint16_t len);
+uint16_t radio_get_tx_pending(const radio_t* dev);
 
 #endif /* INC_RADIO_H_ */
@@ -86,6 +86,12 @@ typedef union register_t {
 	uint32_t reg_vals[4];
 } register_t;
 
+// Register values that set an output frequency, so they can be worked out ahead of time and written quickly later
+typedef struct signal_generator_freq_t {
+	register_t reg4;
+	register_t reg0;
+} signal_generator_freq_t;
+
 typedef struct signal_generator_t {
 	SPI_HandleTypeDef* hspi;
 	GPIO_TypeDef* le_port;
@@ -95,10 +101,12 @@ typedef struct signal_generator_t {
 	double ref_clk_freq_mhz;
 	register_t regs[6];
 	double freq_pfd_mhz;
+	int8_t next_program_register; // Next register to write while programming, -1 once all are written
 } signal_generator_t;
 
 /**
- * @brief Initialize signal generator. Must be called before any other functions.
+ * @brief Initialize signal generator properties. Must be called before any other functions.
+ * Registers are written to the device by signal_generator_program_step().
  * @param[out] dev: Signal generator device to hold properties
  * @param[in] hspi: SPI handle for data
  * @param[in] le_port: Latch enable GPIO port
@@ -109,6 +117,13 @@ typedef struct signal_generator_t {
  */
 void signal_generator_init(signal_generator_t* dev, SPI_HandleTypeDef* hspi, GPIO_TypeDef* le_port, uint16_t le_pin, TIM_HandleTypeDef* htim, uint32_t tim_channel, double ref_clk_freq_mhz);
 
+/**
+ * @brief Write the next initial register value to the device. Registers are written from 5 down to 0 as required by the ADF4350
+ * @param[in, out] dev: Signal generator device
+ * @return True once all registers are written, false if it should be called again
+ */
+bool signal_generator_program_step(signal_generator_t* dev);
+
 /**
  * @brief Set the output frequency of the signal generator (137.5MHz - 4.4GHz)
  * @param[in, out] dev: Signal generator device
@@ -116,6 +131,23 @@ void signal_generator_init(signal_generator_t* dev, SPI_HandleTypeDef* hspi, GPI
  */
 void signal_generator_set_output_freq(signal_generator_t* dev, double freq_mhz);
 
+/**
+ * @brief Works out the register values for an output frequency without writing them (137.5MHz - 4.4GHz)
+ * @param[in] dev: Signal generator device
+ * @param[in] freq_mhz: Frequency of output signal, at max resolution
+ * @param[out] freq: Register values for that frequency
+ * @return True if calculated, false if inputs are invalid
+ */
+bool signal_generator_calculate_freq(const signal_generator_t* dev, double freq_mhz, signal_generator_freq_t* freq);
+
+/**
+ * @brief Writes register values from signal_generator_calculate_freq() to the device. Only two SPI writes, so it's
+ * quick enough to call from an interrupt
+ * @param[in, out] dev: Signal generator device
+ * @param[in] freq: Register values to write
+ */
+void signal_generator_write_freq(signal_generator_t* dev, const signal_generator_freq_t* freq);
+
 /**
  * @brief Start signal generation with current settings
  * @param[in] dev: Signal generator device
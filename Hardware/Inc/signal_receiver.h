@@ -3,6 +3,8 @@
  *
  * Driver for the ground-penetrating radar's signal receiver
  * Interface: ADC sampling
+ * Captures are written by DMA straight to a buffer the caller gives, so there's nothing to copy out afterwards
+ * Samples are 12 bits, moved by DMA a halfword at a time into uint16_t
  */
 
 #ifndef INC_SIGNAL_RECEIVER_H_
@@ -13,34 +15,44 @@
 
 #define SIG_RECEIVER_MAX_DMA_SAMPLES 500
 
-typedef struct signal_receiver_t {
+typedef struct signal_receiver_t signal_receiver_t;
+
+typedef void (*signal_receiver_callback_t)(signal_receiver_t* dev);
+
+struct signal_receiver_t {
 	ADC_HandleTypeDef* hadc;
-	uint32_t adc_dma_stream[SIG_RECEIVER_MAX_DMA_SAMPLES];
+	uint16_t* destination; // Where the current or last capture is written
 	uint32_t num_samples;
-} signal_receiver_t;
+	volatile bool capturing;
+	signal_receiver_callback_t complete_callback;
+};
 
 /**
  * @brief Initializes signal receiver. Must be called before any other functions
+ * Only one receiver can be capturing at a time, since the ADC interrupt finds its device from the one last started
  * @param[in] dev: Signal receiver device to initialize
  * @param[in] hadc: ADC handle to receive from
  */
 void signal_receiver_init(signal_receiver_t* dev, ADC_HandleTypeDef* hadc);
 
 /**
- * @brief Record a number of bytes from the receiver via ADC
+ * @brief Record a number of samples from the receiver via ADC
  * @param[in] dev: Signal receiver device
+ * @param[out] destination: Where to write the samples. Must stay valid until the capture completes
  * @param[in] num_samples: Number of samples to take from the receiver
+ * @param[in] complete_callback: Called from the DMA interrupt once the capture is done, NULL for none
+ * @return True if started, false if inputs are invalid or a capture is in progress
  *
  * Uses DMA, so no additional CPU intervention is required
  */
-void signal_receiver_start(signal_receiver_t* dev, uint32_t num_samples);
+bool signal_receiver_start(signal_receiver_t* dev, uint16_t* destination, uint32_t num_samples, signal_receiver_callback_t complete_callback);
 
 /**
  * @brief Gets data from the signal receiver if sampling not in progress
  * @param[in] dev: Signal receiver device
- * @param[out] len: Number of samples recorded
- * @return Pointer to signal receiver data if sampling complete, NULL otherwise
+ * @param[out] len: Number of samples recorded. May be NULL
+ * @return Destination of the last capture if sampling complete, NULL otherwise
  */
-uint32_t* signal_receiver_get_data(signal_receiver_t* dev, uint32_t* num_samples);
+uint16_t* signal_receiver_get_data(signal_receiver_t* dev, uint32_t* num_samples);
 
 #endif /* INC_SIGNAL_RECEIVER_H_ */
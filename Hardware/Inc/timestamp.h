@@ -0,0 +1,21 @@
+/*
+ * timestamp.h
+ * Product: STM32F7 SysTick
+ *
+ * Microsecond timestamps for sensor samples, built from the HAL millisecond tick and the SysTick down-counter
+ * Safe to call from interrupts, including ones that preempt the SysTick interrupt.
+ * Wraps every ~71 minutes, so compare timestamps by subtracting them as uint32_t (or int32_t for signed differences).
+ */
+
+#ifndef INC_TIMESTAMP_H_
+#define INC_TIMESTAMP_H_
+
+#include "stm32f7xx_hal.h"
+
+/**
+ * @brief Gets current time
+ * @return Microseconds since boot, modulo 2^32
+ */
+uint32_t timestamp_get_us(void);
+
+#endif /* INC_TIMESTAMP_H_ */
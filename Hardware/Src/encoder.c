@@ -3,8 +3,9 @@
  */
 
 #include "encoder.h"
+#include "timestamp.h"
 
-void encoder_init(encoder_t* dev, TIM_HandleTypeDef* htim) {
+void encoder_init(encoder_t* dev, TIM_HandleTypeDef* htim, TIM_HandleTypeDef* htim_capture) {
 	// Check user input
 	if (!dev || !htim) {
 		return;
@@ -12,6 +13,16 @@ void encoder_init(encoder_t* dev, TIM_HandleTypeDef* htim) {
 
 	// Set initial encoder properties
 	dev->htim = htim;
+	dev->htim_capture = htim_capture;
+	dev->capture_clock_hz = 0;
+	if (htim_capture) {
+		// APB1 timers run at twice the bus clock whenever the bus is divided
+		uint32_t timer_clock_hz = HAL_RCC_GetPCLK1Freq();
+		if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1) {
+			timer_clock_hz *= 2;
+		}
+		dev->capture_clock_hz = timer_clock_hz / (htim_capture->Init.Prescaler + 1);
+	}
 
 	// Zero encoder
 	encoder_zero(dev);
@@ -25,6 +36,9 @@ void encoder_start(const encoder_t* dev) {
 
 	// Start recording encoders
 	HAL_TIM_Encoder_Start(dev->htim, TIM_CHANNEL_ALL);
+	if (dev->htim_capture) {
+		HAL_TIM_IC_Start(dev->htim_capture, TIM_CHANNEL_1);
+	}
 }
 
 void encoder_stop(const encoder_t* dev) {
@@ -35,6 +49,9 @@ void encoder_stop(const encoder_t* dev) {
 
 	// Stop recording encoders
 	HAL_TIM_Encoder_Stop(dev->htim, TIM_CHANNEL_ALL);
+	if (dev->htim_capture) {
+		HAL_TIM_IC_Stop(dev->htim_capture, TIM_CHANNEL_1);
+	}
 }
 
 encoder_data_t* encoder_get_data(encoder_t* dev) {
@@ -43,18 +60,26 @@ encoder_data_t* encoder_get_data(encoder_t* dev) {
 		return NULL;
 	}
 
-	uint32_t cur_ticks = dev->htim->Instance->CNT;
-
-	// If current ticks in lower third and last ticks in upper third, there was forward wrap around
-	if (cur_ticks < (dev->htim->Init.Period / 3) && dev->data.tick_1s > (dev->htim->Init.Period / 3 * 2)) {
-		dev->data.tick_65536s += 1;
-	}
-	// If current ticks in upper third and last ticks in lower third, there was reverse wrap around
-	else if (cur_ticks > (dev->htim->Init.Period / 3 * 2) && dev->data.tick_1s < (dev->htim->Init.Period / 3)) {
-		dev->data.tick_65536s -= 1;
+	uint16_t cur_count;
+	uint16_t edge_count = 0;
+	if (dev->htim_capture) {
+		// An edge between reads would pair one edge's count with another's time, so read again until none did
+		TIM_TypeDef* capture = dev->htim_capture->Instance;
+		do {
+			dev->data.edge_time = capture->CCR1;
+			edge_count = (uint16_t) dev->htim->Instance->CCR1;
+			cur_count = (uint16_t) dev->htim->Instance->CNT;
+			dev->data.capture_time = capture->CNT;
+		} while (capture->CCR1 != dev->data.edge_time);
+	} else {
+		cur_count = (uint16_t) dev->htim->Instance->CNT;
 	}
+	dev->data.timestamp_us = timestamp_get_us();
 
-	dev->data.tick_1s = cur_ticks;
+	// Counter period is the full 16 bits, so the modular difference is the signed change even across wrap around
+	dev->data.ticks += (int16_t) (cur_count - dev->last_count);
+	dev->data.edge_ticks = dev->data.ticks + (int16_t) (edge_count - cur_count);
+	dev->last_count = cur_count;
 	return &(dev->data);
 }
 
@@ -66,6 +91,9 @@ void encoder_zero(encoder_t* dev) {
 
 	// Set register counter and software counters to 0
 	dev->htim->Instance->CNT = 0;
-	dev->data.tick_1s = 0;
-	dev->data.tick_65536s = 0;
+	dev->last_count = 0;
+	dev->data.ticks = 0;
+	dev->data.edge_ticks = 0;
+	dev->data.edge_time = 0;
+	dev->data.capture_time = 0;
 }
@@ -3,12 +3,76 @@
  */
 
 #include "gps.h"
+#include "timestamp.h"
 #include "string.h"
 
-static void gps_rx_complete(UART_HandleTypeDef* huart, uint16_t size) {
-	// Indicate RX is complete by unregistering this callback
-	HAL_UART_UnRegisterRxEventCallback(huart);
-	huart->RxXferSize = size; // Since dev object not reachable here, cheat by setting RxXferSize now that it's not needed
+// Time from the GPS measuring a fix to starting to send it. Rough figure for the SAM-M8Q, measure against PPS to refine
+#define GPS_OUTPUT_LATENCY_US 50000
+#define GPS_UART_BITS_PER_BYTE 10 // Start, 8 data, stop
+
+#define GPS_DEFAULT_BAUD_RATE 9600 // SAM-M8Q factory setting
+#define GPS_BAUD_RATE 230400 // NAV-PVT at 10 Hz is 1000 B/s, so this leaves the line idle most of the time
+#define GPS_MEAS_PERIOD_MS 100 // 10 Hz, the SAM-M8Q maximum with GPS and GLONASS
+#define GPS_CFG_SETTLE_MS 100 // Time for the GPS to apply a configuration message before the next one
+
+// UART callbacks only get the UART handle, so keep the device here. Set in gps_init()
+static gps_t* gps_dev = NULL;
+
+/**
+ * @brief Decodes the frame the parser just completed and queues it if it's a fix
+ * @param[in, out] dev: GPS device
+ * @param[in] event_time_us: Time of the UART event that delivered the frame
+ * @param[in] bytes_after: Bytes received after the frame by the same event
+ */
+static void gps_queue_fix(gps_t* dev, uint32_t event_time_us, uint16_t bytes_after) {
+	gps_data_t fix;
+	if (!ubx_decode_nav_pvt(&dev->parser, &fix.pvt)) {
+		return;
+	}
+
+	// Fix was measured before its frame started sending. Frame and any bytes after it took time to send
+	uint32_t bytes_sent = (uint32_t) dev->parser.length + UBX_FRAME_OVERHEAD + bytes_after;
+	uint32_t tx_time_us = bytes_sent * GPS_UART_BITS_PER_BYTE * 1000000 / dev->huart->Init.BaudRate;
+	fix.timestamp_us = event_time_us - tx_time_us - GPS_OUTPUT_LATENCY_US;
+	sample_ring_push(&dev->fixes, &fix);
+}
+
+static void gps_rx_event(UART_HandleTypeDef* huart, uint16_t size) {
+	(void) huart; // Only one GPS, kept in gps_dev
+	if (!gps_dev) {
+		return;
+	}
+
+	// Size is how far DMA has written into the buffer, which it keeps filling after this event.
+	// Frame everything new since the last event, wrapping around the end of the buffer
+	uint32_t event_time_us = timestamp_get_us();
+	uint16_t read_index = gps_dev->rx_read_index;
+	uint16_t pending = size >= read_index ? size - read_index : size + GPS_RX_BUFFER_SIZE - read_index;
+	while (pending) {
+		uint16_t run = GPS_RX_BUFFER_SIZE - read_index;
+		if (run > pending) {
+			run = pending;
+		}
+		bool frame_done;
+		uint16_t used = ubx_parser_feed_bytes(&gps_dev->parser, &gps_dev->rx_data[read_index], run, &frame_done);
+		read_index = (read_index + used) % GPS_RX_BUFFER_SIZE;
+		pending -= used;
+		if (frame_done) {
+			gps_queue_fix(gps_dev, event_time_us, pending);
+		}
+	}
+	gps_dev->rx_read_index = read_index;
+}
+
+static void gps_rx_error(UART_HandleTypeDef* huart) {
+	(void) huart; // Only one GPS, kept in gps_dev
+	if (!gps_dev) {
+		return;
+	}
+
+	// DMA stops on receive errors, so start over from the beginning of the buffer
+	gps_dev->num_rx_errors++;
+	gps_start_rx(gps_dev);
 }
 
 void gps_init(gps_t* dev, UART_HandleTypeDef* huart) {
@@ -20,51 +84,120 @@ void gps_init(gps_t* dev, UART_HandleTypeDef* huart) {
 	// Set initial dev properties
 	dev->huart = huart;
 	memset(dev->rx_data, 0, sizeof(dev->rx_data));
+	dev->rx_read_index = 0;
+	ubx_parser_init(&dev->parser);
+	sample_ring_init(&dev->fixes, dev->fix_storage, sizeof(gps_data_t), GPS_FIX_QUEUE_SIZE);
+	dev->has_peeked_fix = false;
+	dev->num_rx_errors = 0;
+	dev->init_step = GPS_INIT_PORT_DEFAULT_BAUD;
+	dev->init_step_start_ms = HAL_GetTick();
+	gps_dev = dev;
+}
 
-	// Assume GPS configurations have been saved on the GPS module
-	// This way, code can remain the same when configurations change
-	// Therefore, no need for UBX messages here
+/**
+ * @brief Changes the baud rate of the UART to the GPS
+ * @param[in] dev: GPS device
+ * @param[in] baud_rate: New baud rate
+ * @return True if successful, false otherwise
+ */
+static bool gps_set_baud_rate(gps_t* dev, uint32_t baud_rate) {
+	dev->huart->Init.BaudRate = baud_rate;
+	return HAL_UART_Init(dev->huart) == HAL_OK;
 }
 
-void gps_start_rx(gps_t* dev) {
-	// Check user input
-	if (!dev) {
+/**
+ * @brief Starts sending a configuration frame built in dev->tx_data, then moves to the next initialization step
+ * @param[in, out] dev: GPS device
+ * @param[in] len: Frame length, 0 if building it failed
+ * @param[in] next_step: Initialization step once sending starts
+ */
+static void gps_send_config(gps_t* dev, uint16_t len, gps_init_step_t next_step) {
+	if (!len || HAL_UART_Transmit_IT(dev->huart, dev->tx_data, len) != HAL_OK) {
+		dev->init_step = GPS_INIT_FAILED;
 		return;
 	}
-
-	// Register event callback and start DMA RX ended by IDLE line detection
-	HAL_UART_RegisterRxEventCallback(dev->huart, gps_rx_complete);
-	HAL_UARTEx_ReceiveToIdle_DMA(dev->huart, dev->rx_data, RX_DATA_SIZE);
+	dev->init_step = next_step;
+	dev->init_step_start_ms = HAL_GetTick();
 }
 
-static bool gps_set_last_data(gps_t* dev) {
-	struct minmea_sentence_gga gga;
-	enum minmea_sentence_id id = minmea_sentence_id((char*)(dev->rx_data), false);
-	switch(id) {
-	// Just process GGA data, no other messages needed
-	case MINMEA_SENTENCE_GGA:
-		if (minmea_parse_gga(&gga, (char*)(dev->rx_data))) {
-			dev->last_data.gga = gga;
-			return true;
+bool gps_init_step(gps_t* dev) {
+	// Check user inputs
+	if (!dev) {
+		return true;
+	}
+
+	// Each step sends one frame. Wait for the last one to finish sending and be applied before the next
+	if (dev->init_step < GPS_INIT_READY
+			&& (dev->huart->gState != HAL_UART_STATE_READY || HAL_GetTick() - dev->init_step_start_ms < GPS_CFG_SETTLE_MS)) {
+		return false;
+	}
+
+	// GPS stays at its old baud rate until the CFG-PRT frame is fully received, so it's sent at both rates.
+	// Whichever rate the GPS wasn't listening at just produces a frame it ignores
+	uint16_t len;
+	switch (dev->init_step) {
+	case GPS_INIT_PORT_DEFAULT_BAUD:
+		if (!gps_set_baud_rate(dev, GPS_DEFAULT_BAUD_RATE)) {
+			dev->init_step = GPS_INIT_FAILED;
+			break;
 		}
+		len = ubx_build_cfg_prt_uart(dev->tx_data, sizeof(dev->tx_data), GPS_BAUD_RATE);
+		gps_send_config(dev, len, GPS_INIT_PORT_FAST_BAUD);
+		break;
+	case GPS_INIT_PORT_FAST_BAUD:
+		if (!gps_set_baud_rate(dev, GPS_BAUD_RATE)) {
+			dev->init_step = GPS_INIT_FAILED;
+			break;
+		}
+		len = ubx_build_cfg_prt_uart(dev->tx_data, sizeof(dev->tx_data), GPS_BAUD_RATE);
+		gps_send_config(dev, len, GPS_INIT_RATE);
+		break;
+	case GPS_INIT_RATE:
+		len = ubx_build_cfg_rate(dev->tx_data, sizeof(dev->tx_data), GPS_MEAS_PERIOD_MS);
+		gps_send_config(dev, len, GPS_INIT_MSG);
+		break;
+	case GPS_INIT_MSG:
+		len = ubx_build_cfg_msg(dev->tx_data, sizeof(dev->tx_data), UBX_CLASS_NAV, UBX_ID_NAV_PVT, 1);
+		gps_send_config(dev, len, GPS_INIT_START_RX);
+		break;
+	case GPS_INIT_START_RX:
+		// Callbacks can only be registered once transmitting is done
+		gps_start_rx(dev);
+		dev->init_step = GPS_INIT_READY;
 		break;
 	default:
 		break;
 	}
-	return false;
+
+	return dev->init_step == GPS_INIT_READY || dev->init_step == GPS_INIT_FAILED;
 }
 
-gps_data_t* gps_check_for_update(gps_t* dev) {
+void gps_start_rx(gps_t* dev) {
 	// Check user input
 	if (!dev) {
-		return NULL;
+		return;
 	}
 
-	if (dev->huart->RxEventCallback) {
+	// Register event callbacks and start circular DMA RX, which reports idle line and half/full transfer events.
+	// DMA never stops on its own, so there's nothing to re-arm
+	dev->rx_read_index = 0;
+	dev->parser.state = UBX_PARSE_SYNC_1;
+	HAL_UART_RegisterRxEventCallback(dev->huart, gps_rx_event);
+	HAL_UART_RegisterCallback(dev->huart, HAL_UART_ERROR_CB_ID, gps_rx_error);
+	HAL_UARTEx_ReceiveToIdle_DMA(dev->huart, dev->rx_data, GPS_RX_BUFFER_SIZE);
+}
+
+const gps_data_t* gps_check_for_update(gps_t* dev) {
+	// Check user input
+	if (!dev) {
 		return NULL;
 	}
 
-	// Set last data with GPS processing
-	gps_set_last_data(dev);
-	return &dev->last_data;
+	// Fixes are handed out in place, so the last one is only done with now
+	if (dev->has_peeked_fix) {
+		sample_ring_pop(&dev->fixes);
+	}
+	const gps_data_t* fix = (const gps_data_t*) sample_ring_peek(&dev->fixes);
+	dev->has_peeked_fix = fix != NULL;
+	return fix;
 }
@@ -0,0 +1,285 @@
+/*
+ * i2c_async.c
+ */
+
+#include "i2c_async.h"
+#include "timestamp.h"
+#include "string.h"
+
+#define I2C_ASYNC_TIMEOUT_US 10000 // Longest a transaction may be on the bus. Reading the whole BNO055 data block at 100 kHz takes ~4 ms
+#define I2C_ASYNC_RECOVERY_HALF_PERIOD_US 5 // 100 kHz bit-banged SCL
+#define I2C_ASYNC_RECOVERY_PULSES 9 // Enough to clock out any byte a slave is stuck sending
+#define I2C_ASYNC_STUCK_ERRORS (HAL_I2C_ERROR_BERR | HAL_I2C_ERROR_ARLO | HAL_I2C_ERROR_TIMEOUT)
+
+// I2C callbacks only get the I2C handle, so keep the bus here. Set in i2c_async_init()
+static i2c_async_t* i2c_async_bus = NULL;
+
+static void i2c_async_master_tx_complete(I2C_HandleTypeDef* hi2c);
+static void i2c_async_master_rx_complete(I2C_HandleTypeDef* hi2c);
+static void i2c_async_error(I2C_HandleTypeDef* hi2c);
+
+/**
+ * @brief Registers transfer callbacks. Needed again whenever the handle is reinitialized
+ * @param[in] bus: Bus
+ */
+static void i2c_async_register_callbacks(i2c_async_t* bus) {
+	HAL_I2C_RegisterCallback(bus->hi2c, HAL_I2C_MASTER_TX_COMPLETE_CB_ID, i2c_async_master_tx_complete);
+	HAL_I2C_RegisterCallback(bus->hi2c, HAL_I2C_MASTER_RX_COMPLETE_CB_ID, i2c_async_master_rx_complete);
+	HAL_I2C_RegisterCallback(bus->hi2c, HAL_I2C_ERROR_CB_ID, i2c_async_error);
+}
+
+/**
+ * @brief Finishes the active transaction and records its statistics. Call from an interrupt or with interrupts disabled
+ * @param[in, out] bus: Bus
+ * @param[in] success: Whether the transaction succeeded
+ */
+static void i2c_async_finish(i2c_async_t* bus, bool success) {
+	i2c_async_transaction_t* txn = bus->active;
+	if (!txn) {
+		return;
+	}
+
+	bus->active = NULL;
+	txn->done_us = timestamp_get_us();
+	if (success) {
+		uint32_t latency_us = txn->done_us - txn->queued_us;
+		if (!bus->stats.num_done || latency_us < bus->stats.latency_min_us) {
+			bus->stats.latency_min_us = latency_us;
+		}
+		if (latency_us > bus->stats.latency_max_us) {
+			bus->stats.latency_max_us = latency_us;
+		}
+		bus->stats.latency_sum_us += latency_us;
+		bus->stats.num_done++;
+		txn->status = I2C_ASYNC_DONE;
+	} else {
+		bus->stats.num_failed++;
+		txn->status = I2C_ASYNC_FAILED;
+	}
+}
+
+/**
+ * @brief Starts queued transactions until one is on the bus or the queue is empty. Call from an interrupt or with interrupts disabled
+ * @param[in, out] bus: Bus
+ */
+static void i2c_async_start_next(i2c_async_t* bus) {
+	while (!bus->active && !bus->needs_recovery && bus->tail != bus->head) {
+		i2c_async_transaction_t* txn = bus->queue[bus->tail & (I2C_ASYNC_QUEUE_SIZE - 1)];
+		bus->tail++;
+		bus->active = txn;
+		txn->status = I2C_ASYNC_BUSY;
+		txn->start_us = timestamp_get_us();
+
+		// A slave holding the bus would only make the HAL report busy, so recover instead
+		if (__HAL_I2C_GET_FLAG(bus->hi2c, I2C_FLAG_BUSY)) {
+			i2c_async_finish(bus, false);
+			bus->needs_recovery = true;
+			break;
+		}
+
+		HAL_StatusTypeDef status;
+		if (txn->is_read) {
+			// Register address goes first, and the read follows with a repeated start once it's sent
+			bus->is_reg_phase = true;
+			status = HAL_I2C_Master_Seq_Transmit_DMA(bus->hi2c, txn->dev_addr << 1, &txn->reg_addr, 1, I2C_FIRST_FRAME);
+		} else {
+			bus->is_reg_phase = false;
+			bus->tx_data[0] = txn->reg_addr;
+			memcpy(&bus->tx_data[1], txn->data, txn->len);
+			status = HAL_I2C_Master_Transmit_DMA(bus->hi2c, txn->dev_addr << 1, bus->tx_data, txn->len + 1);
+		}
+		if (status != HAL_OK) {
+			i2c_async_finish(bus, false);
+		}
+	}
+}
+
+static void i2c_async_master_tx_complete(I2C_HandleTypeDef* hi2c) {
+	i2c_async_t* bus = i2c_async_bus;
+	if (!bus || !bus->active) {
+		return;
+	}
+
+	// Register address of a read is sent, so read the data
+	if (bus->is_reg_phase) {
+		bus->is_reg_phase = false;
+		i2c_async_transaction_t* txn = bus->active;
+		if (HAL_I2C_Master_Seq_Receive_DMA(hi2c, (txn->dev_addr << 1) | 0x01, txn->data, txn->len, I2C_LAST_FRAME) != HAL_OK) {
+			i2c_async_finish(bus, false);
+			i2c_async_start_next(bus);
+		}
+		return;
+	}
+
+	i2c_async_finish(bus, true);
+	i2c_async_start_next(bus);
+}
+
+static void i2c_async_master_rx_complete(I2C_HandleTypeDef* hi2c) {
+	(void) hi2c; // Only one bus, kept in i2c_async_bus
+	i2c_async_t* bus = i2c_async_bus;
+	if (!bus) {
+		return;
+	}
+
+	i2c_async_finish(bus, true);
+	i2c_async_start_next(bus);
+}
+
+static void i2c_async_error(I2C_HandleTypeDef* hi2c) {
+	i2c_async_t* bus = i2c_async_bus;
+	if (!bus) {
+		return;
+	}
+
+	// A NACK only fails this transaction, but bus errors may leave a slave driving SDA
+	i2c_async_finish(bus, false);
+	if (HAL_I2C_GetError(hi2c) & I2C_ASYNC_STUCK_ERRORS) {
+		bus->needs_recovery = true;
+	}
+	i2c_async_start_next(bus);
+}
+
+void i2c_async_init(i2c_async_t* bus, I2C_HandleTypeDef* hi2c, GPIO_TypeDef* scl_port, uint16_t scl_pin, GPIO_TypeDef* sda_port, uint16_t sda_pin) {
+	// Check user inputs
+	if (!bus || !hi2c || !scl_port || !sda_port) {
+		return;
+	}
+
+	bus->hi2c = hi2c;
+	bus->scl_port = scl_port;
+	bus->scl_pin = scl_pin;
+	bus->sda_port = sda_port;
+	bus->sda_pin = sda_pin;
+	bus->head = 0;
+	bus->tail = 0;
+	bus->active = NULL;
+	bus->is_reg_phase = false;
+	bus->needs_recovery = false;
+	memset(&bus->stats, 0, sizeof(bus->stats));
+	i2c_async_bus = bus;
+	i2c_async_register_callbacks(bus);
+}
+
+bool i2c_async_submit(i2c_async_t* bus, i2c_async_transaction_t* txn) {
+	// Check user inputs
+	if (!bus || !txn || !txn->data || !txn->len || i2c_async_is_pending(txn) || (!txn->is_read && txn->len > I2C_ASYNC_MAX_WRITE_LEN)) {
+		return false;
+	}
+
+	// Completion interrupts also start transactions, so keep them out while the queue changes
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	bool queued = bus->head - bus->tail < I2C_ASYNC_QUEUE_SIZE;
+	if (queued) {
+		txn->status = I2C_ASYNC_QUEUED;
+		txn->queued_us = timestamp_get_us();
+		bus->queue[bus->head & (I2C_ASYNC_QUEUE_SIZE - 1)] = txn;
+		bus->head++;
+		i2c_async_start_next(bus);
+	}
+	__set_PRIMASK(primask);
+	return queued;
+}
+
+/**
+ * @brief Busy-waits for bit-banged recovery clock edges
+ * @param[in] us: Microseconds to wait
+ */
+static void i2c_async_delay_us(uint32_t us) {
+	uint32_t start_us = timestamp_get_us();
+	while (timestamp_get_us() - start_us < us);
+}
+
+/**
+ * @brief Frees a stuck bus by clocking SCL until the slave releases SDA, sending a STOP, and reinitializing the peripheral
+ * @param[in, out] bus: Bus
+ */
+static void i2c_async_recover(i2c_async_t* bus) {
+	// Deinitializing also stops DMA and I2C interrupts, so nothing else touches the bus from here
+	HAL_I2C_DeInit(bus->hi2c);
+
+	GPIO_InitTypeDef gpio = {0};
+	gpio.Mode = GPIO_MODE_OUTPUT_OD;
+	gpio.Pull = GPIO_NOPULL;
+	gpio.Speed = GPIO_SPEED_FREQ_LOW;
+	HAL_GPIO_WritePin(bus->scl_port, bus->scl_pin, GPIO_PIN_SET);
+	HAL_GPIO_WritePin(bus->sda_port, bus->sda_pin, GPIO_PIN_SET);
+	gpio.Pin = bus->scl_pin;
+	HAL_GPIO_Init(bus->scl_port, &gpio);
+	gpio.Pin = bus->sda_pin;
+	HAL_GPIO_Init(bus->sda_port, &gpio);
+	i2c_async_delay_us(I2C_ASYNC_RECOVERY_HALF_PERIOD_US);
+
+	// Clock out whatever the slave is sending until it lets go of SDA
+	for (int i = 0; i < I2C_ASYNC_RECOVERY_PULSES && HAL_GPIO_ReadPin(bus->sda_port, bus->sda_pin) == GPIO_PIN_RESET; i++) {
+		HAL_GPIO_WritePin(bus->scl_port, bus->scl_pin, GPIO_PIN_RESET);
+		i2c_async_delay_us(I2C_ASYNC_RECOVERY_HALF_PERIOD_US);
+		HAL_GPIO_WritePin(bus->scl_port, bus->scl_pin, GPIO_PIN_SET);
+		i2c_async_delay_us(I2C_ASYNC_RECOVERY_HALF_PERIOD_US);
+	}
+
+	// STOP is SDA rising while SCL is high
+	HAL_GPIO_WritePin(bus->scl_port, bus->scl_pin, GPIO_PIN_RESET);
+	i2c_async_delay_us(I2C_ASYNC_RECOVERY_HALF_PERIOD_US);
+	HAL_GPIO_WritePin(bus->sda_port, bus->sda_pin, GPIO_PIN_RESET);
+	i2c_async_delay_us(I2C_ASYNC_RECOVERY_HALF_PERIOD_US);
+	HAL_GPIO_WritePin(bus->scl_port, bus->scl_pin, GPIO_PIN_SET);
+	i2c_async_delay_us(I2C_ASYNC_RECOVERY_HALF_PERIOD_US);
+	HAL_GPIO_WritePin(bus->sda_port, bus->sda_pin, GPIO_PIN_SET);
+	i2c_async_delay_us(I2C_ASYNC_RECOVERY_HALF_PERIOD_US);
+
+	// Reinitializing puts the pins back on the peripheral but resets the callbacks
+	HAL_I2C_Init(bus->hi2c);
+	HAL_I2CEx_ConfigAnalogFilter(bus->hi2c, I2C_ANALOGFILTER_ENABLE);
+	HAL_I2CEx_ConfigDigitalFilter(bus->hi2c, 0);
+	i2c_async_register_callbacks(bus);
+	bus->stats.num_recoveries++;
+}
+
+void i2c_async_poll(i2c_async_t* bus) {
+	// Check user inputs
+	if (!bus) {
+		return;
+	}
+
+	// Give up on a transaction that's been on the bus too long
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	i2c_async_transaction_t* txn = bus->active;
+	if (txn && timestamp_get_us() - txn->start_us > I2C_ASYNC_TIMEOUT_US) {
+		i2c_async_finish(bus, false);
+		bus->stats.num_timeouts++;
+		bus->needs_recovery = true;
+	}
+	bool needs_recovery = bus->needs_recovery;
+	__set_PRIMASK(primask);
+
+	if (!needs_recovery) {
+		return;
+	}
+
+	// Queued transactions wait out the recovery, then start
+	i2c_async_recover(bus);
+	primask = __get_PRIMASK();
+	__disable_irq();
+	bus->needs_recovery = false;
+	i2c_async_start_next(bus);
+	__set_PRIMASK(primask);
+}
+
+bool i2c_async_transfer_wait(i2c_async_t* bus, i2c_async_transaction_t* txn) {
+	if (!i2c_async_submit(bus, txn)) {
+		return false;
+	}
+
+	// Polling times out and recovers a stuck transaction, so this can't wait forever
+	while (i2c_async_is_pending(txn)) {
+		i2c_async_poll(bus);
+	}
+	return txn->status == I2C_ASYNC_DONE;
+}
+
+bool i2c_async_is_pending(const i2c_async_transaction_t* txn) {
+	return txn && (txn->status == I2C_ASYNC_QUEUED || txn->status == I2C_ASYNC_BUSY);
+}
@@ -3,96 +3,329 @@
  */
 
 #include "imu.h"
+#include "timestamp.h"
 #include "string.h"
 
-#define IMU_I2C_TIMEOUT_MS 100
+// Offsets into the sample block, which starts at the gyro X LSB register
+#define IMU_SAMPLE_GYRO_OFFSET 0
+#define IMU_SAMPLE_EULER_OFFSET (BNO055_EULER_H_LSB_ADDR - BNO055_GYRO_DATA_X_LSB_ADDR)
+#define IMU_SAMPLE_QUATERNION_OFFSET (BNO055_QUATERNION_DATA_W_LSB_ADDR - BNO055_GYRO_DATA_X_LSB_ADDR)
+#define IMU_SAMPLE_LINEAR_ACCEL_OFFSET (BNO055_LINEAR_ACCEL_DATA_X_LSB_ADDR - BNO055_GYRO_DATA_X_LSB_ADDR)
+#define IMU_SAMPLE_CALIB_STAT_OFFSET (BNO055_CALIB_STAT_ADDR - BNO055_GYRO_DATA_X_LSB_ADDR)
+
+#define IMU_UNIT_SEL_ACCEL_MG 0x01
+#define IMU_UNIT_SEL_GYRO_RPS 0x02
+#define IMU_UNIT_SEL_EULER_RAD 0x04
 
 // For callback read/write functions. Since a write/read will be called before the callbacks,
 // this can always be set to the right value first.
-static I2C_HandleTypeDef* hi2c_cur = NULL;
+static i2c_async_t* bus_cur = NULL;
 
 /**
- * @brief Callback for writing to IMU serially via I2C
+ * @brief Callback for writing to IMU serially via I2C. Waits on the transaction, so only for configuration
  * @param[in] dev_addr: I2C device address
  * @param[in] reg_addr: IMU target register address
  * @param[in] reg_data: Data to write to address
  * @param[in] wr_len: Length of register to write (length of reg_data)
  */
 static int8_t imu_i2c_write(uint8_t dev_addr, uint8_t reg_addr, uint8_t* reg_data, uint8_t wr_len) {
-	// Set up transmit data
-	uint8_t tx_data[wr_len + 1];
-	tx_data[0] = reg_addr;
-	memcpy(&tx_data[1], reg_data, wr_len);
-
-	// Transmit tx data
-	if (HAL_I2C_Master_Transmit(hi2c_cur, (dev_addr << 1), tx_data, wr_len + 1, IMU_I2C_TIMEOUT_MS) != HAL_OK) {
-		return BNO055_ERROR;
-	}
-	return BNO055_SUCCESS;
+	i2c_async_transaction_t txn = {
+		.dev_addr = dev_addr,
+		.reg_addr = reg_addr,
+		.is_read = false,
+		.data = reg_data,
+		.len = wr_len
+	};
+	return i2c_async_transfer_wait(bus_cur, &txn) ? BNO055_SUCCESS : BNO055_ERROR;
 }
 
 /**
- * @brief Callback for reading from IMU serially via I2C
+ * @brief Callback for reading from IMU serially via I2C. Waits on the transaction, so only for configuration
  * @param[in] dev_addr: I2C device address
  * @param[in] reg_addr: IMU target register address
  * @param[in] reg_data: Data to write to address
  * @param[in] r_len: Length of register to read (length of reg_data)
  */
 static int8_t imu_i2c_read(uint8_t dev_addr, uint8_t reg_addr, uint8_t* reg_data, uint8_t r_len) {
-	// Transmit register to read from
-	if (HAL_I2C_Master_Transmit(hi2c_cur, (dev_addr << 1), &reg_addr, 1, IMU_I2C_TIMEOUT_MS) != HAL_OK) {
-		return BNO055_ERROR;
-	}
-	// Read register into reg_data
-	if (HAL_I2C_Master_Receive(hi2c_cur, (dev_addr << 1) | 0x01, reg_data, r_len, IMU_I2C_TIMEOUT_MS) != HAL_OK) {
-		return BNO055_ERROR;
-	}
-	return BNO055_SUCCESS;
+	i2c_async_transaction_t txn = {
+		.dev_addr = dev_addr,
+		.reg_addr = reg_addr,
+		.is_read = true,
+		.data = reg_data,
+		.len = r_len
+	};
+	return i2c_async_transfer_wait(bus_cur, &txn) ? BNO055_SUCCESS : BNO055_ERROR;
 }
 
 static void imu_delay(u32 msec) {
 	HAL_Delay(msec);
 }
 
-void imu_init(imu_t* dev, I2C_HandleTypeDef* hi2c) {
+void imu_init(imu_t* dev, I2C_HandleTypeDef* hi2c, GPIO_TypeDef* scl_port, uint16_t scl_pin, GPIO_TypeDef* sda_port, uint16_t sda_pin) {
+	// Check user inputs
+	if (!dev || !hi2c) {
+		return;
+	}
+
 	// Initialize IMU parameters
-	dev->hi2c = hi2c;
+	i2c_async_init(&dev->bus, hi2c, scl_port, scl_pin, sda_port, sda_pin);
+	dev->has_sample_request = false;
+	dev->num_late_samples = 0;
+	dev->has_stored_calibration = false;
+	dev->calib_read_step = IMU_CALIB_READ_IDLE;
+	dev->init_step = IMU_INIT_CHIP;
+	dev->init_step_start_ms = HAL_GetTick();
 
 	// Initialize BNO device
 	dev->bno_dev.dev_addr = BNO055_I2C_ADDR1;
 	dev->bno_dev.bus_read = imu_i2c_read;
 	dev->bno_dev.bus_write = imu_i2c_write;
 	dev->bno_dev.delay_msec = imu_delay;
-	hi2c_cur = dev->hi2c;
-	bno055_init(&dev->bno_dev);
-
-	// Set power mode, sensor reading mode, and correct units
-	bno055_set_power_mode(BNO055_POWER_MODE_NORMAL);
-	bno055_set_operation_mode(BNO055_OPERATION_MODE_NDOF);
-	bno055_set_euler_unit(BNO055_EULER_UNIT_RAD);
-	bno055_set_gyro_unit(BNO055_GYRO_UNIT_RPS);
-	bno055_set_accel_unit(BNO055_ACCEL_UNIT_MSQ);
 }
 
-imu_data_t* imu_get_data(imu_t* dev) {
-	// Set current I2C handle for callbacks
-	hi2c_cur = dev->hi2c;
+/**
+ * @brief Moves IMU initialization to the next step, remembering when it started
+ * @param[in, out] dev: IMU device
+ * @param[in] step: Next initialization step
+ */
+static void imu_set_init_step(imu_t* dev, imu_init_step_t step) {
+	dev->init_step = step;
+	dev->init_step_start_ms = HAL_GetTick();
+}
 
-	// Get heading as quaternion
-	struct bno055_euler_double_t temp_heading;
-	if (bno055_convert_double_euler_hpr_rad(&temp_heading) != BNO055_SUCCESS) {
-		return NULL;
+bool imu_init_step(imu_t* dev) {
+	// Check user inputs
+	if (!dev) {
+		return true;
+	}
+
+	// Set current I2C bus for callbacks
+	bus_cur = &dev->bus;
+
+	// Mode switches are written straight to the mode register and waited on here,
+	// since the Bosch driver would otherwise block in HAL_Delay() for each switch
+	u8 op_mode;
+	switch (dev->init_step) {
+	case IMU_INIT_CHIP:
+		// IMU may still be in a fusion mode if only the microcontroller was reset
+		if (bno055_init(&dev->bno_dev) != BNO055_SUCCESS || bno055_get_operation_mode(&op_mode) != BNO055_SUCCESS) {
+			imu_set_init_step(dev, IMU_INIT_FAILED);
+			break;
+		}
+		if (op_mode != BNO055_OPERATION_MODE_CONFIG) {
+			op_mode = BNO055_OPERATION_MODE_CONFIG;
+			if (bno055_write_register(BNO055_OPERATION_MODE_REG, &op_mode, 1) != BNO055_SUCCESS) {
+				imu_set_init_step(dev, IMU_INIT_FAILED);
+				break;
+			}
+			imu_set_init_step(dev, IMU_INIT_WAIT_CONFIG);
+			break;
+		}
+		imu_set_init_step(dev, IMU_INIT_CONFIGURE);
+		break;
+	case IMU_INIT_WAIT_CONFIG:
+		if (HAL_GetTick() - dev->init_step_start_ms >= BNO055_CONFIG_MODE_SWITCHING_DELAY) {
+			imu_set_init_step(dev, IMU_INIT_CONFIGURE);
+		}
+		break;
+	case IMU_INIT_CONFIGURE:
+		// Setting power mode and units in config mode avoids a mode switch for each setting
+		// Units and page are read back once here, so samples can skip the driver's per-read page and unit checks
+		op_mode = BNO055_OPERATION_MODE_NDOF;
+		u8 unit_sel;
+		if (bno055_set_power_mode(BNO055_POWER_MODE_NORMAL) != BNO055_SUCCESS
+				|| bno055_set_euler_unit(BNO055_EULER_UNIT_RAD) != BNO055_SUCCESS
+				|| bno055_set_gyro_unit(BNO055_GYRO_UNIT_RPS) != BNO055_SUCCESS
+				|| bno055_set_accel_unit(BNO055_ACCEL_UNIT_MSQ) != BNO055_SUCCESS
+				|| bno055_write_page_id(BNO055_PAGE_ZERO) != BNO055_SUCCESS
+				|| bno055_read_register(BNO055_UNIT_SEL_ADDR, &unit_sel, 1) != BNO055_SUCCESS) {
+			imu_set_init_step(dev, IMU_INIT_FAILED);
+			break;
+		}
+		// Offsets only take effect when written in config mode. Without them, fusion starts uncalibrated
+		if (dev->has_stored_calibration && bno055_write_register(BNO055_ACCEL_OFFSET_X_LSB_ADDR,
+				dev->stored_calibration.regs, IMU_CALIBRATION_LEN) != BNO055_SUCCESS) {
+			imu_set_init_step(dev, IMU_INIT_FAILED);
+			break;
+		}
+		if (bno055_write_register(BNO055_OPERATION_MODE_REG, &op_mode, 1) != BNO055_SUCCESS) {
+			imu_set_init_step(dev, IMU_INIT_FAILED);
+			break;
+		}
+		dev->euler_scale = (float) (1 / ((unit_sel & IMU_UNIT_SEL_EULER_RAD) ? BNO055_EULER_DIV_RAD : BNO055_EULER_DIV_DEG));
+		dev->gyro_scale = (float) (1 / ((unit_sel & IMU_UNIT_SEL_GYRO_RPS) ? BNO055_GYRO_DIV_RPS : BNO055_GYRO_DIV_DPS));
+		dev->accel_scale = (float) (1 / ((unit_sel & IMU_UNIT_SEL_ACCEL_MG) ? BNO055_ACCEL_DIV_MG : BNO055_LINEAR_ACCEL_DIV_MSQ));
+		imu_set_init_step(dev, IMU_INIT_WAIT_FUSION);
+		break;
+	case IMU_INIT_WAIT_FUSION:
+		if (HAL_GetTick() - dev->init_step_start_ms >= BNO055_MODE_SWITCHING_DELAY) {
+			imu_set_init_step(dev, IMU_INIT_READY);
+		}
+		break;
+	default:
+		break;
+	}
+
+	return dev->init_step == IMU_INIT_READY || dev->init_step == IMU_INIT_FAILED;
+}
+
+bool imu_is_ready(const imu_t* dev) {
+	return dev && dev->init_step == IMU_INIT_READY && dev->calib_read_step == IMU_CALIB_READ_IDLE;
+}
+
+void imu_set_stored_calibration(imu_t* dev, const imu_calibration_t* calibration) {
+	// Check user inputs
+	if (!dev || !calibration) {
+		return;
+	}
+
+	dev->stored_calibration = *calibration;
+	dev->has_stored_calibration = true;
+}
+
+/**
+ * @brief Reads a little-endian signed 16-bit register pair
+ * @param[in] buf: LSB register
+ * @return Value
+ */
+static int16_t imu_read_s16(const uint8_t* buf) {
+	return (int16_t) ((uint16_t) buf[0] | ((uint16_t) buf[1] << 8));
+}
+
+/**
+ * @brief Queues a read of the next sample's registers
+ * @param[in, out] dev: IMU device
+ * @return True if the read was queued
+ */
+static bool imu_request_sample(imu_t* dev) {
+	// Transaction still on the bus can't be touched
+	if (i2c_async_is_pending(&dev->sample_read)) {
+		return false;
 	}
-	dev->imu_data.heading = temp_heading;
 
-	// Get linear acceleration
-	struct bno055_linear_accel_double_t temp_linear_accel;
-	if (bno055_convert_double_linear_accel_xyz_msq(&temp_linear_accel) != BNO055_SUCCESS) {
+	// Gyro through calibration status are contiguous, so one burst gets the whole sample
+	dev->sample_read = (i2c_async_transaction_t) {
+		.dev_addr = dev->bno_dev.dev_addr,
+		.reg_addr = BNO055_GYRO_DATA_X_LSB_ADDR,
+		.is_read = true,
+		.data = dev->sample_raw,
+		.len = IMU_SAMPLE_LEN
+	};
+	dev->has_sample_request = i2c_async_submit(&dev->bus, &dev->sample_read);
+	return dev->has_sample_request;
+}
+
+/**
+ * @brief Decodes a raw sample block with the scale factors read at configuration
+ * @param[in, out] dev: IMU device, whose imu_data gets the decoded sample
+ */
+static void imu_decode_sample(imu_t* dev) {
+	const uint8_t* raw = dev->sample_raw;
+	imu_data_t* data = &dev->imu_data;
+	for (int i = 0; i < 3; i++) {
+		data->gyro_rps[i] = imu_read_s16(&raw[IMU_SAMPLE_GYRO_OFFSET + 2 * i]) * dev->gyro_scale;
+		data->linear_accel_msq[i] = imu_read_s16(&raw[IMU_SAMPLE_LINEAR_ACCEL_OFFSET + 2 * i]) * dev->accel_scale;
+	}
+	data->heading_rad = imu_read_s16(&raw[IMU_SAMPLE_EULER_OFFSET]) * dev->euler_scale;
+	data->roll_rad = imu_read_s16(&raw[IMU_SAMPLE_EULER_OFFSET + 2]) * dev->euler_scale;
+	data->pitch_rad = imu_read_s16(&raw[IMU_SAMPLE_EULER_OFFSET + 4]) * dev->euler_scale;
+	for (int i = 0; i < 4; i++) {
+		data->quaternion[i] = imu_read_s16(&raw[IMU_SAMPLE_QUATERNION_OFFSET + 2 * i]);
+	}
+	data->calib_status = raw[IMU_SAMPLE_CALIB_STAT_OFFSET];
+	data->timestamp_us = dev->sample_read.start_us;
+}
+
+imu_data_t* imu_get_data(imu_t* dev) {
+	// Check IMU can be read
+	if (!imu_is_ready(dev)) {
 		return NULL;
 	}
-	dev->imu_data.linear_accel = temp_linear_accel;
 
-	return &(dev->imu_data);
+	// Recover the bus here if the last request got stuck
+	i2c_async_poll(&dev->bus);
+
+	// Sample requested last call should have arrived in the meantime
+	imu_data_t* data = NULL;
+	if (dev->has_sample_request) {
+		if (i2c_async_is_pending(&dev->sample_read)) {
+			dev->num_late_samples++;
+			return NULL;
+		}
+		if (dev->sample_read.status == I2C_ASYNC_DONE) {
+			imu_decode_sample(dev);
+			data = &dev->imu_data;
+		}
+	}
+
+	// Request the next sample so it's waiting next call
+	imu_request_sample(dev);
+	return data;
 }
 
+bool imu_is_fully_calibrated(const imu_data_t* data) {
+	return data && data->calib_status == IMU_CALIB_STAT_FULL;
+}
 
+/**
+ * @brief Moves calibration reading to the next step, remembering when it started
+ * @param[in, out] dev: IMU device
+ * @param[in] step: Next calibration reading step
+ */
+static void imu_set_calib_read_step(imu_t* dev, imu_calib_read_step_t step) {
+	dev->calib_read_step = step;
+	dev->calib_read_step_start_ms = HAL_GetTick();
+}
+
+bool imu_read_calibration_step(imu_t* dev, imu_calibration_t* calibration, bool* success) {
+	// Check user inputs
+	if (!dev || !calibration || !success || dev->init_step != IMU_INIT_READY) {
+		if (success) {
+			*success = false;
+		}
+		return true;
+	}
+
+	// Set current I2C bus for callbacks
+	bus_cur = &dev->bus;
+
+	u8 op_mode;
+	switch (dev->calib_read_step) {
+	case IMU_CALIB_READ_IDLE:
+		// Let the requested sample finish so it doesn't read mid mode switch. It's stale by the time reading is done
+		if (i2c_async_is_pending(&dev->sample_read)) {
+			return false;
+		}
+		dev->has_sample_request = false;
+		op_mode = BNO055_OPERATION_MODE_CONFIG;
+		if (bno055_write_register(BNO055_OPERATION_MODE_REG, &op_mode, 1) != BNO055_SUCCESS) {
+			*success = false;
+			return true;
+		}
+		imu_set_calib_read_step(dev, IMU_CALIB_READ_WAIT_CONFIG);
+		break;
+	case IMU_CALIB_READ_WAIT_CONFIG:
+		if (HAL_GetTick() - dev->calib_read_step_start_ms < BNO055_CONFIG_MODE_SWITCHING_DELAY) {
+			break;
+		}
+		// Go back to fusion even if the read failed, so the IMU stays usable
+		*success = bno055_read_register(BNO055_ACCEL_OFFSET_X_LSB_ADDR, calibration->regs, IMU_CALIBRATION_LEN) == BNO055_SUCCESS;
+		op_mode = BNO055_OPERATION_MODE_NDOF;
+		if (bno055_write_register(BNO055_OPERATION_MODE_REG, &op_mode, 1) != BNO055_SUCCESS) {
+			*success = false;
+		}
+		dev->calib_read_succeeded = *success;
+		imu_set_calib_read_step(dev, IMU_CALIB_READ_WAIT_FUSION);
+		break;
+	case IMU_CALIB_READ_WAIT_FUSION:
+		if (HAL_GetTick() - dev->calib_read_step_start_ms >= BNO055_MODE_SWITCHING_DELAY) {
+			imu_set_calib_read_step(dev, IMU_CALIB_READ_IDLE);
+			*success = dev->calib_read_succeeded;
+			return true;
+		}
+		break;
+	default:
+		break;
+	}
+	return false;
+}
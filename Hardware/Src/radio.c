@@ -5,21 +5,68 @@
 #include "radio.h"
 #include "string.h"
 
-#define RADIO_UART_TIMEOUT_MS 100
-
 #define RADIO_HEADER 0xBEEF
+#define RADIO_FRAMING_LEN 5 // 2-byte header ID, 2-byte length, & 1-byte checksum
+
+typedef struct radio_cmd_t {
+	const char* cmd;
+	uint8_t param;
+} radio_cmd_t;
+
+// Assume most configurations are set up beforehand via XCTU, except those explicitly set below
+static const radio_cmd_t init_cmds[] = {
+	{"AP", 0},	// Set device to transparent operating mode (AP = 0) to define our own protocol
+	{"RO", 3},	// Set packetization timeout (number of characters of silence to wait before sending packet) to 3
+};
+#define NUM_INIT_CMDS (sizeof(init_cmds) / sizeof(init_cmds[0]))
+
+// UART callbacks only get the UART handle, so keep the radio here. Set in radio_init()
+static radio_t* radio_dev = NULL;
 
 /**
- * @brief Sends command to radio to adjust a setting
- * @param[in] dev: Radio device
- * @param[in] cmd: 2-letter command to send
- * @param[in] param: Parameter following command
+ * @brief Starts sending the oldest queued bytes, up to the end of the buffer, if the UART is idle. Call from an interrupt
+ * or with interrupts disabled
+ * @param[in, out] dev: Radio device
  */
-static void radio_send_cmd(radio_t* dev, const char* cmd, uint8_t param) {
-	char tx_data[5] = "AT";
-	memcpy(&tx_data[2], cmd, 2);
-	tx_data[5] = param;
-	HAL_UART_Transmit(dev->huart, (uint8_t*) tx_data, 4, RADIO_UART_TIMEOUT_MS);
+static void radio_start_next(radio_t* dev) {
+	uint32_t pending = dev->tx_head - dev->tx_tail;
+	if (dev->tx_dma_len || !pending) {
+		return;
+	}
+
+	// Bytes that wrap around the end of the buffer go out in the next transfer
+	uint32_t start = dev->tx_tail & (RADIO_TX_BUFFER_SIZE - 1);
+	uint32_t len = RADIO_TX_BUFFER_SIZE - start;
+	if (len > pending) {
+		len = pending;
+	}
+	if (HAL_UART_Transmit_DMA(dev->huart, &dev->tx_buffer[start], (uint16_t) len) == HAL_OK) {
+		dev->tx_dma_len = (uint16_t) len;
+	}
+}
+
+/**
+ * @brief Frees the bytes of the finished transfer and starts the next one
+ * @param[in] huart: UART handle of the radio
+ */
+static void radio_tx_complete(UART_HandleTypeDef* huart) {
+	(void) huart; // Only one radio, kept in radio_dev
+	radio_t* dev = radio_dev;
+	if (!dev) {
+		return;
+	}
+
+	dev->tx_tail += dev->tx_dma_len;
+	dev->tx_dma_len = 0;
+	radio_start_next(dev);
+}
+
+/**
+ * @brief Gives up on a transfer that failed, since its bytes can't be resent mid-packet, and moves on to the next one
+ * @param[in] huart: UART handle of the radio
+ */
+static void radio_error(UART_HandleTypeDef* huart) {
+	radio_tx_complete(huart);
 }
 
 void radio_init(radio_t* dev, UART_HandleTypeDef* huart) {
@@ -30,38 +77,101 @@ void radio_init(radio_t* dev, UART_HandleTypeDef* huart) {
 
 	// Set initial dev properties
 	dev->huart = huart;
+	dev->init_cmd_num = 0;
+	dev->init_byte_num = 0;
+	dev->tx_head = 0;
+	dev->tx_tail = 0;
+	dev->tx_dma_len = 0;
+	dev->num_dropped = 0;
 
-	// Assume most configurations are set up beforehand via XCTU, except those explicitly set below
+	// Callbacks can only be registered while the UART is idle, which it is until the first transmit
+	radio_dev = dev;
+	HAL_UART_RegisterCallback(huart, HAL_UART_TX_COMPLETE_CB_ID, radio_tx_complete);
+	HAL_UART_RegisterCallback(huart, HAL_UART_ERROR_CB_ID, radio_error);
+}
 
-	// Set device to transparent operating mode (AP = 0) to define our own protocol
-	radio_send_cmd(dev, "AP", 0);
-	// Set packetization timeout (number of characters of silence to wait before sending packet) to 3
-	radio_send_cmd(dev, "RO", 3);
+bool radio_init_step(radio_t* dev) {
+	// Check user inputs
+	if (!dev) {
+		return true;
+	}
+
+	// Feed the UART one byte at a time while its transmit register is empty, instead of blocking until the commands are sent
+	while (dev->init_cmd_num < NUM_INIT_CMDS && __HAL_UART_GET_FLAG(dev->huart, UART_FLAG_TXE)) {
+		// Build command when starting to send it
+		if (dev->init_byte_num == 0) {
+			dev->init_tx_data[0] = 'A';
+			dev->init_tx_data[1] = 'T';
+			memcpy(&dev->init_tx_data[2], init_cmds[dev->init_cmd_num].cmd, 2);
+			dev->init_tx_data[4] = init_cmds[dev->init_cmd_num].param;
+		}
+
+		dev->huart->Instance->TDR = dev->init_tx_data[dev->init_byte_num++];
+		if (dev->init_byte_num >= RADIO_CMD_LEN) {
+			dev->init_byte_num = 0;
+			dev->init_cmd_num++;
+		}
+	}
+
+	return dev->init_cmd_num >= NUM_INIT_CMDS;
+}
+
+/**
+ * @brief Copies a byte into the transmit buffer and adds it to the packet checksum
+ * @param[in, out] dev: Radio device
+ * @param[in, out] head: Where to write, advanced past the byte
+ * @param[in, out] sum: Packet checksum
+ * @param[in] byte: Byte to queue
+ */
+static inline void radio_queue_byte(radio_t* dev, uint32_t* head, uint8_t* sum, uint8_t byte) {
+	dev->tx_buffer[*head & (RADIO_TX_BUFFER_SIZE - 1)] = byte;
+	(*head)++;
+	*sum += byte;
 }
 
-void radio_transmit(radio_t* dev, uint8_t* data, uint16_t len) {
+bool radio_transmit(radio_t* dev, uint8_t* data, uint16_t len) {
 	// Check user input
 	if (!dev || !data) {
-		return;
+		return false;
+	}
+
+	// Only the completion interrupt frees space, so the space seen here can only grow while the packet is copied
+	if ((uint32_t) len + RADIO_FRAMING_LEN > RADIO_TX_BUFFER_SIZE - (dev->tx_head - dev->tx_tail)) {
+		dev->num_dropped++;
+		return false;
 	}
 
 	// Add custom protocol of packet (2-byte header ID, 2-byte length, & 1-byte checksum)
-	uint8_t tx_data[len + 5];
+	uint32_t head = dev->tx_head;
+	uint8_t sum = 0;
 	// Header
-	tx_data[0] = RADIO_HEADER >> 8;
-	tx_data[1] = RADIO_HEADER & 0xFF;
+	radio_queue_byte(dev, &head, &sum, RADIO_HEADER >> 8);
+	radio_queue_byte(dev, &head, &sum, RADIO_HEADER & 0xFF);
 	// Length
-	tx_data[2] = len >> 8;
-	tx_data[3] = len & 0xFF;
+	radio_queue_byte(dev, &head, &sum, len >> 8);
+	radio_queue_byte(dev, &head, &sum, len & 0xFF);
 	// Data
-	memcpy(&tx_data[4], data, len);
-	// Checksum (overflowed sum of data)
-	uint8_t sum = 0;
-	for (uint16_t i = 0; i < sizeof(tx_data); i++) {
-		sum += tx_data[i];
+	for (uint16_t i = 0; i < len; i++) {
+		radio_queue_byte(dev, &head, &sum, data[i]);
+	}
+	// Checksum (overflowed sum of header, length, and data)
+	uint8_t checksum = sum;
+	radio_queue_byte(dev, &head, &sum, checksum);
+
+	// Completion interrupts also start transfers, so keep them out while the packet is handed over
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	dev->tx_head = head;
+	radio_start_next(dev);
+	__set_PRIMASK(primask);
+	return true;
+}
+
+uint16_t radio_get_tx_pending(const radio_t* dev) {
+	// Check user input
+	if (!dev) {
+		return 0;
 	}
-	tx_data[len + 4] = sum;
 
-	// Transmit packet to radio
-	HAL_UART_Transmit(dev->huart, tx_data, len + 5, RADIO_UART_TIMEOUT_MS);
+	return (uint16_t) (dev->tx_head - dev->tx_tail);
 }
@@ -7,21 +7,16 @@
 #include <math.h>
 
 /**
- * @brief Writes the given register based on the device struct values
+ * @brief Writes a register value to the device
  * @param[in] dev: Signal generator device
- * @param[in] register_num: Number of register to write (0-5)
+ * @param[in] reg: Register value to write
  */
-static void signal_generator_write_register(const signal_generator_t* dev, uint8_t register_num) {
-
-	// Check user inputs
-	if (!dev || register_num > 5) {
-		return;
-	}
+static void signal_generator_write_value(const signal_generator_t* dev, const register_t* reg) {
 
 	// Produce register value (convert from little endian to big endian for SPI send)
 	uint8_t reg_vals[4] = {0};
 	for (int i = 0; i < 4; i++) {
-		reg_vals[i] = dev->regs[register_num].reg_vals[3 - i];
+		reg_vals[i] = reg->reg_vals[3 - i];
 	}
 
 	// SPI write to device
@@ -30,6 +25,21 @@ static void signal_generator_write_register(const signal_generator_t* dev, uint8
 	HAL_GPIO_WritePin(dev->le_port, dev->le_pin, GPIO_PIN_SET);
 }
 
+/**
+ * @brief Writes the given register based on the device struct values
+ * @param[in] dev: Signal generator device
+ * @param[in] register_num: Number of register to write (0-5)
+ */
+static void signal_generator_write_register(const signal_generator_t* dev, uint8_t register_num) {
+
+	// Check user inputs
+	if (!dev || register_num > 5) {
+		return;
+	}
+
+	signal_generator_write_value(dev, &dev->regs[register_num]);
+}
+
 void signal_generator_init(signal_generator_t* dev, SPI_HandleTypeDef* hspi, GPIO_TypeDef* le_port, uint16_t le_pin, TIM_HandleTypeDef* htim, uint32_t tim_channel, double ref_clk_freq_mhz) {
 
 	// Check user inputs
@@ -115,23 +125,35 @@ void signal_generator_init(signal_generator_t* dev, SPI_HandleTypeDef* hspi, GPI
 	// R = R counter divisor (1 - 1023)
 	dev->freq_pfd_mhz = ref_clk_freq_mhz * ((1 + reg2->RDOUBLER) / reg2->RCOUNT);
 
-	// Write registers
-	for (int i = 5; i >= 0; i--) {
-		signal_generator_write_register(dev, (uint8_t) i);
+	// Registers are written in steps by signal_generator_program_step()
+	dev->next_program_register = 5;
+}
+
+bool signal_generator_program_step(signal_generator_t* dev) {
+
+	// Check user inputs
+	if (!dev) {
+		return true;
 	}
+
+	if (dev->next_program_register >= 0) {
+		signal_generator_write_register(dev, (uint8_t) dev->next_program_register);
+		dev->next_program_register--;
+	}
+	return dev->next_program_register < 0;
 }
 
-void signal_generator_set_output_freq(signal_generator_t* dev, double freq_mhz) {
+bool signal_generator_calculate_freq(const signal_generator_t* dev, double freq_mhz, signal_generator_freq_t* freq) {
 
 	// Check user inputs
-	if (!dev || freq_mhz < 137.5 || freq_mhz > 4400) {
-		return;
+	if (!dev || !freq || freq_mhz < 137.5 || freq_mhz > 4400) {
+		return false;
 	}
 
 	// Choose DIVSELECT (final divider either 1, 2, 4, 8, 16). VCO output is only 2.2GHz - 4.4GHz
 	// DIVSELECT = floor(log(4400/freq_mhz)/log(2))
-	dev->regs[4].reg4.DIVSELECT = (uint8_t) floor(log(4400.0 / freq_mhz) / log(2.0));
-	signal_generator_write_register(dev, 4);
+	freq->reg4 = dev->regs[4];
+	freq->reg4.reg4.DIVSELECT = (uint8_t) floor(log(4400.0 / freq_mhz) / log(2.0));
 
 	// Set PLL values to produce desired output frequency
 	// Rf_out = fpfd * (INT + FRAC / MOD) / RF_div
@@ -139,12 +161,34 @@ void signal_generator_set_output_freq(signal_generator_t* dev, double freq_mhz)
 	// MOD = (2 - 4095)
 	// FRAC = (0 - [MOD - 1])
 	// RF_div = DIVSELECT (1, 2, 4, 8, 16)
-	double remainder = freq_mhz * (double)(1u << dev->regs[4].reg4.DIVSELECT) / dev->freq_pfd_mhz;
+	double remainder = freq_mhz * (double)(1u << freq->reg4.reg4.DIVSELECT) / dev->freq_pfd_mhz;
 	double INT = floor(remainder);
-	double FRAC = (remainder - INT) * (double) dev->regs[0].reg1.MOD;
-	dev->regs[0].reg0.INT = (uint16_t) INT;
-	dev->regs[0].reg0.FRAC = (uint16_t) FRAC;
-	signal_generator_write_register(dev, 0);
+	double FRAC = (remainder - INT) * (double) dev->regs[1].reg1.MOD;
+	freq->reg0 = dev->regs[0];
+	freq->reg0.reg0.INT = (uint16_t) INT;
+	freq->reg0.reg0.FRAC = (uint16_t) FRAC;
+	return true;
+}
+
+void signal_generator_write_freq(signal_generator_t* dev, const signal_generator_freq_t* freq) {
+
+	// Check user inputs
+	if (!dev || !freq) {
+		return;
+	}
+
+	// Keep the device struct matching what was written
+	dev->regs[4] = freq->reg4;
+	dev->regs[0] = freq->reg0;
+	signal_generator_write_value(dev, &dev->regs[4]);
+	signal_generator_write_value(dev, &dev->regs[0]);
+}
+
+void signal_generator_set_output_freq(signal_generator_t* dev, double freq_mhz) {
+	signal_generator_freq_t freq;
+	if (signal_generator_calculate_freq(dev, freq_mhz, &freq)) {
+		signal_generator_write_freq(dev, &freq);
+	}
 }
 
 void signal_generator_start(const signal_generator_t* dev) {
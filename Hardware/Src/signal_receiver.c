@@ -4,14 +4,27 @@
 
 #include "signal_receiver.h"
 
+#include <stddef.h>
+
+static signal_receiver_t* capturing_dev; // Device whose capture the ADC interrupt belongs to
+
 /**
  * @brief Callback for when signal receiving completes
  * @param hadc: ADC handle that finished receiving
  *
- * Sets callback to NULL to indicate completeness.
+ * Stops the circular DMA before it wraps around over the capture, then lets the device's owner know.
  */
 static void signal_receiver_complete(ADC_HandleTypeDef* hadc) {
-	hadc->ConvCpltCallback = NULL;
+	HAL_ADC_Stop_DMA(hadc);
+
+	signal_receiver_t* dev = capturing_dev;
+	if (!dev || dev->hadc != hadc) {
+		return;
+	}
+	dev->capturing = false;
+	if (dev->complete_callback) {
+		dev->complete_callback(dev);
+	}
 }
 
 void signal_receiver_init(signal_receiver_t* dev, ADC_HandleTypeDef* hadc) {
@@ -21,37 +34,47 @@ void signal_receiver_init(signal_receiver_t* dev, ADC_HandleTypeDef* hadc) {
 	}
 
 	dev->hadc = hadc;
-	hadc->ConvCpltCallback = NULL; // Notify
+	dev->destination = NULL;
+	dev->num_samples = 0;
+	dev->capturing = false;
+	dev->complete_callback = NULL;
+	// Registered once here, since callbacks can only be registered while the ADC is idle
+	HAL_ADC_RegisterCallback(hadc, HAL_ADC_CONVERSION_COMPLETE_CB_ID, signal_receiver_complete);
 }
 
-void signal_receiver_start(signal_receiver_t* dev, uint32_t num_samples) {
+bool signal_receiver_start(signal_receiver_t* dev, uint16_t* destination, uint32_t num_samples, signal_receiver_callback_t complete_callback) {
 	// Check user inputs
-	if (!dev || num_samples > SIG_RECEIVER_MAX_DMA_SAMPLES) {
-		num_samples = 0;
-		return;
+	if (!dev || !destination || num_samples == 0 || num_samples > SIG_RECEIVER_MAX_DMA_SAMPLES) {
+		return false;
 	}
 
 	// Check conversion isn't currently in progress
-	if (dev->hadc->ConvCpltCallback != NULL) {
-		return;
+	if (dev->capturing) {
+		return false;
 	}
 
+	dev->destination = destination;
 	dev->num_samples = num_samples;
+	dev->complete_callback = complete_callback;
+	dev->capturing = true;
+	capturing_dev = dev;
 
-	HAL_ADC_RegisterCallback(dev->hadc, HAL_ADC_CONVERSION_COMPLETE_CB_ID, signal_receiver_complete);
-	HAL_ADC_Start_DMA(dev->hadc, dev->adc_dma_stream, num_samples);
+	// HAL takes a word pointer whatever the DMA width, but the transfer is configured as halfwords
+	HAL_ADC_Start_DMA(dev->hadc, (uint32_t*) destination, num_samples);
+	return true;
 }
 
-uint32_t* signal_receiver_get_data(signal_receiver_t* dev, uint32_t* num_samples) {
+uint16_t* signal_receiver_get_data(signal_receiver_t* dev, uint32_t* num_samples) {
 	// Check user inputs
 	if (!dev) {
 		return NULL;
 	}
-	// If callback exists, it hasn't been called yet
-	if (dev->hadc->ConvCpltCallback) {
+	if (dev->capturing) {
 		return NULL;
 	}
 
-	*num_samples = dev->num_samples;
-	return dev->adc_dma_stream;
+	if (num_samples) {
+		*num_samples = dev->num_samples;
+	}
+	return dev->destination;
 }
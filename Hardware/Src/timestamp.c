@@ -0,0 +1,25 @@
+/*
+ * timestamp.c
+ */
+
+#include "timestamp.h"
+
+uint32_t timestamp_get_us(void) {
+	uint32_t ms = HAL_GetTick();
+	uint32_t val = SysTick->VAL;
+
+	if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+		// SysTick reloaded but its interrupt hasn't run (called with it masked), so the tick is one ms behind.
+		// Read the counter again in case the reload happened after the first read
+		ms++;
+		val = SysTick->VAL;
+	} else if (ms != HAL_GetTick()) {
+		// SysTick interrupt ran between reads
+		ms = HAL_GetTick();
+		val = SysTick->VAL;
+	}
+
+	// SysTick counts down from LOAD to 0 once per ms
+	uint32_t load = SysTick->LOAD;
+	return ms * 1000 + (load - val) * 1000 / (load + 1);
+}
@@ -0,0 +1,75 @@
+/*
+ * geodesy.h
+ *
+ * Converts WGS84 geodetic coordinates to a local east/north/up (ENU) tangent plane fixed at an origin
+ * Everything that depends only on the origin (its sine and cosine, meridian and normal radii of curvature) is computed once,
+ * so each conversion is a few multiply-adds on integer offsets from the origin, with no trig.
+ * Uses a second-order expansion of geodetic-to-ENU about the origin, which stays within a few millimeters of the exact
+ * ECEF rotation over a survey area a kilometer across.
+ * Reference: B. Hofmann-Wellenhof et al., GNSS - Global Navigation Satellite Systems, 2008, sec. 10.2
+ *
+ * No hardware dependencies, so it also builds on a host.
+ */
+
+#ifndef INC_GEODESY_H_
+#define INC_GEODESY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#define GEODESY_WGS84_A_M		6378137.0 // Semi-major axis
+#define GEODESY_WGS84_E2		6.69437999014e-3 // First eccentricity squared
+#define GEODESY_E7_TO_RAD		(3.14159265358979323846 / 180 * 1e-7)
+
+/**
+ * Local tangent plane origin. Coefficients scale offsets in 1e-7 degrees and mm to meters
+ */
+typedef struct geodesy_enu_origin_t {
+	int32_t lat_e7;
+	int32_t lon_e7;
+	int32_t height_mm; // Above ellipsoid
+	double east_per_dlon; // East from longitude offset, (N + h) cos(lat)
+	double east_per_dlat_dlon; // Meridians converging away from the origin latitude, -(M + h) sin(lat)
+	double north_per_dlat; // North from latitude offset, M + h
+	double north_per_dlat2; // Meridian radius changing with latitude, dM/dlat / 2
+	double north_per_dlon2; // Parallels curving away from east, (N + h) sin(lat) cos(lat) / 2
+	double up_per_dlat2; // Surface dropping below the tangent plane, -(M + h) / 2
+	double up_per_dlon2; // -(N + h) cos(lat)^2 / 2
+} geodesy_enu_origin_t;
+
+/**
+ * Position in the local tangent plane, in meters
+ */
+typedef struct geodesy_enu_t {
+	double east_m;
+	double north_m;
+	double up_m;
+} geodesy_enu_t;
+
+/**
+ * @brief Fixes a tangent plane origin and precomputes its conversion coefficients
+ * @param[out] origin: Origin to initialize
+ * @param[in] lat_e7: Origin latitude in 1e-7 degrees
+ * @param[in] lon_e7: Origin longitude in 1e-7 degrees
+ * @param[in] height_mm: Origin height above ellipsoid in mm
+ */
+void geodesy_enu_origin_init(geodesy_enu_origin_t* origin, int32_t lat_e7, int32_t lon_e7, int32_t height_mm);
+
+/**
+ * @brief Converts a geodetic position to the tangent plane of an origin. Accurate within a few kilometers of the origin
+ * @param[in] origin: Tangent plane origin
+ * @param[in] lat_e7: Latitude in 1e-7 degrees
+ * @param[in] lon_e7: Longitude in 1e-7 degrees
+ * @param[in] height_mm: Height above ellipsoid in mm
+ * @return Position east, north, and up of the origin
+ */
+geodesy_enu_t geodesy_to_enu(const geodesy_enu_origin_t* origin, int32_t lat_e7, int32_t lon_e7, int32_t height_mm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_GEODESY_H_ */
@@ -0,0 +1,73 @@
+/*
+ * sample_ring.h
+ *
+ * Lock-free single-producer, single-consumer ring buffer of fixed-size samples
+ * Meant for an interrupt (producer) handing timestamped sensor samples to the main loop (consumer) without disabling interrupts.
+ * The producer only writes head and the consumer only writes tail, so each index has a single writer.
+ * When full, new samples are dropped and counted rather than overwriting one the consumer may be reading.
+ *
+ * Storage is provided by the caller, and capacity must be a power of 2. No hardware dependencies, so it also builds on a host.
+ */
+
+#ifndef INC_SAMPLE_RING_H_
+#define INC_SAMPLE_RING_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct sample_ring_t {
+	uint8_t* storage;
+	uint32_t sample_size;
+	uint32_t capacity;
+	volatile uint32_t head; // Total samples pushed, written only by producer
+	volatile uint32_t tail; // Total samples popped, written only by consumer
+	volatile uint32_t num_dropped; // Samples pushed while full, written only by producer
+} sample_ring_t;
+
+/**
+ * @brief Initializes an empty ring buffer
+ * @param[out] ring: Ring buffer to initialize
+ * @param[in] storage: Buffer of at least sample_size * capacity bytes
+ * @param[in] sample_size: Size of one sample in bytes
+ * @param[in] capacity: Maximum number of samples held. Must be a power of 2
+ * @return True if initialized, false if inputs are invalid
+ */
+bool sample_ring_init(sample_ring_t* ring, void* storage, uint32_t sample_size, uint32_t capacity);
+
+/**
+ * @brief Copies a sample into the ring. Producer side only
+ * @param[in, out] ring: Ring buffer
+ * @param[in] sample: Sample of sample_size bytes to copy
+ * @return True if pushed, false if the ring was full and the sample was dropped
+ */
+bool sample_ring_push(sample_ring_t* ring, const void* sample);
+
+/**
+ * @brief Gets the oldest sample without removing it. Consumer side only
+ * @param[in] ring: Ring buffer
+ * @return Pointer to oldest sample, valid until sample_ring_pop(). NULL if empty
+ */
+const void* sample_ring_peek(const sample_ring_t* ring);
+
+/**
+ * @brief Removes the oldest sample. Consumer side only
+ * @param[in, out] ring: Ring buffer
+ */
+void sample_ring_pop(sample_ring_t* ring);
+
+/**
+ * @brief Gets number of samples waiting in the ring
+ * @param[in] ring: Ring buffer
+ * @return Number of samples waiting
+ */
+uint32_t sample_ring_count(const sample_ring_t* ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SAMPLE_RING_H_ */
@@ -0,0 +1,172 @@
+/*
+ * ubx.h
+ *
+ * u-blox UBX binary protocol: incremental frame parser, NAV-PVT decoding, and builders for the configuration messages the GPS needs
+ * Frames are 0xB5 0x62, class, ID, 2-byte little-endian payload length, payload, and a 2-byte 8-bit Fletcher checksum over class through payload.
+ * Reference: u-blox 8 / u-blox M8 Receiver Description, Protocol Specification (UBX-13003221)
+ *
+ * No hardware dependencies, so it also builds on a host.
+ */
+
+#ifndef INC_UBX_H_
+#define INC_UBX_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define UBX_SYNC_CHAR_1		0xB5
+#define UBX_SYNC_CHAR_2		0x62
+#define UBX_FRAME_OVERHEAD	8 // Sync chars, class, ID, length, checksum
+#define UBX_MAX_PAYLOAD		100 // Longest payload kept by the parser. Longer frames are skipped
+
+#define UBX_CLASS_NAV		0x01
+#define UBX_CLASS_CFG		0x06
+#define UBX_ID_NAV_PVT		0x07
+#define UBX_ID_CFG_PRT		0x00
+#define UBX_ID_CFG_MSG		0x01
+#define UBX_ID_CFG_RATE		0x08
+
+#define UBX_NAV_PVT_PAYLOAD_LEN	92
+#define UBX_CFG_PRT_PAYLOAD_LEN	20
+#define UBX_CFG_MSG_PAYLOAD_LEN	3
+#define UBX_CFG_RATE_PAYLOAD_LEN	6
+
+#define UBX_NAV_PVT_FLAGS_GNSS_FIX_OK	0x01
+
+typedef enum {
+	UBX_FIX_NONE = 0,
+	UBX_FIX_DEAD_RECKONING,
+	UBX_FIX_2D,
+	UBX_FIX_3D,
+	UBX_FIX_GNSS_DEAD_RECKONING,
+	UBX_FIX_TIME_ONLY
+} ubx_fix_type_t;
+
+typedef enum {
+	UBX_PARSE_SYNC_1 = 0,
+	UBX_PARSE_SYNC_2,
+	UBX_PARSE_CLASS,
+	UBX_PARSE_ID,
+	UBX_PARSE_LENGTH_1,
+	UBX_PARSE_LENGTH_2,
+	UBX_PARSE_PAYLOAD,
+	UBX_PARSE_CHECKSUM_A,
+	UBX_PARSE_CHECKSUM_B
+} ubx_parse_state_t;
+
+typedef struct ubx_parser_t {
+	ubx_parse_state_t state;
+	uint8_t msg_class;
+	uint8_t msg_id;
+	uint16_t length;
+	uint16_t index;
+	uint8_t ck_a;
+	uint8_t ck_b;
+	uint8_t payload[UBX_MAX_PAYLOAD];
+	uint32_t num_checksum_errors;
+} ubx_parser_t;
+
+/**
+ * Navigation position, velocity, and time solution. Units follow the message: 1e-7 degrees, mm, mm/s, 1e-5 degrees
+ */
+typedef struct ubx_nav_pvt_t {
+	uint32_t itow_ms; // GPS time of week of the navigation epoch
+	uint8_t fix_type; // ubx_fix_type_t
+	uint8_t flags; // UBX_NAV_PVT_FLAGS_*
+	uint8_t num_satellites;
+	int32_t lon_e7;
+	int32_t lat_e7;
+	int32_t height_mm; // Above ellipsoid
+	int32_t height_msl_mm; // Above mean sea level
+	uint32_t h_acc_mm; // Horizontal accuracy estimate
+	uint32_t v_acc_mm; // Vertical accuracy estimate
+	int32_t vel_n_mm_s;
+	int32_t vel_e_mm_s;
+	int32_t vel_d_mm_s;
+	int32_t ground_speed_mm_s;
+	int32_t head_motion_e5;
+	uint32_t speed_acc_mm_s;
+} ubx_nav_pvt_t;
+
+/**
+ * @brief Resets parser to look for the start of a frame
+ * @param[out] parser: Parser to initialize
+ */
+void ubx_parser_init(ubx_parser_t* parser);
+
+/**
+ * @brief Feeds one received byte to the parser
+ * @param[in, out] parser: Parser
+ * @param[in] byte: Received byte
+ * @return True if the byte completed a frame with a valid checksum. Its class, ID, length, and payload stay in the parser until the next byte
+ */
+bool ubx_parser_feed(ubx_parser_t* parser, uint8_t byte);
+
+/**
+ * @brief Feeds received bytes to the parser, stopping after the first completed frame. Payloads are copied and checksummed in runs rather than byte by byte
+ * @param[in, out] parser: Parser
+ * @param[in] data: Received bytes
+ * @param[in] len: Number of received bytes
+ * @param[out] frame_done: True if a frame with a valid checksum was completed, same as ubx_parser_feed()
+ * @return Number of bytes consumed. Feed the rest after handling a completed frame
+ */
+uint16_t ubx_parser_feed_bytes(ubx_parser_t* parser, const uint8_t* data, uint16_t len, bool* frame_done);
+
+/**
+ * @brief Decodes the frame the parser just completed as NAV-PVT
+ * @param[in] parser: Parser that just completed a frame
+ * @param[out] pvt: Decoded solution
+ * @return True if the frame is NAV-PVT, false otherwise
+ */
+bool ubx_decode_nav_pvt(const ubx_parser_t* parser, ubx_nav_pvt_t* pvt);
+
+/**
+ * @brief Builds a frame around a payload
+ * @param[out] frame: Buffer for frame
+ * @param[in] frame_size: Size of buffer
+ * @param[in] msg_class: Message class
+ * @param[in] msg_id: Message ID
+ * @param[in] payload: Payload, may be NULL if len is 0
+ * @param[in] len: Payload length
+ * @return Frame length, 0 if the buffer is too small
+ */
+uint16_t ubx_build_frame(uint8_t* frame, uint16_t frame_size, uint8_t msg_class, uint8_t msg_id, const uint8_t* payload, uint16_t len);
+
+/**
+ * @brief Builds CFG-PRT for UART1: 8N1 at a baud rate, accepting UBX and NMEA input and sending only UBX output
+ * @param[out] frame: Buffer for frame
+ * @param[in] frame_size: Size of buffer
+ * @param[in] baud_rate: New baud rate
+ * @return Frame length, 0 if the buffer is too small
+ */
+uint16_t ubx_build_cfg_prt_uart(uint8_t* frame, uint16_t frame_size, uint32_t baud_rate);
+
+/**
+ * @brief Builds CFG-RATE setting the navigation solution period, aligned to GPS time
+ * @param[out] frame: Buffer for frame
+ * @param[in] frame_size: Size of buffer
+ * @param[in] meas_period_ms: Time between navigation solutions (100 ms for 10 Hz)
+ * @return Frame length, 0 if the buffer is too small
+ */
+uint16_t ubx_build_cfg_rate(uint8_t* frame, uint16_t frame_size, uint16_t meas_period_ms);
+
+/**
+ * @brief Builds CFG-MSG setting how often a message is output on the current port
+ * @param[out] frame: Buffer for frame
+ * @param[in] frame_size: Size of buffer
+ * @param[in] msg_class: Class of message to output
+ * @param[in] msg_id: ID of message to output
+ * @param[in] rate: Output once every this many navigation solutions, 0 to disable
+ * @return Frame length, 0 if the buffer is too small
+ */
+uint16_t ubx_build_cfg_msg(uint8_t* frame, uint16_t frame_size, uint8_t msg_class, uint8_t msg_id, uint8_t rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_UBX_H_ */
@@ -0,0 +1,47 @@
+/*
+ * geodesy.c
+ */
+
+#include "geodesy.h"
+
+#include <math.h>
+
+void geodesy_enu_origin_init(geodesy_enu_origin_t* origin, int32_t lat_e7, int32_t lon_e7, int32_t height_mm) {
+	origin->lat_e7 = lat_e7;
+	origin->lon_e7 = lon_e7;
+	origin->height_mm = height_mm;
+
+	double lat_rad = lat_e7 * GEODESY_E7_TO_RAD;
+	double sin_lat = sin(lat_rad);
+	double cos_lat = cos(lat_rad);
+	double h = height_mm * 0.001;
+
+	// Normal (prime vertical) and meridian radii of curvature at the origin
+	double w2 = 1 - GEODESY_WGS84_E2 * sin_lat * sin_lat;
+	double normal_m = GEODESY_WGS84_A_M / sqrt(w2);
+	double meridian_m = normal_m * (1 - GEODESY_WGS84_E2) / w2;
+	double meridian_slope_m = 3 * meridian_m * GEODESY_WGS84_E2 * sin_lat * cos_lat / w2; // dM/dlat
+
+	// Offsets arrive in 1e-7 degrees, so fold that scale into each coefficient once
+	const double k = GEODESY_E7_TO_RAD;
+	origin->east_per_dlon = (normal_m + h) * cos_lat * k;
+	origin->east_per_dlat_dlon = -(meridian_m + h) * sin_lat * k * k;
+	origin->north_per_dlat = (meridian_m + h) * k;
+	origin->north_per_dlat2 = meridian_slope_m / 2 * k * k;
+	origin->north_per_dlon2 = (normal_m + h) * sin_lat * cos_lat / 2 * k * k;
+	origin->up_per_dlat2 = -(meridian_m + h) / 2 * k * k;
+	origin->up_per_dlon2 = -(normal_m + h) * cos_lat * cos_lat / 2 * k * k;
+}
+
+geodesy_enu_t geodesy_to_enu(const geodesy_enu_origin_t* origin, int32_t lat_e7, int32_t lon_e7, int32_t height_mm) {
+	// Integer offsets are exact, so precision doesn't depend on how far the origin is from the equator or prime meridian
+	double dlat = (double) lat_e7 - origin->lat_e7;
+	double dlon = (double) lon_e7 - origin->lon_e7;
+	double dh = (height_mm - origin->height_mm) * 0.001;
+
+	geodesy_enu_t enu;
+	enu.east_m = dlon * (origin->east_per_dlon + origin->east_per_dlat_dlon * dlat);
+	enu.north_m = dlat * (origin->north_per_dlat + origin->north_per_dlat2 * dlat) + origin->north_per_dlon2 * dlon * dlon;
+	enu.up_m = dh + origin->up_per_dlat2 * dlat * dlat + origin->up_per_dlon2 * dlon * dlon;
+	return enu;
+}
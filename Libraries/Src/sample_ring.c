@@ -0,0 +1,74 @@
+/*
+ * sample_ring.c
+ */
+
+#include "sample_ring.h"
+
+#include <stddef.h>
+#include <string.h>
+
+bool sample_ring_init(sample_ring_t* ring, void* storage, uint32_t sample_size, uint32_t capacity) {
+	// Check user inputs
+	if (!ring || !storage || sample_size == 0 || capacity == 0 || (capacity & (capacity - 1)) != 0) {
+		return false;
+	}
+
+	ring->storage = (uint8_t*) storage;
+	ring->sample_size = sample_size;
+	ring->capacity = capacity;
+	ring->head = 0;
+	ring->tail = 0;
+	ring->num_dropped = 0;
+	return true;
+}
+
+bool sample_ring_push(sample_ring_t* ring, const void* sample) {
+	// Check user inputs
+	if (!ring || !sample) {
+		return false;
+	}
+
+	// Acquire pairs with the consumer's release of tail, so the slot is no longer being read before it's overwritten
+	uint32_t head = ring->head;
+	uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	if (head - tail >= ring->capacity) {
+		ring->num_dropped++;
+		return false;
+	}
+
+	memcpy(&ring->storage[(head & (ring->capacity - 1)) * ring->sample_size], sample, ring->sample_size);
+	// Release publishes the sample contents before the consumer can see the new head
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+
+const void* sample_ring_peek(const sample_ring_t* ring) {
+	// Check user inputs
+	if (!ring) {
+		return NULL;
+	}
+
+	uint32_t tail = ring->tail;
+	if (__atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail) {
+		return NULL;
+	}
+	return &ring->storage[(tail & (ring->capacity - 1)) * ring->sample_size];
+}
+
+void sample_ring_pop(sample_ring_t* ring) {
+	// Check user inputs
+	if (!ring || __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == ring->tail) {
+		return;
+	}
+
+	__atomic_store_n(&ring->tail, ring->tail + 1, __ATOMIC_RELEASE);
+}
+
+uint32_t sample_ring_count(const sample_ring_t* ring) {
+	// Check user inputs
+	if (!ring) {
+		return 0;
+	}
+
+	return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - ring->tail;
+}
@@ -0,0 +1,252 @@
+/*
+ * ubx.c
+ */
+
+#include "ubx.h"
+
+#include <stddef.h>
+#include <string.h>
+
+/**
+ * @brief Reads a little-endian unsigned 32-bit value
+ * @param[in] buf: First byte of value
+ * @return Value
+ */
+static uint32_t ubx_read_u32(const uint8_t* buf) {
+	return (uint32_t) buf[0] | ((uint32_t) buf[1] << 8) | ((uint32_t) buf[2] << 16) | ((uint32_t) buf[3] << 24);
+}
+
+/**
+ * @brief Reads a little-endian signed 32-bit value
+ * @param[in] buf: First byte of value
+ * @return Value
+ */
+static int32_t ubx_read_i32(const uint8_t* buf) {
+	return (int32_t) ubx_read_u32(buf);
+}
+
+/**
+ * @brief Writes a little-endian unsigned 16-bit value
+ * @param[out] buf: First byte of value
+ * @param[in] val: Value
+ */
+static void ubx_write_u16(uint8_t* buf, uint16_t val) {
+	buf[0] = (uint8_t) val;
+	buf[1] = (uint8_t) (val >> 8);
+}
+
+/**
+ * @brief Writes a little-endian unsigned 32-bit value
+ * @param[out] buf: First byte of value
+ * @param[in] val: Value
+ */
+static void ubx_write_u32(uint8_t* buf, uint32_t val) {
+	ubx_write_u16(buf, (uint16_t) val);
+	ubx_write_u16(&buf[2], (uint16_t) (val >> 16));
+}
+
+/**
+ * @brief Adds a byte to the running Fletcher checksum
+ * @param[in, out] parser: Parser
+ * @param[in] byte: Byte covered by checksum
+ */
+static void ubx_parser_checksum(ubx_parser_t* parser, uint8_t byte) {
+	parser->ck_a += byte;
+	parser->ck_b += parser->ck_a;
+}
+
+void ubx_parser_init(ubx_parser_t* parser) {
+	// Check user inputs
+	if (!parser) {
+		return;
+	}
+
+	parser->state = UBX_PARSE_SYNC_1;
+	parser->num_checksum_errors = 0;
+}
+
+bool ubx_parser_feed(ubx_parser_t* parser, uint8_t byte) {
+	// Check user inputs
+	if (!parser) {
+		return false;
+	}
+
+	switch (parser->state) {
+	case UBX_PARSE_SYNC_1:
+		if (byte == UBX_SYNC_CHAR_1) {
+			parser->state = UBX_PARSE_SYNC_2;
+		}
+		break;
+	case UBX_PARSE_SYNC_2:
+		// A repeated first sync char may still start a frame
+		parser->state = byte == UBX_SYNC_CHAR_2 ? UBX_PARSE_CLASS : byte == UBX_SYNC_CHAR_1 ? UBX_PARSE_SYNC_2 : UBX_PARSE_SYNC_1;
+		break;
+	case UBX_PARSE_CLASS:
+		parser->ck_a = 0;
+		parser->ck_b = 0;
+		ubx_parser_checksum(parser, byte);
+		parser->msg_class = byte;
+		parser->state = UBX_PARSE_ID;
+		break;
+	case UBX_PARSE_ID:
+		ubx_parser_checksum(parser, byte);
+		parser->msg_id = byte;
+		parser->state = UBX_PARSE_LENGTH_1;
+		break;
+	case UBX_PARSE_LENGTH_1:
+		ubx_parser_checksum(parser, byte);
+		parser->length = byte;
+		parser->state = UBX_PARSE_LENGTH_2;
+		break;
+	case UBX_PARSE_LENGTH_2:
+		ubx_parser_checksum(parser, byte);
+		parser->length |= (uint16_t) byte << 8;
+		parser->index = 0;
+		// Frames too long to hold are assumed to be noise or unneeded messages, so resynchronize
+		if (parser->length > UBX_MAX_PAYLOAD) {
+			parser->state = UBX_PARSE_SYNC_1;
+		} else {
+			parser->state = parser->length ? UBX_PARSE_PAYLOAD : UBX_PARSE_CHECKSUM_A;
+		}
+		break;
+	case UBX_PARSE_PAYLOAD:
+		ubx_parser_checksum(parser, byte);
+		parser->payload[parser->index++] = byte;
+		if (parser->index >= parser->length) {
+			parser->state = UBX_PARSE_CHECKSUM_A;
+		}
+		break;
+	case UBX_PARSE_CHECKSUM_A:
+		if (byte == parser->ck_a) {
+			parser->state = UBX_PARSE_CHECKSUM_B;
+		} else {
+			parser->num_checksum_errors++;
+			parser->state = UBX_PARSE_SYNC_1;
+		}
+		break;
+	case UBX_PARSE_CHECKSUM_B:
+		parser->state = UBX_PARSE_SYNC_1;
+		if (byte == parser->ck_b) {
+			return true;
+		}
+		parser->num_checksum_errors++;
+		break;
+	default:
+		parser->state = UBX_PARSE_SYNC_1;
+		break;
+	}
+	return false;
+}
+
+uint16_t ubx_parser_feed_bytes(ubx_parser_t* parser, const uint8_t* data, uint16_t len, bool* frame_done) {
+	// Check user inputs
+	if (!parser || !data || !frame_done) {
+		return 0;
+	}
+
+	*frame_done = false;
+	uint16_t i = 0;
+	while (i < len) {
+		if (parser->state == UBX_PARSE_PAYLOAD) {
+			// Payload is most of a frame, so handle as much of it as is here in one tight loop
+			uint16_t run = parser->length - parser->index;
+			if (run > len - i) {
+				run = len - i;
+			}
+			uint8_t ck_a = parser->ck_a;
+			uint8_t ck_b = parser->ck_b;
+			uint8_t* dst = &parser->payload[parser->index];
+			for (uint16_t j = 0; j < run; j++) {
+				ck_a += data[i + j];
+				ck_b += ck_a;
+				dst[j] = data[i + j];
+			}
+			parser->ck_a = ck_a;
+			parser->ck_b = ck_b;
+			parser->index += run;
+			i += run;
+			if (parser->index >= parser->length) {
+				parser->state = UBX_PARSE_CHECKSUM_A;
+			}
+		} else if (ubx_parser_feed(parser, data[i++])) {
+			*frame_done = true;
+			break;
+		}
+	}
+	return i;
+}
+
+bool ubx_decode_nav_pvt(const ubx_parser_t* parser, ubx_nav_pvt_t* pvt) {
+	// Check user inputs
+	if (!parser || !pvt || parser->msg_class != UBX_CLASS_NAV || parser->msg_id != UBX_ID_NAV_PVT
+			|| parser->length != UBX_NAV_PVT_PAYLOAD_LEN) {
+		return false;
+	}
+
+	// Offsets from the NAV-PVT payload description
+	const uint8_t* payload = parser->payload;
+	pvt->itow_ms = ubx_read_u32(&payload[0]);
+	pvt->fix_type = payload[20];
+	pvt->flags = payload[21];
+	pvt->num_satellites = payload[23];
+	pvt->lon_e7 = ubx_read_i32(&payload[24]);
+	pvt->lat_e7 = ubx_read_i32(&payload[28]);
+	pvt->height_mm = ubx_read_i32(&payload[32]);
+	pvt->height_msl_mm = ubx_read_i32(&payload[36]);
+	pvt->h_acc_mm = ubx_read_u32(&payload[40]);
+	pvt->v_acc_mm = ubx_read_u32(&payload[44]);
+	pvt->vel_n_mm_s = ubx_read_i32(&payload[48]);
+	pvt->vel_e_mm_s = ubx_read_i32(&payload[52]);
+	pvt->vel_d_mm_s = ubx_read_i32(&payload[56]);
+	pvt->ground_speed_mm_s = ubx_read_i32(&payload[60]);
+	pvt->head_motion_e5 = ubx_read_i32(&payload[64]);
+	pvt->speed_acc_mm_s = ubx_read_u32(&payload[68]);
+	return true;
+}
+
+uint16_t ubx_build_frame(uint8_t* frame, uint16_t frame_size, uint8_t msg_class, uint8_t msg_id, const uint8_t* payload, uint16_t len) {
+	// Check user inputs
+	if (!frame || (len && !payload) || frame_size < len + UBX_FRAME_OVERHEAD) {
+		return 0;
+	}
+
+	frame[0] = UBX_SYNC_CHAR_1;
+	frame[1] = UBX_SYNC_CHAR_2;
+	frame[2] = msg_class;
+	frame[3] = msg_id;
+	ubx_write_u16(&frame[4], len);
+	memcpy(&frame[6], payload, len);
+
+	uint8_t ck_a = 0;
+	uint8_t ck_b = 0;
+	for (uint16_t i = 2; i < len + 6; i++) {
+		ck_a += frame[i];
+		ck_b += ck_a;
+	}
+	frame[len + 6] = ck_a;
+	frame[len + 7] = ck_b;
+	return len + UBX_FRAME_OVERHEAD;
+}
+
+uint16_t ubx_build_cfg_prt_uart(uint8_t* frame, uint16_t frame_size, uint32_t baud_rate) {
+	uint8_t payload[UBX_CFG_PRT_PAYLOAD_LEN] = {0};
+	payload[0] = 1; // UART1
+	ubx_write_u32(&payload[4], 0x000008C0); // 8 data bits, no parity, 1 stop bit
+	ubx_write_u32(&payload[8], baud_rate);
+	ubx_write_u16(&payload[12], 0x0003); // In: UBX and NMEA
+	ubx_write_u16(&payload[14], 0x0001); // Out: UBX
+	return ubx_build_frame(frame, frame_size, UBX_CLASS_CFG, UBX_ID_CFG_PRT, payload, sizeof(payload));
+}
+
+uint16_t ubx_build_cfg_rate(uint8_t* frame, uint16_t frame_size, uint16_t meas_period_ms) {
+	uint8_t payload[UBX_CFG_RATE_PAYLOAD_LEN] = {0};
+	ubx_write_u16(&payload[0], meas_period_ms);
+	ubx_write_u16(&payload[2], 1); // One navigation solution per measurement
+	ubx_write_u16(&payload[4], 1); // GPS time
+	return ubx_build_frame(frame, frame_size, UBX_CLASS_CFG, UBX_ID_CFG_RATE, payload, sizeof(payload));
+}
+
+uint16_t ubx_build_cfg_msg(uint8_t* frame, uint16_t frame_size, uint8_t msg_class, uint8_t msg_id, uint8_t rate) {
+	uint8_t payload[UBX_CFG_MSG_PAYLOAD_LEN] = {msg_class, msg_id, rate};
+	return ubx_build_frame(frame, frame_size, UBX_CLASS_CFG, UBX_ID_CFG_MSG, payload, sizeof(payload));
+}
@@ -2,6 +2,11 @@
  * area_search_manager.h
  *
  * Creates an area for searching, consisting of pose destinations along the way.
+ *
+ * Destinations can be worked out one at a time as they're needed, or the whole search can be planned when the area is
+ * generated. A planned search is a table of legs, each a destination and an index into a handful of path shapes that
+ * every leg shares (along a pass, or turning onto the next pass either way), so the table costs 12 bytes a leg.
+ * Retrieving the next leg is then a table lookup and moving the shape into place, with no path planning or trig.
  */
 
 #ifndef INC_AREA_SEARCH_MANAGER_H_
@@ -13,6 +18,20 @@ extern "C" {
 
 #include <stdbool.h>
 #include "drive_constants.h"
+#include "dubins_path.h"
+
+#ifndef AREA_SEARCH_MAX_LEGS
+#define AREA_SEARCH_MAX_LEGS	2048 // Most legs a planned search holds. Bigger searches are planned a leg at a time
+#endif
+#define AREA_SEARCH_MAX_SHAPES	8 // Most distinct leg paths a planned search holds
+
+typedef struct area_search_leg_t {
+	pose2d_t destination;
+	dubins_path_t path; // Path from the last destination
+	double max_vel_mps; // Fastest speed the path can be driven at
+	bool line_complete; // Whether the leg turns onto another pass
+	bool gpr_stop; // Whether GPR is recorded at the destination
+} area_search_leg_t;
 
 /**
  * @brief Generates a rectangular area for the robot to search with a given number of passes and recording stops per pass.
@@ -22,8 +41,10 @@ extern "C" {
  * @param[in] num_passes: Number of passes to make across the area, assuming "there and back" is 2 passes
  * @param[in] stops_per_pass: Number of times to stop in each pass, excluding the ends
  * @param[in] start_pose: Starting pose for the area generation (where robot is facing when in bottom left corner)
+ * @param[in] precompute: Whether to plan every leg now (true) or work out destinations as they're needed (false)
+ * @param[in] record_while_driving: Whether GPR is recorded continuously along each pass (true) or only at stops (false)
  */
-void area_search_manager_generate_area(double width_m, double length_m, int num_passes, int stops_per_pass, pose2d_t start_pose);
+void area_search_manager_generate_area(double width_m, double length_m, int num_passes, int stops_per_pass, pose2d_t start_pose, bool precompute, bool record_while_driving);
 
 /**
  * @brief Returns the next pose the robot should stop at and tracks that the last pose was correctly hit
@@ -32,6 +53,25 @@ void area_search_manager_generate_area(double width_m, double length_m, int num_
  */
 pose2d_t area_search_manager_retrieve_next_destination(bool* line_complete);
 
+/**
+ * @brief Returns the next leg of a planned search and tracks that the last pose was correctly hit
+ * @param[out] leg: Next leg
+ * @return Whether there was a next leg (true) or not (false), either because the search wasn't planned or is complete
+ */
+bool area_search_manager_retrieve_next_leg(area_search_leg_t* leg);
+
+/**
+ * @brief Returns whether the next destination is along a pass that's recorded while driving, instead of a turn onto a pass
+ * or a stop to record at
+ */
+bool area_search_manager_next_is_recorded_line();
+
+/**
+ * @brief Skips the stops along the rest of the current pass, for recording while driving straight through them
+ * @return Pose of the end of the pass
+ */
+pose2d_t area_search_manager_retrieve_line_end();
+
 /**
  * @brief Returns whether whole area was searched
  */
@@ -0,0 +1,58 @@
+/*
+ * calibration_manager.h
+ *
+ * Keeps IMU calibration across power cycles, so heading is good from startup instead of after the BNO055 recalibrates
+ * Calibration is read at the first stop the state machine asks for it at once the IMU reports being fully calibrated, and
+ * appended as a versioned, CRC-checked record to a reserved flash sector. Reading stops fusion for about 600 ms, so it's
+ * never started while driving. The newest valid record is restored during IMU configuration.
+ * Records are only appended, so the sector is erased only once it's full, and only at startup.
+ */
+
+#ifndef INC_CALIBRATION_MANAGER_H_
+#define INC_CALIBRATION_MANAGER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "imu.h"
+
+/**
+ * @brief Restores the newest stored calibration to the IMU. Call between imu_init() and the first imu_init_step()
+ * @param[in, out] imu: IMU device
+ */
+void calibration_manager_init(imu_t* imu);
+
+/**
+ * @brief Tracks time until the IMU is fully calibrated, then reads and stores its calibration once a read is requested.
+ * Call every update, even without a new sample
+ * @param[in, out] imu: IMU device
+ * @param[in] sample: Latest IMU sample, NULL if there isn't one
+ */
+void calibration_manager_update(imu_t* imu, const imu_data_t* sample);
+
+/**
+ * @brief Starts reading calibration off the IMU if it's fully calibrated and hasn't been read yet. Call only while the
+ * robot is stopped, and keep it stopped until calibration_manager_is_reading() is false
+ */
+void calibration_manager_request_read();
+
+/**
+ * @brief Checks if calibration is being read off the IMU, which pauses IMU samples
+ * @return True if reading, false otherwise
+ */
+bool calibration_manager_is_reading();
+
+/**
+ * @brief Gets time from initialization until the IMU first reported being fully calibrated
+ * @return Time to calibrated in ms, 0 if not calibrated yet
+ */
+uint32_t calibration_manager_get_time_to_calibrated_ms();
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_CALIBRATION_MANAGER_H_ */
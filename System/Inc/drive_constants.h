@@ -9,7 +9,10 @@
 
 #define MAX_DRIVE_SPEED_MPS				1   // Maximum speed of the robot in m/s when driving both sides at full power
 #define MAX_DRIVE_ACCEL_MPSPS			1	// Maximum acceleration of robot in m/s^2 (used for planning, so may not be true dynamics)
+#define MAX_DRIVE_JERK_MPSPSPS			4	// Maximum rate of change of acceleration in m/s^3 when planning, so acceleration ramps instead of slipping the tracks
 #define WHEEL_BASE_M					0.2 // Wheel base of the robot in meters
+#define DRIVE_WHEEL_RADIUS_M			0.05 // Radius of the drive sprocket in meters
+#define ENCODER_TICKS_PER_REV			8192 // Quadrature ticks per sprocket revolution (2048 PPR x4)
 
 #define VOLTAGE_VELOCITY_SLOPE_LEFT		0
 #define VOLTAGE_VELOCITY_SLOPE_RIGHT	0
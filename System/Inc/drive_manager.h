@@ -24,6 +24,11 @@ typedef struct drive_state_estimation_t {
  */
 void drive_manager_init();
 
+/**
+ * @brief Enable drive manager so the drive control loop can command the motors
+ */
+void drive_manager_enable();
+
 /**
  * @brief Disable drive manager by ensuring motors aren't getting any input
  */
@@ -37,11 +42,17 @@ void drive_manager_disable();
 void drive_manager_change_setpoint(double forward_vel_mps, double turn_vel_radps);
 
 /**
- * @brief Runs a single instance of the drive control loop
+ * @brief Runs a single instance of the drive control loop. Does nothing while drive manager is disabled
  * @param[in] state: Subset of estimated robot state that drive manager needs to run feedback loop
  */
 void drive_manager_run(drive_state_estimation_t* state);
 
+/**
+ * @brief Gets the battery voltage last read by the drive control loop
+ * @return Battery voltage in volts, 0 if not read yet
+ */
+double drive_manager_get_battery_voltage();
+
 /**
  * @brief Controls robot motor speed with button press
  */
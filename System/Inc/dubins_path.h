@@ -0,0 +1,100 @@
+/*
+ * dubins_path.h
+ *
+ * Shortest paths between two poses for a robot that can't turn tighter than a minimum radius (Dubins paths)
+ * Every such path is three segments, each a left arc, a right arc, or a straight line, with the arcs at the minimum
+ * radius. Paths are kept as their segment lengths instead of sampled points, so a long survey line costs no more memory
+ * than a short one.
+ * Poses along a path and the closest point on a path to a pose are found analytically per segment.
+ * No hardware dependencies, so it also builds on a host.
+ */
+
+#ifndef INC_DUBINS_PATH_H_
+#define INC_DUBINS_PATH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "drive_constants.h"
+
+#define DUBINS_PATH_NUM_SEGMENTS	3
+
+typedef enum {
+	DUBINS_SEGMENT_LEFT,
+	DUBINS_SEGMENT_STRAIGHT,
+	DUBINS_SEGMENT_RIGHT
+} dubins_segment_t;
+
+typedef struct dubins_path_t {
+	pose2d_t start_poses[DUBINS_PATH_NUM_SEGMENTS]; // Pose at the start of each segment
+	dubins_segment_t segments[DUBINS_PATH_NUM_SEGMENTS];
+	double lengths_m[DUBINS_PATH_NUM_SEGMENTS];
+	double radius_m;
+} dubins_path_t;
+
+typedef struct dubins_path_projection_t {
+	double progress_m; // Distance along the path of the closest point
+	double lateral_error_m; // Signed distance from the closest point, positive to the left of the path
+	int segment; // Segment the closest point is on
+} dubins_path_projection_t;
+
+/**
+ * @brief Finds the shortest path between two poses with arcs no tighter than a turn radius
+ * @param[out] path: Path to fill in
+ * @param[in] start_pose: Pose to start from
+ * @param[in] end_pose: Pose to finish in
+ * @param[in] radius_m: Turn radius, greater than 0
+ * @return True if planned, false if inputs are invalid
+ */
+bool dubins_path_plan(dubins_path_t* path, pose2d_t start_pose, pose2d_t end_pose, double radius_m);
+
+/**
+ * @brief Gets the total length of a path
+ * @param[in] path: Path
+ * @return Length in meters
+ */
+double dubins_path_get_length(const dubins_path_t* path);
+
+/**
+ * @brief Checks whether a path turns at all, which limits the speed it can be driven at
+ * @param[in] path: Path
+ * @return True if any arc is longer than a millimeter
+ */
+bool dubins_path_has_arcs(const dubins_path_t* path);
+
+/**
+ * @brief Gets the pose a distance along a path. Distances past the end continue straight along the final heading
+ * @param[in] path: Path
+ * @param[in] progress_m: Distance along the path, clamped to be at least 0
+ * @return Pose at that distance
+ */
+pose2d_t dubins_path_sample(const dubins_path_t* path, double progress_m);
+
+/**
+ * @brief Finds the closest point on a path to a position, only searching from a segment onward so progress around a
+ * loop doesn't jump back to where the path crosses itself
+ * @param[in] path: Path
+ * @param[in] pose: Position to project
+ * @param[in] first_segment: Segment to start searching from
+ * @return Closest point. Progress before the start and past the end continues along the start and final headings
+ */
+dubins_path_projection_t dubins_path_project(const dubins_path_t* path, pose2d_t pose, int first_segment);
+
+/**
+ * @brief Moves a path planned from the origin facing along x so it starts at a pose instead. The heading's cosine and sine
+ * are given so callers that already have them cached don't pay for the trig
+ * @param[in, out] path: Path to move
+ * @param[in] origin: Pose to start the path at
+ * @param[in] cos_theta: Cosine of the origin's heading
+ * @param[in] sin_theta: Sine of the origin's heading
+ */
+void dubins_path_transform(dubins_path_t* path, pose2d_t origin, double cos_theta, double sin_theta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_DUBINS_PATH_H_ */
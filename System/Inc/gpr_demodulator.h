@@ -0,0 +1,63 @@
+/*
+ * gpr_demodulator.h
+ *
+ * Reduces each frequency step of a GPR sweep to one complex (I/Q) sample at the mixer's intermediate frequency
+ * Stepped-frequency processing only needs the echo's amplitude and phase at each step, which is a single bin of the
+ * step's spectrum. That bin is found with a Hann-windowed single-bin DFT against a table of window-weighted cosines and
+ * sines, built once for a sample count and reused for every step after. Quality metrics come out of the same pass.
+ * No hardware dependencies, so it also builds on a host.
+ */
+
+#ifndef INC_GPR_DEMODULATOR_H_
+#define INC_GPR_DEMODULATOR_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef GPR_DEMODULATOR_MAX_SAMPLES
+#define GPR_DEMODULATOR_MAX_SAMPLES	500
+#endif
+#define GPR_DEMODULATOR_ADC_MAX		4095 // Full scale of the 12-bit ADC
+
+typedef struct __attribute__((__packed__)) gpr_iq_t {
+	float i; // In-phase amplitude of the IF, in ADC counts
+	float q; // Quadrature amplitude of the IF, in ADC counts
+	uint16_t dc; // Mean sample, in ADC counts
+	uint8_t if_percent; // Share of the step's AC power that's at the IF. Low means noise or interference swamped the echo
+	uint8_t num_clipped; // Samples at either end of the ADC range, saturating at 255
+} gpr_iq_t;
+
+typedef struct gpr_demodulator_t {
+	float cos_table[GPR_DEMODULATOR_MAX_SAMPLES]; // Window * cos at the IF, scaled so a tone's amplitude comes out
+	float sin_table[GPR_DEMODULATOR_MAX_SAMPLES]; // Window * -sin at the IF, scaled the same way
+	float cos_sum; // Sums of the tables, to take the mean out of I and Q without a second pass
+	float sin_sum;
+	int num_samples;
+} gpr_demodulator_t;
+
+/**
+ * @brief Builds the window and IF tables for a sample count
+ * @param[out] demod: Demodulator to initialize
+ * @param[in] num_samples: Samples per step, 2 to GPR_DEMODULATOR_MAX_SAMPLES
+ * @param[in] if_cycles_per_sample: Intermediate frequency divided by the sampling rate, 0 to 0.5
+ * @return True if initialized, false if inputs are invalid
+ */
+bool gpr_demodulator_init(gpr_demodulator_t* demod, int num_samples, double if_cycles_per_sample);
+
+/**
+ * @brief Demodulates one frequency step
+ * @param[in] demod: Demodulator, initialized for this step's sample count
+ * @param[in] samples: Step's ADC samples
+ * @param[out] iq: I/Q sample and quality metrics of the step
+ */
+void gpr_demodulator_run(const gpr_demodulator_t* demod, const uint16_t* samples, gpr_iq_t* iq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_GPR_DEMODULATOR_H_ */
@@ -13,36 +13,92 @@ extern "C" {
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "drive_constants.h"
+#include "gpr_demodulator.h"
+
+#define GPR_MANAGER_ADC_SAMPLING_RATE_HZ	(1333333 + 1./3) // ADC_CLK / (Sampling Cycles + Resolution Cycles) = 24000000 / (3 + 15)
+#define GPR_MANAGER_IF_HZ					(GPR_MANAGER_ADC_SAMPLING_RATE_HZ / 2 * 0.9) // Nyquist frequency with 10% headroom to prevent aliasing
+
+typedef struct gpr_trace_info_t {
+	uint32_t trace_num; // Sweeps completed since initialization, so consumers can tell a new trace from one already read
+	uint32_t start_us; // When the sweep's first step started, from timestamp_get_us()
+	uint32_t end_us; // When the sweep's last step finished
+	pose2d_t pose; // Where the robot was during the sweep, if it was tagged
+	bool has_pose;
+} gpr_trace_info_t;
+
 /**
- * @brief Initializes the GPR hardware
+ * @brief Initializes the GPR hardware properties. Hardware isn't usable until gpr_manager_init_step() reports it's done
  */
 void gpr_manager_init();
 
+/**
+ * @brief Advances GPR hardware setup by one non-blocking step
+ * @return True once GPR hardware is set up, false if it should be called again
+ */
+bool gpr_manager_init_step();
+
 /**
  * @brief Record GPR data in a step frequency sweep through the given frequency ranges
+ * The sweep runs from interrupts at hardware speed: each step starts once the one before is captured and its pulse has
+ * ended, and the transmitter is programmed for the next step while the current one is still capturing
  * @param[in] start_freq_mhz: Frequency to start sweep at in MHz
  * @param[in] stop_freq_mhz: Frequency to stop sweep at
- * @param[in] num_steps: Number of steps in the frequency sweep
+ * @param[in] num_steps: Number of steps in the frequency sweep, including the start and stop frequencies (2 to 50)
  * @param[in] num_samples_per_step: How long to record in each frequency step
  */
 void gpr_manager_start_recording(double start_freq_mhz, double stop_freq, int num_steps, int num_samples_per_step);
 
 /**
- * @brief Continue the GPR manager recording
+ * @brief Checks on the GPR manager recording. The sweep advances on its own, so this doesn't need calling for it to finish
  * @return True if GPR is still recording, false if GPR recording is complete
  */
 bool gpr_manager_loop_recording();
 
 /**
  * @brief Get data from GPR manager. Must be called while no recording is in progress to complete successfully.
- * @param[out] data: Start address of data, in 2D array of length (num_steps, array_samples_per_step)
+ * @param[out] data: Start address of data, in 2D array of length (num_steps, array_samples_per_step). Samples are 12 bits, right aligned
  * @param[out] freqs_mhz: Frequencies (in MHz) matching up to each step in data
  * @param[out] actual_num_steps: Number of steps in data. Also, equals # of rows in data and length of freqs_mhz
  * @param[out] array_samples_per_step: Number of samples allocated in data array per step (length of row in data)
  * @param[out] actual_samples_per_step: Number of samples actually used in each data step (# of usable columns in data)
  * @return True if data retrieval was successful, False if failure (ie recording in progress)
  */
-bool gpr_manager_get_data(uint32_t** data, double** freqs_mhz, int* actual_num_steps, int* array_samples_per_step, int* actual_samples_per_step);
+bool gpr_manager_get_data(uint16_t** data, double** freqs_mhz, int* actual_num_steps, int* array_samples_per_step, int* actual_samples_per_step);
+
+/**
+ * @brief Get the most recent sweep reduced to one I/Q sample per step at the IF. Demodulated the first time it's asked for
+ * after a sweep, so raw data from gpr_manager_get_data() is still there if wanted
+ * @param[out] iq: Start address of I/Q samples, one per step
+ * @param[out] freqs_mhz: Frequencies (in MHz) matching up to each step
+ * @param[out] actual_num_steps: Number of steps
+ * @return True if retrieval was successful, false if a sweep hasn't completed yet, one is in progress, or its steps are
+ * too short to demodulate
+ */
+bool gpr_manager_get_iq(gpr_iq_t** iq, double** freqs_mhz, int* actual_num_steps);
+
+/**
+ * @brief Get the range profile (A-scan) of the most recent sweep, Hann-windowed and zero-padded to
+ * GPR_RANGE_PROFILE_MAX_POINTS. Bin k is at a delay of k / (num_points * step frequency). Synthesized the first time it's
+ * asked for after a sweep
+ * @param[out] magnitudes: Start address of the magnitude of each bin, in ADC counts
+ * @param[out] num_points: Number of bins
+ * @return True if retrieval was successful, false if I/Q samples of the sweep aren't available or it ended early
+ */
+bool gpr_manager_get_range_profile(float** magnitudes, int* num_points);
+
+/**
+ * @brief Tags the most recent sweep with where the robot was during it, for sweeps recorded while moving
+ * @param[in] pose: Pose of the robot during the sweep
+ */
+void gpr_manager_tag_pose(pose2d_t pose);
+
+/**
+ * @brief Gets when the most recent sweep was captured and where, matching the data from gpr_manager_get_data()
+ * @param[out] info: Trace info
+ * @return True if retrieval was successful, false if a sweep hasn't completed yet or one is in progress
+ */
+bool gpr_manager_get_trace_info(gpr_trace_info_t* info);
 
 #ifdef __cplusplus
 }
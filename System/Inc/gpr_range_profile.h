@@ -0,0 +1,76 @@
+/*
+ * gpr_range_profile.h
+ *
+ * Synthesizes a GPR range profile (A-scan) from the I/Q samples of a stepped-frequency sweep
+ * A reflector at delay t turns each step's phase by 2 * pi * f * t, so an inverse DFT across the steps puts it in the bin
+ * at t times the sweep's frequency step times the transform size. Steps are windowed and zero-padded to a power of two,
+ * then transformed in place by a radix-2 inverse FFT. Twiddles are built once for the largest transform, and the window
+ * and bit-reversed load order once per step count, so a profile needs no trig or heap.
+ * No hardware dependencies, so it also builds on a host.
+ */
+
+#ifndef INC_GPR_RANGE_PROFILE_H_
+#define INC_GPR_RANGE_PROFILE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gpr_demodulator.h"
+
+#ifndef GPR_RANGE_PROFILE_MAX_POINTS
+#define GPR_RANGE_PROFILE_MAX_POINTS	64 // Largest transform, a power of two no smaller than the most steps in a sweep
+#endif
+
+typedef enum gpr_range_window_t {
+	GprRangeWindowRectangular, // Narrowest peaks, but strong reflectors hide weak ones near them behind -13 dB sidelobes
+	GprRangeWindowHann // Peaks about twice as wide, sidelobes down to -31 dB
+} gpr_range_window_t;
+
+typedef struct gpr_complex_t {
+	float re;
+	float im;
+} gpr_complex_t;
+
+typedef struct gpr_range_profile_t {
+	gpr_complex_t twiddles[GPR_RANGE_PROFILE_MAX_POINTS / 2]; // e^(j * 2 * pi * k / GPR_RANGE_PROFILE_MAX_POINTS)
+	float window[GPR_RANGE_PROFILE_MAX_POINTS]; // Scaled so a reflector's amplitude at each step comes out as its peak
+	uint8_t load_order[GPR_RANGE_PROFILE_MAX_POINTS]; // Bit-reversed bin each step is loaded into
+	int num_steps;
+	int num_points;
+} gpr_range_profile_t;
+
+/**
+ * @brief Builds the twiddle, window, and load order tables for a sweep size
+ * @param[out] profile: Range profile to initialize
+ * @param[in] num_steps: Steps in each sweep, 1 to num_points
+ * @param[in] num_points: Transform size after zero-padding, a power of two from 2 to GPR_RANGE_PROFILE_MAX_POINTS
+ * @param[in] window: Window applied across the steps
+ * @return True if initialized, false if inputs are invalid
+ */
+bool gpr_range_profile_init(gpr_range_profile_t* profile, int num_steps, int num_points, gpr_range_window_t window);
+
+/**
+ * @brief Synthesizes the range profile of one sweep. Bin k is at a delay of k / (num_points * step frequency)
+ * @param[in] profile: Range profile, initialized for this sweep's step count
+ * @param[in] iq: I/Q sample of each step, from lowest frequency to highest
+ * @param[out] bins: Complex range profile, num_points long. Also the transform's working space
+ */
+void gpr_range_profile_run(const gpr_range_profile_t* profile, const gpr_iq_t* iq, gpr_complex_t* bins);
+
+/**
+ * @brief Takes the magnitude of each bin of a range profile
+ * @param[in] bins: Complex range profile
+ * @param[in] num_points: Bins in the profile
+ * @param[out] magnitudes: Magnitude of each bin, in ADC counts. May not alias bins
+ */
+void gpr_range_profile_magnitudes(const gpr_complex_t* bins, int num_points, float* magnitudes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_GPR_RANGE_PROFILE_H_ */
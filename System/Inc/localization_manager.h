@@ -3,7 +3,7 @@
  *
  * Gathers sensor data from encoders, GPS, and IMU if available
  * Tracks estimated robot pose, velocity, and uncertainty in those measurements
- * Updates estimated pose, velocity, and uncertainty with new sensor data using Kalman filtering
+ * Updates estimated pose, velocity, and uncertainty with new sensor data using a particle filter (see particle_filter.h)
  */
 
 #ifndef INC_LOCALIZATION_MANAGER_H_
@@ -45,13 +45,22 @@ typedef struct localization_estimate_t {
 	vector_3d vel;
 	vector_3d heading_zyx;
 	vector_3d ang_vel_zyx;
+	uint32_t num_particles; // Active particles after the last update
+	uint32_t update_us; // Time the last update took
+	uint32_t imu_time_to_calibrated_ms; // From initialization until the IMU first reported full calibration, 0 until then
 } localization_estimate_t;
 
 /**
- * @brief Initializes sensors internally
+ * @brief Initializes sensors internally and starts asynchronous sensors. IMU isn't usable until localization_manager_init_step() reports it's done
  */
 void localization_manager_init();
 
+/**
+ * @brief Advances sensor setup by one non-blocking step
+ * @return True once sensor setup is finished, false if it should be called again
+ */
+bool localization_manager_init_step();
+
 /**
  * @brief Enable the given sensors
  * @param[in] sensor_type: Type of the sensor to enable
@@ -65,12 +74,26 @@ void localization_manager_sensor_enable(localization_sensor_type_t sensor_type,
  */
 localization_estimate_t* localization_manager_update_estimates();
 
+/**
+ * @brief Returns current localization estimate without reading new sensor data
+ * @return Pointer to current localization estimate
+ */
+localization_estimate_t* localization_manager_get_estimate();
+
 /**
  * @brief Returns current localization manager estimate as a 2D "flattened" pose
  * @return Flattened 2D pose of localization estimate
  */
 pose2d_t localization_manager_estimate_to_pose2d();
 
+/**
+ * @brief Gets the estimated 2D pose at a recent time, interpolated between localization updates
+ * @param[in] timestamp_us: Time to get pose at, from timestamp_get_us(). Times after the last update get its pose
+ * @param[out] pose: Flattened 2D pose at that time
+ * @return True if found, false if the time is older than the pose history kept for fusing late measurements
+ */
+bool localization_manager_get_pose_at(uint32_t timestamp_us, pose2d_t* pose);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,134 @@
+/*
+ * loop_profiler.h
+ *
+ * Measures how long named stages of the scheduler loop take
+ * Timing uses the Cortex-M7 DWT cycle counter on target, or std::chrono (ns) when built on a host with LOOP_PROFILER_HOST defined
+ * Each probe keeps min/max/mean and a log2 histogram of its durations, which can be summarized compactly for telemetry
+ *
+ * Probes are only compiled in when LOOP_PROFILER_ENABLED is 1, which defaults to debug builds.
+ * Otherwise all LOOP_PROFILER_* macros expand to nothing and this module adds no code.
+ */
+
+#ifndef INC_LOOP_PROFILER_H_
+#define INC_LOOP_PROFILER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#ifndef LOOP_PROFILER_ENABLED
+#ifdef DEBUG
+#define LOOP_PROFILER_ENABLED 1
+#else
+#define LOOP_PROFILER_ENABLED 0
+#endif
+#endif
+
+#if LOOP_PROFILER_ENABLED && !defined(LOOP_PROFILER_HOST)
+#include "stm32f7xx_hal.h"
+#endif
+
+#define LOOP_PROFILER_HIST_BINS 16 // Bin i holds durations of [2^i, 2^(i+1)) us. Bin 0 also holds durations under 1 us
+
+typedef enum {
+	LOOP_PROFILER_PROBE_LOCALIZATION_UPDATE = 0,
+	LOOP_PROFILER_PROBE_TRAJECTORY_FOLLOW,
+	LOOP_PROFILER_PROBE_DRIVE_RUN,
+	LOOP_PROFILER_PROBE_IMU_READ,
+	LOOP_PROFILER_PROBE_GPS_READ,
+	LOOP_PROFILER_PROBE_RADIO_TRANSMIT,
+	NUM_LOOP_PROFILER_PROBES
+} loop_profiler_probe_t;
+
+typedef struct loop_profiler_stats_t {
+	uint32_t num_samples;
+	uint32_t min_counts;
+	uint32_t max_counts;
+	uint64_t total_counts;
+	uint32_t hist[LOOP_PROFILER_HIST_BINS];
+} loop_profiler_stats_t;
+
+/**
+ * Compact, telemetry-ready summary of one probe. Durations are in microseconds and saturate at UINT16_MAX
+ */
+typedef struct __attribute__((__packed__)) loop_profiler_probe_summary_t {
+	uint16_t num_samples;
+	uint16_t min_us;
+	uint16_t max_us;
+	uint16_t mean_us;
+	uint8_t hist[LOOP_PROFILER_HIST_BINS]; // Share of samples in each bin, where 255 is all samples
+} loop_profiler_probe_summary_t;
+
+typedef struct __attribute__((__packed__)) loop_profiler_summary_t {
+	loop_profiler_probe_summary_t probes[NUM_LOOP_PROFILER_PROBES];
+} loop_profiler_summary_t;
+
+#if LOOP_PROFILER_ENABLED
+
+#ifdef LOOP_PROFILER_HOST
+/**
+ * @brief Gets current profiler time
+ * @return Current time in counts (ns on host)
+ */
+uint32_t loop_profiler_now(void);
+#else
+/**
+ * @brief Gets current profiler time
+ * @return Current time in counts (CPU cycles on target)
+ */
+static inline uint32_t loop_profiler_now(void) {
+	return DWT->CYCCNT;
+}
+#endif
+
+/**
+ * @brief Starts the profiler timer and clears all probe statistics
+ */
+void loop_profiler_init(void);
+
+/**
+ * @brief Records a single duration for a probe
+ * @param[in] probe: Probe the duration belongs to
+ * @param[in] counts: Duration in profiler counts
+ */
+void loop_profiler_record(loop_profiler_probe_t probe, uint32_t counts);
+
+/**
+ * @brief Gets raw statistics of a probe
+ * @param[in] probe: Probe to get statistics of
+ * @return Pointer to probe statistics, NULL if probe doesn't exist
+ */
+const loop_profiler_stats_t* loop_profiler_get_stats(loop_profiler_probe_t probe);
+
+/**
+ * @brief Gets name of a probe
+ * @param[in] probe: Probe to get name of
+ * @return Name of probe, NULL if probe doesn't exist
+ */
+const char* loop_profiler_get_name(loop_profiler_probe_t probe);
+
+/**
+ * @brief Summarizes all probe statistics in microseconds and clears them to start a new measurement window
+ * @param[out] summary: Summary of all probes since last call
+ */
+void loop_profiler_take_summary(loop_profiler_summary_t* summary);
+
+#define LOOP_PROFILER_INIT() loop_profiler_init()
+#define LOOP_PROFILER_BEGIN(probe) uint32_t loop_profiler_start_##probe = loop_profiler_now()
+#define LOOP_PROFILER_END(probe) loop_profiler_record((probe), loop_profiler_now() - loop_profiler_start_##probe)
+
+#else
+
+#define LOOP_PROFILER_INIT()
+#define LOOP_PROFILER_BEGIN(probe)
+#define LOOP_PROFILER_END(probe)
+
+#endif /* LOOP_PROFILER_ENABLED */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_LOOP_PROFILER_H_ */
@@ -0,0 +1,72 @@
+/*
+ * motion_profile.h
+ *
+ * Jerk-limited (seven-segment S-curve) motion profiles from rest to rest, stored as a table of samples
+ * Segments are: jerk up, constant acceleration, jerk down, cruise, and the same mirrored to stop. Acceleration ramps at
+ * a limited jerk instead of stepping, so tracks don't slip at the start and end of a move.
+ * The profile is sampled at fixed time steps into a flat array of (position, velocity, acceleration). It's followed by
+ * position with a cursor that only moves forward, so each lookup is a step or two from the last instead of a search.
+ * No hardware dependencies, so it also builds on a host.
+ */
+
+#ifndef INC_MOTION_PROFILE_H_
+#define INC_MOTION_PROFILE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifndef MOTION_PROFILE_MAX_SAMPLES
+#define MOTION_PROFILE_MAX_SAMPLES	1024
+#endif
+#define MOTION_PROFILE_MIN_DT_S		0.01 // Sample period, stretched for moves too long to fit in the table
+
+typedef struct motion_profile_sample_t {
+	float pos;
+	float vel;
+	float accel;
+} motion_profile_sample_t;
+
+typedef struct motion_profile_t {
+	motion_profile_sample_t samples[MOTION_PROFILE_MAX_SAMPLES]; // Magnitudes, nondecreasing in position
+	uint32_t num_samples;
+	float dt_s; // Time between samples
+	float direction; // 1 or -1, applied to looked up samples
+	uint32_t cursor; // Sample at or before the last looked up position
+} motion_profile_t;
+
+/**
+ * @brief Generates a rest to rest profile covering a distance within velocity, acceleration, and jerk limits
+ * @param[out] profile: Profile to fill in
+ * @param[in] distance: Signed distance to move
+ * @param[in] max_vel: Velocity limit, greater than 0
+ * @param[in] max_accel: Acceleration limit, greater than 0
+ * @param[in] max_jerk: Jerk limit, greater than 0
+ * @return True if generated, false if limits are invalid
+ */
+bool motion_profile_generate(motion_profile_t* profile, double distance, double max_vel, double max_accel, double max_jerk);
+
+/**
+ * @brief Gets the profile one sample ahead of a position, so a robot at rest at the start is commanded to move.
+ * The cursor only moves forward, so positions that go backward are held at the furthest one looked up
+ * @param[in, out] profile: Profile
+ * @param[in] pos: Signed position along the profile
+ * @return Signed sample interpolated by position, the last sample once past the end
+ */
+motion_profile_sample_t motion_profile_lookup(motion_profile_t* profile, double pos);
+
+/**
+ * @brief Gets the total distance of a profile
+ * @param[in] profile: Profile
+ * @return Signed distance
+ */
+double motion_profile_get_distance(const motion_profile_t* profile);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_MOTION_PROFILE_H_ */
@@ -0,0 +1,51 @@
+/*
+ * odometry_manager.h
+ *
+ * Integrates differential drive odometry from both encoders at a fixed high rate in a timer interrupt
+ * Encoder counters are sampled every ODOMETRY_PERIOD_US, extended to 64 bits, and integrated into a pose with WHEEL_BASE_M.
+ * Wheel velocities come from hardware timestamps of encoder edges (see wheel_velocity.h), so they aren't quantized to
+ * whole ticks per loop at survey speeds.
+ * Each sample is published as a snapshot in one of two buffers. The interrupt writes the buffer the reader isn't
+ * pointed at, and the reader retries in the rare case it was preempted long enough for both to be rewritten, so neither side blocks.
+ */
+
+#ifndef INC_ODOMETRY_MANAGER_H_
+#define INC_ODOMETRY_MANAGER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "drive_constants.h"
+
+#define ODOMETRY_PERIOD_US		500 // Sample rate of 2 kHz, set by ODOMETRY_TIMER's prescaler and period
+
+typedef struct odometry_snapshot_t {
+	pose2d_t pose; // Integrated from encoders alone since initialization, theta counterclockwise
+	int64_t ticks_l;
+	int64_t ticks_r;
+	float vel_l_mps;
+	float vel_r_mps;
+	uint32_t timestamp_us; // Time encoders were sampled, from timestamp_get_us()
+} odometry_snapshot_t;
+
+/**
+ * @brief Zeroes the encoders and starts sampling them from ODOMETRY_TIMER's interrupt
+ */
+void odometry_manager_init();
+
+/**
+ * @brief Copies the newest published sample without blocking the interrupt that publishes them
+ * @param[out] snapshot: Newest sample
+ * @return True if copied, false if no sample has been published yet
+ */
+bool odometry_manager_get_snapshot(odometry_snapshot_t* snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_ODOMETRY_MANAGER_H_ */
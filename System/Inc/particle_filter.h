@@ -0,0 +1,209 @@
+/*
+ * particle_filter.h
+ *
+ * Fixed-capacity 3D particle filter (Probabilistic Robotics, pg. 95 onward) for robot pose
+ * Particles are stored as a structure of arrays, one contiguous float array per pose component, so the predict and
+ * weight loops run over plain arrays that the compiler can vectorize on a host and that stream well through the M7's single-precision FPU.
+ * Nothing here allocates, and resampling is O(N) and happens in place.
+ *
+ * Capacity is fixed at compile time with PARTICLE_FILTER_NUM_PARTICLES. Only the first num_particles of each array are active,
+ * and resampling can grow or shrink that set, e.g. to the size KLD-sampling asks for (Probabilistic Robotics, pg. 263 onward)
+ *
+ * Predict and weight also work on a range of particles at a time, so a caller with a time budget can check it between
+ * ranges and truncate the set to the particles it got through
+ */
+
+#ifndef INC_PARTICLE_FILTER_H_
+#define INC_PARTICLE_FILTER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#ifndef PARTICLE_FILTER_NUM_PARTICLES
+#define PARTICLE_FILTER_NUM_PARTICLES 1024
+#endif
+
+#if (PARTICLE_FILTER_NUM_PARTICLES & (PARTICLE_FILTER_NUM_PARTICLES - 1)) != 0
+#error "PARTICLE_FILTER_NUM_PARTICLES must be a power of 2"
+#endif
+
+#ifndef PARTICLE_FILTER_MIN_PARTICLES
+#define PARTICLE_FILTER_MIN_PARTICLES 64
+#endif
+
+#define PARTICLE_FILTER_KLD_TABLE_SIZE (2 * PARTICLE_FILTER_NUM_PARTICLES) // Open-addressed bin set, kept at most half full
+
+typedef struct pose3d_t {
+	float x;
+	float y;
+	float z;
+	float yaw;
+	float pitch;
+	float roll;
+} pose3d_t;
+
+// One odometry step, with the seeds of its noise drawn up front so each particle's noise only depends on its index
+typedef struct particle_filter_motion_t {
+	float distance_m;
+	float delta_yaw_rad;
+	float distance_std_m;
+	float yaw_std_rad;
+	float tilt_std_rad;
+	uint32_t seed_distance;
+	uint32_t seed_yaw;
+	uint32_t seed_pitch;
+	uint32_t seed_roll;
+} particle_filter_motion_t;
+
+typedef struct particle_filter_t {
+	float x[PARTICLE_FILTER_NUM_PARTICLES] __attribute__((aligned(16)));
+	float y[PARTICLE_FILTER_NUM_PARTICLES] __attribute__((aligned(16)));
+	float z[PARTICLE_FILTER_NUM_PARTICLES] __attribute__((aligned(16)));
+	float yaw[PARTICLE_FILTER_NUM_PARTICLES] __attribute__((aligned(16)));
+	float pitch[PARTICLE_FILTER_NUM_PARTICLES] __attribute__((aligned(16)));
+	float roll[PARTICLE_FILTER_NUM_PARTICLES] __attribute__((aligned(16)));
+	float weight[PARTICLE_FILTER_NUM_PARTICLES] __attribute__((aligned(16)));
+	uint16_t copies[PARTICLE_FILTER_NUM_PARTICLES]; // Scratch space for resampling
+	uint32_t kld_bins[PARTICLE_FILTER_KLD_TABLE_SIZE]; // Scratch space for counting occupied histogram bins
+	uint32_t num_particles; // Number of active particles
+	uint32_t seed; // Advanced on every random draw so each call gets fresh noise
+} particle_filter_t;
+
+/**
+ * @brief Spreads all PARTICLE_FILTER_NUM_PARTICLES particles around an initial pose with equal weight
+ * @param[out] pf: Particle filter to initialize
+ * @param[in] pose: Initial pose
+ * @param[in] pos_std_m: Standard deviation of initial position spread in meters
+ * @param[in] ang_std_rad: Standard deviation of initial angle spread in radians
+ * @param[in] seed: Seed for the filter's random numbers
+ */
+void particle_filter_init(particle_filter_t* pf, pose3d_t pose, float pos_std_m, float ang_std_rad, uint32_t seed);
+
+/**
+ * @brief Moves every particle by an odometry step with noise (motion model)
+ * @param[in, out] pf: Particle filter
+ * @param[in] distance_m: Distance driven along the robot's forward axis since last predict
+ * @param[in] delta_yaw_rad: Change in yaw since last predict (counterclockwise positive)
+ * @param[in] distance_std_m: Standard deviation of distance noise
+ * @param[in] yaw_std_rad: Standard deviation of yaw noise
+ * @param[in] tilt_std_rad: Standard deviation of pitch and roll random walk
+ */
+void particle_filter_predict(particle_filter_t* pf, float distance_m, float delta_yaw_rad, float distance_std_m, float yaw_std_rad, float tilt_std_rad);
+
+/**
+ * @brief Sets up an odometry step to predict a range of particles at a time with
+ * @param[in, out] pf: Particle filter (only the seed is advanced)
+ * @param[in] distance_m: Distance driven along the robot's forward axis since last predict
+ * @param[in] delta_yaw_rad: Change in yaw since last predict (counterclockwise positive)
+ * @param[in] distance_std_m: Standard deviation of distance noise
+ * @param[in] yaw_std_rad: Standard deviation of yaw noise
+ * @param[in] tilt_std_rad: Standard deviation of pitch and roll random walk
+ * @return Odometry step
+ */
+particle_filter_motion_t particle_filter_motion(particle_filter_t* pf, float distance_m, float delta_yaw_rad, float distance_std_m, float yaw_std_rad, float tilt_std_rad);
+
+/**
+ * @brief Moves a range of particles by an odometry step with noise. Predicting every range of the set with the same
+ * step gives the same particles as particle_filter_predict()
+ * @param[in, out] pf: Particle filter
+ * @param[in] motion: Odometry step from particle_filter_motion()
+ * @param[in] begin: First particle to move
+ * @param[in] end: One past the last particle to move, clamped to the active particle count
+ */
+void particle_filter_predict_range(particle_filter_t* pf, const particle_filter_motion_t* motion, uint32_t begin, uint32_t end);
+
+/**
+ * @brief Weighs particles by how well they match a horizontal position measurement
+ * @param[in, out] pf: Particle filter
+ * @param[in] x: Measured x position
+ * @param[in] y: Measured y position
+ * @param[in] std_m: Standard deviation of measurement in meters
+ */
+void particle_filter_weight_position(particle_filter_t* pf, float x, float y, float std_m);
+
+/**
+ * @brief Weighs a range of particles by how well they match a horizontal position measurement
+ * @param[in, out] pf: Particle filter
+ * @param[in] x: Measured x position
+ * @param[in] y: Measured y position
+ * @param[in] std_m: Standard deviation of measurement in meters
+ * @param[in] begin: First particle to weigh
+ * @param[in] end: One past the last particle to weigh, clamped to the active particle count
+ */
+void particle_filter_weight_position_range(particle_filter_t* pf, float x, float y, float std_m, uint32_t begin, uint32_t end);
+
+/**
+ * @brief Weighs particles by how well they match an orientation measurement
+ * @param[in, out] pf: Particle filter
+ * @param[in] yaw: Measured yaw
+ * @param[in] pitch: Measured pitch
+ * @param[in] roll: Measured roll
+ * @param[in] yaw_std_rad: Standard deviation of yaw measurement
+ * @param[in] tilt_std_rad: Standard deviation of pitch and roll measurements
+ */
+void particle_filter_weight_orientation(particle_filter_t* pf, float yaw, float pitch, float roll, float yaw_std_rad, float tilt_std_rad);
+
+/**
+ * @brief Weighs a range of particles by how well they match an orientation measurement
+ * @param[in, out] pf: Particle filter
+ * @param[in] yaw: Measured yaw
+ * @param[in] pitch: Measured pitch
+ * @param[in] roll: Measured roll
+ * @param[in] yaw_std_rad: Standard deviation of yaw measurement
+ * @param[in] tilt_std_rad: Standard deviation of pitch and roll measurements
+ * @param[in] begin: First particle to weigh
+ * @param[in] end: One past the last particle to weigh, clamped to the active particle count
+ */
+void particle_filter_weight_orientation_range(particle_filter_t* pf, float yaw, float pitch, float roll, float yaw_std_rad, float tilt_std_rad, uint32_t begin, uint32_t end);
+
+/**
+ * @brief Drops every particle past the first num_particles, e.g. ones there wasn't time to update. Weights must be
+ * normalized again afterward
+ * @param[in, out] pf: Particle filter
+ * @param[in] num_particles: Number of particles to keep, at least 1. Larger than the active count keeps them all
+ */
+void particle_filter_truncate(particle_filter_t* pf, uint32_t num_particles);
+
+/**
+ * @brief Normalizes weights to sum to 1. If all weights collapsed to 0, weights are reset to equal
+ * @param[in, out] pf: Particle filter
+ * @return Effective number of particles (1 / sum of squared weights)
+ */
+float particle_filter_normalize(particle_filter_t* pf);
+
+/**
+ * @brief Systematic (low-variance) resampling in O(N). Weights must be normalized. All weights are equal afterward
+ * @param[in, out] pf: Particle filter
+ * @param[in] num_particles: Number of active particles after resampling, clamped to [PARTICLE_FILTER_MIN_PARTICLES, PARTICLE_FILTER_NUM_PARTICLES]
+ */
+void particle_filter_resample(particle_filter_t* pf, uint32_t num_particles);
+
+/**
+ * @brief Number of particles KLD-sampling needs to represent the current particle set
+ *
+ * Particles are binned by x, y, and yaw. The more bins the set spreads over, the more particles are needed
+ * to keep the error of the sample-based approximation under epsilon with probability 1 - delta
+ * @param[in, out] pf: Particle filter (only scratch space is modified)
+ * @param[in] bin_size_m: Width of a position bin in meters
+ * @param[in] bin_size_rad: Width of a yaw bin in radians
+ * @param[in] epsilon: Maximum KL divergence between sampled and true distributions
+ * @param[in] z_quantile: Upper 1 - delta quantile of the standard normal distribution (e.g. 2.33 for delta = 0.01)
+ * @return Required particle count, clamped to [PARTICLE_FILTER_MIN_PARTICLES, PARTICLE_FILTER_NUM_PARTICLES]
+ */
+uint32_t particle_filter_kld_num_particles(particle_filter_t* pf, float bin_size_m, float bin_size_rad, float epsilon, float z_quantile);
+
+/**
+ * @brief Weighted mean pose of all particles. Weights must be normalized
+ * @param[in] pf: Particle filter
+ * @return Mean pose, with angles averaged on the circle
+ */
+pose3d_t particle_filter_estimate(const particle_filter_t* pf);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_PARTICLE_FILTER_H_ */
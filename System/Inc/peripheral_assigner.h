@@ -7,6 +7,9 @@
 
 #define ENCODER_LEFT_TIMER 					&htim3
 #define ENCODER_RIGHT_TIMER 				&htim4
+#define ENCODER_LEFT_CAPTURE_TIMER			&htim2
+#define ENCODER_RIGHT_CAPTURE_TIMER			&htim5
+#define ODOMETRY_TIMER						&htim6
 #define GPS_UART 							&huart2
 #define IMU_I2C								&hi2c2
 #define SIGNAL_GENERATOR_SPI				&hspi3
@@ -0,0 +1,63 @@
+/*
+ * pose_history.h
+ *
+ * Short history of timestamped pose estimates, so measurements that arrive late can be compared against
+ * the pose at the time they were captured instead of the current one
+ * Holds the last POSE_HISTORY_LENGTH poses, overwriting the oldest. No hardware dependencies, so it also builds on a host.
+ */
+
+#ifndef INC_POSE_HISTORY_H_
+#define INC_POSE_HISTORY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "particle_filter.h"
+
+#ifndef POSE_HISTORY_LENGTH
+#define POSE_HISTORY_LENGTH 64 // 640 ms at the 100 Hz localization rate
+#endif
+
+typedef struct pose_history_entry_t {
+	uint32_t timestamp_us;
+	pose3d_t pose;
+} pose_history_entry_t;
+
+typedef struct pose_history_t {
+	pose_history_entry_t entries[POSE_HISTORY_LENGTH];
+	uint32_t num_entries;
+	uint32_t newest; // Index of newest entry
+} pose_history_t;
+
+/**
+ * @brief Empties pose history
+ * @param[out] history: Pose history to initialize
+ */
+void pose_history_init(pose_history_t* history);
+
+/**
+ * @brief Adds a pose to the history. Timestamps must not go backward. A pose with the same timestamp as the newest replaces it
+ * @param[in, out] history: Pose history
+ * @param[in] timestamp_us: Time of pose
+ * @param[in] pose: Pose estimate at that time
+ */
+void pose_history_push(pose_history_t* history, uint32_t timestamp_us, pose3d_t pose);
+
+/**
+ * @brief Gets the pose at a time, interpolating between the poses around it
+ * @param[in] history: Pose history
+ * @param[in] timestamp_us: Time to get pose at. Times after the newest entry get the newest pose
+ * @param[out] pose: Pose at that time
+ * @return True if found, false if history is empty or the time is older than the oldest entry
+ */
+bool pose_history_get(const pose_history_t* history, uint32_t timestamp_us, pose3d_t* pose);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_POSE_HISTORY_H_ */
@@ -0,0 +1,96 @@
+/*
+ * rate_scheduler.h
+ *
+ * Tick-driven, multi-rate scheduler made of independent rate groups
+ * Each rate group has its own period and priority, and keeps overrun and deadline-miss counters
+ * When several groups are due on the same tick, the group with the lowest priority number runs first
+ * Groups don't preempt each other, so a task that runs long delays every other group. Tasks must not wait on hardware
+ *
+ * The scheduler never reads hardware directly. Time comes from a user-given clock and idle time is handed to a user-given idle function.
+ * On target these are HAL_GetTick() and __WFI(). On a host, a virtual clock can be given instead to benchmark release jitter.
+ */
+
+#ifndef INC_RATE_SCHEDULER_H_
+#define INC_RATE_SCHEDULER_H_
+
+#include <cstdint>
+
+typedef uint32_t (*rate_scheduler_clock_t)(void);
+typedef void (*rate_scheduler_idle_t)(void);
+typedef void (*rate_group_task_t)(void* context);
+
+typedef struct rate_group_stats_t {
+	uint32_t releases;			// Number of times the group's task was run
+	uint32_t overruns;			// Number of runs where the task took longer than the group period
+	uint32_t deadline_misses;	// Number of releases that finished after their deadline or were skipped entirely
+	uint32_t max_exec_ticks;	// Longest task execution time seen
+	uint32_t max_jitter_ticks;	// Longest delay between when a release was due and when it actually started
+} rate_group_stats_t;
+
+class RateScheduler {
+
+	public:
+		static constexpr int MAX_RATE_GROUPS = 8;
+
+		/**
+		 * @param[in] clock: Function returning the current time in ticks. Must wrap around at 2^32
+		 * @param[in] idle: Function called when no group is due. May be NULL to busy-wait
+		 */
+		RateScheduler(rate_scheduler_clock_t clock, rate_scheduler_idle_t idle): clock_(clock), idle_(idle) { }
+		~RateScheduler() = default;
+
+		/**
+		 * @brief Adds a new rate group to the scheduler. Group starts disabled
+		 * @param[in] name: Name of group for debugging/telemetry
+		 * @param[in] period_ticks: How often the group should run, in clock ticks (at least 1)
+		 * @param[in] priority: Priority of group when multiple are due (0 = highest)
+		 * @param[in] task: Function to run on each release of the group
+		 * @param[in] context: Argument passed to task on each release
+		 * @return ID of the new group, -1 if there's no room or inputs are invalid
+		 */
+		int add_group(const char* name, uint32_t period_ticks, uint8_t priority, rate_group_task_t task, void* context);
+
+		/**
+		 * @brief Enables or disables a rate group. Enabling a group makes its first release due immediately
+		 * @param[in] group_id: ID returned from add_group()
+		 * @param[in] b_enable: Whether to enable (true) or disable (false) the group
+		 */
+		void set_enabled(int group_id, bool b_enable);
+
+		/**
+		 * @brief Runs the highest-priority due group once, or idles if no group is due
+		 * @return True if a group was run, false if the scheduler idled
+		 */
+		bool run_once();
+
+		/**
+		 * @brief Gets timing statistics of a rate group
+		 * @param[in] group_id: ID returned from add_group()
+		 * @return Pointer to group statistics, NULL if group doesn't exist
+		 */
+		const rate_group_stats_t* get_stats(int group_id) const;
+
+		/**
+		 * @brief Resets timing statistics of all rate groups
+		 */
+		void reset_stats();
+
+	private:
+		typedef struct rate_group_t {
+			const char* name;
+			uint32_t period_ticks;
+			uint8_t priority;
+			bool enabled;
+			rate_group_task_t task;
+			void* context;
+			uint32_t next_release_tick;
+			rate_group_stats_t stats;
+		} rate_group_t;
+
+		rate_scheduler_clock_t clock_;
+		rate_scheduler_idle_t idle_;
+		rate_group_t groups_[MAX_RATE_GROUPS] = {};
+		int num_groups_ = 0;
+};
+
+#endif /* INC_RATE_SCHEDULER_H_ */
@@ -16,8 +16,11 @@ typedef enum {
 	InitializationComplete,
 	RecordingComplete,
 	SystemDisabled,
+	SurveyLineComplete,
+	SurveyLineReached,
 	SystemEnabled,
-	TrajectoryComplete
+	TrajectoryComplete,
+	NUM_END_STATUSES
 } end_status_t;
 
 class State {
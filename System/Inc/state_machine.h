@@ -0,0 +1,176 @@
+/*
+ * state_machine.h
+ *
+ * Primary state machine of the scheduler, defined as a list of (state, end status) -> next state transitions
+ * The list is expanded at compile time into a dense table indexed by [state][end status], so finding the next state is O(1).
+ * The list is also checked at compile time: every transition must be valid and unique, every state must be reachable
+ * from the Initialize state, and every state must have a way out.
+ *
+ * To add a state: add its ID to state_id, add its transitions to STATE_TRANSITIONS, and register its State object with StateMachine.
+ */
+
+#ifndef INC_STATE_MACHINE_H_
+#define INC_STATE_MACHINE_H_
+
+#include "state_interface.h"
+
+typedef enum state_id {
+	Disabled = 0,
+	Drive,
+	DriveRecord,
+	Initialize,
+	Record,
+	NUM_STATES,
+	UNKNOWN
+} state_id;
+
+typedef struct state_transition_t {
+	state_id from;
+	end_status_t end_status;
+	state_id to;
+} state_transition_t;
+
+/**
+ * All state changes. Any (state, end status) pair not listed here keeps the current state
+ */
+static constexpr state_transition_t STATE_TRANSITIONS[] = {
+	{state_id::Initialize,	end_status_t::InitializationComplete,	state_id::Disabled},
+	{state_id::Disabled,	end_status_t::SystemEnabled,			state_id::Drive},
+	{state_id::Drive,		end_status_t::SystemDisabled,			state_id::Disabled},
+	{state_id::Drive,		end_status_t::TrajectoryComplete,		state_id::Record},
+	{state_id::Drive,		end_status_t::SurveyLineReached,		state_id::DriveRecord},
+	{state_id::DriveRecord,	end_status_t::SurveyLineComplete,		state_id::Drive},
+	{state_id::DriveRecord,	end_status_t::SystemDisabled,			state_id::Disabled},
+	{state_id::Record,		end_status_t::RecordingComplete,		state_id::Drive},
+	{state_id::Record,		end_status_t::SystemDisabled,			state_id::Disabled},
+};
+static constexpr int NUM_STATE_TRANSITIONS = sizeof(STATE_TRANSITIONS) / sizeof(STATE_TRANSITIONS[0]);
+static constexpr state_id INITIAL_STATE = state_id::Initialize;
+
+typedef struct state_transition_table_t {
+	state_id next[NUM_STATES][NUM_END_STATUSES];
+} state_transition_table_t;
+
+/**
+ * @brief Expands STATE_TRANSITIONS into a dense table. NoChange maps to the current state, unlisted pairs to UNKNOWN
+ * @return Transition table indexed by [state][end status]
+ */
+constexpr state_transition_table_t state_machine_build_table() {
+	state_transition_table_t table = {};
+	for (int state = 0; state < NUM_STATES; state++) {
+		for (int end_status = 0; end_status < NUM_END_STATUSES; end_status++) {
+			table.next[state][end_status] = end_status == end_status_t::NoChange ? (state_id) state : state_id::UNKNOWN;
+		}
+	}
+	for (int i = 0; i < NUM_STATE_TRANSITIONS; i++) {
+		table.next[STATE_TRANSITIONS[i].from][STATE_TRANSITIONS[i].end_status] = STATE_TRANSITIONS[i].to;
+	}
+	return table;
+}
+
+/**
+ * @brief Checks every transition refers to real states and a real, non-NoChange end status
+ */
+constexpr bool state_machine_transitions_valid() {
+	for (int i = 0; i < NUM_STATE_TRANSITIONS; i++) {
+		const state_transition_t& transition = STATE_TRANSITIONS[i];
+		if (transition.from < 0 || transition.from >= NUM_STATES || transition.to < 0 || transition.to >= NUM_STATES
+				|| transition.end_status <= end_status_t::NoChange || transition.end_status >= NUM_END_STATUSES) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Checks no (state, end status) pair has more than one transition
+ */
+constexpr bool state_machine_transitions_unique() {
+	for (int i = 0; i < NUM_STATE_TRANSITIONS; i++) {
+		for (int j = i + 1; j < NUM_STATE_TRANSITIONS; j++) {
+			if (STATE_TRANSITIONS[i].from == STATE_TRANSITIONS[j].from && STATE_TRANSITIONS[i].end_status == STATE_TRANSITIONS[j].end_status) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Checks every state can be reached from the initial state
+ */
+constexpr bool state_machine_all_states_reachable() {
+	bool reached[NUM_STATES] = {};
+	reached[INITIAL_STATE] = true;
+	// Each pass reaches at least one new state or nothing changes, so NUM_STATES passes are enough
+	for (int pass = 0; pass < NUM_STATES; pass++) {
+		for (int i = 0; i < NUM_STATE_TRANSITIONS; i++) {
+			if (reached[STATE_TRANSITIONS[i].from]) {
+				reached[STATE_TRANSITIONS[i].to] = true;
+			}
+		}
+	}
+	for (int state = 0; state < NUM_STATES; state++) {
+		if (!reached[state]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @brief Checks every state has at least one transition to another state
+ */
+constexpr bool state_machine_all_states_exitable() {
+	for (int state = 0; state < NUM_STATES; state++) {
+		bool has_exit = false;
+		for (int i = 0; i < NUM_STATE_TRANSITIONS; i++) {
+			if (STATE_TRANSITIONS[i].from == state && STATE_TRANSITIONS[i].to != state) {
+				has_exit = true;
+			}
+		}
+		if (!has_exit) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static_assert(state_machine_transitions_valid(), "State transition refers to an undefined state or end status");
+static_assert(state_machine_transitions_unique(), "State transition defined more than once for the same state and end status");
+static_assert(state_machine_all_states_reachable(), "State is unreachable from the initial state");
+static_assert(state_machine_all_states_exitable(), "State has no transition out of it");
+
+class StateMachine {
+
+	public:
+		StateMachine() = default;
+		~StateMachine() = default;
+
+		/**
+		 * @brief Registers a state object so transitions to its ID resolve to it
+		 * @param[in] state: State to register. Its ID must be a valid state_id
+		 * @return True if registered, false if the ID is invalid or already registered
+		 */
+		bool register_state(State* state);
+
+		/**
+		 * @brief Gets the state object registered for an ID
+		 * @param[in] id: ID of state
+		 * @return Registered state, NULL if there is none
+		 */
+		State* get_state(state_id id) const;
+
+		/**
+		 * @brief Gets the next state based on the current state and its end status
+		 * @param[in] current_state: State that produced end status
+		 * @param[in] end_status: What the current state returned as its status
+		 * @return Next state. Current state if the transition is undefined or the next state isn't registered
+		 */
+		State* get_next_state(State* current_state, end_status_t end_status) const;
+
+	private:
+		State* states_[NUM_STATES] = {};
+};
+
+#endif /* INC_STATE_MACHINE_H_ */
@@ -11,15 +11,25 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "gpr_manager.h"
+
+#define TELEMETRY_NUM_SUBSYSTEMS	4 // Subsystems the Monitoring message reports time to ready for, in InitializeState::subsystem_t order
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /**
- * @brief Initialize telemetry manager and its underlying hardware
+ * @brief Initialize telemetry manager and its underlying hardware properties. Radio isn't usable until telemetry_manager_init_step() reports it's done
  */
 void telemetry_manager_init();
 
+/**
+ * @brief Advances radio setup by one non-blocking step
+ * @return True once radio is set up, false if it should be called again
+ */
+bool telemetry_manager_init_step();
+
 /**
  * @brief Telemeter relative robot pose to its initial position (when turned on)
  * @param pos_x: Estimated position in meters of the robot center relative to its starting position along its left-right axis (right positive)
@@ -48,19 +58,47 @@ bool telemetry_manager_send_absolute_pose(double longitude, double latitude, dou
  * @brief Telemeter GPR data at a specific frequency. This will maintain state unless restart parameter is passed or all data is completely sent
  * @param transmit_freq: Frequency in MHz of the signal that the GPR transmitter sent
  * @param mixer_ref_freq: Frequency in MHz of the reference signal the mixer was given to combine with the received signal
- * @param data_values: ADC inputs from the receiver
+ * @param data_values: ADC inputs from the receiver, as 12-bit samples in 16 bits each
  * @param data_len: Number of samples in data
  * @param restart: Whether the next incoming data is from a new set (true) or a continuation of an unfinished old set (false)
  * @return Whether send was successfully queued (true) or not (false). Main cause of failure is full transmit queue
  */
-bool telemetry_manager_send_gpr_data(double transmit_freq, double mixer_ref_freq, uint32_t* data_values, uint16_t data_len, bool restart);
+bool telemetry_manager_send_gpr_data(double transmit_freq, double mixer_ref_freq, uint16_t* data_values, uint16_t data_len, bool restart);
+
+/**
+ * @brief Telemeter a GPR sweep reduced to one I/Q sample per step, with where and when it was captured. This will maintain
+ * state unless restart parameter is passed or all data is completely sent
+ * @param trace: When and where the sweep was captured
+ * @param iq: I/Q samples from gpr_manager_get_iq(), which must stay unchanged until all are sent
+ * @param freqs_mhz: Frequencies in MHz of each step, evenly spaced
+ * @param num_steps: Number of steps in iq
+ * @param restart: Whether the next incoming data is from a new sweep (true) or a continuation of an unfinished old one (false)
+ * @return Whether the whole sweep has been queued (true) or not (false). Main cause of failure is full transmit queue
+ */
+bool telemetry_manager_send_gpr_iq(const gpr_trace_info_t* trace, const gpr_iq_t* iq, const double* freqs_mhz, uint8_t num_steps, bool restart);
+
+/**
+ * @brief Telemeter the range profile (A-scan) of a GPR sweep, with where and when it was captured. This will maintain state
+ * unless restart parameter is passed or all data is completely sent
+ * @param trace: When and where the sweep was captured
+ * @param magnitudes: Magnitude of each bin from gpr_manager_get_range_profile(), which must stay unchanged until all are sent
+ * @param num_points: Number of bins
+ * @param freqs_mhz: Frequencies in MHz of each step, evenly spaced, which set the delay of each bin
+ * @param num_steps: Number of steps in the sweep
+ * @param restart: Whether the next incoming data is from a new sweep (true) or a continuation of an unfinished old one (false)
+ * @return Whether the whole profile has been queued (true) or not (false). Main cause of failure is full transmit queue
+ */
+bool telemetry_manager_send_gpr_range_profile(const gpr_trace_info_t* trace, const float* magnitudes, uint8_t num_points, const double* freqs_mhz, uint8_t num_steps, bool restart);
 
 /**
- * @brief Telemeter data that helps monitor the robot
+ * @brief Telemeter data that helps monitor the robot, including counts of off-course recoveries and how long the last GPR sweep took
+ * When loop profiling is compiled in, a summary of loop stage timings since the last monitoring message is appended
  * @param battery_voltage: Voltage of battery
+ * @param imu_time_to_calibrated_ms: Time from startup until the IMU was fully calibrated, 0 if it isn't yet
+ * @param subsystem_time_to_ready_ms: Time from startup until each subsystem finished setup, TELEMETRY_NUM_SUBSYSTEMS long
  * @return Whether send was successfully queued (true) or not (false). Main cause of failure is full transmit queue
  */
-bool telemetry_manager_send_monitoring_data(double battery_voltage);
+bool telemetry_manager_send_monitoring_data(double battery_voltage, uint32_t imu_time_to_calibrated_ms, const uint32_t* subsystem_time_to_ready_ms);
 
 #ifdef __cplusplus
 }
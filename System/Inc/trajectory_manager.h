@@ -2,8 +2,10 @@
  * trajectory_manager.h
  *
  * Holds an active 2D trajectory for the robot to follow in the global x-y plane from its starting pose.
- * All trajectories consist of three parts: an in-place rotation phase, a drive phase, and another in-place rotation phase.
- * Trajectories can be generated here by providing a final pose and speed multiplier assuming the initial is at position (0, 0) and rotation 0.
+ * Trajectories are the shortest path of arcs and straight lines between the poses (see dubins_path.h), with arcs no tighter
+ * than a minimum turn radius, so the robot keeps moving through turns instead of stopping to rotate in place.
+ * Poses on the same line with the same heading give a single straight line, so survey lines stay straight.
+ * Trajectories can be generated here by providing a start pose, final pose and speed multiplier.
  *
  * Even though the robot may know its pose in 3D, the reference pose should be the robot's position and rotation as if it's in the 2D global x-y frame
  * This "flattening" allows the robot to plan through traverse hilly/bumpy terrain without knowing what the terrain is beforehand.
@@ -11,18 +13,22 @@
  * A trajectory can be followed, outputting setpoint velocity and angular velocity setpoints.
  * When the final pose of a trajectory is "close enough," the planning manager's check for completion will be set true.
  *
- * If the trajectory ever gets off track, it will try to return the robot to the last spot on the trajectory that was reached.
+ * If the trajectory ever gets off track, it will try to return the robot to the closest spot on the trajectory.
  * This off-trajectory behavior was chosen because traversing the full straight line generated is important for mapping.
  * If the trajectory is off-track, the planning manager will be able to tell the user.
  *
- * A trajectory consists of a set of (velocity, position) or (angular velocity, rotation) pairs.
- * Following the trajectory will produce a set of (velocity, angular velocity) setpoints based on current pose.
+ * Speed along the path is a jerk-limited motion profile (see motion_profile.h), a table of (position, velocity, acceleration)
+ * samples by distance along the path.
+ * Following the trajectory will produce a set of (velocity, angular velocity) setpoints based on current pose. Velocity is
+ * looked up by the closest point on the path, and angular velocity steers with pure pursuit towards a point a fixed
+ * distance further along it.
  * Feeding back on pose instead of time prevents the feedback controller from making the setpoints unreasonably high if the robot is having trouble moving.
- * The generated trajectory will respect all dynamics of the robot, most importantly acceleration. This makes sticking to the setpoint much more manageable.
+ * The generated trajectory will respect all dynamics of the robot, most importantly acceleration and its rate of change. This makes sticking to the setpoint much more manageable.
  *
  * When the trajectory does get off track, it will not just generate another trajectory to return to the correct position.
  * Since remaining in a straight line is no longer as important, the robot can simultaneously feedback on heading to the target and distance from the target.
- * Once it reaches target position, it can rotate to the correct heading.
+ * Once it reaches target position, it can rotate to the correct heading. The rest of the trajectory is then planned again
+ * from there so speed ramps up from rest. Each recovery is counted, along with how long it took and how far the robot drove.
  */
 
 #ifndef INC_TRAJECTORY_MANAGER_H_
@@ -33,8 +39,37 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "drive_constants.h"
+#include "dubins_path.h"
+
+typedef struct __attribute__((__packed__)) trajectory_recovery_stats_t {
+	uint16_t num_recoveries; // Times the robot went off course and drove back
+	uint32_t total_duration_ms; // Time spent recovering
+	uint32_t max_duration_ms; // Longest single recovery
+	float distance_m; // Distance driven while recovering
+} trajectory_recovery_stats_t;
+
+/**
+ * @brief Plans a path between two poses, without making it the active trajectory. Lets whole surveys be planned ahead
+ * @param[in] start_pose: Pose that the robot starts in
+ * @param[in] end_pose: Pose for the robot to finish in
+ * @param[out] path: Planned path
+ * @param[out] max_vel_mps: Fastest speed the path can be driven at
+ * @return Whether a path was planned (true) or not (false)
+ */
+bool trajectory_manager_plan_path(pose2d_t start_pose, pose2d_t end_pose, dubins_path_t* path, double* max_vel_mps);
+
+/**
+ * @brief Makes a planned path the active trajectory, canceling any previous one
+ * @param[in] path: Path from trajectory_manager_plan_path()
+ * @param[in] end_pose: Pose at the end of the path
+ * @param[in] max_vel_mps: Fastest speed from trajectory_manager_plan_path()
+ * @param[in] speed_multiplier: 0-1 value to scale maximum planned speed of robot
+ * @param[in] cur_pose: Current 2D pose of the robot, which may be a little short of the path's start
+ */
+void trajectory_manager_load_path(const dubins_path_t* path, pose2d_t end_pose, double max_vel_mps, double speed_multiplier, pose2d_t cur_pose);
 
 /**
  * @brief Calculates a new trajectory for the robot, canceling any previous one
@@ -50,10 +85,16 @@ void trajectory_manager_calculate_trajectory(pose2d_t start_pose, pose2d_t end_p
  * @param[out] forward_vel_mps: Setpoint for the robot's linear velocity in its own frame
  * @param[out] turn_vel_mps: Setpoint for the robot's angular velocity in its own frame
  * @param[out] complete: Whether trajectory is complete (true) or not (false)
- * @param[out] off_course: Whether robot is currently off-course from the trajectory (true) or on-course (false)
+ * @param[out] off_course: Whether robot is currently off-course from the trajectory and driving back to it (true) or on-course (false)
  */
 void trajectory_manager_follow_trajectory(pose2d_t cur_pose, double* forward_vel_mps, double* turn_vel_radps, bool* complete, bool* off_course);
 
+/**
+ * @brief Gets counts of off-course recoveries since startup. A recovery still in progress counts, but its duration doesn't yet
+ * @param[out] stats: Recovery stats
+ */
+void trajectory_manager_get_recovery_stats(trajectory_recovery_stats_t* stats);
+
 #ifdef __cplusplus
 }
 #endif
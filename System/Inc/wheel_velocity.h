@@ -0,0 +1,59 @@
+/*
+ * wheel_velocity.h
+ *
+ * Estimates wheel velocity from encoder edges captured with hardware timestamps (the M/T method)
+ * Velocity is the change in count between two captured edges divided by the exact time between them. The edges are
+ * at least WHEEL_VELOCITY_MIN_WINDOW_S apart, so at high speed many edges are counted in a short window and at low
+ * speed it's the period of a single edge, without quantizing to whole ticks per sample either way.
+ * While no edge arrives, velocity is capped by WHEEL_VELOCITY_DECAY_EDGES edges over the time since the last, so it decays toward a stop
+ * instead of holding the last value, and is zeroed after WHEEL_VELOCITY_STOP_S.
+ * No hardware dependencies, so it also builds on a host.
+ */
+
+#ifndef INC_WHEEL_VELOCITY_H_
+#define INC_WHEEL_VELOCITY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WHEEL_VELOCITY_MIN_WINDOW_S		0.008 // Shortest time between the edges velocity is measured over
+#define WHEEL_VELOCITY_STOP_S			0.1 // Time without an edge after which the wheel is stopped
+#define WHEEL_VELOCITY_DECAY_EDGES		1.5 // More than one edge, since edges aren't evenly spaced and one can come late at a steady speed
+
+typedef struct wheel_velocity_t {
+	uint32_t clock_hz; // Rate of the capture timer
+	uint32_t ticks_per_edge; // Encoder count change between captured edges
+	bool has_edge;
+	uint32_t ref_time; // Capture time of the edge velocity is measured from
+	int64_t ref_ticks;
+	uint32_t last_time; // Capture time of the newest edge
+	double ticks_per_s;
+} wheel_velocity_t;
+
+/**
+ * @brief Initializes a stopped wheel velocity estimate
+ * @param[out] wv: Estimator to initialize
+ * @param[in] clock_hz: Rate of the timer edges are captured with
+ * @param[in] ticks_per_edge: Encoder count change between captured edges (4 when capturing one edge of one channel of a x4 quadrature count)
+ */
+void wheel_velocity_init(wheel_velocity_t* wv, uint32_t clock_hz, uint32_t ticks_per_edge);
+
+/**
+ * @brief Updates velocity with the newest captured edge. Call at a steady rate, whether or not a new edge was captured
+ * @param[in, out] wv: Estimator
+ * @param[in] edge_time: Capture timer value at the newest edge
+ * @param[in] edge_ticks: Encoder count at the newest edge
+ * @param[in] now_time: Capture timer value now
+ * @return Velocity in encoder ticks per second
+ */
+double wheel_velocity_update(wheel_velocity_t* wv, uint32_t edge_time, int64_t edge_ticks, uint32_t now_time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_WHEEL_VELOCITY_H_ */
@@ -5,40 +5,62 @@
 #include "area_search_manager.h"
 
 #include <math.h>
+#include <stdint.h>
+
+#include "trajectory_manager.h"
 
 #define PI 3.14159265
 
+#define AREA_SEARCH_LEG_REVERSED	0x01 // Destination heading is opposite the start heading
+#define AREA_SEARCH_LEG_NEW_PASS	0x02 // Leg turns onto another pass
+#define AREA_SEARCH_LEG_GPR_STOP	0x04 // GPR is recorded at the destination
+
+#define AREA_SEARCH_SHAPE_TOLERANCE_M	1e-6 // Segment lengths closer than this are the same shape
+
+// Leg of a precomputed survey. The path there is one of a few shapes shared by all legs
+typedef struct area_search_plan_leg_t {
+	float x;
+	float y;
+	uint8_t shape;
+	uint8_t flags;
+} area_search_plan_leg_t;
+
+// Path planned from the origin facing along x, to be moved to the start of each leg using it
+typedef struct area_search_path_shape_t {
+	dubins_path_t path;
+	float max_vel_mps;
+} area_search_path_shape_t;
+
 static double area_width_m;
 static double area_length_m;
 static int area_num_passes;
 static int area_stops_per_pass;
 static pose2d_t area_start_pose;
 
-static int num_destinations_reached;
+static bool area_record_while_driving;
 
-void area_search_manager_generate_area(double width_m, double length_m, int num_passes, int stops_per_pass, pose2d_t start_pose) {
-	// Set trajectory values
-	area_width_m = width_m;
-	area_length_m = length_m;
-	area_num_passes = num_passes;
-	area_stops_per_pass = stops_per_pass;
-	area_start_pose = start_pose;
-	num_destinations_reached = 1;
-}
+static int num_destinations_reached;
 
-pose2d_t area_search_manager_retrieve_next_destination(bool* line_complete) {
+static area_search_plan_leg_t plan_legs[AREA_SEARCH_MAX_LEGS];
+static area_search_path_shape_t plan_shapes[AREA_SEARCH_MAX_SHAPES];
+static int num_plan_shapes;
+static bool plan_precomputed = false;
+static double heading_cos; // Of the start heading, so legs can be moved into place without trig
+static double heading_sin;
 
-	// Stop if area search area is complet
-	if (area_search_manager_is_complete()) {
-		*line_complete = true;
-		return;
-	}
+/**
+ * @brief Calculates a destination of the search
+ * @param[in] destination_num: Destination number, where 0 is the start
+ * @param[out] line_complete: Whether the destination is the first of a pass after the first
+ * @return Pose of the destination
+ */
+static pose2d_t area_search_manager_calculate_destination(int destination_num, bool* line_complete) {
 
 	// Calculate coordinates to go to in robot's original frame
-	int pass_number = num_destinations_reached / (area_stops_per_pass + 2);
+	int pass_number = destination_num / (area_stops_per_pass + 2);
 	double y_orig = pass_number * area_width_m / (area_num_passes - 1);
 
-	double stop_number = num_destinations_reached % (area_stops_per_pass + 2);
+	double stop_number = destination_num % (area_stops_per_pass + 2);
 	*line_complete = stop_number == 0; // Set line complete to true if next stop is first of the next pass
 	if (pass_number % 2 == 1) {
 		stop_number = (area_stops_per_pass + 1) - stop_number;
@@ -59,6 +81,167 @@ pose2d_t area_search_manager_retrieve_next_destination(bool* line_complete) {
 	return next_pose;
 }
 
+/**
+ * @brief Finds a matching path shape or adds a new one
+ * @param[in] path: Path planned from the origin facing along x
+ * @param[in] max_vel_mps: Fastest speed the path can be driven at
+ * @return Index of the shape, or -1 if there's no room for another
+ */
+static int area_search_manager_find_shape(const dubins_path_t* path, double max_vel_mps) {
+	for (int i = 0; i < num_plan_shapes; i++) {
+		const dubins_path_t* shape = &plan_shapes[i].path;
+		bool match = plan_shapes[i].max_vel_mps == (float) max_vel_mps;
+		for (int j = 0; j < DUBINS_PATH_NUM_SEGMENTS && match; j++) {
+			match = shape->segments[j] == path->segments[j] && fabs(shape->lengths_m[j] - path->lengths_m[j]) < AREA_SEARCH_SHAPE_TOLERANCE_M;
+		}
+		if (match) {
+			return i;
+		}
+	}
+	if (num_plan_shapes >= AREA_SEARCH_MAX_SHAPES) {
+		return -1;
+	}
+	plan_shapes[num_plan_shapes].path = *path;
+	plan_shapes[num_plan_shapes].max_vel_mps = (float) max_vel_mps;
+	return num_plan_shapes++;
+}
+
+/**
+ * @brief Plans every leg of the search into the leg table
+ * @return Whether the whole search fit in the table (true) or not (false)
+ */
+static bool area_search_manager_precompute() {
+	int num_legs = (area_stops_per_pass + 2) * area_num_passes - 1;
+	if (num_legs > AREA_SEARCH_MAX_LEGS) {
+		return false;
+	}
+
+	num_plan_shapes = 0;
+	bool line_complete;
+	pose2d_t last_pose = area_search_manager_calculate_destination(0, &line_complete);
+	for (int i = 0; i < num_legs; i++) {
+		pose2d_t next_pose = area_search_manager_calculate_destination(i + 1, &line_complete);
+
+		// Plan in the frame of the last destination, so legs that look the same from where they start share a shape
+		double dx = next_pose.x - last_pose.x;
+		double dy = next_pose.y - last_pose.y;
+		double c = cos(last_pose.theta);
+		double s = sin(last_pose.theta);
+		pose2d_t origin = {0, 0, 0};
+		pose2d_t relative_pose = {dx * c + dy * s, -dx * s + dy * c, next_pose.theta - last_pose.theta};
+		dubins_path_t path;
+		double max_vel_mps;
+		if (!trajectory_manager_plan_path(origin, relative_pose, &path, &max_vel_mps)) {
+			return false;
+		}
+		int shape = area_search_manager_find_shape(&path, max_vel_mps);
+		if (shape < 0) {
+			return false;
+		}
+
+		plan_legs[i].x = (float) next_pose.x;
+		plan_legs[i].y = (float) next_pose.y;
+		plan_legs[i].shape = (uint8_t) shape;
+		plan_legs[i].flags = area_record_while_driving ? 0 : AREA_SEARCH_LEG_GPR_STOP;
+		if (next_pose.theta != area_start_pose.theta) {
+			plan_legs[i].flags |= AREA_SEARCH_LEG_REVERSED;
+		}
+		if (line_complete) {
+			plan_legs[i].flags |= AREA_SEARCH_LEG_NEW_PASS;
+		}
+		last_pose = next_pose;
+	}
+	return true;
+}
+
+/**
+ * @brief Gets a destination from the leg table
+ * @param[in] leg_num: Leg number
+ * @return Pose of the destination
+ */
+static pose2d_t area_search_manager_plan_destination(int leg_num) {
+	pose2d_t pose = {plan_legs[leg_num].x, plan_legs[leg_num].y, area_start_pose.theta};
+	if (plan_legs[leg_num].flags & AREA_SEARCH_LEG_REVERSED) {
+		pose.theta += pose.theta > 0 ? -PI : PI;
+	}
+	return pose;
+}
+
+/**
+ * @brief Checks whether the next destination is the first of a pass, so getting there means turning onto it
+ * @return True if the next destination starts a pass
+ */
+static bool area_search_manager_next_starts_pass() {
+	return num_destinations_reached % (area_stops_per_pass + 2) == 0;
+}
+
+void area_search_manager_generate_area(double width_m, double length_m, int num_passes, int stops_per_pass, pose2d_t start_pose, bool precompute, bool record_while_driving) {
+	// Set trajectory values
+	area_width_m = width_m;
+	area_length_m = length_m;
+	area_num_passes = num_passes;
+	area_stops_per_pass = stops_per_pass;
+	area_start_pose = start_pose;
+	area_record_while_driving = record_while_driving;
+	num_destinations_reached = 1;
+	heading_cos = cos(start_pose.theta);
+	heading_sin = sin(start_pose.theta);
+
+	// Plan everything now if asked to. Searches too big for the table are planned a leg at a time instead
+	plan_precomputed = precompute && area_search_manager_precompute();
+}
+
+pose2d_t area_search_manager_retrieve_next_destination(bool* line_complete) {
+
+	// Stop if area search area is complete
+	if (area_search_manager_is_complete()) {
+		*line_complete = true;
+		return area_start_pose;
+	}
+
+	return area_search_manager_calculate_destination(num_destinations_reached++, line_complete);
+}
+
+bool area_search_manager_retrieve_next_leg(area_search_leg_t* leg) {
+	// Check user input
+	if (!leg || !plan_precomputed || area_search_manager_is_complete()) {
+		return false;
+	}
+
+	// Move the leg's shape to start at the last destination. Headings are only ever the start heading or opposite it, so
+	// their cosine and sine are known already
+	int leg_num = num_destinations_reached - 1;
+	pose2d_t last_pose = area_start_pose;
+	double heading_sign = 1;
+	if (leg_num > 0) {
+		last_pose = area_search_manager_plan_destination(leg_num - 1);
+		heading_sign = plan_legs[leg_num - 1].flags & AREA_SEARCH_LEG_REVERSED ? -1 : 1;
+	}
+	leg->destination = area_search_manager_plan_destination(leg_num);
+	leg->path = plan_shapes[plan_legs[leg_num].shape].path;
+	dubins_path_transform(&leg->path, last_pose, heading_sign * heading_cos, heading_sign * heading_sin);
+	leg->max_vel_mps = plan_shapes[plan_legs[leg_num].shape].max_vel_mps;
+	leg->line_complete = plan_legs[leg_num].flags & AREA_SEARCH_LEG_NEW_PASS;
+	leg->gpr_stop = plan_legs[leg_num].flags & AREA_SEARCH_LEG_GPR_STOP;
+
+	num_destinations_reached++;
+	return true;
+}
+
+bool area_search_manager_next_is_recorded_line() {
+	return area_record_while_driving && !area_search_manager_is_complete() && !area_search_manager_next_starts_pass();
+}
+
+pose2d_t area_search_manager_retrieve_line_end() {
+	// Skip the stops along the rest of the pass. The last one before the next pass starts is its end
+	pose2d_t line_end = area_start_pose;
+	bool line_complete;
+	do {
+		line_end = area_search_manager_calculate_destination(num_destinations_reached++, &line_complete);
+	} while (!area_search_manager_is_complete() && !area_search_manager_next_starts_pass());
+	return line_end;
+}
+
 bool area_search_manager_is_complete() {
 	// 2 intermediate stops per pass * number of passes
 	return num_destinations_reached >= (area_stops_per_pass + 2) * area_num_passes;
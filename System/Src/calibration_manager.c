@@ -0,0 +1,193 @@
+/*
+ * calibration_manager.c
+ */
+
+#include "calibration_manager.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define CALIBRATION_FLASH_SECTOR	FLASH_SECTOR_11 // Must match the CALIBRATION region in the linker script
+#define CALIBRATION_MAGIC			0x43414c42 // "CALB"
+#define CALIBRATION_VERSION			1 // Bump when the record layout or the meaning of the stored registers changes
+#define FLASH_ERASED_WORD			0xFFFFFFFF
+
+typedef struct calibration_record_t {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t len;
+	imu_calibration_t calibration;
+	uint8_t reserved[2]; // Keeps the record a whole number of words
+	uint32_t crc; // CRC-32 of everything before it
+} calibration_record_t;
+
+_Static_assert(sizeof(calibration_record_t) % sizeof(uint32_t) == 0, "Calibration records are programmed a word at a time");
+
+// Bounds of the reserved flash sector, from the linker script
+extern uint8_t _scalibration;
+extern uint8_t _ecalibration;
+
+typedef enum {
+	CALIBRATION_WAITING = 0,	// IMU not fully calibrated yet
+	CALIBRATION_PENDING,		// Fully calibrated, waiting for the robot to stop
+	CALIBRATION_READING,		// Reading calibration off the IMU
+	CALIBRATION_DONE			// Stored, or nothing new to store, this power cycle
+} calibration_state_t;
+
+static calibration_state_t state;
+static bool was_restored;
+static imu_calibration_t restored_calibration;
+static uint32_t init_ms;
+static uint32_t time_to_calibrated_ms;
+
+/**
+ * @brief Calculates CRC-32 (IEEE 802.3) of a buffer
+ * @param[in] data: Buffer
+ * @param[in] len: Length of buffer
+ * @return CRC
+ */
+static uint32_t calibration_manager_crc32(const uint8_t* data, uint32_t len) {
+	uint32_t crc = 0xFFFFFFFF;
+	for (uint32_t i = 0; i < len; i++) {
+		crc ^= data[i];
+		for (int bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+/**
+ * @brief Checks a record's magic number, version, length, and CRC
+ * @param[in] record: Record in flash
+ * @return True if valid, false otherwise
+ */
+static bool calibration_manager_is_valid(const calibration_record_t* record) {
+	return record->magic == CALIBRATION_MAGIC && record->version == CALIBRATION_VERSION
+			&& record->len == sizeof(imu_calibration_t)
+			&& record->crc == calibration_manager_crc32((const uint8_t*) record, offsetof(calibration_record_t, crc));
+}
+
+/**
+ * @brief Finds the newest valid record and the first unwritten slot
+ * @param[out] newest: Newest valid record, NULL if none
+ * @return First unwritten slot, NULL if the sector is full
+ */
+static calibration_record_t* calibration_manager_scan(const calibration_record_t** newest) {
+	*newest = NULL;
+	for (uint8_t* addr = &_scalibration; addr + sizeof(calibration_record_t) <= &_ecalibration; addr += sizeof(calibration_record_t)) {
+		calibration_record_t* record = (calibration_record_t*) addr;
+		if (record->magic == FLASH_ERASED_WORD) {
+			return record;
+		}
+		// Records cut off by a power loss fail their CRC and are skipped
+		if (calibration_manager_is_valid(record)) {
+			*newest = record;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Programs a record into an unwritten slot
+ * @param[in] slot: Unwritten slot in flash
+ * @param[in] calibration: Calibration to store
+ * @return True if programmed and valid, false otherwise
+ */
+static bool calibration_manager_program(calibration_record_t* slot, const imu_calibration_t* calibration) {
+	calibration_record_t record = {0};
+	record.magic = CALIBRATION_MAGIC;
+	record.version = CALIBRATION_VERSION;
+	record.len = sizeof(imu_calibration_t);
+	record.calibration = *calibration;
+	record.crc = calibration_manager_crc32((const uint8_t*) &record, offsetof(calibration_record_t, crc));
+
+	// Programming a few words only stalls flash reads for microseconds, unlike erasing
+	const uint32_t* words = (const uint32_t*) &record;
+	bool success = HAL_FLASH_Unlock() == HAL_OK;
+	for (uint32_t i = 0; success && i < sizeof(record) / sizeof(uint32_t); i++) {
+		success = HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, (uint32_t) slot + i * sizeof(uint32_t), words[i]) == HAL_OK;
+	}
+	HAL_FLASH_Lock();
+	return success && calibration_manager_is_valid(slot);
+}
+
+/**
+ * @brief Erases the calibration sector. Stalls the CPU for up to a few seconds, since code runs from the same flash bank
+ * @return True if erased, false otherwise
+ */
+static bool calibration_manager_erase() {
+	FLASH_EraseInitTypeDef erase = {0};
+	erase.TypeErase = FLASH_TYPEERASE_SECTORS;
+	erase.Sector = CALIBRATION_FLASH_SECTOR;
+	erase.NbSectors = 1;
+	erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+	uint32_t sector_error;
+	bool success = HAL_FLASH_Unlock() == HAL_OK && HAL_FLASHEx_Erase(&erase, &sector_error) == HAL_OK;
+	HAL_FLASH_Lock();
+	return success;
+}
+
+void calibration_manager_init(imu_t* imu) {
+	state = CALIBRATION_WAITING;
+	was_restored = false;
+	init_ms = HAL_GetTick();
+	time_to_calibrated_ms = 0;
+
+	const calibration_record_t* newest;
+	calibration_record_t* slot = calibration_manager_scan(&newest);
+	if (newest) {
+		restored_calibration = newest->calibration;
+		was_restored = true;
+		imu_set_stored_calibration(imu, &restored_calibration);
+	}
+
+	// Full sector only happens after thousands of saves. Make room now rather than stalling while driving
+	if (!slot && calibration_manager_erase() && was_restored) {
+		calibration_manager_program((calibration_record_t*) &_scalibration, &restored_calibration);
+	}
+}
+
+void calibration_manager_update(imu_t* imu, const imu_data_t* sample) {
+	if (sample && !time_to_calibrated_ms && imu_is_fully_calibrated(sample)) {
+		time_to_calibrated_ms = HAL_GetTick() - init_ms;
+		if (!time_to_calibrated_ms) {
+			time_to_calibrated_ms = 1;
+		}
+		state = CALIBRATION_PENDING;
+	}
+
+	// Reading takes the IMU out of fusion for a moment, so it's only done once per power cycle, when the robot is stopped
+	if (state != CALIBRATION_READING) {
+		return;
+	}
+	imu_calibration_t calibration;
+	bool success;
+	if (!imu_read_calibration_step(imu, &calibration, &success)) {
+		return;
+	}
+	state = CALIBRATION_DONE;
+	if (!success || (was_restored && !memcmp(&calibration, &restored_calibration, sizeof(calibration)))) {
+		return;
+	}
+
+	const calibration_record_t* newest;
+	calibration_record_t* slot = calibration_manager_scan(&newest);
+	if (slot) {
+		calibration_manager_program(slot, &calibration);
+	}
+}
+
+void calibration_manager_request_read() {
+	if (state == CALIBRATION_PENDING) {
+		state = CALIBRATION_READING;
+	}
+}
+
+bool calibration_manager_is_reading() {
+	return state == CALIBRATION_READING;
+}
+
+uint32_t calibration_manager_get_time_to_calibrated_ms() {
+	return time_to_calibrated_ms;
+}
@@ -42,6 +42,8 @@ static double setpoint_forward_vel_mps = 0;
 static double setpoint_turn_vel_radps = 0;
 static double setpoint_heading_rad = 0;
 static bool use_next_heading_as_target = false; // Whether next incoming heading should be used to determine the target
+static bool is_enabled = false; // Whether the drive control loop may command the motors
+static double last_battery_voltage = 0;
 
 static double demo_motor_percent = 0;
 static bool demo_motor_dir_forward = true;
@@ -79,7 +81,20 @@ void drive_manager_init() {
 	pid_controller_set_pid(&pid_ctrl_heading, DEFAULT_KP_HEADING, DEFAULT_KI_HEADING, DEFAULT_KD_HEADING);
 }
 
+void drive_manager_enable() {
+	// Start from rest so stale setpoints and PID state aren't applied
+	setpoint_forward_vel_mps = 0;
+	setpoint_turn_vel_radps = 0;
+	use_next_heading_as_target = true;
+	pid_controller_reset(&pid_ctrl_vel_wheel_l);
+	pid_controller_reset(&pid_ctrl_vel_wheel_r);
+	pid_controller_reset(&pid_ctrl_heading);
+	is_enabled = true;
+}
+
 void drive_manager_disable() {
+	is_enabled = false;
+
 	// Set motor percentages to 0
 	motor_set_percentage(&motor_l, 0);
 	motor_set_percentage(&motor_r, 0);
@@ -153,6 +168,11 @@ void drive_manager_change_setpoint(double forward_vel_mps, double turn_vel_radps
 
 void drive_manager_run(drive_state_estimation_t* state) {
 
+	// Motors must not be commanded while disabled
+	if (!is_enabled) {
+		return;
+	}
+
 	// Start battery voltage conversion
 	voltage_monitor_start_read(&voltage_monitor);
 
@@ -186,7 +206,10 @@ void drive_manager_run(drive_state_estimation_t* state) {
 
 	// Retrieve battery voltage
 	double battery_voltage;
-	voltage_monitor_get_voltage(&voltage_monitor, &battery_voltage);
+	if (voltage_monitor_get_voltage(&voltage_monitor, &battery_voltage)) {
+		last_battery_voltage = battery_voltage;
+	}
+	battery_voltage = last_battery_voltage;
 
 	// Convert control wheel velocity setpoints to motor percentages
 	double motor_percent_l;
@@ -198,6 +221,10 @@ void drive_manager_run(drive_state_estimation_t* state) {
 	motor_set_percentage(&motor_r, motor_percent_r);
 }
 
+double drive_manager_get_battery_voltage() {
+	return last_battery_voltage;
+}
+
 void drive_manager_run_demo() {
 	if (button_is_pressed(&user_button)) {
 		if (fabs(demo_motor_percent) >= 1 - DEMO_MOTOR_PERCENT_INCREASE / 2) {
@@ -0,0 +1,330 @@
+/*
+ * dubins_path.c
+ */
+
+#include "dubins_path.h"
+
+#include <float.h>
+#include <math.h>
+#include <stddef.h>
+
+#define PI 3.14159265358979
+
+#define NUM_PATH_TYPES 6
+
+#define DUBINS_PATH_MIN_ARC_M 1e-3 // Shorter arcs are rounding in headings that should match, not real turns
+
+static const dubins_segment_t path_types[NUM_PATH_TYPES][DUBINS_PATH_NUM_SEGMENTS] = {
+		{DUBINS_SEGMENT_LEFT, DUBINS_SEGMENT_STRAIGHT, DUBINS_SEGMENT_LEFT},
+		{DUBINS_SEGMENT_LEFT, DUBINS_SEGMENT_STRAIGHT, DUBINS_SEGMENT_RIGHT},
+		{DUBINS_SEGMENT_RIGHT, DUBINS_SEGMENT_STRAIGHT, DUBINS_SEGMENT_LEFT},
+		{DUBINS_SEGMENT_RIGHT, DUBINS_SEGMENT_STRAIGHT, DUBINS_SEGMENT_RIGHT},
+		{DUBINS_SEGMENT_RIGHT, DUBINS_SEGMENT_LEFT, DUBINS_SEGMENT_RIGHT},
+		{DUBINS_SEGMENT_LEFT, DUBINS_SEGMENT_RIGHT, DUBINS_SEGMENT_LEFT}
+};
+
+/**
+ * @brief Wraps an angle to [0, 2 PI), treating angles within rounding of 0 or 2 PI as 0
+ * @param[in] angle: Angle in radians
+ * @return Wrapped angle
+ */
+static double wrap_angle_positive(double angle) {
+	double wrapped = angle - 2 * PI * floor(angle / (2 * PI));
+	// Rounding just below 0 shouldn't turn into a full circle, and rounding just above it shouldn't count as a turn
+	return wrapped < 1e-9 || wrapped > 2 * PI - 1e-9 ? 0 : wrapped;
+}
+
+/**
+ * @brief Finds the normalized segment lengths of one path type between poses in the frame of the line joining them,
+ * scaled so the turn radius is 1 (Shkel and Lumelsky's closed forms)
+ * @param[in] type: Index into path_types
+ * @param[in] alpha: Start heading relative to the line joining the poses
+ * @param[in] beta: End heading relative to the line joining the poses
+ * @param[in] d: Distance between the poses in turn radii
+ * @param[out] lengths: Segment lengths in turn radii (radians for arcs)
+ * @return True if this type of path exists between the poses
+ */
+static bool dubins_path_type_lengths(int type, double alpha, double beta, double d, double lengths[DUBINS_PATH_NUM_SEGMENTS]) {
+	double sa = sin(alpha);
+	double sb = sin(beta);
+	double ca = cos(alpha);
+	double cb = cos(beta);
+	double c_ab = cos(alpha - beta);
+	double p_sq;
+	double tmp;
+
+	switch (type) {
+	case 0: // LSL
+		p_sq = 2 + d * d - 2 * c_ab + 2 * d * (sa - sb);
+		if (p_sq < 0) {
+			return false;
+		}
+		tmp = atan2(cb - ca, d + sa - sb);
+		lengths[0] = wrap_angle_positive(tmp - alpha);
+		lengths[1] = sqrt(p_sq);
+		lengths[2] = wrap_angle_positive(beta - tmp);
+		return true;
+	case 1: // LSR
+		p_sq = -2 + d * d + 2 * c_ab + 2 * d * (sa + sb);
+		if (p_sq < 0) {
+			return false;
+		}
+		lengths[1] = sqrt(p_sq);
+		tmp = atan2(-ca - cb, d + sa + sb) - atan2(-2, lengths[1]);
+		lengths[0] = wrap_angle_positive(tmp - alpha);
+		lengths[2] = wrap_angle_positive(tmp - beta);
+		return true;
+	case 2: // RSL
+		p_sq = -2 + d * d + 2 * c_ab - 2 * d * (sa + sb);
+		if (p_sq < 0) {
+			return false;
+		}
+		lengths[1] = sqrt(p_sq);
+		tmp = atan2(ca + cb, d - sa - sb) - atan2(2, lengths[1]);
+		lengths[0] = wrap_angle_positive(alpha - tmp);
+		lengths[2] = wrap_angle_positive(beta - tmp);
+		return true;
+	case 3: // RSR
+		p_sq = 2 + d * d - 2 * c_ab + 2 * d * (sb - sa);
+		if (p_sq < 0) {
+			return false;
+		}
+		tmp = atan2(ca - cb, d - sa + sb);
+		lengths[0] = wrap_angle_positive(alpha - tmp);
+		lengths[1] = sqrt(p_sq);
+		lengths[2] = wrap_angle_positive(tmp - beta);
+		return true;
+	case 4: // RLR
+		tmp = (6 - d * d + 2 * c_ab + 2 * d * (sa - sb)) / 8;
+		if (fabs(tmp) > 1) {
+			return false;
+		}
+		lengths[1] = wrap_angle_positive(2 * PI - acos(tmp));
+		lengths[0] = wrap_angle_positive(alpha - atan2(ca - cb, d - sa + sb) + lengths[1] / 2);
+		lengths[2] = wrap_angle_positive(alpha - beta - lengths[0] + lengths[1]);
+		return true;
+	case 5: // LRL
+		tmp = (6 - d * d + 2 * c_ab + 2 * d * (sb - sa)) / 8;
+		if (fabs(tmp) > 1) {
+			return false;
+		}
+		lengths[1] = wrap_angle_positive(2 * PI - acos(tmp));
+		lengths[0] = wrap_angle_positive(-alpha - atan2(ca - cb, d + sa - sb) + lengths[1] / 2);
+		lengths[2] = wrap_angle_positive(beta - alpha - lengths[0] + lengths[1]);
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * @brief Moves a pose along one segment
+ * @param[in] pose: Pose at the start of the segment
+ * @param[in] segment: Segment type
+ * @param[in] length_m: Distance to move along the segment
+ * @param[in] radius_m: Turn radius
+ * @return Pose after moving
+ */
+static pose2d_t dubins_segment_advance(pose2d_t pose, dubins_segment_t segment, double length_m, double radius_m) {
+	pose2d_t next = pose;
+	if (segment == DUBINS_SEGMENT_STRAIGHT) {
+		next.x += length_m * cos(pose.theta);
+		next.y += length_m * sin(pose.theta);
+	}
+	else {
+		// Arcs turn about a center one radius to the side, left counterclockwise and right clockwise
+		double turn = segment == DUBINS_SEGMENT_LEFT ? 1 : -1;
+		next.theta = pose.theta + turn * length_m / radius_m;
+		next.x += turn * radius_m * (sin(next.theta) - sin(pose.theta));
+		next.y -= turn * radius_m * (cos(next.theta) - cos(pose.theta));
+	}
+	return next;
+}
+
+/**
+ * @brief Finds the closest point on one segment to a position
+ * @param[in] start_pose: Pose at the start of the segment
+ * @param[in] segment: Segment type
+ * @param[in] length_m: Segment length
+ * @param[in] radius_m: Turn radius
+ * @param[in] pose: Position to project
+ * @param[out] lateral_error_m: Signed distance from the closest point, positive to the left
+ * @return Distance along the segment of the closest point, clamped to the segment
+ */
+static double dubins_segment_project(pose2d_t start_pose, dubins_segment_t segment, double length_m, double radius_m, pose2d_t pose, double* lateral_error_m) {
+	double dx = pose.x - start_pose.x;
+	double dy = pose.y - start_pose.y;
+	double c = cos(start_pose.theta);
+	double s = sin(start_pose.theta);
+
+	if (segment == DUBINS_SEGMENT_STRAIGHT) {
+		double along = fmin(fmax(dx * c + dy * s, 0), length_m);
+		double ex = pose.x - (start_pose.x + along * c);
+		double ey = pose.y - (start_pose.y + along * s);
+		*lateral_error_m = copysign(hypot(ex, ey), dy * c - dx * s);
+		return along;
+	}
+
+	// Angle swept about the arc center from the start to the position. Past the end of the arc, pick whichever end
+	// is closer in angle
+	double turn = segment == DUBINS_SEGMENT_LEFT ? 1 : -1;
+	double center_dx = dx + turn * radius_m * s;
+	double center_dy = dy - turn * radius_m * c;
+	double swept = wrap_angle_positive(turn * (atan2(center_dy, center_dx) - atan2(-turn * c, turn * s)));
+	double arc = length_m / radius_m;
+	if (swept > arc) {
+		swept = swept - arc < 2 * PI - swept ? arc : 0;
+	}
+	double along = swept * radius_m;
+	pose2d_t closest = dubins_segment_advance(start_pose, segment, along, radius_m);
+	double ex = pose.x - closest.x;
+	double ey = pose.y - closest.y;
+	*lateral_error_m = copysign(hypot(ex, ey), ey * cos(closest.theta) - ex * sin(closest.theta));
+	return along;
+}
+
+bool dubins_path_plan(dubins_path_t* path, pose2d_t start_pose, pose2d_t end_pose, double radius_m) {
+	// Check user inputs
+	if (!path || radius_m <= 0) {
+		return false;
+	}
+
+	// Work in the frame of the line from start to end, scaled by the turn radius
+	double dx = end_pose.x - start_pose.x;
+	double dy = end_pose.y - start_pose.y;
+	double d = hypot(dx, dy) / radius_m;
+	double line_heading = d > 0 ? atan2(dy, dx) : 0;
+	double alpha = wrap_angle_positive(start_pose.theta - line_heading);
+	double beta = wrap_angle_positive(end_pose.theta - line_heading);
+
+	// Try every path type and keep the shortest
+	double best_length = DBL_MAX;
+	int best_type = -1;
+	double best_lengths[DUBINS_PATH_NUM_SEGMENTS] = {0};
+	for (int type = 0; type < NUM_PATH_TYPES; type++) {
+		double lengths[DUBINS_PATH_NUM_SEGMENTS];
+		if (!dubins_path_type_lengths(type, alpha, beta, d, lengths)) {
+			continue;
+		}
+		double length = lengths[0] + lengths[1] + lengths[2];
+		if (length < best_length) {
+			best_length = length;
+			best_type = type;
+			for (int i = 0; i < DUBINS_PATH_NUM_SEGMENTS; i++) {
+				best_lengths[i] = lengths[i];
+			}
+		}
+	}
+	if (best_type < 0) {
+		return false;
+	}
+
+	path->radius_m = radius_m;
+	pose2d_t pose = start_pose;
+	for (int i = 0; i < DUBINS_PATH_NUM_SEGMENTS; i++) {
+		path->segments[i] = path_types[best_type][i];
+		path->lengths_m[i] = best_lengths[i] * radius_m;
+		path->start_poses[i] = pose;
+		pose = dubins_segment_advance(pose, path->segments[i], path->lengths_m[i], radius_m);
+	}
+	return true;
+}
+
+double dubins_path_get_length(const dubins_path_t* path) {
+	return path->lengths_m[0] + path->lengths_m[1] + path->lengths_m[2];
+}
+
+bool dubins_path_has_arcs(const dubins_path_t* path) {
+	for (int i = 0; i < DUBINS_PATH_NUM_SEGMENTS; i++) {
+		if (path->segments[i] != DUBINS_SEGMENT_STRAIGHT && path->lengths_m[i] > DUBINS_PATH_MIN_ARC_M) {
+			return true;
+		}
+	}
+	return false;
+}
+
+pose2d_t dubins_path_sample(const dubins_path_t* path, double progress_m) {
+	if (progress_m < 0) {
+		progress_m = 0;
+	}
+	for (int i = 0; i < DUBINS_PATH_NUM_SEGMENTS - 1; i++) {
+		if (progress_m <= path->lengths_m[i]) {
+			return dubins_segment_advance(path->start_poses[i], path->segments[i], progress_m, path->radius_m);
+		}
+		progress_m -= path->lengths_m[i];
+	}
+
+	// Past the end of the last segment, continue straight
+	int last = DUBINS_PATH_NUM_SEGMENTS - 1;
+	if (progress_m <= path->lengths_m[last]) {
+		return dubins_segment_advance(path->start_poses[last], path->segments[last], progress_m, path->radius_m);
+	}
+	pose2d_t end_pose = dubins_segment_advance(path->start_poses[last], path->segments[last], path->lengths_m[last], path->radius_m);
+	return dubins_segment_advance(end_pose, DUBINS_SEGMENT_STRAIGHT, progress_m - path->lengths_m[last], path->radius_m);
+}
+
+dubins_path_projection_t dubins_path_project(const dubins_path_t* path, pose2d_t pose, int first_segment) {
+	dubins_path_projection_t best = {0, 0, 0};
+	if (first_segment < 0) {
+		first_segment = 0;
+	}
+
+	// Only look at the current segment and the one after it, skipping empty ones. Further segments can pass back near
+	// the current one
+	double progress_before = 0;
+	for (int i = 0; i < first_segment && i < DUBINS_PATH_NUM_SEGMENTS; i++) {
+		progress_before += path->lengths_m[i];
+	}
+	double best_error = DBL_MAX;
+	int num_searched = 0;
+	for (int i = first_segment; i < DUBINS_PATH_NUM_SEGMENTS && num_searched < 2; i++) {
+		if (path->lengths_m[i] <= 0) {
+			continue;
+		}
+		double lateral_error_m;
+		double along = dubins_segment_project(path->start_poses[i], path->segments[i], path->lengths_m[i], path->radius_m, pose, &lateral_error_m);
+		if (fabs(lateral_error_m) < best_error) {
+			best_error = fabs(lateral_error_m);
+			best.progress_m = progress_before + along;
+			best.lateral_error_m = lateral_error_m;
+			best.segment = i;
+		}
+		progress_before += path->lengths_m[i];
+		num_searched++;
+	}
+
+	// Before the start of the path, count progress back along the start heading so a robot that starts short of the
+	// path can be seen approaching it
+	if (num_searched > 0 && best.progress_m <= 0) {
+		double dx = pose.x - path->start_poses[0].x;
+		double dy = pose.y - path->start_poses[0].y;
+		double c = cos(path->start_poses[0].theta);
+		double s = sin(path->start_poses[0].theta);
+		best.progress_m = fmin(dx * c + dy * s, 0);
+		best.lateral_error_m = dy * c - dx * s;
+		return best;
+	}
+
+	// Past the end of the path, keep counting progress along the final heading so overshoot can be seen
+	double length = dubins_path_get_length(path);
+	if (num_searched == 0 || best.progress_m >= length) {
+		pose2d_t end_pose = dubins_path_sample(path, length);
+		double dx = pose.x - end_pose.x;
+		double dy = pose.y - end_pose.y;
+		double c = cos(end_pose.theta);
+		double s = sin(end_pose.theta);
+		best.progress_m = length + fmax(dx * c + dy * s, 0);
+		best.lateral_error_m = dy * c - dx * s;
+		best.segment = DUBINS_PATH_NUM_SEGMENTS - 1;
+	}
+	return best;
+}
+
+void dubins_path_transform(dubins_path_t* path, pose2d_t origin, double cos_theta, double sin_theta) {
+	for (int i = 0; i < DUBINS_PATH_NUM_SEGMENTS; i++) {
+		pose2d_t pose = path->start_poses[i];
+		path->start_poses[i].x = origin.x + pose.x * cos_theta - pose.y * sin_theta;
+		path->start_poses[i].y = origin.y + pose.x * sin_theta + pose.y * cos_theta;
+		path->start_poses[i].theta = origin.theta + pose.theta;
+	}
+}
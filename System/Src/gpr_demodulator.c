@@ -0,0 +1,72 @@
+/*
+ * gpr_demodulator.c
+ */
+
+#include "gpr_demodulator.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#define GPR_DEMODULATOR_PI	3.14159265358979
+
+bool gpr_demodulator_init(gpr_demodulator_t* demod, int num_samples, double if_cycles_per_sample) {
+	// Check user inputs
+	if (!demod || num_samples < 2 || num_samples > GPR_DEMODULATOR_MAX_SAMPLES || if_cycles_per_sample < 0 || if_cycles_per_sample > 0.5) {
+		return false;
+	}
+
+	// A tone of amplitude A at the IF sums to A * sum(w) / 2 in the bin, so 2 / sum(w) scales that back to A. The Hann
+	// window sums to (N - 1) / 2
+	double scale = 4.0 / (num_samples - 1);
+	double cos_sum = 0;
+	double sin_sum = 0;
+	for (int n = 0; n < num_samples; n++) {
+		// Hann window, which keeps leakage from the mean and other tones out of the IF bin
+		double window = 0.5 - 0.5 * cos(2 * GPR_DEMODULATOR_PI * n / (num_samples - 1));
+		double phase = 2 * GPR_DEMODULATOR_PI * if_cycles_per_sample * n;
+		demod->cos_table[n] = (float) (scale * window * cos(phase));
+		demod->sin_table[n] = (float) (-scale * window * sin(phase));
+		cos_sum += demod->cos_table[n];
+		sin_sum += demod->sin_table[n];
+	}
+	demod->cos_sum = (float) cos_sum;
+	demod->sin_sum = (float) sin_sum;
+	demod->num_samples = num_samples;
+	return true;
+}
+
+void gpr_demodulator_run(const gpr_demodulator_t* demod, const uint16_t* samples, gpr_iq_t* iq) {
+	// Check user inputs
+	if (!demod || !samples || !iq) {
+		return;
+	}
+
+	// One pass for the bin, the mean and power, and clipping
+	float i_sum = 0;
+	float q_sum = 0;
+	uint32_t sample_sum = 0;
+	uint64_t sample_sum_sq = 0;
+	int num_clipped = 0;
+	for (int n = 0; n < demod->num_samples; n++) {
+		uint16_t sample = samples[n];
+		i_sum += sample * demod->cos_table[n];
+		q_sum += sample * demod->sin_table[n];
+		sample_sum += sample;
+		sample_sum_sq += (uint32_t) sample * sample;
+		num_clipped += sample == 0 || sample >= GPR_DEMODULATOR_ADC_MAX;
+	}
+
+	// Take the mean out of the bin, since the window doesn't quite null it
+	float mean = (float) sample_sum / demod->num_samples;
+	iq->i = i_sum - mean * demod->cos_sum;
+	iq->q = q_sum - mean * demod->sin_sum;
+	iq->dc = (uint16_t) (mean + 0.5f);
+	iq->num_clipped = num_clipped > UINT8_MAX ? UINT8_MAX : (uint8_t) num_clipped;
+
+	// AC power in double, since the mean squared can dwarf it. A tone of amplitude A has power A^2 / 2
+	double mean_d = (double) sample_sum / demod->num_samples;
+	float ac_power = (float) ((double) sample_sum_sq / demod->num_samples - mean_d * mean_d);
+	float if_power = (iq->i * iq->i + iq->q * iq->q) / 2;
+	float if_fraction = ac_power > 0 ? if_power / ac_power : 0;
+	iq->if_percent = if_fraction >= 1 ? 100 : (uint8_t) (if_fraction * 100 + 0.5f);
+}
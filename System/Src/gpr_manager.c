@@ -4,40 +4,168 @@
 
 #include "gpr_manager.h"
 
-#include <string.h>
-
+#include "gpr_demodulator.h"
+#include "gpr_range_profile.h"
 #include "peripheral_assigner.h"
 #include "signal_generator.h"
 #include "signal_receiver.h"
 #include "stm32f7xx_hal.h"
+#include "timestamp.h"
 
-#define ADC_SAMPLING_RATE_HZ 		1333333 + 1./3 // ADC_CLK / (Sampling Cycles + Resolution Cycles) = 24000000 / (3 + 15)
-#define ADC_TARGET_INPUT_FREQ_HZ    ADC_SAMPLING_RATE_HZ / 2 * 0.9 // Nyquist frequency with 10% headroom to prevent aliasing
 #define MAX_STEP_INCREMENTS			50
 #define PULSE_TIME_US				1. // Pulse time in microseconds
+#define REFERENCE_SETTLE_US			150. // Time for the mixer reference to lock after retuning, about what the transmitter gets during a capture
+#define RANGE_PROFILE_WINDOW		GprRangeWindowHann
+#define RANGE_PROFILE_POINTS		GPR_RANGE_PROFILE_MAX_POINTS // Every sweep is zero-padded to the largest transform
+
+_Static_assert(GPR_RANGE_PROFILE_MAX_POINTS >= MAX_STEP_INCREMENTS, "Range profile is too small for the largest sweep");
+
+// Register values for both synthesizers at one step of the sweep
+typedef struct gpr_step_t {
+	signal_generator_freq_t transmit;
+	signal_generator_freq_t reference;
+} gpr_step_t;
+
+// What the GPR timer is timing
+typedef enum gpr_timer_phase_t {
+	GprTimerSettle, // Mixer reference locking on a new step before its capture
+	GprTimerPulse // Transmit pulse
+} gpr_timer_phase_t;
 
 static signal_generator_t sig_gen;
 static signal_receiver_t sig_rec;
 static signal_generator_t sig_rec_reference;
 
-static uint32_t last_data[MAX_STEP_INCREMENTS][SIG_RECEIVER_MAX_DMA_SAMPLES]; // Most recent recorded data
+static uint16_t last_data[MAX_STEP_INCREMENTS][SIG_RECEIVER_MAX_DMA_SAMPLES]; // Most recent recorded data, written by DMA a row per step
 static double last_frequencies[MAX_STEP_INCREMENTS]; // Most recent recorded frequencies
-static double start_freq_mhz; // What frequency sweep was started at
-static double stop_freq_mhz; // What frequency sweep was stopped at
-static double freq_step_size_mhz; // How much to increment in each frequency sweep
+static gpr_step_t sweep_steps[MAX_STEP_INCREMENTS]; // Worked out before the sweep starts, so interrupts only write them
+static int num_steps; // How many frequency steps are in the sweep
 static int num_samples_per_step; // How many samples are actually used in each frequency step
-static int current_step_num; // What the current step number is in the sequence, starting at 0
-static bool is_recording; // Whether GPR is currently in recording state
+static volatile int current_step_num; // What the current step number is in the sequence, starting at 0
+static volatile bool is_recording; // Whether GPR is currently in recording state
+static volatile gpr_timer_phase_t timer_phase; // What the running GPR timer period is timing
+static volatile bool pulse_on; // Transmit pulse is running, so the next step has to wait for it to end
+static volatile bool step_captured; // Current step's capture finished before its pulse did
+static uint32_t timer_clock_hz; // Rate GPR_MANAGER_TIMER counts at
+static gpr_trace_info_t last_trace_info; // When and where the most recent sweep was captured
+static gpr_demodulator_t demodulator;
+static gpr_iq_t last_iq[MAX_STEP_INCREMENTS]; // Most recent sweep reduced to an I/Q sample per step
+static uint32_t iq_trace_num; // Trace last_iq was demodulated from, 0 for none
+static gpr_range_profile_t range_profile;
+static gpr_complex_t last_profile_bins[GPR_RANGE_PROFILE_MAX_POINTS]; // Most recent sweep's range profile
+static float last_profile_magnitudes[GPR_RANGE_PROFILE_MAX_POINTS];
+static uint32_t profile_trace_num; // Trace last_profile_bins was synthesized from, 0 for none
+
+static void gpr_manager_capture_cplt(signal_receiver_t* dev);
+
+/**
+ * @brief Starts the GPR timer for one period, ending in gpr_manager_timer_cplt()
+ * @param[in] time_us: Period in microseconds
+ * @param[in] phase: What the period is timing
+ */
+static void gpr_manager_start_timer(double time_us, gpr_timer_phase_t phase) {
+	TIM_HandleTypeDef* htim = GPR_MANAGER_TIMER;
+	timer_phase = phase;
+	__HAL_TIM_SET_AUTORELOAD(htim, (uint32_t) (timer_clock_hz * time_us / 1000000.0) - 1);
+	__HAL_TIM_SET_COUNTER(htim, 0);
+	// Auto-reload is preloaded, so load the new period now instead of after the old one. This flags an update too, which
+	// has to be cleared so it doesn't end the period straight away
+	htim->Instance->EGR = TIM_EGR_UG;
+	__HAL_TIM_CLEAR_FLAG(htim, TIM_FLAG_UPDATE);
+	HAL_TIM_Base_Start_IT(htim);
+}
+
+/**
+ * @brief Fires the transmit pulse, with a timer to end it
+ */
+static void gpr_manager_start_pulse() {
+	pulse_on = true;
+	signal_generator_start(&sig_gen);
+	gpr_manager_start_timer(PULSE_TIME_US, GprTimerPulse);
+}
+
+/**
+ * @brief Retunes the mixer reference for a step, then waits for it to lock before capturing. The reference drives the
+ * capture, so it can only change once the step before has been captured
+ * @param[in] step_num: Step to start
+ */
+static void gpr_manager_start_step(int step_num) {
+	signal_generator_write_freq(&sig_rec_reference, &sweep_steps[step_num].reference);
+	gpr_manager_start_timer(REFERENCE_SETTLE_US, GprTimerSettle);
+}
+
+/**
+ * @brief Ends the sweep
+ */
+static void gpr_manager_finish_sweep() {
+	signal_generator_stop(&sig_rec_reference);
+	last_trace_info.end_us = timestamp_get_us();
+	last_trace_info.trace_num++;
+	is_recording = false;
+}
+
+/**
+ * @brief Moves on to the next step once the current one is captured and its pulse has ended, or ends the sweep after
+ * the last step
+ */
+static void gpr_manager_next_step() {
+	int step_num = current_step_num + 1;
+	current_step_num = step_num;
+
+	if (step_num >= num_steps) {
+		gpr_manager_finish_sweep();
+		return;
+	}
+	gpr_manager_start_step(step_num);
+}
 
 /**
- * @brief Callback for when GPR signal generation is complete.
+ * @brief Callback for when the GPR timer period ends
  *
- * Stops signal generator
+ * Once the reference has settled, captures the current step and fires its pulse. Once the pulse ends, stops the signal
+ * generator and programs it for the next step. It's idle until that step's pulse, so it has the rest of this step's
+ * capture and the next step's settling to lock. If the capture already finished, the next step starts here
  */
-static void gpr_manager_sig_gen_cplt(TIM_HandleTypeDef* htim) {
+static void gpr_manager_timer_cplt(TIM_HandleTypeDef* htim) {
 	(void) htim; // Unused, just needed for callback
-	signal_generator_stop(&sig_gen);
 	HAL_TIM_Base_Stop_IT(GPR_MANAGER_TIMER);
+
+	if (timer_phase == GprTimerSettle) {
+		int step_num = current_step_num;
+		if (!signal_receiver_start(&sig_rec, last_data[step_num], num_samples_per_step, gpr_manager_capture_cplt)) {
+			gpr_manager_finish_sweep();
+			return;
+		}
+		gpr_manager_start_pulse();
+		return;
+	}
+
+	signal_generator_stop(&sig_gen);
+	pulse_on = false;
+	int next_step_num = current_step_num + 1;
+	if (next_step_num < num_steps) {
+		signal_generator_write_freq(&sig_gen, &sweep_steps[next_step_num].transmit);
+	}
+	if (step_captured) {
+		step_captured = false;
+		gpr_manager_next_step();
+	}
+}
+
+/**
+ * @brief Callback for when a step's capture is complete
+ *
+ * The capture is already in its row of the sweep data, so this only starts the next step. Captures shorter than the
+ * pulse finish while it's still on, and then the pulse's end starts the next step instead, since it has to stop and
+ * retune the transmitter first. Both interrupts have the same priority, so neither can run in the middle of the other
+ */
+static void gpr_manager_capture_cplt(signal_receiver_t* dev) {
+	(void) dev; // Unused, just needed for callback
+	if (pulse_on) {
+		step_captured = true;
+		return;
+	}
+	gpr_manager_next_step();
 }
 
 void gpr_manager_init() {
@@ -61,89 +189,130 @@ void gpr_manager_init() {
 			SIGNAL_RECEIVER_REF_TIMER_CHANNEL,
 			SystemCoreClock
 	);
-}
-
-/**
- * @brief Start transmitting/recording GPR at a specific frequency
- * @param[in] freq_mhz: Frequency to start recording at
- * @param[in] num_samples: Number of samples to record
- */
-static void gpr_record_start(double freq_mhz, uint32_t num_samples) {
-	// Set output frequency of signal generator
-	signal_generator_set_output_freq(&sig_gen, freq_mhz);
-	// Set reference frequency for signal receiver and start the reference clock
-	signal_generator_set_output_freq(&sig_gen, freq_mhz - (ADC_TARGET_INPUT_FREQ_HZ / 1000000.));
-	signal_generator_start(&sig_rec_reference);
-	// Start recording on signal receiver
-	signal_receiver_start(&sig_rec, num_samples);
+	// Registered once here, since callbacks can only be registered while the timer is idle
+	HAL_TIM_RegisterCallback(GPR_MANAGER_TIMER, HAL_TIM_PERIOD_ELAPSED_CB_ID, gpr_manager_timer_cplt);
 
+	// APB1 timers run at twice the bus clock whenever the bus is divided
+	timer_clock_hz = HAL_RCC_GetPCLK1Freq();
+	if ((RCC->CFGR & RCC_CFGR_PPRE1) != RCC_HCLK_DIV1) {
+		timer_clock_hz *= 2;
+	}
+	timer_clock_hz /= (GPR_MANAGER_TIMER)->Init.Prescaler + 1;
+}
 
-	// Start signal generator and timer for stopping the signal generator
-	uint32_t new_period = (uint32_t) ((double) SystemCoreClock * PULSE_TIME_US / 1000000.0);
-	__HAL_TIM_SET_AUTORELOAD(GPR_MANAGER_TIMER, new_period);
-	signal_generator_start(&sig_gen);
-	HAL_TIM_Base_Start_IT(GPR_MANAGER_TIMER);
-	HAL_TIM_RegisterCallback(GPR_MANAGER_TIMER, HAL_TIM_PERIOD_ELAPSED_CB_ID, gpr_manager_sig_gen_cplt);
+bool gpr_manager_init_step() {
+	// Program both synthesizers side by side
+	bool sig_gen_done = signal_generator_program_step(&sig_gen);
+	bool sig_rec_reference_done = signal_generator_program_step(&sig_rec_reference);
+	return sig_gen_done && sig_rec_reference_done;
 }
 
-void gpr_manager_start_recording(double start_freq_mhz_, double stop_freq_mhz_, int num_steps_, int num_samples_per_step_) {
-	if (is_recording || num_steps_ > MAX_STEP_INCREMENTS || num_samples_per_step_ > SIG_RECEIVER_MAX_DMA_SAMPLES) {
+void gpr_manager_start_recording(double start_freq_mhz, double stop_freq_mhz, int num_steps_, int num_samples_per_step_) {
+	if (is_recording || num_steps_ < 2 || num_steps_ > MAX_STEP_INCREMENTS || num_samples_per_step_ > SIG_RECEIVER_MAX_DMA_SAMPLES) {
 		return;
 	}
 
-	is_recording = true;
-	start_freq_mhz = start_freq_mhz_;
-	stop_freq_mhz = stop_freq_mhz_;
-	freq_step_size_mhz = (stop_freq_mhz - start_freq_mhz_) / num_steps_;
+	// Work out every step's register values now, so the interrupts that run the sweep only have to write them
+	double freq_step_size_mhz = (stop_freq_mhz - start_freq_mhz) / (num_steps_ - 1); // First and last steps are at the start and stop frequencies
+	for (int i = 0; i < num_steps_; i++) {
+		double freq_mhz = start_freq_mhz + freq_step_size_mhz * i;
+		last_frequencies[i] = freq_mhz;
+		if (!signal_generator_calculate_freq(&sig_gen, freq_mhz, &sweep_steps[i].transmit)
+				|| !signal_generator_calculate_freq(&sig_rec_reference, freq_mhz - (GPR_MANAGER_IF_HZ / 1000000.), &sweep_steps[i].reference)) {
+			return;
+		}
+	}
+
+	// Window and IF tables only change with the sample count. Sweeps too short to demodulate are still recorded raw
+	if (num_samples_per_step_ != demodulator.num_samples
+			&& !gpr_demodulator_init(&demodulator, num_samples_per_step_, GPR_MANAGER_IF_HZ / GPR_MANAGER_ADC_SAMPLING_RATE_HZ)) {
+		demodulator.num_samples = 0;
+	}
+
+	// Window and load order only change with the step count. Sweeps without a profile are still recorded and demodulated
+	if (num_steps_ != range_profile.num_steps
+			&& !gpr_range_profile_init(&range_profile, num_steps_, RANGE_PROFILE_POINTS, RANGE_PROFILE_WINDOW)) {
+		range_profile.num_steps = 0;
+	}
+
+	num_steps = num_steps_;
 	num_samples_per_step = num_samples_per_step_;
 	current_step_num = 0;
-	gpr_record_start(start_freq_mhz, num_samples_per_step);
-}
+	pulse_on = false;
+	step_captured = false;
+	last_trace_info.start_us = timestamp_get_us();
+	last_trace_info.has_pose = false;
+	is_recording = true;
 
-/**
- * @brief Gets pointer to data from the GPR if recording isn't in progress
- * @return Pointer to data if recording not in progress, NULL if recording is in progress
- */
-static uint32_t* gpr_get_data() {
-	uint32_t* data = signal_receiver_get_data(&sig_rec, NULL); // We know how many samples there are
-	// Stop reference clock to signal receiver if signal receiver is done recording
-	if (data) {
-		signal_generator_stop(&sig_rec_reference);
-	}
-	return data;
+	// Start the first step. The rest are started from the interrupt that ends the step before
+	signal_generator_write_freq(&sig_gen, &sweep_steps[0].transmit);
+	signal_generator_start(&sig_rec_reference);
+	gpr_manager_start_step(0);
 }
 
 bool gpr_manager_loop_recording() {
-	if (!is_recording) {
+	return is_recording;
+}
+
+bool gpr_manager_get_data(uint16_t** data, double** freqs_mhz, int* actual_num_steps, int* array_samples_per_step, int* actual_samples_per_step) {
+	*data = &(last_data[0][0]);
+	*freqs_mhz = last_frequencies;
+	*actual_num_steps = current_step_num; // Counts steps captured, so it ends at the number of steps
+	*array_samples_per_step = SIG_RECEIVER_MAX_DMA_SAMPLES;
+	*actual_samples_per_step = num_samples_per_step;
+
+	return !is_recording;
+}
+
+void gpr_manager_tag_pose(pose2d_t pose) {
+	last_trace_info.pose = pose;
+	last_trace_info.has_pose = true;
+}
+
+bool gpr_manager_get_iq(gpr_iq_t** iq, double** freqs_mhz, int* actual_num_steps) {
+	if (is_recording || last_trace_info.trace_num == 0 || demodulator.num_samples != num_samples_per_step) {
 		return false;
 	}
 
-	uint32_t* data = gpr_get_data();
-	// Check if current frequency recording is still in progress
-	if (!data) {
-		return true;
+	// Demodulate each sweep once, the first time it's asked for
+	if (iq_trace_num != last_trace_info.trace_num) {
+		for (int i = 0; i < current_step_num; i++) {
+			gpr_demodulator_run(&demodulator, last_data[i], &last_iq[i]);
+		}
+		iq_trace_num = last_trace_info.trace_num;
+	}
+	*iq = last_iq;
+	*freqs_mhz = last_frequencies;
+	*actual_num_steps = current_step_num;
+	return true;
+}
+
+bool gpr_manager_get_range_profile(float** magnitudes, int* num_points) {
+	gpr_iq_t* iq;
+	double* freqs_mhz;
+	int actual_num_steps;
+	if (!gpr_manager_get_iq(&iq, &freqs_mhz, &actual_num_steps)) {
+		return false;
 	}
 
-	// If reached, current recording has completed. Copy into data array
-	memcpy(&last_data[current_step_num], data, num_samples_per_step);
-	current_step_num++;
-	double next_freq_mhz = start_freq_mhz + freq_step_size_mhz * current_step_num;
-	// Stop whole recording if the last frequency has completed
-	if (next_freq_mhz > stop_freq_mhz) {
-		is_recording = false;
+	// Sweeps that ended early would leave the previous sweep's I/Q in the missing steps, and the window is only built for
+	// whole sweeps, so only whole sweeps get a profile
+	if (actual_num_steps != range_profile.num_steps) {
 		return false;
 	}
-	// If reached, current frequency recording has stopped but more frequencies must be swept
-	gpr_record_start(start_freq_mhz + freq_step_size_mhz * current_step_num, num_samples_per_step);
+
+	// Synthesize each sweep once, the first time it's asked for
+	if (profile_trace_num != last_trace_info.trace_num) {
+		gpr_range_profile_run(&range_profile, iq, last_profile_bins);
+		gpr_range_profile_magnitudes(last_profile_bins, range_profile.num_points, last_profile_magnitudes);
+		profile_trace_num = last_trace_info.trace_num;
+	}
+	*magnitudes = last_profile_magnitudes;
+	*num_points = range_profile.num_points;
 	return true;
 }
 
-bool gpr_manager_get_data(uint32_t** data, double** freqs_mhz, int* actual_num_steps, int* array_samples_per_step, int* actual_samples_per_step) {
-	*data = &(last_data[0][0]);
-	*freqs_mhz = last_frequencies;
-	*actual_num_steps = current_step_num; // Due to behavior of gpr_manager_loop_recording(), current_step_num will end 1 over the last index number
-	*array_samples_per_step = SIG_RECEIVER_MAX_DMA_SAMPLES;
-	*actual_samples_per_step = num_samples_per_step;
-
-	return !is_recording;
+bool gpr_manager_get_trace_info(gpr_trace_info_t* info) {
+	*info = last_trace_info;
+	return !is_recording && last_trace_info.trace_num > 0;
 }
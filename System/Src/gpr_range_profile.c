@@ -0,0 +1,106 @@
+/*
+ * gpr_range_profile.c
+ */
+
+#include "gpr_range_profile.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#define GPR_RANGE_PROFILE_PI	3.14159265358979
+
+bool gpr_range_profile_init(gpr_range_profile_t* profile, int num_steps, int num_points, gpr_range_window_t window) {
+	// Check user inputs
+	if (!profile || num_points < 2 || num_points > GPR_RANGE_PROFILE_MAX_POINTS || (num_points & (num_points - 1)) != 0
+			|| num_steps < 1 || num_steps > num_points) {
+		return false;
+	}
+
+	// Twiddles for the largest transform. Smaller ones take every (max / size)th
+	for (int k = 0; k < GPR_RANGE_PROFILE_MAX_POINTS / 2; k++) {
+		double angle = 2 * GPR_RANGE_PROFILE_PI * k / GPR_RANGE_PROFILE_MAX_POINTS;
+		profile->twiddles[k].re = (float) cos(angle);
+		profile->twiddles[k].im = (float) sin(angle);
+	}
+
+	// A reflector adds up across the steps to its amplitude times the window's sum, so dividing by that sum leaves its
+	// amplitude as the peak. Zero-padding adds bins between, but not amplitude
+	double window_sum = 0;
+	for (int n = 0; n < num_steps; n++) {
+		double weight = 1;
+		if (window == GprRangeWindowHann && num_steps > 1) {
+			weight = 0.5 - 0.5 * cos(2 * GPR_RANGE_PROFILE_PI * (n + 0.5) / num_steps);
+		}
+		profile->window[n] = (float) weight;
+		window_sum += weight;
+	}
+	for (int n = 0; n < num_steps; n++) {
+		profile->window[n] = (float) (profile->window[n] / window_sum);
+	}
+
+	// Steps are loaded in bit-reversed order, so the transform can start on its butterflies straight away
+	int num_bits = 0;
+	while ((1 << num_bits) < num_points) {
+		num_bits++;
+	}
+	for (int n = 0; n < num_points; n++) {
+		int reversed = 0;
+		for (int bit = 0; bit < num_bits; bit++) {
+			reversed |= ((n >> bit) & 1) << (num_bits - 1 - bit);
+		}
+		profile->load_order[n] = (uint8_t) reversed;
+	}
+
+	profile->num_steps = num_steps;
+	profile->num_points = num_points;
+	return true;
+}
+
+void gpr_range_profile_run(const gpr_range_profile_t* profile, const gpr_iq_t* iq, gpr_complex_t* bins) {
+	// Check user inputs
+	if (!profile || !iq || !bins) {
+		return;
+	}
+
+	// Load windowed steps, and zeros past the last one
+	int num_points = profile->num_points;
+	for (int n = 0; n < profile->num_steps; n++) {
+		gpr_complex_t* bin = &bins[profile->load_order[n]];
+		bin->re = iq[n].i * profile->window[n];
+		bin->im = iq[n].q * profile->window[n];
+	}
+	for (int n = profile->num_steps; n < num_points; n++) {
+		gpr_complex_t* bin = &bins[profile->load_order[n]];
+		bin->re = 0;
+		bin->im = 0;
+	}
+
+	// Radix-2 decimation in time, combining pairs of half-size transforms until the whole profile is done
+	for (int half_size = 1; half_size < num_points; half_size *= 2) {
+		int twiddle_stride = GPR_RANGE_PROFILE_MAX_POINTS / (2 * half_size);
+		for (int start = 0; start < num_points; start += 2 * half_size) {
+			for (int k = 0; k < half_size; k++) {
+				gpr_complex_t w = profile->twiddles[k * twiddle_stride];
+				gpr_complex_t* a = &bins[start + k];
+				gpr_complex_t* b = &bins[start + k + half_size];
+				float t_re = b->re * w.re - b->im * w.im;
+				float t_im = b->re * w.im + b->im * w.re;
+				b->re = a->re - t_re;
+				b->im = a->im - t_im;
+				a->re += t_re;
+				a->im += t_im;
+			}
+		}
+	}
+}
+
+void gpr_range_profile_magnitudes(const gpr_complex_t* bins, int num_points, float* magnitudes) {
+	// Check user inputs
+	if (!bins || !magnitudes) {
+		return;
+	}
+
+	for (int k = 0; k < num_points; k++) {
+		magnitudes[k] = sqrtf(bins[k].re * bins[k].re + bins[k].im * bins[k].im);
+	}
+}
@@ -3,46 +3,135 @@
  */
 
 #include "localization_manager.h"
+#include "calibration_manager.h"
+#include "geodesy.h"
+#include "loop_profiler.h"
+#include "odometry_manager.h"
+#include "particle_filter.h"
 #include "peripheral_assigner.h"
+#include "pose_history.h"
+#include "sample_ring.h"
+#include "timestamp.h"
 
+#include <math.h>
+
+#define PF_SEED						0x6b8b4567
+#define PF_INIT_POS_STD_M			0.05f
+#define PF_INIT_ANG_STD_RAD			0.05f
+#define PF_DIST_NOISE_FRAC			0.05f	// Odometry distance noise as a fraction of distance driven
+#define PF_DIST_NOISE_MIN_M			0.0005f
+#define PF_YAW_NOISE_FRAC			0.10f	// Odometry yaw noise as a fraction of yaw turned
+#define PF_YAW_NOISE_MIN_RAD		0.002f
+#define PF_TILT_NOISE_RAD			0.005f	// Pitch and roll random walk per update
+#define PF_IMU_YAW_STD_RAD			0.05f
+#define PF_IMU_TILT_STD_RAD			0.03f
+#define PF_RESAMPLE_NEFF_FRAC		0.5f	// Resample once effective particle count drops below this fraction
+#define PF_KLD_BIN_SIZE_M			0.05f
+#define PF_KLD_BIN_SIZE_RAD			0.0873f	// 5 degrees
+#define PF_KLD_EPSILON				0.05f
+#define PF_KLD_Z_QUANTILE			2.33f	// delta = 0.01
+#define PF_RESIZE_FRAC				0.25f	// Resample to the KLD particle count once it differs from the current count by this fraction
+#define PF_INIT_FILTER_CYCLES		1000	// Per-particle cost guesses until the first update is measured
+#define PF_INIT_FINISH_CYCLES		500
+#define PF_CHUNK_SIZE				PARTICLE_FILTER_MIN_PARTICLES	// Particles filtered between budget checks
+
+// Groups don't preempt each other, so an update delays the control group's next release by as long as it runs. Half
+// the control period leaves the rest for the control task itself. It's a target rather than a hard limit: the first
+// chunk of particles is always filtered, and the normalize, KLD and resample cost is predicted from recent updates
+// rather than checked as it runs, so an update can still overrun it
+#define LOCALIZATION_BUDGET_US		500
+#define COST_DECAY_SHIFT			4		// Worst-case costs decay by 1/16 per update so a one-off spike doesn't pin them
+
+#define GPS_MIN_STD_M				0.5f	// Floor on the horizontal position std reported by the GPS
+
+#define SENSOR_QUEUE_SIZE			8		// Samples held per sensor between updates. Must be a power of 2
+
+// Encoders are integrated by the odometry manager, so they don't queue samples here
 typedef union sensor_data_t {
-	encoder_data_t encoder_data;
 	gps_data_t gps_data;
 	imu_data_t imu_data;
 } localization_sensor_data_t;
 
 typedef struct sensor_t {
 	bool enabled;
-	bool updated;
-	localization_sensor_data_t last_data;
+	sample_ring_t samples; // Timestamped samples waiting to be fused, oldest first
+	localization_sensor_data_t sample_storage[SENSOR_QUEUE_SIZE];
 } localization_sensor_t;
 
+// Measurements worked out against the predicted pose before filtering, so every chunk of particles is weighed the same
+typedef struct orientation_measurement_t {
+	float yaw;
+	float pitch;
+	float roll;
+} orientation_measurement_t;
+
+typedef struct position_measurement_t {
+	float x;
+	float y;
+	float std_m;
+} position_measurement_t;
+
 static localization_sensor_t sensors[NUM_SENSORS];
 
-static encoder_t encoder_l;
-static encoder_t encoder_r;
 static gps_t gps;
 static imu_t imu;
 static localization_estimate_t cur_estimate;
 
+static particle_filter_t pf;
+static odometry_snapshot_t last_odometry; // Odometry at the last update, to predict from the motion since
+static pose3d_t last_pose; // Estimate at the last update
+static bool has_last_odometry;
+static bool has_initial_heading; // Particles start pointing along the first IMU heading
+static pose_history_t pose_history; // Poses of recent updates, to fuse late measurements against the pose when they were captured
+static bool has_gps_origin;
+static geodesy_enu_origin_t gps_origin; // Tangent plane at the first fix
+static float gps_origin_x; // Where the GPS origin is in the estimate frame
+static float gps_origin_y;
+static uint32_t last_update_ms;
+static uint32_t sensor_read_cycles; // Worst recent cost of reading sensors
+static uint32_t filter_cycles_per_particle; // Worst recent cost of predicting and weighing one particle
+static uint32_t finish_cycles_per_particle; // Worst recent cost of normalizing, estimating, and resampling one particle
+
 void localization_manager_init() {
 	// Initialize sensors
-	encoder_init(&encoder_l, ENCODER_LEFT_TIMER);
-	encoder_init(&encoder_r, ENCODER_RIGHT_TIMER);
 	gps_init(&gps, GPS_UART);
-	imu_init(&imu, IMU_I2C);
+	imu_init(&imu, IMU_I2C, IMU_SCL_GPIO_Port, IMU_SCL_Pin, IMU_SDA_GPIO_Port, IMU_SDA_Pin);
+	calibration_manager_init(&imu);
 
 	// Initialize sensor structs
 	for (int i = 0; i < NUM_SENSORS; i++) {
 		sensors[i].enabled = false;
-		sensors[i].updated = false;
+		sample_ring_init(&sensors[i].samples, sensors[i].sample_storage, sizeof(localization_sensor_data_t), SENSOR_QUEUE_SIZE);
 	}
 
 	// Start asynchronous sensors
-	encoder_start(&encoder_l);
-	encoder_start(&encoder_r);
-	gps_start_rx(&gps);
+	odometry_manager_init();
+
+	// Robot starts at the origin of its frame. Heading is unknown until the IMU reports
+	pose3d_t origin = {0};
+	particle_filter_init(&pf, origin, PF_INIT_POS_STD_M, PF_INIT_ANG_STD_RAD, PF_SEED);
+	pose_history_init(&pose_history);
+	last_pose = origin;
+	has_last_odometry = false;
+	has_initial_heading = false;
+	has_gps_origin = false;
+	last_update_ms = HAL_GetTick();
+	sensor_read_cycles = 0;
+	filter_cycles_per_particle = PF_INIT_FILTER_CYCLES;
+	finish_cycles_per_particle = PF_INIT_FINISH_CYCLES;
+	cur_estimate.num_particles = pf.num_particles;
 
+	// Start the DWT cycle counter, which times updates against their budget
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->LAR = 0xC5ACCE55;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+bool localization_manager_init_step() {
+	// IMU and GPS have slow, multi-step setups. GPS starts receiving once configured
+	bool imu_done = imu_init_step(&imu);
+	bool gps_done = gps_init_step(&gps);
+	return imu_done && gps_done;
 }
 
 void localization_manager_sensor_enable(localization_sensor_type_t sensor_type, bool b_enable) {
@@ -55,67 +144,285 @@ void localization_manager_sensor_enable(localization_sensor_type_t sensor_type,
 }
 
 /**
- * @brief Gobble data from all enabled sensors.
+ * @brief Gobble data from all enabled sensors into their sample queues.
  *
  * Some sensors may not have data always available even if available
  */
 static void localization_manager_read_sensor_data() {
 
-	for (int i = 0; i < NUM_SENSORS; i++) {
-		sensors[i].updated = false;
+	if (sensors[GPS].enabled) {
+		// GPS is asynchronous but low frequency update, so it will not always have data available.
+		// Fixes queue up in the driver as they arrive, so take all of them
+		LOOP_PROFILER_BEGIN(LOOP_PROFILER_PROBE_GPS_READ);
+		const gps_data_t* temp_gps_data;
+		while ((temp_gps_data = gps_check_for_update(&gps)) != NULL) {
+			sample_ring_push(&sensors[GPS].samples, temp_gps_data);
+		}
+		LOOP_PROFILER_END(LOOP_PROFILER_PROBE_GPS_READ);
+	}
+
+	if (sensors[IMU].enabled) {
+		// IMU is synchronous, so requesting data will return data unless IMU setup or the read failed
+		LOOP_PROFILER_BEGIN(LOOP_PROFILER_PROBE_IMU_READ);
+		imu_data_t* temp_imu_data = imu_get_data(&imu);
+		LOOP_PROFILER_END(LOOP_PROFILER_PROBE_IMU_READ);
+		if (temp_imu_data) {
+			sample_ring_push(&sensors[IMU].samples, temp_imu_data);
+		}
+		calibration_manager_update(&imu, temp_imu_data);
+		cur_estimate.imu_time_to_calibrated_ms = calibration_manager_get_time_to_calibrated_ms();
 	}
+}
 
-	if (sensors[ENCODER_LEFT].enabled) {
-		// Encoder is asynchronous but with very high frequency update, so it should always have new data available
-		sensors[ENCODER_LEFT].last_data.encoder_data = *encoder_get_data(&encoder_l);
-		sensors[ENCODER_LEFT].updated = true;
+/**
+ * @brief Wraps an angle to [-PI, PI)
+ * @param[in] angle: Angle in radians
+ * @return Wrapped angle
+ */
+static float localization_manager_wrap_angle(float angle) {
+	return angle - 6.28318531f * floorf((angle + 3.14159265f) * (1.0f / 6.28318531f));
+}
+
+/**
+ * @brief Moves a pose by an odometry step the way particles are moved, without the noise
+ * @param[in] pose: Pose before the step
+ * @param[in] distance: Distance driven along the robot's forward axis
+ * @param[in] delta_yaw: Change in yaw
+ * @return Pose after the step
+ */
+static pose3d_t localization_manager_predict_pose(pose3d_t pose, float distance, float delta_yaw) {
+	float mid_yaw = pose.yaw + 0.5f * delta_yaw;
+	float horizontal = distance * cosf(pose.pitch);
+	pose.x += horizontal * cosf(mid_yaw);
+	pose.y += horizontal * sinf(mid_yaw);
+	pose.z += distance * sinf(pose.pitch);
+	pose.yaw = localization_manager_wrap_angle(pose.yaw + delta_yaw);
+	return pose;
+}
+
+/**
+ * @brief Turns a GPS fix into a position measurement, moved forward by how far the robot has gone since the fix was measured
+ * @param[in] fix: GPS fix
+ * @param[in] now: Predicted pose now
+ * @param[out] meas: Position measurement
+ * @return True if the fix can be fused, false if it has no valid solution or is too old
+ */
+static bool localization_manager_gps_measurement(const gps_data_t* fix, pose3d_t now, position_measurement_t* meas) {
+	if (!(fix->pvt.flags & UBX_NAV_PVT_FLAGS_GNSS_FIX_OK) || (fix->pvt.fix_type != UBX_FIX_2D && fix->pvt.fix_type != UBX_FIX_3D)) {
+		return false;
 	}
 
-	if (sensors[ENCODER_RIGHT].enabled) {
-		sensors[ENCODER_RIGHT].last_data.encoder_data = *encoder_get_data(&encoder_r);
-		sensors[ENCODER_RIGHT].updated = true;
+	// Fix is too old to place against a past pose
+	pose3d_t then;
+	if (!pose_history_get(&pose_history, fix->timestamp_us, &then)) {
+		return false;
 	}
 
-	if (sensors[GPS].enabled) {
-		gps_data_t* temp_gps_data = gps_check_for_update(&gps);
-		// GPS is asynchronous but low frequency update, so it will not always have data available
-		if (temp_gps_data) {
-			sensors[GPS].last_data.gps_data = *temp_gps_data;
-			sensors[GPS].updated = true;
-			gps_start_rx(&gps);
-		}
+	// First fix anchors GPS coordinates to where the robot was when it was measured, and fixes the tangent plane
+	// east and north are measured in, so later fixes convert without trig
+	if (!has_gps_origin) {
+		geodesy_enu_origin_init(&gps_origin, fix->pvt.lat_e7, fix->pvt.lon_e7, fix->pvt.height_mm);
+		gps_origin_x = then.x;
+		gps_origin_y = then.y;
+		has_gps_origin = true;
 	}
+	geodesy_enu_t enu = geodesy_to_enu(&gps_origin, fix->pvt.lat_e7, fix->pvt.lon_e7, fix->pvt.height_mm);
+	float x = gps_origin_x + (float) enu.east_m;
+	float y = gps_origin_y + (float) enu.north_m;
 
-	if (sensors[IMU].enabled) {
-		// IMU is synchronous, so requesting data will return data
-		sensors[IMU].last_data.imu_data = *imu_get_data(&imu);
-		sensors[IMU].updated = true;
+	// Accuracy estimate can be optimistic on a good sky, so keep a floor under it
+	float std_m = fix->pvt.h_acc_mm * 0.001f;
+	if (std_m < GPS_MIN_STD_M) {
+		std_m = GPS_MIN_STD_M;
 	}
+	meas->x = x + (now.x - then.x);
+	meas->y = y + (now.y - then.y);
+	meas->std_m = std_m;
+	return true;
+}
+
+/**
+ * @brief Turns an IMU sample into an orientation measurement, turned by how far the robot has turned since it was measured
+ * @param[in] sample: IMU sample
+ * @param[in] now: Predicted pose now
+ * @param[out] meas: Orientation measurement
+ * @return True if the sample can be fused, false if it was used to start the particles over instead
+ */
+static bool localization_manager_imu_measurement(const imu_data_t* sample, pose3d_t now, orientation_measurement_t* meas) {
+	// BNO055 heading is clockwise from magnetic north, while yaw is counterclockwise from east
+	float yaw = localization_manager_wrap_angle((float) (3.14159265358979 / 2) - sample->heading_rad);
+	float pitch = sample->pitch_rad;
+	float roll = sample->roll_rad;
+
+	// Until the IMU first reports, heading was only a guess, so start the particles over pointing the right way
+	if (!has_initial_heading) {
+		pose3d_t start = {now.x, now.y, now.z, yaw, pitch, roll};
+		particle_filter_init(&pf, start, PF_INIT_POS_STD_M, PF_INIT_ANG_STD_RAD, PF_SEED);
+		pose_history_init(&pose_history);
+		has_initial_heading = true;
+		return false;
+	}
+
+	pose3d_t then;
+	if (pose_history_get(&pose_history, sample->timestamp_us, &then)) {
+		yaw = localization_manager_wrap_angle(yaw + localization_manager_wrap_angle(now.yaw - then.yaw));
+	}
+	meas->yaw = yaw;
+	meas->pitch = pitch;
+	meas->roll = roll;
+	return true;
+}
+
+/**
+ * @brief Tracks the worst recent value of a cost, letting it decay slowly when costs drop
+ * @param[in] worst: Current worst recent cost
+ * @param[in] cost: Newly measured cost
+ * @return New worst recent cost
+ */
+static uint32_t localization_manager_track_worst(uint32_t worst, uint32_t cost) {
+	worst -= worst >> COST_DECAY_SHIFT;
+	return cost > worst ? cost : worst;
 }
 
 localization_estimate_t* localization_manager_update_estimates() {
 
-	// TODO: Predict current state based on last system input and last state
+	uint32_t start_cycles = DWT->CYCCNT;
+	uint32_t budget_cycles = LOCALIZATION_BUDGET_US * (SystemCoreClock / 1000000);
+	uint32_t cur_ms = HAL_GetTick();
+	float dt = (cur_ms - last_update_ms) / 1000.0f;
+	last_update_ms = cur_ms;
 
 	// Read new sensor data
 	localization_manager_read_sensor_data();
+	uint32_t filter_start_cycles = DWT->CYCCNT;
 
-	// Update estimate based on new GPS data
-	if (sensors[GPS].updated) {
-		//sensors[GPS].last_data.gps_data;
+	// Motion odometry integrated since the last update, in the odometry frame rotated into the body frame it started in
+	float distance = 0;
+	float delta_yaw = 0;
+	float speed_mps = 0;
+	uint32_t now_us = timestamp_get_us();
+	odometry_snapshot_t odometry;
+	if (sensors[ENCODER_LEFT].enabled && sensors[ENCODER_RIGHT].enabled && odometry_manager_get_snapshot(&odometry)) {
+		if (has_last_odometry) {
+			double dx = odometry.pose.x - last_odometry.pose.x;
+			double dy = odometry.pose.y - last_odometry.pose.y;
+			distance = (float) (dx * cos(last_odometry.pose.theta) + dy * sin(last_odometry.pose.theta));
+			delta_yaw = (float) (odometry.pose.theta - last_odometry.pose.theta);
+		}
+		last_odometry = odometry;
+		has_last_odometry = true;
+		speed_mps = (odometry.vel_l_mps + odometry.vel_r_mps) / 2;
+		cur_estimate.ang_vel_zyx.z = (odometry.vel_r_mps - odometry.vel_l_mps) / WHEEL_BASE_M;
+		now_us = odometry.timestamp_us;
 	}
 
-	// Update estimate based on new encoder data
-	if (sensors[ENCODER_LEFT].updated && sensors[ENCODER_RIGHT].updated) {
-		//sensors[ENCODER_LEFT].last_data.encoder_data;
-		//sensors[ENCODER_RIGHT].last_data.encoder_data;
+	// Measurements are compared against the pose when they were captured, and that difference is applied to the
+	// predicted pose now. The last estimate moved by the odometry step stands in for the prediction, so measurements are
+	// known before any particle is filtered. It goes in the history so captures since the last update interpolate onto it
+	pose3d_t predicted = localization_manager_predict_pose(last_pose, distance, delta_yaw);
+	pose_history_push(&pose_history, now_us, predicted);
+
+	// New IMU data. The first sample starts the particles over at the predicted pose, so they aren't moved again
+	bool had_initial_heading = has_initial_heading;
+	orientation_measurement_t orientations[SENSOR_QUEUE_SIZE];
+	int num_orientations = 0;
+	const imu_data_t* imu_sample;
+	while (num_orientations < SENSOR_QUEUE_SIZE && (imu_sample = (const imu_data_t*) sample_ring_peek(&sensors[IMU].samples)) != NULL) {
+		if (localization_manager_imu_measurement(imu_sample, predicted, &orientations[num_orientations])) {
+			num_orientations++;
+		}
+		sample_ring_pop(&sensors[IMU].samples);
 	}
+	bool restarted = has_initial_heading && !had_initial_heading;
 
-	// Update estimate based on new IMU data
-	if (sensors[IMU].updated) {
-		//sensors[IMU].last_data.imu_data;
+	// New GPS data, which is usually well over one update late
+	position_measurement_t positions[SENSOR_QUEUE_SIZE];
+	int num_positions = 0;
+	const gps_data_t* gps_sample;
+	while (num_positions < SENSOR_QUEUE_SIZE && (gps_sample = (const gps_data_t*) sample_ring_peek(&sensors[GPS].samples)) != NULL) {
+		if (localization_manager_gps_measurement(gps_sample, predicted, &positions[num_positions])) {
+			num_positions++;
+		}
+		sample_ring_pop(&sensors[GPS].samples);
 	}
 
+	// Filter a chunk of particles at a time: move it by the odometry step, then weigh it by every measurement. Once the
+	// rest of the budget would only cover finishing the particles filtered so far, the rest are dropped. The first chunk
+	// always runs, so the set never drops below the minimum
+	particle_filter_motion_t motion = particle_filter_motion(&pf, distance, delta_yaw,
+			PF_DIST_NOISE_MIN_M + PF_DIST_NOISE_FRAC * fabsf(distance),
+			PF_YAW_NOISE_MIN_RAD + PF_YAW_NOISE_FRAC * fabsf(delta_yaw),
+			PF_TILT_NOISE_RAD);
+	uint32_t chunk_cycles = (filter_cycles_per_particle + finish_cycles_per_particle) * PF_CHUNK_SIZE;
+	uint32_t num_filtered = 0;
+	do {
+		uint32_t end = num_filtered + PF_CHUNK_SIZE < pf.num_particles ? num_filtered + PF_CHUNK_SIZE : pf.num_particles;
+		if (!restarted) {
+			particle_filter_predict_range(&pf, &motion, num_filtered, end);
+		}
+		for (int i = 0; i < num_orientations; i++) {
+			particle_filter_weight_orientation_range(&pf, orientations[i].yaw, orientations[i].pitch, orientations[i].roll,
+					PF_IMU_YAW_STD_RAD, PF_IMU_TILT_STD_RAD, num_filtered, end);
+		}
+		for (int i = 0; i < num_positions; i++) {
+			particle_filter_weight_position_range(&pf, positions[i].x, positions[i].y, positions[i].std_m, num_filtered, end);
+		}
+		num_filtered = end;
+	} while (num_filtered < pf.num_particles
+			&& DWT->CYCCNT - start_cycles + chunk_cycles + finish_cycles_per_particle * num_filtered <= budget_cycles);
+	particle_filter_truncate(&pf, num_filtered);
+	uint32_t finish_start_cycles = DWT->CYCCNT;
+
+	float num_effective = particle_filter_normalize(&pf);
+	pose3d_t pose = particle_filter_estimate(&pf);
+
+	// Size the particle set for next update: as many as KLD-sampling says the current spread needs, but never more than
+	// the worst recent costs say will fit in the budget
+	uint32_t cycles_per_particle = filter_cycles_per_particle + finish_cycles_per_particle;
+	uint32_t max_particles = sensor_read_cycles < budget_cycles ? (budget_cycles - sensor_read_cycles) / cycles_per_particle : 0;
+	// The filter can't shrink below its minimum, so a tighter budget would only force a resample on every update
+	if (max_particles < PARTICLE_FILTER_MIN_PARTICLES) {
+		max_particles = PARTICLE_FILTER_MIN_PARTICLES;
+	}
+	uint32_t num_particles = particle_filter_kld_num_particles(&pf, PF_KLD_BIN_SIZE_M, PF_KLD_BIN_SIZE_RAD, PF_KLD_EPSILON, PF_KLD_Z_QUANTILE);
+	if (num_particles > max_particles) {
+		num_particles = max_particles;
+	}
+
+	// Resample when weights have degenerated, since resampling throws away particle diversity, or when the set must change size
+	bool degenerate = num_effective < PF_RESAMPLE_NEFF_FRAC * pf.num_particles;
+	bool over_budget = pf.num_particles > max_particles;
+	bool resize = num_particles > (1 + PF_RESIZE_FRAC) * pf.num_particles || num_particles < (1 - PF_RESIZE_FRAC) * pf.num_particles;
+	if (degenerate || over_budget || resize) {
+		particle_filter_resample(&pf, num_particles);
+	}
+
+	pose_history_push(&pose_history, now_us, pose);
+	last_pose = pose;
+
+	uint32_t end_cycles = DWT->CYCCNT;
+	sensor_read_cycles = localization_manager_track_worst(sensor_read_cycles, filter_start_cycles - start_cycles);
+	filter_cycles_per_particle = localization_manager_track_worst(filter_cycles_per_particle, (finish_start_cycles - filter_start_cycles) / num_filtered);
+	finish_cycles_per_particle = localization_manager_track_worst(finish_cycles_per_particle, (end_cycles - finish_start_cycles) / num_filtered);
+	cur_estimate.num_particles = pf.num_particles;
+	cur_estimate.update_us = (end_cycles - start_cycles) / (SystemCoreClock / 1000000);
+	// Horizontal velocity comes from the wheels, which unlike pose differences don't jump when GPS pulls the estimate
+	cur_estimate.vel.x = speed_mps * cosf(pose.yaw);
+	cur_estimate.vel.y = speed_mps * sinf(pose.yaw);
+	if (dt > 0) {
+		cur_estimate.vel.z = (pose.z - cur_estimate.pos.z) / dt;
+	}
+	cur_estimate.pos.x = pose.x;
+	cur_estimate.pos.y = pose.y;
+	cur_estimate.pos.z = pose.z;
+	cur_estimate.heading_zyx.z = pose.yaw;
+	cur_estimate.heading_zyx.y = pose.pitch;
+	cur_estimate.heading_zyx.x = pose.roll;
+
+	return &cur_estimate;
+}
+
+localization_estimate_t* localization_manager_get_estimate() {
 	return &cur_estimate;
 }
 
@@ -123,3 +430,14 @@ pose2d_t localization_manager_estimate_to_pose2d() {
 	pose2d_t cur_2d_pose = {cur_estimate.pos.x, cur_estimate.pos.y, cur_estimate.heading_zyx.z};
 	return cur_2d_pose;
 }
+
+bool localization_manager_get_pose_at(uint32_t timestamp_us, pose2d_t* pose) {
+	pose3d_t then;
+	if (!pose_history_get(&pose_history, timestamp_us, &then)) {
+		return false;
+	}
+	pose->x = then.x;
+	pose->y = then.y;
+	pose->theta = then.yaw;
+	return true;
+}
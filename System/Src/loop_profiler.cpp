@@ -0,0 +1,146 @@
+/*
+ * loop_profiler.cpp
+ */
+
+#include "loop_profiler.h"
+
+#if LOOP_PROFILER_ENABLED
+
+#include <cstddef>
+#include <cstring>
+
+#ifdef LOOP_PROFILER_HOST
+#include <chrono>
+#endif
+
+static loop_profiler_stats_t probe_stats[NUM_LOOP_PROFILER_PROBES];
+
+static const char* const probe_names[NUM_LOOP_PROFILER_PROBES] = {
+	"localization_update",
+	"trajectory_follow",
+	"drive_run",
+	"imu_read",
+	"gps_read",
+	"radio_transmit",
+};
+
+#ifdef LOOP_PROFILER_HOST
+uint32_t loop_profiler_now(void) {
+	return (uint32_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+#endif
+
+/**
+ * @brief Gets how many profiler counts make up one microsecond
+ * @return Profiler counts per microsecond
+ */
+static uint32_t loop_profiler_counts_per_us() {
+#ifdef LOOP_PROFILER_HOST
+	return 1000;
+#else
+	return SystemCoreClock / 1000000;
+#endif
+}
+
+/**
+ * @brief Clears statistics of all probes
+ */
+static void loop_profiler_clear() {
+	memset(probe_stats, 0, sizeof(probe_stats));
+	for (int i = 0; i < NUM_LOOP_PROFILER_PROBES; i++) {
+		probe_stats[i].min_counts = UINT32_MAX;
+	}
+}
+
+/**
+ * @brief Saturates a value to fit in 16 bits
+ * @param[in] val: Value to saturate
+ * @return Saturated value
+ */
+static uint16_t loop_profiler_saturate_u16(uint64_t val) {
+	return val > UINT16_MAX ? UINT16_MAX : (uint16_t) val;
+}
+
+void loop_profiler_init(void) {
+#ifndef LOOP_PROFILER_HOST
+	// Enable trace so the DWT cycle counter runs, then start it from 0
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->LAR = 0xC5ACCE55; // Unlock DWT registers on Cortex-M7
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+	loop_profiler_clear();
+}
+
+void loop_profiler_record(loop_profiler_probe_t probe, uint32_t counts) {
+	// Check user inputs
+	if (probe < 0 || probe >= NUM_LOOP_PROFILER_PROBES) {
+		return;
+	}
+
+	loop_profiler_stats_t* stats = &probe_stats[probe];
+	stats->num_samples++;
+	stats->total_counts += counts;
+	if (counts < stats->min_counts) {
+		stats->min_counts = counts;
+	}
+	if (counts > stats->max_counts) {
+		stats->max_counts = counts;
+	}
+
+	// Bin is floor(log2(us)), found from the highest set bit
+	uint32_t us = counts / loop_profiler_counts_per_us();
+	int bin = us ? 31 - __builtin_clz(us) : 0;
+	if (bin >= LOOP_PROFILER_HIST_BINS) {
+		bin = LOOP_PROFILER_HIST_BINS - 1;
+	}
+	stats->hist[bin]++;
+}
+
+const loop_profiler_stats_t* loop_profiler_get_stats(loop_profiler_probe_t probe) {
+	// Check user inputs
+	if (probe < 0 || probe >= NUM_LOOP_PROFILER_PROBES) {
+		return NULL;
+	}
+
+	return &probe_stats[probe];
+}
+
+const char* loop_profiler_get_name(loop_profiler_probe_t probe) {
+	// Check user inputs
+	if (probe < 0 || probe >= NUM_LOOP_PROFILER_PROBES) {
+		return NULL;
+	}
+
+	return probe_names[probe];
+}
+
+void loop_profiler_take_summary(loop_profiler_summary_t* summary) {
+	// Check user inputs
+	if (!summary) {
+		return;
+	}
+
+	uint32_t counts_per_us = loop_profiler_counts_per_us();
+	for (int i = 0; i < NUM_LOOP_PROFILER_PROBES; i++) {
+		const loop_profiler_stats_t* stats = &probe_stats[i];
+		loop_profiler_probe_summary_t* probe_summary = &summary->probes[i];
+		memset(probe_summary, 0, sizeof(*probe_summary));
+		if (stats->num_samples == 0) {
+			continue;
+		}
+
+		probe_summary->num_samples = loop_profiler_saturate_u16(stats->num_samples);
+		probe_summary->min_us = loop_profiler_saturate_u16(stats->min_counts / counts_per_us);
+		probe_summary->max_us = loop_profiler_saturate_u16(stats->max_counts / counts_per_us);
+		probe_summary->mean_us = loop_profiler_saturate_u16(stats->total_counts / stats->num_samples / counts_per_us);
+		for (int bin = 0; bin < LOOP_PROFILER_HIST_BINS; bin++) {
+			probe_summary->hist[bin] = (uint8_t) ((uint64_t) stats->hist[bin] * UINT8_MAX / stats->num_samples);
+		}
+	}
+
+	// Start a new measurement window
+	loop_profiler_clear();
+}
+
+#endif /* LOOP_PROFILER_ENABLED */
@@ -0,0 +1,183 @@
+/*
+ * motion_profile.c
+ */
+
+#include "motion_profile.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#define NUM_SEGMENTS 7
+
+typedef struct segment_t {
+	double duration_s;
+	double jerk;
+} segment_t;
+
+/**
+ * @brief Finds the peak velocity reachable over a distance when accelerating and decelerating within limits
+ * @param[in] distance: Unsigned distance
+ * @param[in] max_vel: Velocity limit
+ * @param[in] max_accel: Acceleration limit
+ * @param[in] max_jerk: Jerk limit
+ * @param[out] jerk_time_s: Duration of each jerk segment
+ * @param[out] accel_time_s: Duration of each constant acceleration segment
+ * @return Peak velocity
+ */
+static double motion_profile_peak_vel(double distance, double max_vel, double max_accel, double max_jerk, double* jerk_time_s, double* accel_time_s) {
+	// Accelerating to v takes sqrt(v / j) of jerk each way if that doesn't hit the acceleration limit, and otherwise
+	// a / j of jerk each way with constant acceleration between. Speeding up and slowing down covers v * (total time accelerating)
+	double vel = max_vel;
+	if (vel * max_jerk < max_accel * max_accel) {
+		double t = sqrt(vel / max_jerk);
+		if (2 * vel * t > distance) {
+			// Too short to reach max velocity, even without reaching max acceleration: d = 2 v sqrt(v / j)
+			vel = pow(distance * sqrt(max_jerk) / 2, 2.0 / 3.0);
+		}
+	} else if (vel * (max_accel / max_jerk + vel / max_accel) > distance) {
+		// Too short to reach max velocity: d = v (a / j + v / a)
+		double k = max_accel / max_jerk;
+		vel = (-k + sqrt(k * k + 4 * distance / max_accel)) * max_accel / 2;
+		if (vel * max_jerk < max_accel * max_accel) {
+			vel = pow(distance * sqrt(max_jerk) / 2, 2.0 / 3.0);
+		}
+	}
+
+	if (vel * max_jerk < max_accel * max_accel) {
+		*jerk_time_s = sqrt(vel / max_jerk);
+		*accel_time_s = 0;
+	} else {
+		*jerk_time_s = max_accel / max_jerk;
+		*accel_time_s = vel / max_accel - *jerk_time_s;
+	}
+	return vel;
+}
+
+bool motion_profile_generate(motion_profile_t* profile, double distance, double max_vel, double max_accel, double max_jerk) {
+	// Check user inputs
+	if (!profile || max_vel <= 0 || max_accel <= 0 || max_jerk <= 0) {
+		return false;
+	}
+
+	profile->direction = distance < 0 ? -1 : 1;
+	profile->cursor = 0;
+	distance = fabs(distance);
+
+	double jerk_time_s;
+	double accel_time_s;
+	double peak_vel = motion_profile_peak_vel(distance, max_vel, max_accel, max_jerk, &jerk_time_s, &accel_time_s);
+	double cruise_time_s = peak_vel > 0 ? (distance - peak_vel * (2 * jerk_time_s + accel_time_s)) / peak_vel : 0;
+	if (cruise_time_s < 0) {
+		cruise_time_s = 0;
+	}
+	segment_t segments[NUM_SEGMENTS] = {
+			{jerk_time_s, max_jerk},
+			{accel_time_s, 0},
+			{jerk_time_s, -max_jerk},
+			{cruise_time_s, 0},
+			{jerk_time_s, -max_jerk},
+			{accel_time_s, 0},
+			{jerk_time_s, max_jerk}
+	};
+	double total_time_s = 0;
+	for (int i = 0; i < NUM_SEGMENTS; i++) {
+		total_time_s += segments[i].duration_s;
+	}
+
+	// Fit the whole move in the table, sampling slower if it's long
+	double dt_s = total_time_s / (MOTION_PROFILE_MAX_SAMPLES - 1);
+	if (dt_s < MOTION_PROFILE_MIN_DT_S) {
+		dt_s = MOTION_PROFILE_MIN_DT_S;
+	}
+	uint32_t num_samples = (uint32_t) ceil(total_time_s / dt_s) + 1;
+	if (num_samples > MOTION_PROFILE_MAX_SAMPLES) {
+		num_samples = MOTION_PROFILE_MAX_SAMPLES;
+	}
+	profile->dt_s = (float) dt_s;
+
+	// Step through segments alongside sample times, carrying the exact state at each segment start
+	int segment = 0;
+	double segment_start_s = 0;
+	double pos = 0;
+	double vel = 0;
+	double accel = 0;
+	for (uint32_t i = 0; i < num_samples; i++) {
+		double t = i * dt_s;
+		while (segment < NUM_SEGMENTS && t >= segment_start_s + segments[segment].duration_s) {
+			double d = segments[segment].duration_s;
+			double j = segments[segment].jerk;
+			pos += vel * d + accel * d * d / 2 + j * d * d * d / 6;
+			vel += accel * d + j * d * d / 2;
+			accel += j * d;
+			segment_start_s += d;
+			segment++;
+		}
+
+		motion_profile_sample_t* sample = &profile->samples[i];
+		if (segment >= NUM_SEGMENTS) {
+			sample->pos = (float) distance;
+			sample->vel = 0;
+			sample->accel = 0;
+		} else {
+			double d = t - segment_start_s;
+			double j = segments[segment].jerk;
+			sample->pos = (float) (pos + vel * d + accel * d * d / 2 + j * d * d * d / 6);
+			sample->vel = (float) (vel + accel * d + j * d * d / 2);
+			sample->accel = (float) (accel + j * d);
+		}
+	}
+	profile->samples[num_samples - 1].pos = (float) distance;
+	profile->samples[num_samples - 1].vel = 0;
+	profile->samples[num_samples - 1].accel = 0;
+	profile->num_samples = num_samples;
+	return true;
+}
+
+motion_profile_sample_t motion_profile_lookup(motion_profile_t* profile, double pos) {
+	motion_profile_sample_t result = {0, 0, 0};
+
+	// Check user inputs
+	if (!profile || profile->num_samples == 0) {
+		return result;
+	}
+
+	// Move the cursor up to the position. It's usually already there or one step behind
+	float unsigned_pos = (float) (pos * profile->direction);
+	uint32_t last = profile->num_samples - 1;
+	while (profile->cursor < last && profile->samples[profile->cursor + 1].pos <= unsigned_pos) {
+		profile->cursor++;
+	}
+
+	// Interpolate between the next two samples at the same fraction the position is between the current two
+	uint32_t i = profile->cursor;
+	if (i + 1 >= last) {
+		result = profile->samples[last];
+	} else {
+		const motion_profile_sample_t* a = &profile->samples[i];
+		const motion_profile_sample_t* b = &profile->samples[i + 1];
+		const motion_profile_sample_t* c = &profile->samples[i + 2];
+		float frac = b->pos > a->pos ? (unsigned_pos - a->pos) / (b->pos - a->pos) : 0;
+		if (frac < 0) {
+			frac = 0;
+		} else if (frac > 1) {
+			frac = 1;
+		}
+		result.pos = b->pos + frac * (c->pos - b->pos);
+		result.vel = b->vel + frac * (c->vel - b->vel);
+		result.accel = b->accel + frac * (c->accel - b->accel);
+	}
+
+	result.pos *= profile->direction;
+	result.vel *= profile->direction;
+	result.accel *= profile->direction;
+	return result;
+}
+
+double motion_profile_get_distance(const motion_profile_t* profile) {
+	// Check user inputs
+	if (!profile || profile->num_samples == 0) {
+		return 0;
+	}
+
+	return profile->samples[profile->num_samples - 1].pos * profile->direction;
+}
@@ -0,0 +1,98 @@
+/*
+ * odometry_manager.c
+ */
+
+#include "odometry_manager.h"
+#include "encoder.h"
+#include "peripheral_assigner.h"
+#include "wheel_velocity.h"
+
+#include <math.h>
+
+#define ENCODER_M_PER_TICK		(2 * 3.14159265358979 * DRIVE_WHEEL_RADIUS_M / ENCODER_TICKS_PER_REV)
+#define ENCODER_TICKS_PER_EDGE	4 // Only A channel rising edges are captured, one per quadrature cycle
+
+static encoder_t encoder_l;
+static encoder_t encoder_r;
+static pose2d_t pose;
+static wheel_velocity_t wheel_vel_l;
+static wheel_velocity_t wheel_vel_r;
+
+static odometry_snapshot_t snapshots[2];
+static volatile uint32_t num_published; // Snapshot num_published & 1 is the newest, written only by the interrupt
+
+/**
+ * @brief Samples both encoders, integrates the pose, and publishes a snapshot. Runs from ODOMETRY_TIMER's interrupt
+ * @param[in] htim: Timer handle
+ */
+static void odometry_manager_sample(TIM_HandleTypeDef* htim) {
+	(void) htim; // Unused, just needed for callback
+	int64_t last_ticks_l = encoder_l.data.ticks;
+	int64_t last_ticks_r = encoder_r.data.ticks;
+	const encoder_data_t* data_l = encoder_get_data(&encoder_l);
+	const encoder_data_t* data_r = encoder_get_data(&encoder_r);
+
+	// Midpoint heading integrates arcs exactly to second order. Most samples see no motion, so skip the trig on those
+	if (data_l->ticks != last_ticks_l || data_r->ticks != last_ticks_r) {
+		double dist_l = (data_l->ticks - last_ticks_l) * ENCODER_M_PER_TICK;
+		double dist_r = (data_r->ticks - last_ticks_r) * ENCODER_M_PER_TICK;
+		double distance = (dist_l + dist_r) / 2;
+		double delta_theta = (dist_r - dist_l) / WHEEL_BASE_M;
+		double mid_theta = pose.theta + delta_theta / 2;
+		pose.x += distance * cos(mid_theta);
+		pose.y += distance * sin(mid_theta);
+		pose.theta += delta_theta;
+	}
+
+	double ticks_per_s_l = wheel_velocity_update(&wheel_vel_l, data_l->edge_time, data_l->edge_ticks, data_l->capture_time);
+	double ticks_per_s_r = wheel_velocity_update(&wheel_vel_r, data_r->edge_time, data_r->edge_ticks, data_r->capture_time);
+
+	odometry_snapshot_t* snapshot = &snapshots[(num_published + 1) & 1];
+	snapshot->pose = pose;
+	snapshot->ticks_l = data_l->ticks;
+	snapshot->ticks_r = data_r->ticks;
+	snapshot->vel_l_mps = (float) (ticks_per_s_l * ENCODER_M_PER_TICK);
+	snapshot->vel_r_mps = (float) (ticks_per_s_r * ENCODER_M_PER_TICK);
+	snapshot->timestamp_us = data_r->timestamp_us;
+
+	// Snapshot must be complete before it's published
+	__DMB();
+	num_published++;
+}
+
+void odometry_manager_init() {
+	encoder_init(&encoder_l, ENCODER_LEFT_TIMER, ENCODER_LEFT_CAPTURE_TIMER);
+	encoder_init(&encoder_r, ENCODER_RIGHT_TIMER, ENCODER_RIGHT_CAPTURE_TIMER);
+	wheel_velocity_init(&wheel_vel_l, encoder_l.capture_clock_hz, ENCODER_TICKS_PER_EDGE);
+	wheel_velocity_init(&wheel_vel_r, encoder_r.capture_clock_hz, ENCODER_TICKS_PER_EDGE);
+	pose.x = 0;
+	pose.y = 0;
+	pose.theta = 0;
+	num_published = 0;
+
+	encoder_start(&encoder_l);
+	encoder_start(&encoder_r);
+	HAL_TIM_RegisterCallback(ODOMETRY_TIMER, HAL_TIM_PERIOD_ELAPSED_CB_ID, odometry_manager_sample);
+	HAL_TIM_Base_Start_IT(ODOMETRY_TIMER);
+}
+
+bool odometry_manager_get_snapshot(odometry_snapshot_t* snapshot) {
+	// Check user input
+	if (!snapshot) {
+		return false;
+	}
+
+	// The interrupt fully runs between reads here. It writes the other buffer first, so the copy is only
+	// overwritten if it publishes twice during it
+	uint32_t published;
+	do {
+		published = num_published;
+		if (published == 0) {
+			return false;
+		}
+		__DMB();
+		*snapshot = snapshots[published & 1];
+		__DMB();
+	} while (num_published - published > 1);
+	return true;
+}
@@ -0,0 +1,404 @@
+/*
+ * particle_filter.c
+ */
+
+#include "particle_filter.h"
+
+#include <math.h>
+#include <string.h>
+
+#define PF_PI 		3.14159265f
+#define PF_TWO_PI	6.28318531f
+#define PF_SQRT6	2.44948974f
+
+/**
+ * @brief Mixes bits of a 32-bit value (lowbias32 integer hash)
+ * @param[in] x: Value to hash
+ * @return Hashed value
+ */
+static inline uint32_t particle_filter_hash(uint32_t x) {
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+/**
+ * @brief Gets a new seed for one batch of per-particle random draws
+ * @param[in, out] pf: Particle filter
+ * @return Seed for the batch
+ */
+static uint32_t particle_filter_next_seed(particle_filter_t* pf) {
+	pf->seed++;
+	return particle_filter_hash(pf->seed);
+}
+
+/**
+ * @brief Approximately normal random number with zero mean and unit variance
+ * @param[in] seed: Seed of the current batch of draws
+ * @param[in] i: Index of the draw in the batch
+ * @return Random number
+ *
+ * Counter-based (hash of seed and index) rather than a sequential generator so loops over particles have no carried dependency.
+ * The sum of two uniforms (triangular distribution) is close enough to normal for motion noise.
+ */
+static inline float particle_filter_randn(uint32_t seed, uint32_t i) {
+	uint32_t h = particle_filter_hash(seed ^ (i * 0x9E3779B9u));
+	float u = (float) (h & 0xFFFF) + (float) (h >> 16);
+	return (u * (1.0f / 65536.0f) - 1.0f) * PF_SQRT6;
+}
+
+/**
+ * @brief Wraps an angle to [-PI, PI)
+ * @param[in] angle: Angle in radians
+ * @return Wrapped angle
+ */
+static inline float particle_filter_wrap_angle(float angle) {
+	return angle - PF_TWO_PI * floorf((angle + PF_PI) * (1.0f / PF_TWO_PI));
+}
+
+void particle_filter_init(particle_filter_t* pf, pose3d_t pose, float pos_std_m, float ang_std_rad, uint32_t seed) {
+	// Check user inputs
+	if (!pf) {
+		return;
+	}
+
+	pf->seed = seed;
+	uint32_t seed_x = particle_filter_next_seed(pf);
+	uint32_t seed_y = particle_filter_next_seed(pf);
+	uint32_t seed_z = particle_filter_next_seed(pf);
+	uint32_t seed_yaw = particle_filter_next_seed(pf);
+	uint32_t seed_pitch = particle_filter_next_seed(pf);
+	uint32_t seed_roll = particle_filter_next_seed(pf);
+	const float equal_weight = 1.0f / PARTICLE_FILTER_NUM_PARTICLES;
+
+	for (uint32_t i = 0; i < PARTICLE_FILTER_NUM_PARTICLES; i++) {
+		pf->x[i] = pose.x + pos_std_m * particle_filter_randn(seed_x, i);
+		pf->y[i] = pose.y + pos_std_m * particle_filter_randn(seed_y, i);
+		pf->z[i] = pose.z + pos_std_m * particle_filter_randn(seed_z, i);
+		pf->yaw[i] = particle_filter_wrap_angle(pose.yaw + ang_std_rad * particle_filter_randn(seed_yaw, i));
+		pf->pitch[i] = pose.pitch + ang_std_rad * particle_filter_randn(seed_pitch, i);
+		pf->roll[i] = pose.roll + ang_std_rad * particle_filter_randn(seed_roll, i);
+		pf->weight[i] = equal_weight;
+	}
+	pf->num_particles = PARTICLE_FILTER_NUM_PARTICLES;
+}
+
+void particle_filter_predict(particle_filter_t* pf, float distance_m, float delta_yaw_rad, float distance_std_m, float yaw_std_rad, float tilt_std_rad) {
+	// Check user inputs
+	if (!pf) {
+		return;
+	}
+
+	particle_filter_motion_t motion = particle_filter_motion(pf, distance_m, delta_yaw_rad, distance_std_m, yaw_std_rad, tilt_std_rad);
+	particle_filter_predict_range(pf, &motion, 0, pf->num_particles);
+}
+
+particle_filter_motion_t particle_filter_motion(particle_filter_t* pf, float distance_m, float delta_yaw_rad, float distance_std_m, float yaw_std_rad, float tilt_std_rad) {
+	particle_filter_motion_t motion = {distance_m, delta_yaw_rad, distance_std_m, yaw_std_rad, tilt_std_rad, 0, 0, 0, 0};
+	// Check user inputs
+	if (!pf) {
+		return motion;
+	}
+
+	motion.seed_distance = particle_filter_next_seed(pf);
+	motion.seed_yaw = particle_filter_next_seed(pf);
+	motion.seed_pitch = particle_filter_next_seed(pf);
+	motion.seed_roll = particle_filter_next_seed(pf);
+	return motion;
+}
+
+void particle_filter_predict_range(particle_filter_t* pf, const particle_filter_motion_t* motion, uint32_t begin, uint32_t end) {
+	// Check user inputs
+	if (!pf || !motion) {
+		return;
+	}
+	if (end > pf->num_particles) {
+		end = pf->num_particles;
+	}
+
+	const float distance_m = motion->distance_m;
+	const float delta_yaw_rad = motion->delta_yaw_rad;
+	const float distance_std_m = motion->distance_std_m;
+	const float yaw_std_rad = motion->yaw_std_rad;
+	const float tilt_std_rad = motion->tilt_std_rad;
+	const uint32_t seed_dist = motion->seed_distance;
+	const uint32_t seed_yaw = motion->seed_yaw;
+	const uint32_t seed_pitch = motion->seed_pitch;
+	const uint32_t seed_roll = motion->seed_roll;
+	float* restrict x = pf->x;
+	float* restrict y = pf->y;
+	float* restrict z = pf->z;
+	float* restrict yaw = pf->yaw;
+	float* restrict pitch = pf->pitch;
+	float* restrict roll = pf->roll;
+
+	for (uint32_t i = begin; i < end; i++) {
+		float dist = distance_m + distance_std_m * particle_filter_randn(seed_dist, i);
+		float dyaw = delta_yaw_rad + yaw_std_rad * particle_filter_randn(seed_yaw, i);
+
+		// Drive along the average heading over the step, tilted by pitch
+		float mid_yaw = yaw[i] + 0.5f * dyaw;
+		float horizontal = dist * cosf(pitch[i]);
+		x[i] += horizontal * cosf(mid_yaw);
+		y[i] += horizontal * sinf(mid_yaw);
+		z[i] += dist * sinf(pitch[i]);
+		yaw[i] = particle_filter_wrap_angle(yaw[i] + dyaw);
+
+		// Pitch and roll aren't driven by odometry, so let them random walk for the IMU to correct
+		pitch[i] += tilt_std_rad * particle_filter_randn(seed_pitch, i);
+		roll[i] += tilt_std_rad * particle_filter_randn(seed_roll, i);
+	}
+}
+
+void particle_filter_weight_position(particle_filter_t* pf, float meas_x, float meas_y, float std_m) {
+	// Check user inputs
+	if (!pf) {
+		return;
+	}
+
+	particle_filter_weight_position_range(pf, meas_x, meas_y, std_m, 0, pf->num_particles);
+}
+
+void particle_filter_weight_position_range(particle_filter_t* pf, float meas_x, float meas_y, float std_m, uint32_t begin, uint32_t end) {
+	// Check user inputs
+	if (!pf || std_m <= 0) {
+		return;
+	}
+	if (end > pf->num_particles) {
+		end = pf->num_particles;
+	}
+
+	const float inv_var = 1.0f / (std_m * std_m);
+	const float* restrict x = pf->x;
+	const float* restrict y = pf->y;
+	float* restrict weight = pf->weight;
+
+	for (uint32_t i = begin; i < end; i++) {
+		float dx = x[i] - meas_x;
+		float dy = y[i] - meas_y;
+		weight[i] *= expf(-0.5f * (dx * dx + dy * dy) * inv_var);
+	}
+}
+
+void particle_filter_weight_orientation(particle_filter_t* pf, float meas_yaw, float meas_pitch, float meas_roll, float yaw_std_rad, float tilt_std_rad) {
+	// Check user inputs
+	if (!pf) {
+		return;
+	}
+
+	particle_filter_weight_orientation_range(pf, meas_yaw, meas_pitch, meas_roll, yaw_std_rad, tilt_std_rad, 0, pf->num_particles);
+}
+
+void particle_filter_weight_orientation_range(particle_filter_t* pf, float meas_yaw, float meas_pitch, float meas_roll, float yaw_std_rad, float tilt_std_rad, uint32_t begin, uint32_t end) {
+	// Check user inputs
+	if (!pf || yaw_std_rad <= 0 || tilt_std_rad <= 0) {
+		return;
+	}
+	if (end > pf->num_particles) {
+		end = pf->num_particles;
+	}
+
+	const float inv_var_yaw = 1.0f / (yaw_std_rad * yaw_std_rad);
+	const float inv_var_tilt = 1.0f / (tilt_std_rad * tilt_std_rad);
+	const float* restrict yaw = pf->yaw;
+	const float* restrict pitch = pf->pitch;
+	const float* restrict roll = pf->roll;
+	float* restrict weight = pf->weight;
+
+	for (uint32_t i = begin; i < end; i++) {
+		float dyaw = particle_filter_wrap_angle(yaw[i] - meas_yaw);
+		float dpitch = pitch[i] - meas_pitch;
+		float droll = roll[i] - meas_roll;
+		weight[i] *= expf(-0.5f * (dyaw * dyaw * inv_var_yaw + (dpitch * dpitch + droll * droll) * inv_var_tilt));
+	}
+}
+
+void particle_filter_truncate(particle_filter_t* pf, uint32_t num_particles) {
+	// Check user inputs
+	if (!pf || num_particles < 1) {
+		return;
+	}
+
+	// Slots aren't ordered by pose, since resampling leaves survivors in place and fills gaps wherever they are, so
+	// dropping the tail keeps the rest of the set representative
+	if (num_particles < pf->num_particles) {
+		pf->num_particles = num_particles;
+	}
+}
+
+float particle_filter_normalize(particle_filter_t* pf) {
+	// Check user inputs
+	if (!pf) {
+		return 0;
+	}
+
+	float* restrict weight = pf->weight;
+	const uint32_t num_particles = pf->num_particles;
+	float sum = 0;
+	for (uint32_t i = 0; i < num_particles; i++) {
+		sum += weight[i];
+	}
+
+	// Every particle disagreed with the measurements. Nothing better is known, so treat them equally
+	if (!(sum > 0) || isinf(sum)) {
+		for (uint32_t i = 0; i < num_particles; i++) {
+			weight[i] = 1.0f / num_particles;
+		}
+		return num_particles;
+	}
+
+	const float inv_sum = 1.0f / sum;
+	float sum_sq = 0;
+	for (uint32_t i = 0; i < num_particles; i++) {
+		weight[i] *= inv_sum;
+		sum_sq += weight[i] * weight[i];
+	}
+	return 1.0f / sum_sq;
+}
+
+/**
+ * @brief Copies one particle over another
+ * @param[in, out] pf: Particle filter
+ * @param[in] dst: Index of particle to overwrite
+ * @param[in] src: Index of particle to copy
+ */
+static void particle_filter_copy(particle_filter_t* pf, uint32_t dst, uint32_t src) {
+	pf->x[dst] = pf->x[src];
+	pf->y[dst] = pf->y[src];
+	pf->z[dst] = pf->z[src];
+	pf->yaw[dst] = pf->yaw[src];
+	pf->pitch[dst] = pf->pitch[src];
+	pf->roll[dst] = pf->roll[src];
+}
+
+void particle_filter_resample(particle_filter_t* pf, uint32_t num_particles) {
+	// Check user inputs
+	if (!pf) {
+		return;
+	}
+	if (num_particles < PARTICLE_FILTER_MIN_PARTICLES) {
+		num_particles = PARTICLE_FILTER_MIN_PARTICLES;
+	} else if (num_particles > PARTICLE_FILTER_NUM_PARTICLES) {
+		num_particles = PARTICLE_FILTER_NUM_PARTICLES;
+	}
+
+	// Systematic resampling: evenly spaced pointers with one random offset walk the cumulative weights once,
+	// counting how many copies of each particle survive
+	const uint32_t old_num_particles = pf->num_particles;
+	const uint32_t max_num_particles = old_num_particles > num_particles ? old_num_particles : num_particles;
+	const float step = 1.0f / num_particles;
+	float pointer = step * (float) (particle_filter_next_seed(pf) >> 8) * (1.0f / 16777216.0f);
+	float cumulative = pf->weight[0];
+	uint32_t src = 0;
+	for (uint32_t i = 0; i < max_num_particles; i++) {
+		pf->copies[i] = 0;
+	}
+	for (uint32_t i = 0; i < num_particles; i++) {
+		while (pointer > cumulative && src < old_num_particles - 1) {
+			src++;
+			cumulative += pf->weight[src];
+		}
+		pf->copies[src]++;
+		pointer += step;
+	}
+
+	// Survivors below the new count stay put. Slots below the new count with no copies are free, and are filled by
+	// the extra copies of survivors plus every copy of survivors past the new count. Free slots are never a source, so nothing is moved twice
+	uint32_t free_slot = 0;
+	for (uint32_t i = 0; i < old_num_particles; i++) {
+		uint16_t num_moves = i < num_particles && pf->copies[i] ? pf->copies[i] - 1 : pf->copies[i];
+		for (uint16_t move = 0; move < num_moves; move++) {
+			while (pf->copies[free_slot] != 0) {
+				free_slot++;
+			}
+			particle_filter_copy(pf, free_slot, i);
+			free_slot++;
+		}
+	}
+
+	for (uint32_t i = 0; i < num_particles; i++) {
+		pf->weight[i] = step;
+	}
+	pf->num_particles = num_particles;
+}
+
+/**
+ * @brief Floors a value into the index of its bin
+ * @param[in] val: Value to bin
+ * @param[in] inv_bin_size: 1 / width of a bin
+ * @return Bin index
+ */
+static inline int32_t particle_filter_bin(float val, float inv_bin_size) {
+	return (int32_t) floorf(val * inv_bin_size);
+}
+
+uint32_t particle_filter_kld_num_particles(particle_filter_t* pf, float bin_size_m, float bin_size_rad, float epsilon, float z_quantile) {
+	// Check user inputs
+	if (!pf || bin_size_m <= 0 || bin_size_rad <= 0 || epsilon <= 0) {
+		return PARTICLE_FILTER_MIN_PARTICLES;
+	}
+
+	// Count occupied bins with an open-addressed set. Keys pack 11 bits each of x and y bins and 9 bits of yaw bin
+	// (position wraps every 2048 bins, which only merges bins far apart) with the top bit marking the slot used
+	const float inv_bin_size_m = 1.0f / bin_size_m;
+	const float inv_bin_size_rad = 1.0f / bin_size_rad;
+	uint32_t num_bins = 0;
+	memset(pf->kld_bins, 0, sizeof(pf->kld_bins));
+	for (uint32_t i = 0; i < pf->num_particles; i++) {
+		uint32_t key = 0x80000000u
+				| ((uint32_t) particle_filter_bin(pf->x[i], inv_bin_size_m) & 0x7FF)
+				| (((uint32_t) particle_filter_bin(pf->y[i], inv_bin_size_m) & 0x7FF) << 11)
+				| (((uint32_t) particle_filter_bin(pf->yaw[i], inv_bin_size_rad) & 0x1FF) << 22);
+		uint32_t slot = particle_filter_hash(key) & (PARTICLE_FILTER_KLD_TABLE_SIZE - 1);
+		while (pf->kld_bins[slot] != 0 && pf->kld_bins[slot] != key) {
+			slot = (slot + 1) & (PARTICLE_FILTER_KLD_TABLE_SIZE - 1);
+		}
+		if (pf->kld_bins[slot] == 0) {
+			pf->kld_bins[slot] = key;
+			num_bins++;
+		}
+	}
+
+	if (num_bins < 2) {
+		return PARTICLE_FILTER_MIN_PARTICLES;
+	}
+
+	// Wilson-Hilferty approximation of the chi-square quantile with num_bins - 1 degrees of freedom
+	float a = 2.0f / (9.0f * (num_bins - 1));
+	float b = 1.0f - a + sqrtf(a) * z_quantile;
+	float required = (num_bins - 1) / (2.0f * epsilon) * b * b * b;
+	if (required < PARTICLE_FILTER_MIN_PARTICLES) {
+		return PARTICLE_FILTER_MIN_PARTICLES;
+	}
+	if (required > PARTICLE_FILTER_NUM_PARTICLES) {
+		return PARTICLE_FILTER_NUM_PARTICLES;
+	}
+	return (uint32_t) ceilf(required);
+}
+
+pose3d_t particle_filter_estimate(const particle_filter_t* pf) {
+	pose3d_t mean = {0};
+	// Check user inputs
+	if (!pf) {
+		return mean;
+	}
+
+	// Average angles as offsets from a reference particle so wrap around at +/-PI doesn't skew the mean
+	const float ref_yaw = pf->yaw[0];
+	const uint32_t num_particles = pf->num_particles;
+	float mean_dyaw = 0;
+	for (uint32_t i = 0; i < num_particles; i++) {
+		float w = pf->weight[i];
+		mean.x += w * pf->x[i];
+		mean.y += w * pf->y[i];
+		mean.z += w * pf->z[i];
+		mean_dyaw += w * particle_filter_wrap_angle(pf->yaw[i] - ref_yaw);
+		mean.pitch += w * pf->pitch[i];
+		mean.roll += w * pf->roll[i];
+	}
+	mean.yaw = particle_filter_wrap_angle(ref_yaw + mean_dyaw);
+	return mean;
+}
@@ -0,0 +1,80 @@
+/*
+ * pose_history.c
+ */
+
+#include "pose_history.h"
+
+#include <math.h>
+#include <stddef.h>
+
+void pose_history_init(pose_history_t* history) {
+	// Check user inputs
+	if (!history) {
+		return;
+	}
+
+	history->num_entries = 0;
+	history->newest = POSE_HISTORY_LENGTH - 1;
+}
+
+void pose_history_push(pose_history_t* history, uint32_t timestamp_us, pose3d_t pose) {
+	// Check user inputs
+	if (!history) {
+		return;
+	}
+
+	if (history->num_entries == 0 || history->entries[history->newest].timestamp_us != timestamp_us) {
+		history->newest = (history->newest + 1) % POSE_HISTORY_LENGTH;
+		if (history->num_entries < POSE_HISTORY_LENGTH) {
+			history->num_entries++;
+		}
+	}
+	history->entries[history->newest].timestamp_us = timestamp_us;
+	history->entries[history->newest].pose = pose;
+}
+
+/**
+ * @brief Interpolates between two angles the short way around the circle
+ * @param[in] a: Angle at fraction 0
+ * @param[in] b: Angle at fraction 1
+ * @param[in] frac: Fraction of the way from a to b
+ * @return Interpolated angle in [-PI, PI)
+ */
+static float pose_history_lerp_angle(float a, float b, float frac) {
+	const float two_pi = 6.28318531f;
+	float diff = b - a;
+	diff -= two_pi * floorf((diff + 3.14159265f) / two_pi);
+	float angle = a + frac * diff;
+	return angle - two_pi * floorf((angle + 3.14159265f) / two_pi);
+}
+
+bool pose_history_get(const pose_history_t* history, uint32_t timestamp_us, pose3d_t* pose) {
+	// Check user inputs
+	if (!history || !pose || history->num_entries == 0) {
+		return false;
+	}
+
+	// Walk back from the newest entry until one is at or before the requested time. Times are compared
+	// as signed differences so the microsecond counter wrapping doesn't matter
+	const pose_history_entry_t* newer = &history->entries[history->newest];
+	if ((int32_t) (newer->timestamp_us - timestamp_us) <= 0) {
+		*pose = newer->pose;
+		return true;
+	}
+	for (uint32_t i = 1; i < history->num_entries; i++) {
+		const pose_history_entry_t* older = &history->entries[(history->newest + POSE_HISTORY_LENGTH - i) % POSE_HISTORY_LENGTH];
+		int32_t since_older_us = (int32_t) (timestamp_us - older->timestamp_us);
+		if (since_older_us >= 0) {
+			float frac = (float) since_older_us / (int32_t) (newer->timestamp_us - older->timestamp_us);
+			pose->x = older->pose.x + frac * (newer->pose.x - older->pose.x);
+			pose->y = older->pose.y + frac * (newer->pose.y - older->pose.y);
+			pose->z = older->pose.z + frac * (newer->pose.z - older->pose.z);
+			pose->yaw = pose_history_lerp_angle(older->pose.yaw, newer->pose.yaw, frac);
+			pose->pitch = older->pose.pitch + frac * (newer->pose.pitch - older->pose.pitch);
+			pose->roll = older->pose.roll + frac * (newer->pose.roll - older->pose.roll);
+			return true;
+		}
+		newer = older;
+	}
+	return false;
+}
@@ -0,0 +1,110 @@
+/*
+ * rate_scheduler.cpp
+ */
+
+#include "rate_scheduler.h"
+
+#include <cstddef>
+
+int RateScheduler::add_group(const char* name, uint32_t period_ticks, uint8_t priority, rate_group_task_t task, void* context) {
+	// Check user inputs
+	if (num_groups_ >= MAX_RATE_GROUPS || period_ticks == 0 || !task) {
+		return -1;
+	}
+
+	rate_group_t* group = &groups_[num_groups_];
+	group->name = name;
+	group->period_ticks = period_ticks;
+	group->priority = priority;
+	group->enabled = false;
+	group->task = task;
+	group->context = context;
+	group->next_release_tick = 0;
+	group->stats = {};
+
+	return num_groups_++;
+}
+
+void RateScheduler::set_enabled(int group_id, bool b_enable) {
+	// Check user inputs
+	if (group_id < 0 || group_id >= num_groups_) {
+		return;
+	}
+
+	rate_group_t* group = &groups_[group_id];
+	if (b_enable && !group->enabled) {
+		group->next_release_tick = clock_();
+	}
+	group->enabled = b_enable;
+}
+
+bool RateScheduler::run_once() {
+	uint32_t now = clock_();
+
+	// Find the highest-priority group that is due. Signed difference handles clock wrap around
+	rate_group_t* due_group = nullptr;
+	for (int i = 0; i < num_groups_; i++) {
+		rate_group_t* group = &groups_[i];
+		if (!group->enabled || (int32_t) (now - group->next_release_tick) < 0) {
+			continue;
+		}
+		if (!due_group || group->priority < due_group->priority) {
+			due_group = group;
+		}
+	}
+
+	// Nothing to do until the next tick
+	if (!due_group) {
+		if (idle_) {
+			idle_();
+		}
+		return false;
+	}
+
+	// Skip releases that were missed entirely instead of running them back to back
+	uint32_t jitter = now - due_group->next_release_tick;
+	if (jitter >= due_group->period_ticks) {
+		uint32_t num_skipped = jitter / due_group->period_ticks;
+		due_group->stats.deadline_misses += num_skipped;
+		due_group->next_release_tick += num_skipped * due_group->period_ticks;
+		jitter -= num_skipped * due_group->period_ticks;
+	}
+	if (jitter > due_group->stats.max_jitter_ticks) {
+		due_group->stats.max_jitter_ticks = jitter;
+	}
+
+	// Run the group's task and time it
+	due_group->task(due_group->context);
+	uint32_t end = clock_();
+	uint32_t exec = end - now;
+	due_group->stats.releases++;
+	if (exec > due_group->stats.max_exec_ticks) {
+		due_group->stats.max_exec_ticks = exec;
+	}
+	if (exec > due_group->period_ticks) {
+		due_group->stats.overruns++;
+	}
+
+	// Deadline of this release is the start of the next one
+	due_group->next_release_tick += due_group->period_ticks;
+	if ((int32_t) (end - due_group->next_release_tick) > 0) {
+		due_group->stats.deadline_misses++;
+	}
+
+	return true;
+}
+
+const rate_group_stats_t* RateScheduler::get_stats(int group_id) const {
+	// Check user inputs
+	if (group_id < 0 || group_id >= num_groups_) {
+		return NULL;
+	}
+
+	return &groups_[group_id].stats;
+}
+
+void RateScheduler::reset_stats() {
+	for (int i = 0; i < num_groups_; i++) {
+		groups_[i].stats = {};
+	}
+}
@@ -4,76 +4,249 @@
 
 #include "scheduler.h"
 
+#include <math.h>
+
+#include "drive_manager.h"
+#include "gpr_manager.h"
+#include "localization_manager.h"
+#include "loop_profiler.h"
+#include "odometry_manager.h"
+#include "rate_scheduler.h"
 #include "state_disabled.h"
 #include "state_drive.h"
+#include "state_drive_record.h"
 #include "state_initialize.h"
+#include "state_machine.h"
 #include "state_record.h"
 #include "stm32f7xx_hal.h"
+#include "telemetry_manager.h"
+
+// Rate group periods in HAL ticks (ms)
+#define CONTROL_PERIOD_MS		1	// Drive control loop (1 kHz)
+#define LOCALIZATION_PERIOD_MS	10	// Localization estimate update (100 Hz)
+#define STATE_PERIOD_MS			10	// State machine init/run/cleanup (100 Hz)
+#define TELEMETRY_PERIOD_MS		50	// Pose telemetry (20 Hz)
+#define MONITORING_DECIMATION	20	// Telemetry group releases per monitoring message (1 Hz)
+
+// What GPR sweeps are telemetered as
+#define GPR_TELEMETRY_RAW			0	// Every ADC sample of each step
+#define GPR_TELEMETRY_IQ			1	// One I/Q sample per step
+#define GPR_TELEMETRY_RANGE_PROFILE	2	// Magnitude of each range bin
+#define GPR_TELEMETRY_MODE			GPR_TELEMETRY_RANGE_PROFILE
+
+// Rate group priorities (0 = highest)
+#define CONTROL_PRIORITY		0
+#define LOCALIZATION_PRIORITY	1
+#define STATE_PRIORITY			2
+#define TELEMETRY_PRIORITY		3
 
-#define LOOP_PERIOD_MS 10  // How often a loop of the code should be run
+// Order must match the order groups are added in scheduler_run()
+typedef enum rate_group_id {
+	ControlGroup = 0,
+	LocalizationGroup,
+	TelemetryGroup,
+	StateGroup,
+	NUM_RATE_GROUPS
+} rate_group_id;
 
+static StateMachine state_machine;
 static State* p_current_state;
 static State* p_next_state;
+static InitializeState* p_initialize_state;
+
+static_assert(TELEMETRY_NUM_SUBSYSTEMS == InitializeState::NUM_SUBSYSTEMS, "Monitoring message must report every subsystem");
+
+/**
+ * @brief Clock for the rate scheduler
+ * @return Current HAL tick in ms
+ */
+static uint32_t scheduler_clock() {
+	return HAL_GetTick();
+}
 
-typedef enum state_id {
-	Disabled = 0,
-	Drive,
-	Initialize,
-	Record,
-	NUM_STATES,
-	UNKNOWN
-} state_id;
+/**
+ * @brief Sleeps until the next interrupt (at latest the next SysTick) when no rate group is due
+ */
+static void scheduler_idle() {
+	__WFI();
+}
 
 /**
- * @brief Get the next state based on the current state and its end status
- * @param[in] end_status: What the current state returned as its status
+ * @brief Runs a single instance of the drive control loop with the latest localization estimate
+ * @param[in] context: Unused
  */
-static state_id get_next_state(end_status_t end_status) {
-	// Return the current state if there's no change
-	if (end_status == end_status_t::NoChange) {
-		return (state_id) p_current_state->get_id();
+static void scheduler_control_task(void* context) {
+	(void) context;
+	localization_estimate_t* estimate = localization_manager_get_estimate();
+	drive_state_estimation_t state_estimation = {
+		estimate->vel.x * cos(estimate->heading_zyx.z) + estimate->vel.y * sin(estimate->heading_zyx.z),
+		estimate->heading_zyx.z,
+		estimate->ang_vel_zyx.z
+	};
+
+	// Wheel velocities are fresher straight from odometry than through the last localization update
+	odometry_snapshot_t odometry;
+	if (odometry_manager_get_snapshot(&odometry)) {
+		state_estimation.vel = (odometry.vel_l_mps + odometry.vel_r_mps) / 2;
+		state_estimation.ang_vel_yaw = (odometry.vel_r_mps - odometry.vel_l_mps) / WHEEL_BASE_M;
+	}
+	LOOP_PROFILER_BEGIN(LOOP_PROFILER_PROBE_DRIVE_RUN);
+	drive_manager_run(&state_estimation);
+	LOOP_PROFILER_END(LOOP_PROFILER_PROBE_DRIVE_RUN);
+}
+
+/**
+ * @brief Updates the localization estimate with new sensor data
+ * @param[in] context: Unused
+ */
+static void scheduler_localization_task(void* context) {
+	(void) context;
+	LOOP_PROFILER_BEGIN(LOOP_PROFILER_PROBE_LOCALIZATION_UPDATE);
+	localization_manager_update_estimates();
+	LOOP_PROFILER_END(LOOP_PROFILER_PROBE_LOCALIZATION_UPDATE);
+}
+
+/**
+ * @brief Telemeters the latest GPR sweep tagged with where it was captured, as much per release as the radio has room for.
+ * Sweeps that finish while one is still being sent are skipped
+ */
+static void scheduler_send_gpr_trace() {
+	static bool sending = false;
+	static bool restart = false;
+	static uint32_t sent_trace_num = 0;
+	static gpr_trace_info_t trace;
+
+	// Only sweeps tagged with a pose are worth sending
+	if (!sending) {
+		if (!gpr_manager_get_trace_info(&trace) || !trace.has_pose || trace.trace_num == sent_trace_num) {
+			return;
+		}
+		sending = true;
+		restart = true;
+	}
+
+#if GPR_TELEMETRY_MODE == GPR_TELEMETRY_RAW
+	// Raw samples are read out of the sweep matrix as they're sent, so wait out sweeps in progress. The trace header isn't
+	// part of raw messages, so a later sweep overwriting the rest of this one shows up as a jump in the data only
+	static int step_num = 0;
+	uint16_t* data;
+	double* freqs_mhz;
+	int num_steps;
+	int array_samples_per_step;
+	int num_samples;
+	if (!gpr_manager_get_data(&data, &freqs_mhz, &num_steps, &array_samples_per_step, &num_samples)) {
+		return;
+	}
+	if (restart) {
+		step_num = 0;
+	}
+	double tx_freq_mhz = freqs_mhz[step_num];
+	if (telemetry_manager_send_gpr_data(tx_freq_mhz, tx_freq_mhz - GPR_MANAGER_IF_HZ / 1e6, data + step_num * array_samples_per_step, num_samples, restart)) {
+		step_num++;
+		restart = true;
+	} else {
+		restart = false;
+	}
+	bool sent = step_num >= num_steps;
+#elif GPR_TELEMETRY_MODE == GPR_TELEMETRY_IQ
+	// Demodulate once at the start. Sweeps can only start from the state group, so nothing changes between reading the
+	// trace and its I/Q, and I/Q is only ever recalculated here
+	static gpr_iq_t* iq;
+	static double* freqs_mhz;
+	static int num_steps;
+	if (restart && !gpr_manager_get_iq(&iq, &freqs_mhz, &num_steps)) {
+		sending = false;
+		return;
+	}
+	bool sent = telemetry_manager_send_gpr_iq(&trace, iq, freqs_mhz, (uint8_t) num_steps, restart);
+	restart = false;
+#else
+	// Synthesize once at the start, the same way as I/Q. Step frequencies come along so the ground knows each bin's delay
+	static float* magnitudes;
+	static int num_points;
+	static gpr_iq_t* iq;
+	static double* freqs_mhz;
+	static int num_steps;
+	if (restart && !(gpr_manager_get_range_profile(&magnitudes, &num_points) && gpr_manager_get_iq(&iq, &freqs_mhz, &num_steps))) {
+		sending = false;
+		return;
 	}
-	switch(p_current_state->get_id()) {
-	case state_id::Disabled:
-		switch(end_status) {
-		case end_status_t::SystemEnabled:
-			return state_id::Drive;
-		default:
-			break;
+	bool sent = telemetry_manager_send_gpr_range_profile(&trace, magnitudes, (uint8_t) num_points, freqs_mhz, (uint8_t) num_steps, restart);
+	restart = false;
+#endif
+
+	if (sent) {
+		sending = false;
+		sent_trace_num = trace.trace_num;
+	}
+}
+
+/**
+ * @brief Telemeters the latest localization estimate, GPR sweeps as the radio has room, and monitoring data at a lower rate
+ * @param[in] context: Unused
+ */
+static void scheduler_telemetry_task(void* context) {
+	(void) context;
+	static int releases_since_monitoring = 0;
+	if (++releases_since_monitoring >= MONITORING_DECIMATION) {
+		releases_since_monitoring = 0;
+		uint32_t time_to_ready_ms[TELEMETRY_NUM_SUBSYSTEMS];
+		for (int i = 0; i < TELEMETRY_NUM_SUBSYSTEMS; i++) {
+			time_to_ready_ms[i] = p_initialize_state->get_time_to_ready_ms((InitializeState::subsystem_t) i);
 		}
-		break;
-	case state_id::Drive:
-		switch(end_status) {
-		case end_status_t::SystemDisabled:
-			return state_id::Disabled;
-		case end_status_t::TrajectoryComplete:
-			return state_id::Record;
-		default:
-			break;
+		telemetry_manager_send_monitoring_data(
+				drive_manager_get_battery_voltage(),
+				localization_manager_get_estimate()->imu_time_to_calibrated_ms,
+				time_to_ready_ms
+		);
+	}
+
+	localization_estimate_t* estimate = localization_manager_get_estimate();
+	telemetry_manager_send_relative_pose(
+			estimate->pos.x,
+			estimate->pos.y,
+			estimate->pos.z,
+			estimate->heading_zyx.z,
+			estimate->heading_zyx.x,
+			estimate->heading_zyx.y
+	);
+
+	scheduler_send_gpr_trace();
+}
+
+/**
+ * @brief Runs one step of the state machine: cleanup/init on state change, run, then find the next state
+ * @param[in] context: Rate scheduler, used to start the other rate groups once initialization completes
+ */
+static void scheduler_state_task(void* context) {
+	RateScheduler* rate_scheduler = (RateScheduler*) context;
+
+	// Cleanup current state and initialize next state if changing states
+	if (p_next_state != p_current_state) {
+		if (p_current_state) {
+			p_current_state->cleanup();
 		}
-		break;
-	case state_id::Initialize:
-		switch(end_status) {
-		case end_status_t::InitializationComplete:
-			return state_id::Disabled;
-		default:
-			break;
+		if (p_next_state) {
+			p_next_state->init();
 		}
-		break;
-	case state_id::Record:
-		switch(end_status) {
-		case end_status_t::RecordingComplete:
-			return state_id::Drive;
-		case end_status_t::SystemDisabled:
-			return state_id::Disabled;
-		default:
-			break;
+		p_current_state = p_next_state;
+	}
+
+	// Run the current state
+	end_status_t end_status = end_status_t::NoChange;
+	if (p_current_state) {
+		end_status = p_current_state->run();
+	}
+
+	// Managers are only safe to run periodically once the initialize state has set them up
+	if (end_status == end_status_t::InitializationComplete) {
+		for (int i = 0; i < NUM_RATE_GROUPS; i++) {
+			rate_scheduler->set_enabled(i, true);
 		}
-		break;
-	default:
-		break;
 	}
-	return state_id::UNKNOWN;
+
+	// Find and set the next state
+	p_next_state = state_machine.get_next_state(p_current_state, end_status);
 }
 
 void scheduler_run() {
@@ -82,53 +255,32 @@ void scheduler_run() {
 	DisabledState disabled_state = DisabledState(state_id::Disabled);
 	DriveState drive_state = DriveState(state_id::Drive);
 	RecordState record_state = RecordState(state_id::Record);
+	DriveRecordState drive_record_state = DriveRecordState(state_id::DriveRecord);
+	p_initialize_state = &initialize_state;
 
-	State* states[] = {
-		&initialize_state,
-		&disabled_state,
-		&drive_state,
-		&record_state,
-	};
+	state_machine.register_state(&initialize_state);
+	state_machine.register_state(&disabled_state);
+	state_machine.register_state(&drive_state);
+	state_machine.register_state(&record_state);
+	state_machine.register_state(&drive_record_state);
+
+	// Start measuring loop stages (no-op unless profiling is compiled in)
+	LOOP_PROFILER_INIT();
 
 	// Initialize the current and next states
 	p_current_state = nullptr;
-	p_next_state = &initialize_state;
+	p_next_state = state_machine.get_state(INITIAL_STATE);
 
-	// Helper functions throughout infinite loop
-	uint32_t last_time = HAL_GetTick();
-	end_status_t end_status = end_status_t::NoChange;
+	// Set up rate groups. Only the state machine runs until initialization is complete
+	RateScheduler rate_scheduler = RateScheduler(scheduler_clock, scheduler_idle);
+	rate_scheduler.add_group("control", CONTROL_PERIOD_MS, CONTROL_PRIORITY, scheduler_control_task, nullptr);
+	rate_scheduler.add_group("localization", LOCALIZATION_PERIOD_MS, LOCALIZATION_PRIORITY, scheduler_localization_task, nullptr);
+	rate_scheduler.add_group("telemetry", TELEMETRY_PERIOD_MS, TELEMETRY_PRIORITY, scheduler_telemetry_task, nullptr);
+	rate_scheduler.add_group("state", STATE_PERIOD_MS, STATE_PRIORITY, scheduler_state_task, &rate_scheduler);
+	rate_scheduler.set_enabled(rate_group_id::StateGroup, true);
 
 	// Keep running scheduler forever
 	while(1) {
-
-		// Limit rate scheduler runs at
-		if (p_current_state)
-			while((HAL_GetTick() - last_time) < LOOP_PERIOD_MS);
-		last_time = HAL_GetTick();
-
-		// Cleanup current state and initialize next state if changing states
-		if (p_next_state != p_current_state) {
-			if (p_current_state) {
-				p_current_state->cleanup();
-			}
-			if (p_next_state) {
-				p_next_state->init();
-			}
-			p_current_state = p_next_state;
-		}
-
-		// Run the current state
-		if (p_current_state) {
-			end_status = p_current_state->run();
-		}
-
-		// Find and set the next state
-		state_id next_state = get_next_state(end_status);
-		for (State* state : states) {
-			if (state->get_id() == next_state) {
-				p_next_state = state;
-				break;
-			}
-		}
+		rate_scheduler.run_once();
 	}
 }
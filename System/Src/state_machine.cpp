@@ -0,0 +1,42 @@
+/*
+ * state_machine.cpp
+ */
+
+#include "state_machine.h"
+
+#include <cstddef>
+
+static constexpr state_transition_table_t STATE_TRANSITION_TABLE = state_machine_build_table();
+
+bool StateMachine::register_state(State* state) {
+	// Check user inputs
+	if (!state || state->get_id() < 0 || state->get_id() >= NUM_STATES || states_[state->get_id()]) {
+		return false;
+	}
+
+	states_[state->get_id()] = state;
+	return true;
+}
+
+State* StateMachine::get_state(state_id id) const {
+	// Check user inputs
+	if (id < 0 || id >= NUM_STATES) {
+		return NULL;
+	}
+
+	return states_[id];
+}
+
+State* StateMachine::get_next_state(State* current_state, end_status_t end_status) const {
+	// Check user inputs
+	if (!current_state || current_state->get_id() < 0 || current_state->get_id() >= NUM_STATES
+			|| end_status < 0 || end_status >= NUM_END_STATUSES) {
+		return current_state;
+	}
+
+	state_id next_id = STATE_TRANSITION_TABLE.next[current_state->get_id()][end_status];
+	if (next_id == state_id::UNKNOWN || !states_[next_id]) {
+		return current_state;
+	}
+	return states_[next_id];
+}
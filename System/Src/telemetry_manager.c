@@ -4,15 +4,20 @@
 
 #include "telemetry_manager.h"
 
+#include "gpr_manager.h"
+#include "loop_profiler.h"
 #include "radio.h"
 #include "peripheral_assigner.h"
+#include "trajectory_manager.h"
 
 typedef enum {
 	NA = 0,
 	RelativePose,
 	AbsolutePose,
 	GPR,
-	Monitoring
+	Monitoring,
+	GprIq,
+	GprRangeProfile
 } message_id;
 
 static struct message_header_t {
@@ -34,8 +39,26 @@ static struct gpr_payload_t {
 	float mixer_ref_freq;
 } gpr_payload;
 
+static struct __attribute__((__packed__)) gpr_trace_payload_t {
+	uint32_t trace_num;
+	uint32_t capture_start_us;
+	float pos_x; // Pose halfway through the sweep
+	float pos_y;
+	float yaw;
+	float start_freq_mhz;
+	float step_freq_mhz;
+	uint8_t num_values; // Followed by this many gpr_iq_t (one per step) for GprIq, or float (one per bin) for GprRangeProfile
+} gpr_trace_payload;
+
 static struct monitoring_payload_t {
 	float battery_voltage;
+	uint32_t imu_time_to_calibrated_ms;
+	uint32_t subsystem_time_to_ready_ms[TELEMETRY_NUM_SUBSYSTEMS]; // From startup until each subsystem finished setup, 0 until then
+	trajectory_recovery_stats_t trajectory_recovery;
+	uint32_t gpr_sweep_us; // Time the last GPR sweep took, 0 before the first
+#if LOOP_PROFILER_ENABLED
+	loop_profiler_summary_t loop_profile;
+#endif
 } monitoring_payload;
 
 static radio_t radio;
@@ -48,12 +71,33 @@ static void telemetry_manager_update_queue_size() {
 		cur_transmit_queue_size = 0;
 	}
 	last_transmit_time_ms = HAL_GetTick();
+
+	// UART is slower than the radio's air rate, so bytes can still be waiting to leave the board
+	uint16_t tx_pending = radio_get_tx_pending(&radio);
+	if (cur_transmit_queue_size < tx_pending) {
+		cur_transmit_queue_size = tx_pending;
+	}
+}
+
+/**
+ * @brief Queues bytes to transmit over the radio, timing how long queueing takes
+ * @param[in] data: Bytes to transmit
+ * @param[in] len: Number of bytes to transmit
+ */
+static void telemetry_manager_transmit(uint8_t* data, uint16_t len) {
+	LOOP_PROFILER_BEGIN(LOOP_PROFILER_PROBE_RADIO_TRANSMIT);
+	radio_transmit(&radio, data, len);
+	LOOP_PROFILER_END(LOOP_PROFILER_PROBE_RADIO_TRANSMIT);
 }
 
 void telemetry_manager_init() {
 	radio_init(&radio, RADIO_UART);
 }
 
+bool telemetry_manager_init_step() {
+	return radio_init_step(&radio);
+}
+
 bool telemetry_manager_send_relative_pose(double pos_x, double pos_y, double pos_z, double yaw, double roll, double pitch) {
 	// Update estimated queue size
 	telemetry_manager_update_queue_size();
@@ -76,9 +120,9 @@ bool telemetry_manager_send_relative_pose(double pos_x, double pos_y, double pos
 	}
 
 	// Transmit message header
-	radio_transmit(&radio, (uint8_t*) &message_header, sizeof(message_header));
+	telemetry_manager_transmit((uint8_t*) &message_header, sizeof(message_header));
 	// Transmit message payload
-	radio_transmit(&radio, (uint8_t*) &pose_payload, sizeof(pose_payload));
+	telemetry_manager_transmit((uint8_t*) &pose_payload, sizeof(pose_payload));
 	cur_transmit_queue_size += transmit_len;
 
 	return true;
@@ -106,14 +150,14 @@ bool telemetry_manager_send_absolute_pose(double longitude, double latitude, dou
 	}
 
 	// Transmit message header
-	radio_transmit(&radio, (uint8_t*) &message_header, sizeof(message_header));
+	telemetry_manager_transmit((uint8_t*) &message_header, sizeof(message_header));
 	// Transmit message payload
-	radio_transmit(&radio, (uint8_t*) &pose_payload, sizeof(pose_payload));
+	telemetry_manager_transmit((uint8_t*) &pose_payload, sizeof(pose_payload));
 	cur_transmit_queue_size += transmit_len;
 	return true;
 }
 
-bool telemetry_manager_send_gpr_data(double transmit_freq, double mixer_ref_freq, uint32_t* data_values, uint16_t data_len, bool restart) {
+bool telemetry_manager_send_gpr_data(double transmit_freq, double mixer_ref_freq, uint16_t* data_values, uint16_t data_len, bool restart) {
 
 	// Set up internal state for continuing/restarting long data transmissions
 	static int next_data_byte_idx = 0;
@@ -129,7 +173,7 @@ bool telemetry_manager_send_gpr_data(double transmit_freq, double mixer_ref_freq
 	if (!header_sent) {
 		// Set message header
 		message_header.message_id = GPR;
-		message_header.payload_len = sizeof(gpr_payload) + data_len * sizeof(uint32_t); // 4 = size of uint32_t
+		message_header.payload_len = sizeof(gpr_payload) + data_len * sizeof(uint16_t);
 		// Set message payload
 		gpr_payload.transmit_freq = (float) transmit_freq;
 		gpr_payload.mixer_ref_freq = (float) mixer_ref_freq;
@@ -141,25 +185,28 @@ bool telemetry_manager_send_gpr_data(double transmit_freq, double mixer_ref_freq
 		}
 
 		// Transmit message header
-		radio_transmit(&radio, (uint8_t*) &message_header, sizeof(message_header));
+		telemetry_manager_transmit((uint8_t*) &message_header, sizeof(message_header));
 		// Transmit message payload beginning
-		radio_transmit(&radio, (uint8_t*) &gpr_payload, sizeof(gpr_payload));
+		telemetry_manager_transmit((uint8_t*) &gpr_payload, sizeof(gpr_payload));
 		cur_transmit_queue_size += transmit_len;
 		header_sent = true;
 	}
 	if (header_sent) {
-		// Check how many bytes we can put into queue
-		uint16_t transmit_len = RADIO_QUEUE_SIZE - cur_transmit_queue_size;
+		// Check how many bytes we can put into queue. Queue can be over full while the UART catches up
+		int transmit_len = RADIO_QUEUE_SIZE - cur_transmit_queue_size;
+		int data_bytes = data_len * (int) sizeof(uint16_t);
 		bool should_stop = false;
-		if (transmit_len + next_data_byte_idx > data_len * sizeof(uint32_t)) {
-			transmit_len = data_len * sizeof(uint32_t) - next_data_byte_idx;
+		if (transmit_len + next_data_byte_idx >= data_bytes) {
+			transmit_len = data_bytes - next_data_byte_idx;
 			should_stop = true;
 		}
 
 		// Transmit data
-		radio_transmit(&radio, (uint8_t*) (data_values + next_data_byte_idx), transmit_len);
-		cur_transmit_queue_size += transmit_len;
-		next_data_byte_idx += transmit_len;
+		if (transmit_len > 0) {
+			telemetry_manager_transmit((uint8_t*) data_values + next_data_byte_idx, (uint16_t) transmit_len);
+			cur_transmit_queue_size += transmit_len;
+			next_data_byte_idx += transmit_len;
+		}
 		return should_stop;
 	}
 
@@ -167,7 +214,86 @@ bool telemetry_manager_send_gpr_data(double transmit_freq, double mixer_ref_freq
 	return false;
 }
 
-bool telemetry_manager_send_monitoring_data(double battery_voltage) {
+/**
+ * @brief Telemeters values derived from a GPR sweep, headed by when and where it was captured. This will maintain state
+ * unless restart parameter is passed or all data is completely sent
+ * @param[in] id: Message ID, which sets what the values are
+ * @param[in] trace: When and where the sweep was captured
+ * @param[in] freqs_mhz: Frequencies in MHz of each step, evenly spaced
+ * @param[in] num_steps: Number of steps in the sweep
+ * @param[in] values: Values to send, which must stay unchanged until all are sent
+ * @param[in] value_size: Size of each value in bytes
+ * @param[in] num_values: Number of values
+ * @param[in] restart: Whether the next incoming data is from a new sweep (true) or a continuation of an unfinished old one (false)
+ * @return Whether the whole message has been queued (true) or not (false)
+ */
+static bool telemetry_manager_send_gpr_trace(message_id id, const gpr_trace_info_t* trace, const double* freqs_mhz, uint8_t num_steps,
+		const void* values, int value_size, uint8_t num_values, bool restart) {
+
+	// Set up internal state for continuing/restarting long data transmissions
+	static int next_data_byte_idx = 0;
+	static bool header_sent = false;
+	if (restart) {
+		next_data_byte_idx = 0;
+		header_sent = false;
+	}
+
+	// Update estimated queue size
+	telemetry_manager_update_queue_size();
+
+	int data_len = num_values * value_size;
+	if (!header_sent) {
+		// Set message header
+		message_header.message_id = id;
+		message_header.payload_len = sizeof(gpr_trace_payload) + data_len;
+		// Set message payload
+		gpr_trace_payload.trace_num = trace->trace_num;
+		gpr_trace_payload.capture_start_us = trace->start_us;
+		gpr_trace_payload.pos_x = (float) trace->pose.x;
+		gpr_trace_payload.pos_y = (float) trace->pose.y;
+		gpr_trace_payload.yaw = (float) trace->pose.theta;
+		gpr_trace_payload.start_freq_mhz = (float) freqs_mhz[0];
+		gpr_trace_payload.step_freq_mhz = num_steps > 1 ? (float) (freqs_mhz[1] - freqs_mhz[0]) : 0;
+		gpr_trace_payload.num_values = num_values;
+
+		// Check if we can transmit header/beginning of payload into queue
+		uint16_t transmit_len = sizeof(message_header) + sizeof(gpr_trace_payload);
+		if (cur_transmit_queue_size + transmit_len > RADIO_QUEUE_SIZE) {
+			return false;
+		}
+
+		// Transmit message header
+		telemetry_manager_transmit((uint8_t*) &message_header, sizeof(message_header));
+		// Transmit message payload beginning
+		telemetry_manager_transmit((uint8_t*) &gpr_trace_payload, sizeof(gpr_trace_payload));
+		cur_transmit_queue_size += transmit_len;
+		header_sent = true;
+	}
+
+	// Send as many values as fit in the queue
+	int transmit_len = RADIO_QUEUE_SIZE - cur_transmit_queue_size;
+	bool should_stop = false;
+	if (transmit_len + next_data_byte_idx >= data_len) {
+		transmit_len = data_len - next_data_byte_idx;
+		should_stop = true;
+	}
+	if (transmit_len > 0) {
+		telemetry_manager_transmit((uint8_t*) values + next_data_byte_idx, (uint16_t) transmit_len);
+		cur_transmit_queue_size += transmit_len;
+		next_data_byte_idx += transmit_len;
+	}
+	return should_stop;
+}
+
+bool telemetry_manager_send_gpr_iq(const gpr_trace_info_t* trace, const gpr_iq_t* iq, const double* freqs_mhz, uint8_t num_steps, bool restart) {
+	return telemetry_manager_send_gpr_trace(GprIq, trace, freqs_mhz, num_steps, iq, sizeof(gpr_iq_t), num_steps, restart);
+}
+
+bool telemetry_manager_send_gpr_range_profile(const gpr_trace_info_t* trace, const float* magnitudes, uint8_t num_points, const double* freqs_mhz, uint8_t num_steps, bool restart) {
+	return telemetry_manager_send_gpr_trace(GprRangeProfile, trace, freqs_mhz, num_steps, magnitudes, sizeof(float), num_points, restart);
+}
+
+bool telemetry_manager_send_monitoring_data(double battery_voltage, uint32_t imu_time_to_calibrated_ms, const uint32_t* subsystem_time_to_ready_ms) {
 	// Update estimated queue size
 	telemetry_manager_update_queue_size();
 
@@ -176,6 +302,16 @@ bool telemetry_manager_send_monitoring_data(double battery_voltage) {
 	message_header.payload_len = sizeof(monitoring_payload);
 	// Set message payload
 	monitoring_payload.battery_voltage = (float) battery_voltage;
+	monitoring_payload.imu_time_to_calibrated_ms = imu_time_to_calibrated_ms;
+	for (int i = 0; i < TELEMETRY_NUM_SUBSYSTEMS; i++) {
+		monitoring_payload.subsystem_time_to_ready_ms[i] = subsystem_time_to_ready_ms ? subsystem_time_to_ready_ms[i] : 0;
+	}
+	trajectory_manager_get_recovery_stats(&monitoring_payload.trajectory_recovery);
+	// Keeps the last value while a sweep is in progress
+	gpr_trace_info_t gpr_trace;
+	if (gpr_manager_get_trace_info(&gpr_trace)) {
+		monitoring_payload.gpr_sweep_us = gpr_trace.end_us - gpr_trace.start_us;
+	}
 
 	// Check if we can transmit into queue
 	uint16_t transmit_len = sizeof(message_header) + message_header.payload_len;
@@ -183,10 +319,15 @@ bool telemetry_manager_send_monitoring_data(double battery_voltage) {
 		return false;
 	}
 
+	// Only take loop profile once it's known it will be sent, since taking it starts a new measurement window
+#if LOOP_PROFILER_ENABLED
+	loop_profiler_take_summary(&monitoring_payload.loop_profile);
+#endif
+
 	// Transmit message header
-	radio_transmit(&radio, (uint8_t*) &message_header, sizeof(message_header));
+	telemetry_manager_transmit((uint8_t*) &message_header, sizeof(message_header));
 	// Transmit message payload
-	radio_transmit(&radio, (uint8_t*) &monitoring_payload, sizeof(monitoring_payload));
+	telemetry_manager_transmit((uint8_t*) &monitoring_payload, sizeof(monitoring_payload));
 	cur_transmit_queue_size += transmit_len;
 	return true;
 }
@@ -7,223 +7,116 @@
 #include <math.h>
 
 #include "drive_constants.h"
+#include "dubins_path.h"
+#include "motion_profile.h"
+#include "stm32f7xx_hal.h"
 
 #define TRAJECTORY_STOP_BAND_POSITION	0.03 // Meters
-#define TRAJECTORY_STOP_BAND_ANGLE		0.01 // Radians
-
-typedef enum  {
-	INITIAL_ROTATION,
-	DRIVE,
-	FINAL_ROTATION
-} sub_trajectories_t;
-
-typedef struct vel_pos_pair_t {
-	double vel;
-	double pos;
-} vel_pos_pair_t;
-
-static vel_pos_pair_t active_trajectory[3][4];
-static pose2d_t sub_trajectory_start_pose[3];
-static pose2d_t sub_trajectory_end_pose[3];
-static int current_sub_trajectory = INITIAL_ROTATION;
+#define TRAJECTORY_OFF_COURSE_M			0.1 // Meters from the path before giving up on following it
+#define TRAJECTORY_TURN_RADIUS_M		0.5 // Tightest arc planned, in meters
+#define TRAJECTORY_LOOKAHEAD_M			0.25 // Distance ahead along the path that pure pursuit steers towards
+#define TRAJECTORY_RECOVERY_SPEED_MPS	0.3 // Fastest speed when driving back to the path
+#define TRAJECTORY_RECOVERY_GAIN_POS	2.0 // Forward m/s per meter from the recovery point
+#define TRAJECTORY_RECOVERY_GAIN_ANGLE	3.0 // Turn rad/s per radian of heading error
+#define TRAJECTORY_RECOVERY_BAND_ANGLE	0.05 // Radians from the path heading before following again
+
+static dubins_path_t active_path;
+static motion_profile_t active_trajectory;
+static int current_segment = 0;
+static double profile_start_m = 0; // Progress along the path where the speed profile starts, negative if before the path
+static pose2d_t active_end_pose;
+static double active_speed_multiplier;
+
+static bool recovering = false;
+static pose2d_t recovery_target_pose;
+static pose2d_t recovery_last_pose;
+static uint32_t recovery_start_ms;
+static trajectory_recovery_stats_t recovery_stats;
 
 /**
- * @brief Calculates the initial rotation sub-trajectory as pairs of (angular velocity, angle) points relative to sub-trajectory start pose.
- * @param[in] start_pose: Start pose of the whole trajectory
- * @param[in] end_pose: End pose of the whole trajectory
- * @param[in] speed_multiplier: How much the trajectory velocities should be limited on scale of 0-1
+ * @brief Wraps an angle to [-PI, PI)
+ * @param[in] angle: Angle in radians
+ * @return Wrapped angle
  */
-static void calculate_trajectory_initial_rotation(pose2d_t start_pose, pose2d_t end_pose, double speed_multiplier) {
-
-	// Calculate angle from start position to end position
-	double ang_diff_rad = atan2(end_pose.y - start_pose.y, end_pose.x - start_pose.x);
-
-	// Calculate angle from start pose to end position
-	ang_diff_rad -= start_pose.theta;
-
-	// Figure out if triangle or trapezoidal profile is required
-	// Boundary is the triangle velocity vs. time profile that has a slope of MAX_ACCEL and just touches MAX_SPEED
-	// Change in position is the integral under the velocity vs time profile
-	double delta_position_boundary = (MAX_DRIVE_SPEED_MPS * speed_multiplier) * (MAX_DRIVE_SPEED_MPS * speed_multiplier / MAX_DRIVE_ACCEL_MPSPS);
-	if (ang_diff_rad < 0){
-		delta_position_boundary = -delta_position_boundary;
-	}
-	double delta_position_actual = ang_diff_rad * WHEEL_BASE_M / 2;
-
-	// Triangular profile
-	if (fabs(delta_position_actual) < fabs(delta_position_boundary)) {
-
-		// Calculate the velocity at the halfway point (accel will be MAX_ACCEL)
-		// delta_position_actual = peak_vel^2 / MAX_ACCEL
-		// peak_vel = sqrt(abs(delta_position_actual) / MAX_ACCEL) * sign(delta_position_actual)
-		double peak_vel = sqrt(fabs(delta_position_actual) / MAX_DRIVE_ACCEL_MPSPS);
-		if (delta_position_actual < 0) {
-			peak_vel = -peak_vel;
-		}
-
-		// Convert back to angular components
-		double peak_vel_angular = peak_vel / (WHEEL_BASE_M / 2);
-		double delta_position_actual_angular = delta_position_actual / (WHEEL_BASE_M / 2);
-
-		vel_pos_pair_t pairs[4] = {
-				{0, 0},
-				{peak_vel_angular, delta_position_actual_angular / 2},
-				{0, 0},
-				{0, 0}
-		};
-		for (int i = 0; i < 4; i++) {
-			active_trajectory[INITIAL_ROTATION][i] = pairs[i];
-		}
-	}
-
-	// Trapezoidal profile
-	else {
-		vel_pos_pair_t pairs[4] = {
-				{0, 0},
-				{MAX_DRIVE_SPEED_MPS * speed_multiplier / (WHEEL_BASE_M / 2), delta_position_boundary / 2 / (WHEEL_BASE_M / 2)},
-				{MAX_DRIVE_SPEED_MPS * speed_multiplier / (WHEEL_BASE_M / 2), ang_diff_rad - delta_position_boundary / 2 / (WHEEL_BASE_M / 2)},
-				{0, 0}
-		};
-		for (int i = 0; i < 4; i++) {
-			active_trajectory[INITIAL_ROTATION][i] = pairs[i];
-		}
-	}
+static double wrap_angle(double angle) {
+	return angle - 2 * 3.14159265358979 * floor((angle + 3.14159265358979) / (2 * 3.14159265358979));
 }
 
 /**
- * @brief Calculates the drive sub-trajectory as pairs of (velocity, position) points relative to sub-trajectory start pose.
- * @param[in] start_pose: Start pose of the whole trajectory
- * @param[in] end_pose: End pose of the whole trajectory
- * @param[in] speed_multiplier: How much the trajectory velocities should be limited on scale of 0-1
+ * @brief Ends a recovery and adds its duration to the recovery stats
  */
-static void calculate_trajectory_drive(pose2d_t start_pose, pose2d_t end_pose, double speed_multiplier) {
-
-	// Find distance between start pose and end pose
-	double delta_position_actual = hypot(end_pose.y - start_pose.y, end_pose.x - start_pose.x);
-
-	// Figure out if triangular or trapezoidal profile is required
-	double delta_position_boundary = (MAX_DRIVE_SPEED_MPS * speed_multiplier) * (MAX_DRIVE_SPEED_MPS * speed_multiplier / MAX_DRIVE_ACCEL_MPSPS);
-
-	// Triangular profile
-	if (fabs(delta_position_actual) < fabs(delta_position_boundary)) {
-
-		// Calculate the velocity at the halfway point (accel will be MAX_ACCEL)
-		// delta_position_actual = peak_vel^2 / MAX_ACCEL
-		// peak_vel = sqrt(abs(delta_position_actual) / MAX_ACCEL) * sign(delta_position_actual)
-		double peak_vel = sqrt(fabs(delta_position_actual) / MAX_DRIVE_ACCEL_MPSPS);
-
-		// Set velocity/position pairs
-		vel_pos_pair_t pairs[4] = {
-				{0, 0},
-				{peak_vel, delta_position_actual / 2},
-				{0, 0},
-				{0, 0}
-		};
-		for (int i = 0; i < 4; i++) {
-			active_trajectory[DRIVE][i] = pairs[i];
-		}
+static void finish_recovery() {
+	uint32_t duration_ms = HAL_GetTick() - recovery_start_ms;
+	recovery_stats.total_duration_ms += duration_ms;
+	if (duration_ms > recovery_stats.max_duration_ms) {
+		recovery_stats.max_duration_ms = duration_ms;
 	}
-
-	// Trapezoidal profile
-	else {
-		vel_pos_pair_t pairs[4] = {
-				{0, 0},
-				{MAX_DRIVE_SPEED_MPS * speed_multiplier, delta_position_boundary / 2},
-				{MAX_DRIVE_SPEED_MPS * speed_multiplier, delta_position_actual - delta_position_boundary / 2},
-				{0, 0}
-		};
-		for (int i = 0; i < 4; i++) {
-			active_trajectory[DRIVE][i] = pairs[i];
-		}
-	}
-
+	recovering = false;
 }
 
 /**
- * @brief Calculates the final rotation sub-trajectory as pairs of (angular velocity, angle) points relative to sub-trajectory start pose.
- * @param[in] start_pose: Start pose of the whole trajectory
- * @param[in] end_pose: End pose of the whole trajectory
- * @param[in] speed_multiplier: How much the trajectory velocities should be limited on scale of 0-1
+ * @brief Starts driving back to the closest point on the path
+ * @param[in] cur_pose: Current 2D pose of the robot
+ * @param[in] progress_m: Distance along the path of the closest point
  */
-static void calculate_trajectory_final_rotation(pose2d_t start_pose, pose2d_t end_pose, double speed_multiplier) {
-
-	// Calculate angle to turn by subtracting angle of driving from end pose angle
-	double ang_diff_rad = end_pose.theta - atan2(end_pose.y - start_pose.y, end_pose.x - start_pose.x);
-
-	// Figure out if triangle or trapezoidal profile is required
-	// Boundary is the triangle velocity vs. time profile that has a slope of MAX_ACCEL and just touches MAX_SPEED
-	// Change in position is the integral under the velocity vs time profile
-	double delta_position_boundary = (MAX_DRIVE_SPEED_MPS * speed_multiplier) * (MAX_DRIVE_SPEED_MPS * speed_multiplier / MAX_DRIVE_ACCEL_MPSPS);
-	if (ang_diff_rad < 0){
-		delta_position_boundary = -delta_position_boundary;
-	}
-	double delta_position_actual = ang_diff_rad * WHEEL_BASE_M / 2;
-
-	// Triangular profile
-	if (fabs(delta_position_actual) < fabs(delta_position_boundary)) {
-
-		// Calculate the velocity at the halfway point (accel will be MAX_ACCEL)
-		// delta_position_actual = peak_vel^2 / MAX_ACCEL
-		// peak_vel = sqrt(abs(delta_position_actual) / MAX_ACCEL) * sign(delta_position_actual)
-		double peak_vel = sqrt(fabs(delta_position_actual) / MAX_DRIVE_ACCEL_MPSPS);
-		if (delta_position_actual < 0) {
-			peak_vel = -peak_vel;
-		}
-
-		// Convert back to angular components
-		double peak_vel_angular = peak_vel / (WHEEL_BASE_M / 2);
-		double delta_position_actual_angular = delta_position_actual / (WHEEL_BASE_M / 2);
-
-		vel_pos_pair_t pairs[4] = {
-				{0, 0},
-				{peak_vel_angular, delta_position_actual_angular / 2},
-				{0, 0},
-				{0, 0}
-		};
-		for (int i = 0; i < 4; i++) {
-			active_trajectory[FINAL_ROTATION][i] = pairs[i];
-		}
-	}
-
-	// Trapezoidal profile
-	else {
-		vel_pos_pair_t pairs[4] = {
-				{0, 0},
-				{MAX_DRIVE_SPEED_MPS * speed_multiplier / (WHEEL_BASE_M / 2), delta_position_boundary / 2 / (WHEEL_BASE_M / 2)},
-				{MAX_DRIVE_SPEED_MPS * speed_multiplier / (WHEEL_BASE_M / 2), ang_diff_rad - delta_position_boundary / 2 / (WHEEL_BASE_M / 2)},
-				{0, 0}
-		};
-		for (int i = 0; i < 4; i++) {
-			active_trajectory[FINAL_ROTATION][i] = pairs[i];
-		}
-	}
+static void start_recovery(pose2d_t cur_pose, double progress_m) {
+	recovering = true;
+	recovery_target_pose = dubins_path_sample(&active_path, progress_m);
+	recovery_last_pose = cur_pose;
+	recovery_start_ms = HAL_GetTick();
+	recovery_stats.num_recoveries++;
 }
 
 /**
- * @brief Calculates the start poses and end poses of each sub trajectory
- * @param[in] start_pose: Start pose of the whole trajectory
- * @param[in] end_pose: End pose of the whole trajectory
+ * @brief Drives back to the recovery point, feeding back on heading to it and distance from it at the same time,
+ * then turns in place to the path's heading there
+ * @param[in] cur_pose: Current 2D pose of the robot
+ * @param[out] forward_vel_mps: Setpoint for the robot's linear velocity in its own frame
+ * @param[out] turn_vel_radps: Setpoint for the robot's angular velocity in its own frame
+ * @return Whether the robot is back on the path facing along it (true) or not (false)
  */
-static void calculate_sub_trajectory_reference_poses(pose2d_t start_pose, pose2d_t end_pose) {
+static bool follow_recovery(pose2d_t cur_pose, double* forward_vel_mps, double* turn_vel_radps) {
+	recovery_stats.distance_m += hypot(cur_pose.y - recovery_last_pose.y, cur_pose.x - recovery_last_pose.x);
+	recovery_last_pose = cur_pose;
+
+	double dx = recovery_target_pose.x - cur_pose.x;
+	double dy = recovery_target_pose.y - cur_pose.y;
+	double distance_m = hypot(dy, dx);
+	if (distance_m > TRAJECTORY_STOP_BAND_POSITION) {
+		// Slow down the further the target is from straight ahead, and don't drive at all while it's behind
+		double heading_error_rad = wrap_angle(atan2(dy, dx) - cur_pose.theta);
+		*forward_vel_mps = fmin(TRAJECTORY_RECOVERY_GAIN_POS * distance_m, TRAJECTORY_RECOVERY_SPEED_MPS) * fmax(cos(heading_error_rad), 0);
+		*turn_vel_radps = TRAJECTORY_RECOVERY_GAIN_ANGLE * heading_error_rad;
+		return false;
+	}
+
+	double heading_error_rad = wrap_angle(recovery_target_pose.theta - cur_pose.theta);
+	if (fabs(heading_error_rad) > TRAJECTORY_RECOVERY_BAND_ANGLE) {
+		*turn_vel_radps = TRAJECTORY_RECOVERY_GAIN_ANGLE * heading_error_rad;
+		return false;
+	}
+	return true;
+}
 
-	// Set sub-trajectory start poses for initial rotation and drive
-	sub_trajectory_start_pose[INITIAL_ROTATION] = start_pose;
-	sub_trajectory_start_pose[DRIVE] = start_pose;
-	sub_trajectory_start_pose[DRIVE].theta = atan2(end_pose.y - start_pose.y, end_pose.x - start_pose.x);
-	// Set sub-trajectory start pose for final rotation
-	sub_trajectory_start_pose[FINAL_ROTATION].x = end_pose.x;
-	sub_trajectory_start_pose[FINAL_ROTATION].y = end_pose.y;
-	sub_trajectory_start_pose[FINAL_ROTATION].theta = sub_trajectory_start_pose[DRIVE].theta;
+bool trajectory_manager_plan_path(pose2d_t start_pose, pose2d_t end_pose, dubins_path_t* path, double* max_vel_mps) {
+	// Plan the shortest path of arcs and straight lines from start to end pose
+	if (!dubins_path_plan(path, start_pose, end_pose, TRAJECTORY_TURN_RADIUS_M)) {
+		return false;
+	}
 
-	// Set sub-trajectory end poses
-	sub_trajectory_end_pose[INITIAL_ROTATION] = sub_trajectory_start_pose[DRIVE];
-	sub_trajectory_end_pose[DRIVE] = sub_trajectory_start_pose[FINAL_ROTATION];
-	sub_trajectory_end_pose[FINAL_ROTATION] = end_pose;
+	// On arcs the outer wheel moves faster than the robot and sideways acceleration v^2 / r adds to the tracks' load,
+	// so paths that turn are driven slower. Straight paths, like the legs along a survey line, go at full speed
+	*max_vel_mps = MAX_DRIVE_SPEED_MPS;
+	if (dubins_path_has_arcs(path)) {
+		*max_vel_mps = fmin(MAX_DRIVE_SPEED_MPS / (1 + WHEEL_BASE_M / (2 * TRAJECTORY_TURN_RADIUS_M)),
+				sqrt(MAX_DRIVE_ACCEL_MPSPS * TRAJECTORY_TURN_RADIUS_M));
+	}
+	return true;
 }
 
-void trajectory_manager_calculate_trajectory(pose2d_t start_pose, pose2d_t end_pose, double speed_multiplier) {
+void trajectory_manager_load_path(const dubins_path_t* path, pose2d_t end_pose, double max_vel_mps, double speed_multiplier, pose2d_t cur_pose) {
 
-	// Check and scale user inputs. Assume start pose and end pose angles have already been scaled to -PI to PI
+	// Check and scale user inputs
 	if (speed_multiplier > 1) {
 		speed_multiplier = 1;
 	}
@@ -231,29 +124,36 @@ void trajectory_manager_calculate_trajectory(pose2d_t start_pose, pose2d_t end_p
 		speed_multiplier = 0;
 	}
 
-	// Calculate three components of trajectories as the active trajectory
-	calculate_trajectory_initial_rotation(start_pose, end_pose, speed_multiplier);
-	calculate_trajectory_drive(start_pose, end_pose, speed_multiplier);
-	calculate_trajectory_final_rotation(start_pose, end_pose, speed_multiplier);
+	// A new trajectory cancels any recovery on the old one
+	if (recovering) {
+		finish_recovery();
+	}
+	active_path = *path;
+	active_end_pose = end_pose;
+	active_speed_multiplier = speed_multiplier;
 
-	// Calculate sub-trajectory reference poses (start and end)
-	calculate_sub_trajectory_reference_poses(start_pose, end_pose);
+	// Profile speed by distance from where the robot is now. If it stopped short of the start, the profile covers the
+	// gap too, since looking up a profile from before its start would only give its slowest speed
+	profile_start_m = fmin(dubins_path_project(&active_path, cur_pose, 0).progress_m, 0);
+	motion_profile_generate(
+			&active_trajectory,
+			dubins_path_get_length(&active_path) - profile_start_m,
+			max_vel_mps * speed_multiplier,
+			MAX_DRIVE_ACCEL_MPSPS,
+			MAX_DRIVE_JERK_MPSPSPS
+	);
 
-	// Reset the sub-trajectory
-	current_sub_trajectory = INITIAL_ROTATION;
+	// Reset the following progress
+	current_segment = 0;
 }
 
-/**
- * @brief Interpolates the y of an x value given the ends of the line segment defining the linear interpolation
- * @param[in] x_begin: x value of first line segment point
- * @param[in] x_end: x value of last line segment point
- * @param[in] y_begin: y value of first line segment point
- * @param[in] y_end: y value of last line segment point
- * @param[in] x_interp_val: x value to interpolate y of
- * @return Interpolated y value corresponding to given x
- */
-static double interpolate(double x_begin, double x_end, double y_begin, double y_end, double x_interp_val) {
-	return (y_end - y_begin) / (x_end - x_begin) * (x_interp_val - x_begin) + y_begin;
+void trajectory_manager_calculate_trajectory(pose2d_t start_pose, pose2d_t end_pose, double speed_multiplier) {
+	dubins_path_t path;
+	double max_vel_mps;
+	if (!trajectory_manager_plan_path(start_pose, end_pose, &path, &max_vel_mps)) {
+		return;
+	}
+	trajectory_manager_load_path(&path, end_pose, max_vel_mps, speed_multiplier, start_pose);
 }
 
 void trajectory_manager_follow_trajectory(pose2d_t cur_pose, double* forward_vel_mps, double* turn_vel_radps, bool* complete, bool* off_course) {
@@ -264,104 +164,59 @@ void trajectory_manager_follow_trajectory(pose2d_t cur_pose, double* forward_vel
 	*forward_vel_mps = 0;
 	*turn_vel_radps = 0;
 
-	// Check if end condition for current sub-trajectory is met
-	if (current_sub_trajectory == INITIAL_ROTATION || current_sub_trajectory == FINAL_ROTATION) {
-		// If rotation, check if rotation is close to necessary rotation. Incorrect position will be caught and handled later
-		if (fabs(sub_trajectory_end_pose[current_sub_trajectory].theta - cur_pose.theta) < TRAJECTORY_STOP_BAND_ANGLE) {
-			if (current_sub_trajectory == FINAL_ROTATION) {
-				*complete = true;
-			}
-			current_sub_trajectory += 1;
-			return;
-		}
-	}
-	else if (current_sub_trajectory == DRIVE) {
-		// If driving, check if position is close to necessary position. Incorrect rotation will be caught and handled later
-		if (hypot(sub_trajectory_end_pose[current_sub_trajectory].y - cur_pose.y, sub_trajectory_end_pose[current_sub_trajectory].x - cur_pose.x) < TRAJECTORY_STOP_BAND_POSITION) {
-			current_sub_trajectory += 1;
+	// When off course, drive back to the path. Once there, plan the rest of it again so speed ramps up from rest. The
+	// rest of a shortest path is the shortest path from there, so the robot stays on the same line. Start from the
+	// robot's position along the path heading, since a path starting ahead of the robot would be looked up at its
+	// slowest speed until the robot creeps up to it
+	if (recovering) {
+		*off_course = true;
+		if (!follow_recovery(cur_pose, forward_vel_mps, turn_vel_radps)) {
 			return;
 		}
+		*off_course = false;
+		pose2d_t restart_pose = recovery_target_pose;
+		double along_m = (cur_pose.x - restart_pose.x) * cos(restart_pose.theta) + (cur_pose.y - restart_pose.y) * sin(restart_pose.theta);
+		restart_pose.x += along_m * cos(restart_pose.theta);
+		restart_pose.y += along_m * sin(restart_pose.theta);
+		trajectory_manager_calculate_trajectory(restart_pose, active_end_pose, active_speed_multiplier);
+	}
+
+	// Find how far along the path the robot is. Searching only from the current segment onward keeps progress from
+	// jumping back where a path loops over itself
+	dubins_path_projection_t projection = dubins_path_project(&active_path, cur_pose, current_segment);
+	current_segment = projection.segment;
+
+	// Check if the end has been reached. Any leftover heading error is taken out along the next path
+	if (projection.progress_m >= dubins_path_get_length(&active_path) - TRAJECTORY_STOP_BAND_POSITION) {
+		*complete = true;
+		return;
 	}
-	else {
-		// Something is very wrong. We must be off track
+
+	// Check whether robot is off-track. If so, notify higher level and start driving back to the closest point on the path
+	if (fabs(projection.lateral_error_m) > TRAJECTORY_OFF_COURSE_M) {
 		*off_course = true;
+		start_recovery(cur_pose, projection.progress_m);
+		follow_recovery(cur_pose, forward_vel_mps, turn_vel_radps);
 		return;
 	}
 
-	// Check whether robot is off-track. If so, abort and notify higher level
-	// TODO: If off track, go into off-track mode to drive back to closest point on the sub-trajectory.
-	if (current_sub_trajectory == INITIAL_ROTATION || current_sub_trajectory == FINAL_ROTATION) {
-		// Check if position is off by more than double stop band amount
-		if (hypot(sub_trajectory_start_pose[current_sub_trajectory].y - cur_pose.y, sub_trajectory_start_pose[current_sub_trajectory].x - cur_pose.x) > 2 * TRAJECTORY_STOP_BAND_POSITION) {
-			*off_course = true;
-			return;
-		}
-	}
-	else {
-		// Check if rotation is off by more than double stop band amount
-		if (fabs(sub_trajectory_start_pose[current_sub_trajectory].theta - cur_pose.theta) > 2 * TRAJECTORY_STOP_BAND_ANGLE) {
-			*off_course = true;
-			return;
-		}
-	}
+	// Look up speed by how far along the path the robot is
+	motion_profile_sample_t setpoint = motion_profile_lookup(&active_trajectory, projection.progress_m - profile_start_m);
+	*forward_vel_mps = setpoint.vel;
 
-	// From sub-trajectory point closest to current pose, find velocity setpoints
-	bool trajectory_setpoint_found = false;
-	if (current_sub_trajectory == INITIAL_ROTATION || current_sub_trajectory == FINAL_ROTATION) {
-		// Find current angle on trajectory
-		for (int i = 0; i < 3; i++) {
-			if ((sub_trajectory_start_pose[current_sub_trajectory].theta
-					+ active_trajectory[current_sub_trajectory][i].pos
-					< cur_pose.theta
-					&& sub_trajectory_start_pose[current_sub_trajectory].theta
-					+ active_trajectory[current_sub_trajectory][i + 1].pos
-					< cur_pose.theta)
-					|| (sub_trajectory_start_pose[current_sub_trajectory].theta
-							+ active_trajectory[current_sub_trajectory][i].pos
-							> cur_pose.theta
-							&& sub_trajectory_start_pose[current_sub_trajectory].theta
-							+ active_trajectory[current_sub_trajectory][i + 1].pos
-							> cur_pose.theta)) {
-				// Interpolate to find velocities
-				*turn_vel_radps = interpolate(
-						active_trajectory[current_sub_trajectory][i].pos,
-						active_trajectory[current_sub_trajectory][i + 1].pos,
-						active_trajectory[current_sub_trajectory][i].vel,
-						active_trajectory[current_sub_trajectory][i + 1].vel,
-						cur_pose.theta - sub_trajectory_start_pose[current_sub_trajectory].theta
-				);
-				trajectory_setpoint_found = true;
-				break;
-			}
-		}
-	}
-	else {
-		// Find closest position on trajectory to current position
-		// Rotate current position around origin so trajectory is on the x-axis and find the x value to get current position on the trajectory
-		double cur_relative_pos_x = cur_pose.x - sub_trajectory_start_pose[current_sub_trajectory].x;
-		double cur_relative_pos_y = cur_pose.y - sub_trajectory_start_pose[current_sub_trajectory].y;
-		double trajectory_rotation = -atan2(sub_trajectory_end_pose[current_sub_trajectory].y - sub_trajectory_start_pose[current_sub_trajectory].y, sub_trajectory_end_pose[current_sub_trajectory].x - sub_trajectory_start_pose[current_sub_trajectory].x);
-		double cur_trajectory_position = cur_relative_pos_x * cos(trajectory_rotation) - cur_relative_pos_y * sin(trajectory_rotation);
-		// Find current position on trajectory
-		for (int i = 0; i < 3; i++) {
-			if (cur_trajectory_position > active_trajectory[current_sub_trajectory][i].pos && cur_trajectory_position < active_trajectory[current_sub_trajectory][i + 1].pos) {
-				// Interpolate to find correct velocities
-				*forward_vel_mps = interpolate(
-						active_trajectory[current_sub_trajectory][i].pos,
-						active_trajectory[current_sub_trajectory][i + 1].pos,
-						active_trajectory[current_sub_trajectory][i].vel,
-						active_trajectory[current_sub_trajectory][i + 1].vel,
-						cur_trajectory_position
-				);
-				trajectory_setpoint_found = true;
-				break;
-			}
-		}
+	// Pure pursuit: steer along the arc through the point a lookahead distance further along the path. In the robot's
+	// frame, that arc's curvature is 2 y / (x^2 + y^2)
+	pose2d_t target = dubins_path_sample(&active_path, projection.progress_m + TRAJECTORY_LOOKAHEAD_M);
+	double dx = target.x - cur_pose.x;
+	double dy = target.y - cur_pose.y;
+	double target_x = dx * cos(cur_pose.theta) + dy * sin(cur_pose.theta);
+	double target_y = -dx * sin(cur_pose.theta) + dy * cos(cur_pose.theta);
+	double dist_sq = target_x * target_x + target_y * target_y;
+	if (dist_sq > 0) {
+		*turn_vel_radps = *forward_vel_mps * 2 * target_y / dist_sq;
 	}
+}
 
-	// If the rotation/position of the robot is off the expected trajectory, notify that the robot is off-course
-	if (!trajectory_setpoint_found) {
-		*off_course = true;
-		return;
-	}
+void trajectory_manager_get_recovery_stats(trajectory_recovery_stats_t* stats) {
+	*stats = recovery_stats;
 }
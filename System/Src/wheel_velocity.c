@@ -0,0 +1,62 @@
+/*
+ * wheel_velocity.c
+ */
+
+#include "wheel_velocity.h"
+
+#include <stddef.h>
+
+void wheel_velocity_init(wheel_velocity_t* wv, uint32_t clock_hz, uint32_t ticks_per_edge) {
+	// Check user inputs
+	if (!wv) {
+		return;
+	}
+
+	wv->clock_hz = clock_hz;
+	wv->ticks_per_edge = ticks_per_edge;
+	wv->has_edge = false;
+	wv->ticks_per_s = 0;
+}
+
+double wheel_velocity_update(wheel_velocity_t* wv, uint32_t edge_time, int64_t edge_ticks, uint32_t now_time) {
+	// Check user inputs
+	if (!wv) {
+		return 0;
+	}
+
+	// First edge is only a reference to measure from
+	if (!wv->has_edge) {
+		wv->ref_time = edge_time;
+		wv->ref_ticks = edge_ticks;
+		wv->last_time = edge_time;
+		wv->has_edge = true;
+		return wv->ticks_per_s;
+	}
+
+	// Times are compared as unsigned differences so the capture timer wrapping doesn't matter
+	if (edge_time != wv->last_time) {
+		wv->last_time = edge_time;
+		uint32_t window = edge_time - wv->ref_time;
+		if (window >= WHEEL_VELOCITY_MIN_WINDOW_S * wv->clock_hz) {
+			wv->ticks_per_s = (double) (edge_ticks - wv->ref_ticks) * wv->clock_hz / window;
+			wv->ref_time = edge_time;
+			wv->ref_ticks = edge_ticks;
+		}
+	}
+
+	// Next edge hasn't come yet, so the wheel is going no faster than about one edge over the time since the last
+	uint32_t since_edge = now_time - wv->last_time;
+	if (since_edge >= WHEEL_VELOCITY_STOP_S * wv->clock_hz) {
+		wv->ticks_per_s = 0;
+		wv->ref_time = wv->last_time;
+		wv->ref_ticks = edge_ticks;
+	} else if (since_edge > 0) {
+		double max_ticks_per_s = WHEEL_VELOCITY_DECAY_EDGES * wv->ticks_per_edge * wv->clock_hz / since_edge;
+		if (wv->ticks_per_s > max_ticks_per_s) {
+			wv->ticks_per_s = max_ticks_per_s;
+		} else if (wv->ticks_per_s < -max_ticks_per_s) {
+			wv->ticks_per_s = -max_ticks_per_s;
+		}
+	}
+	return wv->ticks_per_s;
+}
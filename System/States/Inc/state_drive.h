@@ -1,7 +1,7 @@
 /*
  * state_drive.h
  *
- * Robot drives to get to the next recording point
+ * Robot drives to get to the next recording point, or to the start of the next line recorded while driving
  */
 
 #ifndef STATES_INC_STATE_DRIVE_H_
@@ -13,6 +13,8 @@ extern "C"{
 
 #include "state_interface.h"
 
+#include "drive_constants.h"
+
 #include <stdbool.h>
 
 class DriveState : public State {
@@ -30,6 +32,9 @@ class DriveState : public State {
 	private:
 		bool line_complete_ = false;
 		bool search_complete_ = false;
+		bool line_reached_ = false;
+		pose2d_t last_destination_ = {0, 0, 0};
+		bool has_last_destination_ = false;
 };
 
 #ifdef __cplusplus
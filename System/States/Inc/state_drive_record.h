@@ -0,0 +1,56 @@
+/*
+ * state_drive_record.h
+ *
+ * Robot drives along a survey line without stopping, recording a GPR sweep every time it has covered a set distance
+ * Sweeps are triggered from encoder ticks so they're evenly spaced along the ground whatever the speed, and each is
+ * tagged with the pose interpolated at the middle of its capture
+ */
+
+#ifndef STATES_INC_STATE_DRIVE_RECORD_H_
+#define STATES_INC_STATE_DRIVE_RECORD_H_
+
+#ifdef __cplusplus
+extern "C"{
+#endif
+
+#include "state_interface.h"
+
+#include "drive_constants.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+class DriveRecordState : public State {
+
+	public:
+		using State::State;
+		using State::get_id;
+
+		void init(void) override;
+
+		end_status_t run(void) override;
+
+		void cleanup(void) override;
+
+	private:
+		int64_t start_ticks_l_ = 0;
+		int64_t start_ticks_r_ = 0;
+		int64_t next_trigger_ticks_ = 0; // Distance along the line of the next sweep, in mean encoder ticks
+		bool sweeping_ = false;
+
+		static constexpr double TRACE_SPACING_M = 0.05;
+		static constexpr double SWEEP_START_FREQ_MHZ = 500;
+		static constexpr double SWEEP_STOP_FREQ_MHZ = 2500;
+		static constexpr int SWEEP_NUM_STEPS = 50;
+		static constexpr int SWEEP_SAMPLES_PER_STEP = 200;
+		static constexpr double SWEEP_TIME_S = 0.025; // About 15 ms for a 50 x 200 sweep at hardware speed, plus up to a 10 ms run before it's noticed
+		// Slow enough that each sweep finishes before the next one is due
+		static constexpr double SPEED_MULTIPLIER = TRACE_SPACING_M / SWEEP_TIME_S / MAX_DRIVE_SPEED_MPS < 1 ? TRACE_SPACING_M / SWEEP_TIME_S / MAX_DRIVE_SPEED_MPS : 1;
+		static constexpr int64_t TRACE_SPACING_TICKS = (int64_t) (TRACE_SPACING_M * ENCODER_TICKS_PER_REV / (2 * 3.14159265358979 * DRIVE_WHEEL_RADIUS_M));
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STATES_INC_STATE_DRIVE_RECORD_H_ */
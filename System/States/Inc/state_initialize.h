@@ -2,6 +2,8 @@
  * state_initialize.h
  *
  * Robot initializes all hardware and managers
+ * Slow hardware setup is split into non-blocking steps that are advanced side by side on every run,
+ * so waits on one device overlap with setup of the others
  */
 
 #ifndef STATES_INC_STATE_INITIALIZE_H_
@@ -13,24 +15,47 @@ extern "C"{
 
 #include "state_interface.h"
 
+#include <stdbool.h>
+
 class InitializeState : public State {
 
 	public:
 		using State::State;
 		using State::get_id;
 
+		typedef enum {
+			DriveSubsystem = 0,
+			GprSubsystem,
+			LocalizationSubsystem,
+			TelemetrySubsystem,
+			NUM_SUBSYSTEMS
+		} subsystem_t;
+
 		void init(void) override;
 
 		end_status_t run(void) override;
 
 		void cleanup(void) override;
 
+		/**
+		 * @brief Gets how long a subsystem took to finish setup since this state was initialized
+		 * @param[in] subsystem: Subsystem to get time of
+		 * @return Time to ready in ms, 0 if subsystem isn't ready yet
+		 */
+		uint32_t get_time_to_ready_ms(subsystem_t subsystem);
+
 	private:
 
+		bool subsystem_ready_[NUM_SUBSYSTEMS] = {};
+		uint32_t time_to_ready_ms_[NUM_SUBSYSTEMS] = {};
+		uint32_t init_start_ms_ = 0;
+
 		static constexpr double SEARCH_AREA_WIDTH_M = 10;
 		static constexpr double SEARCH_AREA_LENGTH_M = 10;
 		static constexpr double NUM_PASSES = 10;
 		static constexpr double STOPS_PER_PASS = 0;
+		static constexpr bool PRECOMPUTE_SEARCH = false;
+		static constexpr bool RECORD_WHILE_DRIVING = false;
 };
 
 #ifdef __cplusplus
@@ -2,6 +2,7 @@
  * state_record.h
  *
  * Robot is stationary and recording GPR data
+ * One sweep is recorded at each stop, and tagged with the pose the robot is stopped at
  */
 
 #ifndef STATES_INC_STATE_RECORD_H_
@@ -24,6 +25,13 @@ class RecordState : public State {
 		end_status_t run(void) override;
 
 		void cleanup(void) override;
+
+	private:
+		// Same sweep as DriveRecordState, so traces recorded either way line up
+		static constexpr double SWEEP_START_FREQ_MHZ = 500;
+		static constexpr double SWEEP_STOP_FREQ_MHZ = 2500;
+		static constexpr int SWEEP_NUM_STEPS = 50;
+		static constexpr int SWEEP_SAMPLES_PER_STEP = 200;
 };
 
 #ifdef __cplusplus
@@ -5,11 +5,18 @@
 #include "state_disabled.h"
 #include "stm32f7xx_hal.h"
 
-void DisabledState::init() {
+#include "calibration_manager.h"
 
+void DisabledState::init() {
+	// Robot is stopped, so it's a good time to save IMU calibration if it's due
+	calibration_manager_request_read();
 }
 
 end_status_t DisabledState::run() {
+	// Stay stopped until the IMU is back in fusion
+	if (calibration_manager_is_reading()) {
+		return end_status_t::NoChange;
+	}
 	return end_status_t::SystemEnabled;
 }
 
@@ -4,9 +4,12 @@
 
 #include "state_drive.h"
 
+#include <math.h>
+
 #include "area_search_manager.h"
 #include "drive_manager.h"
 #include "localization_manager.h"
+#include "loop_profiler.h"
 #include "trajectory_manager.h"
 
 void DriveState::init() {
@@ -15,13 +18,41 @@ void DriveState::init() {
 		search_complete_ = true;
 		return;
 	}
-	// Get the next destination
-	pose2d_t next_pose = area_search_manager_retrieve_next_destination(&line_complete_);
-	// Get current pose from localization manager
-	localization_manager_update_estimates();
+	// Already at the start of a line that's recorded while driving, so leave it to the drive record state
+	line_reached_ = area_search_manager_next_is_recorded_line();
+	if (line_reached_) {
+		return;
+	}
+	// Get current pose from localization manager, which is kept up to date by the localization rate group
 	pose2d_t cur_pose = localization_manager_estimate_to_pose2d();
-	// Calculate a trajectory to reach the next destination
-	trajectory_manager_calculate_trajectory(cur_pose, next_pose, 1.0);
+	// Follow the next leg of the search if it was planned ahead
+	area_search_leg_t leg;
+	if (area_search_manager_retrieve_next_leg(&leg)) {
+		line_complete_ = leg.line_complete;
+		trajectory_manager_load_path(&leg.path, leg.destination, leg.max_vel_mps, 1.0, cur_pose);
+	}
+	else {
+		// Get the next destination
+		pose2d_t next_pose = area_search_manager_retrieve_next_destination(&line_complete_);
+		// Legs along a pass start from the robot's position projected onto the line through the last stop, so the
+		// planned path is the survey line itself and the robot is steered back onto it instead of along a new line from
+		// wherever it stopped
+		pose2d_t start_pose = cur_pose;
+		if (!line_complete_ && has_last_destination_) {
+			double line_dir_x = cos(last_destination_.theta);
+			double line_dir_y = sin(last_destination_.theta);
+			double along_line_m = (start_pose.x - last_destination_.x) * line_dir_x + (start_pose.y - last_destination_.y) * line_dir_y;
+			start_pose.x = last_destination_.x + along_line_m * line_dir_x;
+			start_pose.y = last_destination_.y + along_line_m * line_dir_y;
+			start_pose.theta = last_destination_.theta;
+		}
+		last_destination_ = next_pose;
+		has_last_destination_ = true;
+		// Calculate a trajectory to reach the next destination
+		trajectory_manager_calculate_trajectory(start_pose, next_pose, 1.0);
+	}
+	// Let the drive control rate group command the motors
+	drive_manager_enable();
 }
 
 end_status_t DriveState::run() {
@@ -30,9 +61,11 @@ end_status_t DriveState::run() {
 	if (search_complete_) {
 		return end_status_t::SystemDisabled;
 	}
+	if (line_reached_) {
+		return end_status_t::SurveyLineReached;
+	}
 
 	// Get current pose from localization manager
-	localization_manager_update_estimates();
 	pose2d_t cur_pose = localization_manager_estimate_to_pose2d();
 
 	// Get next setpoints by following the trajectory
@@ -40,16 +73,16 @@ end_status_t DriveState::run() {
 	double turn_vel_radps_setpoint;
 	bool trajectory_complete;
 	bool trajectory_off_course;
+	LOOP_PROFILER_BEGIN(LOOP_PROFILER_PROBE_TRAJECTORY_FOLLOW);
 	trajectory_manager_follow_trajectory(cur_pose, &forward_vel_mps_setpoint, &turn_vel_radps_setpoint, &trajectory_complete, &trajectory_off_course);
+	LOOP_PROFILER_END(LOOP_PROFILER_PROBE_TRAJECTORY_FOLLOW);
 
-	// Apply setpoints from trajectory following to drive
-	drive_state_estimation_t state_estimation = {};
+	// Apply setpoints from trajectory following to drive. Drive control loop itself runs in its own rate group
 	drive_manager_change_setpoint(forward_vel_mps_setpoint, turn_vel_radps_setpoint);
-	drive_manager_run(&state_estimation);
 
-	// Check if trajectory complete
+	// Check if trajectory complete. Recording either happens at this stop or along the line that starts here
 	if (trajectory_complete) {
-		return end_status_t::TrajectoryComplete;
+		return area_search_manager_next_is_recorded_line() ? end_status_t::SurveyLineReached : end_status_t::TrajectoryComplete;
 	}
 
 	//////// DEMO ONLY ////////
@@ -59,5 +92,6 @@ end_status_t DriveState::run() {
 }
 
 void DriveState::cleanup() {
-
+	// Stop the drive control rate group from commanding the motors
+	drive_manager_disable();
 }
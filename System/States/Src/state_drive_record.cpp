@@ -0,0 +1,99 @@
+/*
+ * state_drive_record.cpp
+ */
+
+#include "state_drive_record.h"
+
+#include <math.h>
+
+#include "area_search_manager.h"
+#include "drive_manager.h"
+#include "gpr_manager.h"
+#include "localization_manager.h"
+#include "loop_profiler.h"
+#include "odometry_manager.h"
+#include "trajectory_manager.h"
+
+void DriveRecordState::init() {
+	// Drive straight through the rest of the pass's stops to its end
+	pose2d_t line_end = area_search_manager_retrieve_line_end();
+
+	// Start from the robot's position projected onto the survey line, so the line itself is what gets followed
+	pose2d_t start_pose = localization_manager_estimate_to_pose2d();
+	double line_dir_x = cos(line_end.theta);
+	double line_dir_y = sin(line_end.theta);
+	double along_line_m = (start_pose.x - line_end.x) * line_dir_x + (start_pose.y - line_end.y) * line_dir_y;
+	start_pose.x = line_end.x + along_line_m * line_dir_x;
+	start_pose.y = line_end.y + along_line_m * line_dir_y;
+	start_pose.theta = line_end.theta;
+	trajectory_manager_calculate_trajectory(start_pose, line_end, SPEED_MULTIPLIER);
+
+	// Measure distance along the line from here, with the first sweep right at the start
+	odometry_snapshot_t odometry = {};
+	odometry_manager_get_snapshot(&odometry);
+	start_ticks_l_ = odometry.ticks_l;
+	start_ticks_r_ = odometry.ticks_r;
+	next_trigger_ticks_ = 0;
+	sweeping_ = false;
+
+	// Let the drive control rate group command the motors
+	drive_manager_enable();
+}
+
+end_status_t DriveRecordState::run() {
+
+	// Get current pose from localization manager
+	pose2d_t cur_pose = localization_manager_estimate_to_pose2d();
+
+	// Get next setpoints by following the trajectory
+	double forward_vel_mps_setpoint;
+	double turn_vel_radps_setpoint;
+	bool trajectory_complete;
+	bool trajectory_off_course;
+	LOOP_PROFILER_BEGIN(LOOP_PROFILER_PROBE_TRAJECTORY_FOLLOW);
+	trajectory_manager_follow_trajectory(cur_pose, &forward_vel_mps_setpoint, &turn_vel_radps_setpoint, &trajectory_complete, &trajectory_off_course);
+	LOOP_PROFILER_END(LOOP_PROFILER_PROBE_TRAJECTORY_FOLLOW);
+
+	// Apply setpoints from trajectory following to drive. Drive control loop itself runs in its own rate group
+	drive_manager_change_setpoint(forward_vel_mps_setpoint, turn_vel_radps_setpoint);
+
+	// Continue the sweep in progress. Once it's done, tag it with where the robot was halfway through capturing it
+	if (sweeping_ && !gpr_manager_loop_recording()) {
+		sweeping_ = false;
+		gpr_trace_info_t trace;
+		gpr_manager_get_trace_info(&trace);
+		pose2d_t trace_pose;
+		if (!localization_manager_get_pose_at(trace.start_us + (trace.end_us - trace.start_us) / 2, &trace_pose)) {
+			trace_pose = cur_pose;
+		}
+		gpr_manager_tag_pose(trace_pose);
+	}
+
+	// Start a sweep each time the robot has covered the trace spacing. Sweeps aren't recorded while driving back to the
+	// line, and a trigger that comes while a sweep is still going starts the next one as soon as it's done
+	odometry_snapshot_t odometry;
+	if (!sweeping_ && !trajectory_off_course && odometry_manager_get_snapshot(&odometry)) {
+		int64_t distance_ticks = ((odometry.ticks_l - start_ticks_l_) + (odometry.ticks_r - start_ticks_r_)) / 2;
+		if (distance_ticks >= next_trigger_ticks_) {
+			gpr_manager_start_recording(SWEEP_START_FREQ_MHZ, SWEEP_STOP_FREQ_MHZ, SWEEP_NUM_STEPS, SWEEP_SAMPLES_PER_STEP);
+			sweeping_ = true;
+			// Keep to the spacing grid, unless the robot is more than a whole spacing behind it
+			next_trigger_ticks_ += TRACE_SPACING_TICKS;
+			if (next_trigger_ticks_ <= distance_ticks) {
+				next_trigger_ticks_ = distance_ticks + TRACE_SPACING_TICKS;
+			}
+		}
+	}
+
+	// Line is done once the robot reached its end and the last sweep finished
+	if (trajectory_complete && !sweeping_) {
+		return end_status_t::SurveyLineComplete;
+	}
+
+	return end_status_t::NoChange;
+}
+
+void DriveRecordState::cleanup() {
+	// Stop the drive control rate group from commanding the motors
+	drive_manager_disable();
+}
@@ -10,26 +10,76 @@
 #include "localization_manager.h"
 #include "telemetry_manager.h"
 
+#include "stm32f7xx_hal.h"
+
+typedef bool (*subsystem_init_step_t)(void);
+
+/**
+ * @brief Drive hardware has no slow setup, so it's ready as soon as drive_manager_init() returns
+ * @return Always true
+ */
+static bool drive_manager_always_ready() {
+	return true;
+}
+
+// Order must match InitializeState::subsystem_t
+static const subsystem_init_step_t subsystem_init_steps[InitializeState::NUM_SUBSYSTEMS] = {
+	drive_manager_always_ready,
+	gpr_manager_init_step,
+	localization_manager_init_step,
+	telemetry_manager_init_step,
+};
+
 void InitializeState::init() {
-	// Initialize all the managers, which in turn initialize the hardware
+	init_start_ms_ = HAL_GetTick();
+	for (int i = 0; i < NUM_SUBSYSTEMS; i++) {
+		subsystem_ready_[i] = false;
+		time_to_ready_ms_[i] = 0;
+	}
+
+	// Start initializing all the managers, which in turn start initializing the hardware. None of these block
 	drive_manager_init();
 	gpr_manager_init();
 	localization_manager_init();
 	telemetry_manager_init();
+}
 
-	// Enable sensors in localization manager
+end_status_t InitializeState::run() {
+	// Advance every subsystem that isn't ready yet by one step
+	bool all_ready = true;
+	for (int i = 0; i < NUM_SUBSYSTEMS; i++) {
+		if (!subsystem_ready_[i] && subsystem_init_steps[i]()) {
+			subsystem_ready_[i] = true;
+			time_to_ready_ms_[i] = HAL_GetTick() - init_start_ms_;
+		}
+		all_ready &= subsystem_ready_[i];
+	}
+	if (!all_ready) {
+		return end_status_t::NoChange;
+	}
+
+	// Enable sensors in localization manager. GPS is configured and receiving by now, and fixes without a valid
+	// solution are skipped when fused, so it can be enabled before the first fix
 	localization_manager_sensor_enable(localization_sensor_type_t::ENCODER_LEFT, true);
 	localization_manager_sensor_enable(localization_sensor_type_t::ENCODER_RIGHT, true);
 	localization_manager_sensor_enable(localization_sensor_type_t::IMU, true);
+	localization_manager_sensor_enable(localization_sensor_type_t::GPS, true);
 
 	// Get current location from localization manager and generate search area
 	localization_manager_update_estimates();
 	pose2d_t initial_pose_2d = localization_manager_estimate_to_pose2d();
-	area_search_manager_generate_area(SEARCH_AREA_WIDTH_M, SEARCH_AREA_LENGTH_M, NUM_PASSES, STOPS_PER_PASS, initial_pose_2d);
-}
+	area_search_manager_generate_area(SEARCH_AREA_WIDTH_M, SEARCH_AREA_LENGTH_M, NUM_PASSES, STOPS_PER_PASS, initial_pose_2d, PRECOMPUTE_SEARCH, RECORD_WHILE_DRIVING);
 
-end_status_t InitializeState::run() {
 	return end_status_t::InitializationComplete;
 }
 
 void InitializeState::cleanup() {}
+
+uint32_t InitializeState::get_time_to_ready_ms(subsystem_t subsystem) {
+	// Check user inputs
+	if (subsystem < 0 || subsystem >= NUM_SUBSYSTEMS) {
+		return 0;
+	}
+
+	return time_to_ready_ms_[subsystem];
+}
@@ -4,12 +4,29 @@
 
 #include "state_record.h"
 
-void RecordState::init() {
+#include "calibration_manager.h"
+#include "gpr_manager.h"
+#include "localization_manager.h"
 
+void RecordState::init() {
+	// Start the sweep. It runs from interrupts, so it's only checked on from here
+	gpr_manager_start_recording(SWEEP_START_FREQ_MHZ, SWEEP_STOP_FREQ_MHZ, SWEEP_NUM_STEPS, SWEEP_SAMPLES_PER_STEP);
+	// Robot is stopped, so it's a good time to save IMU calibration if it's due
+	calibration_manager_request_read();
 }
 
 end_status_t RecordState::run() {
-	// For now, don't actually record, just immediately return that recording is complete
+	// Wait for the sweep to finish
+	if (gpr_manager_loop_recording()) {
+		return end_status_t::NoChange;
+	}
+	// Stay stopped until the IMU is back in fusion, which only takes a while at the first stop after it's calibrated
+	if (calibration_manager_is_reading()) {
+		return end_status_t::NoChange;
+	}
+
+	// Robot hasn't moved since the sweep started, so the current estimate is where it was recorded
+	gpr_manager_tag_pose(localization_manager_estimate_to_pose2d());
 	return end_status_t::RecordingComplete;
 }
 
@@ -0,0 +1,45 @@
+/*
+ * bench.h
+ *
+ * Timing for the host benchmarks. Each benchmark is its own program that times a module's calls over many repeats and
+ * prints the cost of one. Host timings only compare approaches against each other: the target's FPU, caches, and clock
+ * differ, so costs on the robot come from the loop profiler instead.
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdio.h>
+#include <time.h>
+
+// Results are added into this so the compiler can't drop the work being timed
+static volatile double bench_sink;
+
+/**
+ * @brief Reads a monotonic clock
+ * @return Time in seconds
+ */
+static inline double bench_now_s(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Prints the cost of one repeat of a timed loop, in nanoseconds if it is under a microsecond
+ * @param[in] name: What was timed
+ * @param[in] elapsed_s: Time the whole loop took
+ * @param[in] num_repeats: Repeats in the loop
+ * @return Cost of one repeat in microseconds
+ */
+static inline double bench_report(const char* name, double elapsed_s, long num_repeats) {
+	double us = elapsed_s * 1e6 / num_repeats;
+	if (us < 1) {
+		printf("%-48s %10.2f ns\n", name, us * 1e3);
+	} else {
+		printf("%-48s %10.3f us\n", name, us);
+	}
+	return us;
+}
+
+#endif /* BENCH_H_ */
@@ -0,0 +1,87 @@
+/*
+ * bench_area_search.c
+ *
+ * Cost of getting each leg of a survey: planned when DriveState needs it, against looked up in the leg table that
+ * area_search_manager precomputes. Loading the leg's speed profile costs the same either way, so it's timed on its own
+ */
+
+#include "area_search_manager.h"
+
+#include "bench.h"
+#include "trajectory_manager.h"
+
+#define NUM_PASSES			20
+#define STOPS_PER_PASS		98
+#define NUM_LEGS			((STOPS_PER_PASS + 2) * NUM_PASSES - 1)
+#define NUM_REPEATS			200
+
+uint32_t HAL_GetTick(void) {
+	return 0;
+}
+
+int main() {
+	const pose2d_t start_pose = {0, 0, 0};
+	printf("area_search: %d passes of %d stops, %d legs\n", NUM_PASSES, STOPS_PER_PASS, NUM_LEGS);
+
+	// Lazy: each leg is planned from the last destination when it's needed
+	double lazy_s = 0;
+	for (int r = 0; r < NUM_REPEATS; r++) {
+		area_search_manager_generate_area(NUM_PASSES - 1, 49.5, NUM_PASSES, STOPS_PER_PASS, start_pose, false, false);
+		pose2d_t last_pose = start_pose;
+		int num_legs = 0;
+		double t0 = bench_now_s();
+		while (!area_search_manager_is_complete()) {
+			bool line_complete;
+			pose2d_t next_pose = area_search_manager_retrieve_next_destination(&line_complete);
+			dubins_path_t path;
+			double max_vel_mps;
+			trajectory_manager_plan_path(last_pose, next_pose, &path, &max_vel_mps);
+			bench_sink += path.lengths_m[1] + max_vel_mps;
+			last_pose = next_pose;
+			num_legs++;
+		}
+		lazy_s += bench_now_s() - t0;
+		if (num_legs != NUM_LEGS) {
+			printf("area_search: lazy search gave %d legs\n", num_legs);
+			return 1;
+		}
+	}
+	double lazy_us = bench_report("  lazy, per leg", lazy_s, (long) NUM_REPEATS * NUM_LEGS);
+
+	// Table: every leg is planned up front, then looked up
+	double precompute_s = 0;
+	double table_s = 0;
+	for (int r = 0; r < NUM_REPEATS; r++) {
+		double t0 = bench_now_s();
+		area_search_manager_generate_area(NUM_PASSES - 1, 49.5, NUM_PASSES, STOPS_PER_PASS, start_pose, true, false);
+		double t1 = bench_now_s();
+		precompute_s += t1 - t0;
+		area_search_leg_t leg;
+		int num_legs = 0;
+		while (area_search_manager_retrieve_next_leg(&leg)) {
+			bench_sink += leg.path.lengths_m[1] + leg.max_vel_mps;
+			num_legs++;
+		}
+		table_s += bench_now_s() - t1;
+		if (num_legs != NUM_LEGS) {
+			printf("area_search: leg table gave %d legs\n", num_legs);
+			return 1;
+		}
+	}
+	double table_us = bench_report("  table, per leg", table_s, (long) NUM_REPEATS * NUM_LEGS);
+	bench_report("  table, precomputing the whole search", precompute_s, NUM_REPEATS);
+
+	// Either way, the leg's speed profile is generated when it's loaded
+	area_search_manager_generate_area(NUM_PASSES - 1, 49.5, NUM_PASSES, STOPS_PER_PASS, start_pose, true, false);
+	area_search_leg_t leg;
+	area_search_manager_retrieve_next_leg(&leg);
+	double t0 = bench_now_s();
+	for (int r = 0; r < NUM_REPEATS * 10; r++) {
+		trajectory_manager_load_path(&leg.path, leg.destination, leg.max_vel_mps, 1.0, start_pose);
+	}
+	double t1 = bench_now_s();
+	bench_report("  loading a leg's speed profile", t1 - t0, NUM_REPEATS * 10);
+
+	printf("area_search: table lookup is %.1fx faster than planning each leg\n", lazy_us / table_us);
+	return 0;
+}
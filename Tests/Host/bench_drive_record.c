@@ -0,0 +1,166 @@
+/*
+ * bench_drive_record.c
+ *
+ * Traces per minute along a survey line, recorded while driving as DriveRecordState does it, against stopping for each
+ * trace as DriveState and RecordState do it. Both drive the real trajectory follower through the unicycle in
+ * survey_sim.h, one state machine run per state period, and a sweep started on one run is noticed on the first run
+ * after it ends.
+ */
+
+#include "trajectory_manager.h"
+
+#include <math.h>
+
+#include "bench.h"
+#include "survey_sim.h"
+
+#define LINE_LENGTH_M		10
+#define TRACE_SPACING_M		0.05 // As DriveRecordState
+#define LINE_TIMEOUT_S		3600
+
+typedef struct line_result_t {
+	int num_traces;
+	double time_s;
+	double worst_gap_m; // Longest distance along the line between the starts of two sweeps
+} line_result_t;
+
+static uint32_t sim_time_ms; // What HAL_GetTick() reports to the trajectory manager
+
+uint32_t HAL_GetTick(void) {
+	return sim_time_ms;
+}
+
+/**
+ * @brief Moves the robot on one state period
+ * @param[in, out] robot: Robot to move
+ * @param[in] forward_vel_mps: Forward velocity setpoint
+ * @param[in] turn_vel_radps: Angular velocity setpoint
+ */
+static void step(survey_sim_robot_t* robot, double forward_vel_mps, double turn_vel_radps) {
+	survey_sim_step(robot, forward_vel_mps, turn_vel_radps);
+	sim_time_ms = (uint32_t) (robot->time_s * 1000 + 0.5);
+}
+
+/**
+ * @brief Drives the line without stopping, starting a sweep each time the robot has covered the trace spacing
+ * @param[in] sweep_s: How long a sweep takes in hardware
+ * @return Traces recorded and how long the line took
+ */
+static line_result_t record_while_driving(double sweep_s) {
+	// Slow enough that each sweep is done, and noticed, before the next is due, as DriveRecordState works out its speed
+	double speed_multiplier = fmin(TRACE_SPACING_M / (sweep_s + SURVEY_SIM_DT_S) / MAX_DRIVE_SPEED_MPS, 1);
+	pose2d_t line_start = {0, 0, 0};
+	pose2d_t line_end = {LINE_LENGTH_M, 0, 0};
+	survey_sim_robot_t robot;
+	survey_sim_init(&robot, line_start, 0);
+	sim_time_ms = 0;
+	trajectory_manager_calculate_trajectory(line_start, line_end, speed_multiplier);
+
+	line_result_t result = {0};
+	double distance_m = 0; // Mean track travel, as DriveRecordState reads it from the encoders
+	double next_trigger_m = 0;
+	double last_trace_m = 0;
+	bool sweeping = false;
+	double sweep_end_s = 0;
+	while (robot.time_s < LINE_TIMEOUT_S) {
+		double forward_vel_mps;
+		double turn_vel_radps;
+		bool complete;
+		bool off_course;
+		trajectory_manager_follow_trajectory(robot.pose, &forward_vel_mps, &turn_vel_radps, &complete, &off_course);
+
+		if (sweeping && robot.time_s >= sweep_end_s) {
+			sweeping = false;
+		}
+		if (!sweeping && !off_course && distance_m >= next_trigger_m) {
+			sweeping = true;
+			sweep_end_s = robot.time_s + sweep_s;
+			if (result.num_traces > 0) {
+				result.worst_gap_m = fmax(result.worst_gap_m, distance_m - last_trace_m);
+			}
+			last_trace_m = distance_m;
+			result.num_traces++;
+			next_trigger_m += TRACE_SPACING_M;
+			if (next_trigger_m <= distance_m) {
+				next_trigger_m = distance_m + TRACE_SPACING_M;
+			}
+		}
+		if (complete && !sweeping) {
+			break;
+		}
+
+		step(&robot, forward_vel_mps, turn_vel_radps);
+		distance_m += fabs(robot.forward_vel_mps) * SURVEY_SIM_DT_S;
+	}
+	result.time_s = robot.time_s;
+	return result;
+}
+
+/**
+ * @brief Drives the line a trace spacing at a time, stopping to record a sweep at the start and at every stop
+ * @param[in] sweep_s: How long a sweep takes in hardware
+ * @return Traces recorded and how long the line took
+ */
+static line_result_t stop_and_go(double sweep_s) {
+	pose2d_t stop = {0, 0, 0};
+	survey_sim_robot_t robot;
+	survey_sim_init(&robot, stop, 0);
+	sim_time_ms = 0;
+
+	line_result_t result = {0};
+	int num_stops = (int) round(LINE_LENGTH_M / TRACE_SPACING_M) + 1;
+	for (int s = 0; s < num_stops && robot.time_s < LINE_TIMEOUT_S; s++) {
+		// Record state: its first run starts the sweep, and the first run after the sweep ends hands back to driving
+		double sweep_end_s = robot.time_s + sweep_s;
+		while (robot.time_s < sweep_end_s) {
+			step(&robot, 0, 0);
+		}
+		result.num_traces++;
+		result.worst_gap_m = TRACE_SPACING_M;
+		if (s == num_stops - 1) {
+			break;
+		}
+		step(&robot, 0, 0);
+
+		// Drive state: plan from the robot projected onto the line, then follow until the run that finds the leg done.
+		// The record state's first run comes a period after that
+		pose2d_t last_stop = stop;
+		stop.x += TRACE_SPACING_M;
+		double along_m = (robot.pose.x - last_stop.x) * cos(last_stop.theta) + (robot.pose.y - last_stop.y) * sin(last_stop.theta);
+		pose2d_t leg_start = {last_stop.x + along_m * cos(last_stop.theta), last_stop.y + along_m * sin(last_stop.theta), last_stop.theta};
+		trajectory_manager_calculate_trajectory(leg_start, stop, 1.0);
+		while (robot.time_s < LINE_TIMEOUT_S) {
+			double forward_vel_mps;
+			double turn_vel_radps;
+			bool complete;
+			bool off_course;
+			trajectory_manager_follow_trajectory(robot.pose, &forward_vel_mps, &turn_vel_radps, &complete, &off_course);
+			if (complete) {
+				break;
+			}
+			step(&robot, forward_vel_mps, turn_vel_radps);
+		}
+		survey_sim_stop(&robot);
+		step(&robot, 0, 0);
+	}
+	result.time_s = robot.time_s;
+	return result;
+}
+
+int main() {
+	// The 50 x 200 and 50 x 500 sweeps at hardware speed, as test_gpr_manager times them, and slower sweeps
+	const double sweeps_s[] = {0.015, 0.02625, 0.1, 0.5};
+	printf("drive_record: %d m line, a trace every %.0f cm\n", LINE_LENGTH_M, TRACE_SPACING_M * 100);
+	for (unsigned s = 0; s < sizeof(sweeps_s) / sizeof(sweeps_s[0]); s++) {
+		double t0 = bench_now_s();
+		line_result_t driving = record_while_driving(sweeps_s[s]);
+		line_result_t stopping = stop_and_go(sweeps_s[s]);
+		double t1 = bench_now_s();
+		double driving_per_min = driving.num_traces / driving.time_s * 60;
+		double stopping_per_min = stopping.num_traces / stopping.time_s * 60;
+		printf("  %5.1f ms sweeps: while driving %d traces in %.1f s, %.0f/min, %.1f cm apart at most. Stop and go %d traces in %.1f s, %.0f/min. %.1fx (%.0f ms to simulate)\n",
+				sweeps_s[s] * 1e3, driving.num_traces, driving.time_s, driving_per_min, driving.worst_gap_m * 100,
+				stopping.num_traces, stopping.time_s, stopping_per_min, driving_per_min / stopping_per_min, (t1 - t0) * 1e3);
+	}
+	return 0;
+}
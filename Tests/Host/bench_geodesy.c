@@ -0,0 +1,121 @@
+/*
+ * bench_geodesy.c
+ *
+ * Cost of converting one GPS fix to the local tangent plane: the cached ENU expansion against the exact ECEF rotation,
+ * and against the spherical projection localization used before
+ */
+
+#include "geodesy.h"
+
+#include <math.h>
+
+#include "bench.h"
+
+#define NUM_FIXES		1024 // Distinct fixes cycled through, so no conversion is computed once and reused
+#define NUM_REPEATS		(16 * 1024 * 1024)
+#define EARTH_RADIUS_M	6371000.0 // As the spherical projection used it
+
+static int32_t lats_e7[NUM_FIXES];
+static int32_t lons_e7[NUM_FIXES];
+static int32_t heights_mm[NUM_FIXES];
+
+/**
+ * @brief Converts a geodetic position to earth-centered, earth-fixed coordinates, as in test_geodesy.c
+ * @param[in] lat_rad: Latitude
+ * @param[in] lon_rad: Longitude
+ * @param[in] height_m: Height above ellipsoid
+ * @param[out] ecef: X, Y, and Z in meters
+ */
+static void to_ecef(double lat_rad, double lon_rad, double height_m, double ecef[3]) {
+	double sin_lat = sin(lat_rad);
+	double normal_m = GEODESY_WGS84_A_M / sqrt(1 - GEODESY_WGS84_E2 * sin_lat * sin_lat);
+	ecef[0] = (normal_m + height_m) * cos(lat_rad) * cos(lon_rad);
+	ecef[1] = (normal_m + height_m) * cos(lat_rad) * sin(lon_rad);
+	ecef[2] = (normal_m * (1 - GEODESY_WGS84_E2) + height_m) * sin_lat;
+}
+
+/**
+ * Exact reference with everything that only depends on the origin cached, so each fix pays for its own trig only
+ */
+typedef struct ecef_origin_t {
+	double ecef[3];
+	double sin_lat;
+	double cos_lat;
+	double sin_lon;
+	double cos_lon;
+} ecef_origin_t;
+
+static geodesy_enu_t ecef_to_enu(const ecef_origin_t* origin, int32_t lat_e7, int32_t lon_e7, int32_t height_mm) {
+	double point[3];
+	to_ecef(lat_e7 * GEODESY_E7_TO_RAD, lon_e7 * GEODESY_E7_TO_RAD, height_mm * 1e-3, point);
+	double d[3] = {point[0] - origin->ecef[0], point[1] - origin->ecef[1], point[2] - origin->ecef[2]};
+	geodesy_enu_t enu;
+	enu.east_m = -origin->sin_lon * d[0] + origin->cos_lon * d[1];
+	enu.north_m = -origin->sin_lat * origin->cos_lon * d[0] - origin->sin_lat * origin->sin_lon * d[1] + origin->cos_lat * d[2];
+	enu.up_m = origin->cos_lat * origin->cos_lon * d[0] + origin->cos_lat * origin->sin_lon * d[1] + origin->sin_lat * d[2];
+	return enu;
+}
+
+int main() {
+	// Fixes scattered over a survey area a kilometer either way of the origin
+	const int32_t lat0_e7 = 423601234;
+	const int32_t lon0_e7 = -710912345;
+	const int32_t height0_mm = 50000;
+	uint32_t seed = 1;
+	for (int i = 0; i < NUM_FIXES; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		lats_e7[i] = lat0_e7 + (int32_t) (seed >> 8) % 90000 - 45000;
+		seed = seed * 1664525u + 1013904223u;
+		lons_e7[i] = lon0_e7 + (int32_t) (seed >> 8) % 120000 - 60000;
+		seed = seed * 1664525u + 1013904223u;
+		heights_mm[i] = height0_mm + (int32_t) (seed >> 8) % 40000 - 20000;
+	}
+	printf("geodesy: %d fixes\n", NUM_REPEATS);
+
+	geodesy_enu_origin_t origin;
+	geodesy_enu_origin_init(&origin, lat0_e7, lon0_e7, height0_mm);
+	double t0 = bench_now_s();
+	for (int i = 0; i < NUM_REPEATS; i++) {
+		int f = i & (NUM_FIXES - 1);
+		geodesy_enu_t enu = geodesy_to_enu(&origin, lats_e7[f], lons_e7[f], heights_mm[f]);
+		bench_sink += enu.east_m + enu.north_m + enu.up_m;
+	}
+	double t1 = bench_now_s();
+	double enu_us = bench_report("  cached ENU expansion", t1 - t0, NUM_REPEATS);
+
+	ecef_origin_t ecef_origin;
+	double lat0 = lat0_e7 * GEODESY_E7_TO_RAD;
+	double lon0 = lon0_e7 * GEODESY_E7_TO_RAD;
+	to_ecef(lat0, lon0, height0_mm * 1e-3, ecef_origin.ecef);
+	ecef_origin.sin_lat = sin(lat0);
+	ecef_origin.cos_lat = cos(lat0);
+	ecef_origin.sin_lon = sin(lon0);
+	ecef_origin.cos_lon = cos(lon0);
+	t0 = bench_now_s();
+	for (int i = 0; i < NUM_REPEATS; i++) {
+		int f = i & (NUM_FIXES - 1);
+		geodesy_enu_t enu = ecef_to_enu(&ecef_origin, lats_e7[f], lons_e7[f], heights_mm[f]);
+		bench_sink += enu.east_m + enu.north_m + enu.up_m;
+	}
+	t1 = bench_now_s();
+	double ecef_us = bench_report("  ECEF reference, origin cached", t1 - t0, NUM_REPEATS);
+
+	// The projection localization used before: a sphere, with cos() of the origin latitude taken on every fix. The origin
+	// is read through a volatile so the compiler can't hoist the cos() out of the loop, as it couldn't across separate fixes
+	volatile double origin_lat_rad = lat0;
+	t0 = bench_now_s();
+	for (int i = 0; i < NUM_REPEATS; i++) {
+		int f = i & (NUM_FIXES - 1);
+		double lat_rad = lats_e7[f] * GEODESY_E7_TO_RAD;
+		double lon_rad = lons_e7[f] * GEODESY_E7_TO_RAD;
+		double east_m = (lon_rad - lon0) * cos(origin_lat_rad) * EARTH_RADIUS_M;
+		double north_m = (lat_rad - lat0) * EARTH_RADIUS_M;
+		bench_sink += east_m + north_m;
+	}
+	t1 = bench_now_s();
+	double sphere_us = bench_report("  spherical projection", t1 - t0, NUM_REPEATS);
+
+	printf("geodesy: cached ENU is %.0fx faster than the ECEF reference and %.1fx faster than the spherical projection\n",
+			ecef_us / enu_us, sphere_us / enu_us);
+	return 0;
+}
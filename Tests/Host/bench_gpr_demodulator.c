@@ -0,0 +1,40 @@
+/*
+ * bench_gpr_demodulator.c
+ *
+ * Cost of demodulating one GPR step
+ */
+
+#include "gpr_demodulator.h"
+
+#include <math.h>
+
+#include "bench.h"
+
+#define NUM_REPEATS		200000
+
+int main() {
+	const int sizes[] = {200, 500};
+	printf("gpr_demodulator: %d steps\n", NUM_REPEATS);
+	for (int s = 0; s < 2; s++) {
+		int num_samples = sizes[s];
+		gpr_demodulator_t demod;
+		gpr_demodulator_init(&demod, num_samples, 0.45);
+		uint16_t samples[GPR_DEMODULATOR_MAX_SAMPLES];
+		for (int n = 0; n < num_samples; n++) {
+			samples[n] = (uint16_t) (2048 + 1000 * cos(2 * 3.14159265358979 * 0.45 * n + 0.7));
+		}
+
+		gpr_iq_t iq;
+		double t0 = bench_now_s();
+		for (int i = 0; i < NUM_REPEATS; i++) {
+			samples[i % num_samples] ^= 1; // Different input every time, so no step is computed once and reused
+			gpr_demodulator_run(&demod, samples, &iq);
+			bench_sink += iq.i;
+		}
+		double t1 = bench_now_s();
+		char name[64];
+		snprintf(name, sizeof(name), "  %d-sample step", num_samples);
+		bench_report(name, t1 - t0, NUM_REPEATS);
+	}
+	return 0;
+}
@@ -0,0 +1,113 @@
+/*
+ * bench_gpr_range_profile.c
+ *
+ * Cost of synthesizing one range profile from a full 50-step sweep zero-padded to 64 points: the windowed FFT against
+ * a direct inverse DFT, both with trig taken per term and with a table built up front
+ */
+
+#include "gpr_range_profile.h"
+
+#include <math.h>
+
+#include "bench.h"
+
+#define NUM_STEPS		50 // MAX_STEP_INCREMENTS in gpr_manager.c
+#define NUM_POINTS		64
+#define NUM_REPEATS		200000
+#define PI				3.14159265358979f
+
+static gpr_range_profile_t profile;
+static gpr_complex_t dft_table[NUM_STEPS][NUM_POINTS]; // e^(j * 2 * pi * n * k / NUM_POINTS), windowed
+
+/**
+ * @brief Direct inverse DFT of a windowed sweep, one term at a time
+ * @param[in] iq: I/Q sample of each step
+ * @param[out] bins: Complex range profile
+ */
+static void direct_dft(const gpr_iq_t* iq, gpr_complex_t* bins) {
+	for (int k = 0; k < NUM_POINTS; k++) {
+		float re = 0;
+		float im = 0;
+		for (int n = 0; n < NUM_STEPS; n++) {
+			float angle = 2 * PI * n * k / NUM_POINTS;
+			float c = cosf(angle) * profile.window[n];
+			float s = sinf(angle) * profile.window[n];
+			re += iq[n].i * c - iq[n].q * s;
+			im += iq[n].i * s + iq[n].q * c;
+		}
+		bins[k].re = re;
+		bins[k].im = im;
+	}
+}
+
+/**
+ * @brief Direct inverse DFT of a windowed sweep, with every term's windowed twiddle looked up
+ * @param[in] iq: I/Q sample of each step
+ * @param[out] bins: Complex range profile
+ */
+static void table_dft(const gpr_iq_t* iq, gpr_complex_t* bins) {
+	for (int k = 0; k < NUM_POINTS; k++) {
+		float re = 0;
+		float im = 0;
+		for (int n = 0; n < NUM_STEPS; n++) {
+			gpr_complex_t w = dft_table[n][k];
+			re += iq[n].i * w.re - iq[n].q * w.im;
+			im += iq[n].i * w.im + iq[n].q * w.re;
+		}
+		bins[k].re = re;
+		bins[k].im = im;
+	}
+}
+
+int main() {
+	gpr_range_profile_init(&profile, NUM_STEPS, NUM_POINTS, GprRangeWindowHann);
+	for (int n = 0; n < NUM_STEPS; n++) {
+		for (int k = 0; k < NUM_POINTS; k++) {
+			float angle = 2 * PI * n * k / NUM_POINTS;
+			dft_table[n][k].re = cosf(angle) * profile.window[n];
+			dft_table[n][k].im = sinf(angle) * profile.window[n];
+		}
+	}
+	gpr_iq_t iq[NUM_STEPS];
+	uint32_t seed = 1;
+	for (int n = 0; n < NUM_STEPS; n++) {
+		seed = seed * 1664525u + 1013904223u;
+		iq[n].i = (float) (seed >> 20) - 2048;
+		seed = seed * 1664525u + 1013904223u;
+		iq[n].q = (float) (seed >> 20) - 2048;
+		iq[n].dc = 0;
+	}
+	gpr_complex_t bins[NUM_POINTS];
+	printf("gpr_range_profile: %d sweeps of %d steps to %d points\n", NUM_REPEATS, NUM_STEPS, NUM_POINTS);
+
+	double t0 = bench_now_s();
+	for (int i = 0; i < NUM_REPEATS; i++) {
+		iq[i % NUM_STEPS].i += 1; // Different input every time, so no profile is computed once and reused
+		gpr_range_profile_run(&profile, iq, bins);
+		bench_sink += bins[i % NUM_POINTS].re;
+	}
+	double t1 = bench_now_s();
+	double fft_us = bench_report("  FFT", t1 - t0, NUM_REPEATS);
+
+	t0 = bench_now_s();
+	for (int i = 0; i < NUM_REPEATS / 10; i++) {
+		iq[i % NUM_STEPS].i += 1;
+		direct_dft(iq, bins);
+		bench_sink += bins[i % NUM_POINTS].re;
+	}
+	t1 = bench_now_s();
+	double direct_us = bench_report("  direct DFT, trig per term", t1 - t0, NUM_REPEATS / 10);
+
+	t0 = bench_now_s();
+	for (int i = 0; i < NUM_REPEATS; i++) {
+		iq[i % NUM_STEPS].i += 1;
+		table_dft(iq, bins);
+		bench_sink += bins[i % NUM_POINTS].re;
+	}
+	t1 = bench_now_s();
+	double table_us = bench_report("  direct DFT, table", t1 - t0, NUM_REPEATS);
+
+	printf("gpr_range_profile: FFT is %.0fx faster than the direct DFT with trig and %.1fx faster with a table\n",
+			direct_us / fft_us, table_us / fft_us);
+	return 0;
+}
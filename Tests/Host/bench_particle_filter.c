@@ -0,0 +1,84 @@
+/*
+ * bench_particle_filter.c
+ *
+ * Cost of one localization update's filter steps, built once for each PARTICLE_FILTER_NUM_PARTICLES
+ */
+
+#include "particle_filter.h"
+
+#include <math.h>
+
+#include "bench.h"
+
+#define NUM_UPDATES			(4 * 1024 * 1024 / PARTICLE_FILTER_NUM_PARTICLES)
+
+// Same models as the localization manager
+#define DIST_NOISE_MIN_M	0.0005f
+#define DIST_NOISE_FRAC		0.05f
+#define YAW_NOISE_MIN_RAD	0.002f
+#define YAW_NOISE_FRAC		0.10f
+#define TILT_NOISE_RAD		0.005f
+#define IMU_YAW_STD_RAD		0.05f
+#define IMU_TILT_STD_RAD	0.03f
+#define GPS_STD_M			0.5f
+#define KLD_BIN_SIZE_M		0.05f
+#define KLD_BIN_SIZE_RAD	0.0873f
+#define KLD_EPSILON			0.05f
+#define KLD_Z_QUANTILE		2.33f
+
+static particle_filter_t pf;
+
+int main() {
+	// Drive a gentle arc at 0.5 m/s with 100 Hz updates, weighing every update by the IMU and every tenth by GPS. The
+	// set is resampled back to full size every update so each step is timed at the same count
+	pose3d_t start = {0, 0, 0, 0, 0, 0};
+	particle_filter_init(&pf, start, 0.05f, 0.05f, 1);
+	const float distance = 0.005f;
+	const float delta_yaw = 0.002f;
+	double predict_s = 0;
+	double weight_s = 0;
+	double normalize_s = 0;
+	double kld_s = 0;
+	double resample_s = 0;
+	float yaw = 0;
+	float x = 0;
+	float y = 0;
+	for (int update = 0; update < NUM_UPDATES; update++) {
+		double t0 = bench_now_s();
+		particle_filter_predict(&pf, distance, delta_yaw, DIST_NOISE_MIN_M + DIST_NOISE_FRAC * distance,
+				YAW_NOISE_MIN_RAD + YAW_NOISE_FRAC * delta_yaw, TILT_NOISE_RAD);
+		double t1 = bench_now_s();
+		x += distance * cosf(yaw + delta_yaw / 2);
+		y += distance * sinf(yaw + delta_yaw / 2);
+		yaw += delta_yaw;
+		particle_filter_weight_orientation(&pf, yaw, 0, 0, IMU_YAW_STD_RAD, IMU_TILT_STD_RAD);
+		if (update % 10 == 0) {
+			particle_filter_weight_position(&pf, x, y, GPS_STD_M);
+		}
+		double t2 = bench_now_s();
+		float num_effective = particle_filter_normalize(&pf);
+		pose3d_t pose = particle_filter_estimate(&pf);
+		double t3 = bench_now_s();
+		uint32_t num_particles = particle_filter_kld_num_particles(&pf, KLD_BIN_SIZE_M, KLD_BIN_SIZE_RAD, KLD_EPSILON, KLD_Z_QUANTILE);
+		double t4 = bench_now_s();
+		particle_filter_resample(&pf, PARTICLE_FILTER_NUM_PARTICLES);
+		double t5 = bench_now_s();
+
+		predict_s += t1 - t0;
+		weight_s += t2 - t1;
+		normalize_s += t3 - t2;
+		kld_s += t4 - t3;
+		resample_s += t5 - t4;
+		bench_sink += num_effective + pose.x + num_particles;
+	}
+
+	printf("particle_filter: %d particles, %d updates\n", PARTICLE_FILTER_NUM_PARTICLES, NUM_UPDATES);
+	bench_report("  predict", predict_s, NUM_UPDATES);
+	bench_report("  weight (IMU, GPS every tenth)", weight_s, NUM_UPDATES);
+	bench_report("  normalize and estimate", normalize_s, NUM_UPDATES);
+	bench_report("  KLD sizing", kld_s, NUM_UPDATES);
+	bench_report("  resample", resample_s, NUM_UPDATES);
+	double total_us = bench_report("  update", predict_s + weight_s + normalize_s + kld_s + resample_s, NUM_UPDATES);
+	printf("%-48s %10.2f ns\n", "  per particle", total_us * 1e3 / PARTICLE_FILTER_NUM_PARTICLES);
+	return 0;
+}
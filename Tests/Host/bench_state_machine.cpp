@@ -0,0 +1,173 @@
+/*
+ * bench_state_machine.cpp
+ *
+ * Cost of finding the next state with StateMachine's table against the nested switch and linear scan of the state list
+ * it replaced
+ */
+
+#include "state_machine.h"
+
+#include "bench.h"
+
+#define NUM_LOOKUPS	(16 * 1024 * 1024)
+#define NUM_INPUTS	4096 // Must be a power of 2
+
+class BenchState : public State {
+
+	public:
+		BenchState(int id): State(id) { }
+
+		end_status_t run() { return end_status_t::NoChange; }
+		void init(void) { }
+		void cleanup(void) { }
+};
+
+static BenchState disabled_state(state_id::Disabled);
+static BenchState drive_state(state_id::Drive);
+static BenchState drive_record_state(state_id::DriveRecord);
+static BenchState initialize_state(state_id::Initialize);
+static BenchState record_state(state_id::Record);
+static State* states[] = {&initialize_state, &disabled_state, &drive_state, &record_state, &drive_record_state};
+static const int num_states = sizeof(states) / sizeof(states[0]);
+
+/**
+ * @brief The scheduler's old way of finding the next state, with the DriveRecord transitions added so both give the
+ * same answers
+ * @param[in] current_state: State that produced end status
+ * @param[in] end_status: What the current state returned as its status
+ * @return Next state
+ */
+__attribute__((noinline)) static State* switch_get_next_state(State* current_state, end_status_t end_status) {
+	state_id next_state = state_id::UNKNOWN;
+	if (end_status == end_status_t::NoChange) {
+		return current_state;
+	}
+	switch (current_state->get_id()) {
+	case state_id::Disabled:
+		switch (end_status) {
+		case end_status_t::SystemEnabled:
+			next_state = state_id::Drive;
+			break;
+		default:
+			break;
+		}
+		break;
+	case state_id::Drive:
+		switch (end_status) {
+		case end_status_t::SystemDisabled:
+			next_state = state_id::Disabled;
+			break;
+		case end_status_t::TrajectoryComplete:
+			next_state = state_id::Record;
+			break;
+		case end_status_t::SurveyLineReached:
+			next_state = state_id::DriveRecord;
+			break;
+		default:
+			break;
+		}
+		break;
+	case state_id::DriveRecord:
+		switch (end_status) {
+		case end_status_t::SurveyLineComplete:
+			next_state = state_id::Drive;
+			break;
+		case end_status_t::SystemDisabled:
+			next_state = state_id::Disabled;
+			break;
+		default:
+			break;
+		}
+		break;
+	case state_id::Initialize:
+		switch (end_status) {
+		case end_status_t::InitializationComplete:
+			next_state = state_id::Disabled;
+			break;
+		default:
+			break;
+		}
+		break;
+	case state_id::Record:
+		switch (end_status) {
+		case end_status_t::RecordingComplete:
+			next_state = state_id::Drive;
+			break;
+		case end_status_t::SystemDisabled:
+			next_state = state_id::Disabled;
+			break;
+		default:
+			break;
+		}
+		break;
+	default:
+		break;
+	}
+	for (int i = 0; i < num_states; i++) {
+		if (states[i]->get_id() == next_state) {
+			return states[i];
+		}
+	}
+	return current_state;
+}
+
+/**
+ * @brief Times both lookups over a sequence of inputs
+ * @param[in] name: Name of the sequence
+ * @param[in] state_machine: State machine with every state registered
+ * @param[in] from: State of each input
+ * @param[in] end_statuses: End status of each input
+ */
+static void bench_inputs(const char* name, const StateMachine& state_machine, State* const* from, const end_status_t* end_statuses) {
+	// Both must agree before their costs mean anything
+	for (int i = 0; i < NUM_INPUTS; i++) {
+		if (switch_get_next_state(from[i], end_statuses[i]) != state_machine.get_next_state(from[i], end_statuses[i])) {
+			printf("state_machine: lookups disagree\n");
+		}
+	}
+
+	char label[64];
+	long sum = 0;
+	double t0 = bench_now_s();
+	for (int i = 0; i < NUM_LOOKUPS; i++) {
+		sum += switch_get_next_state(from[i & (NUM_INPUTS - 1)], end_statuses[i & (NUM_INPUTS - 1)])->get_id();
+	}
+	double t1 = bench_now_s();
+	for (int i = 0; i < NUM_LOOKUPS; i++) {
+		sum += state_machine.get_next_state(from[i & (NUM_INPUTS - 1)], end_statuses[i & (NUM_INPUTS - 1)])->get_id();
+	}
+	double t2 = bench_now_s();
+	bench_sink += sum;
+	snprintf(label, sizeof(label), "  %s, switch and scan", name);
+	bench_report(label, t1 - t0, NUM_LOOKUPS);
+	snprintf(label, sizeof(label), "  %s, table", name);
+	bench_report(label, t2 - t1, NUM_LOOKUPS);
+}
+
+int main() {
+	StateMachine state_machine;
+	for (int i = 0; i < num_states; i++) {
+		state_machine.register_state(states[i]);
+	}
+
+	// Steady running, where nearly every run ends in NoChange, and every pair in a random order, which defeats branch
+	// prediction the way a state change does
+	static State* from[NUM_INPUTS];
+	static end_status_t end_statuses[NUM_INPUTS];
+	uint32_t seed = 1;
+	for (int i = 0; i < NUM_INPUTS; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		from[i] = states[(seed >> 8) % num_states];
+		end_statuses[i] = (seed >> 20) % 100 == 0 ? end_status_t::SystemDisabled : end_status_t::NoChange;
+	}
+	printf("state_machine: %d lookups\n", NUM_LOOKUPS);
+	bench_inputs("steady", state_machine, from, end_statuses);
+
+	for (int i = 0; i < NUM_INPUTS; i++) {
+		seed = seed * 1664525u + 1013904223u;
+		from[i] = states[(seed >> 8) % num_states];
+		end_statuses[i] = (end_status_t) ((seed >> 20) % NUM_END_STATUSES);
+	}
+	bench_inputs("random", state_machine, from, end_statuses);
+	return 0;
+}
@@ -0,0 +1,257 @@
+/*
+ * bench_survey.c
+ *
+ * Time to drive a whole stop-and-go survey with the Dubins path follower, against the rotate-drive-rotate planner it
+ * replaced. The robot is the unicycle in survey_sim.h, and legs are planned the way DriveState plans them. Time spent
+ * recording at the stops is left out, so only driving is compared.
+ */
+
+#include "trajectory_manager.h"
+
+#include <math.h>
+
+#include "area_search_manager.h"
+#include "bench.h"
+#include "motion_profile.h"
+#include "survey_sim.h"
+
+#define LEG_TIMEOUT_S		120 // A leg still going after this long has failed
+#define STALL_TIME_S		0.5 // Commanded to stand still this long without finishing counts as a stall, and the leg as done
+#define STILL_VEL			0.001 // Setpoints below this are standing still, as FLOAT_ZERO_BOUNDARY in drive_manager.c
+#define VELOCITY_LAG_S		0.05 // Response time of the drive control loop, for the runs that don't track setpoints exactly
+
+// Rotate-drive-rotate planner, as trajectory_manager.c had it before Dubins paths
+#define OLD_STOP_BAND_POSITION	0.03
+#define OLD_STOP_BAND_ANGLE		0.01
+
+typedef enum {
+	OLD_INITIAL_ROTATION,
+	OLD_DRIVE,
+	OLD_FINAL_ROTATION
+} old_sub_trajectory_t;
+
+typedef enum {
+	PlannerRotateDriveRotate,
+	PlannerDubins
+} planner_t;
+
+typedef struct survey_result_t {
+	double time_s;
+	int num_stalls;
+	int num_off_course; // Times the follower reported the robot off course
+	int num_failed_legs;
+	double worst_line_error_m; // Furthest the robot got from the survey line partway along a pass
+} survey_result_t;
+
+static motion_profile_t old_profiles[3];
+static pose2d_t old_start_poses[3];
+static pose2d_t old_end_poses[3];
+static int old_sub_trajectory;
+
+static uint32_t sim_time_ms; // What HAL_GetTick() reports to the trajectory manager
+
+uint32_t HAL_GetTick(void) {
+	return sim_time_ms;
+}
+
+/**
+ * @brief Plans a turn in place to face the end position, a straight drive to it, and a turn to the end heading
+ * @param[in] start_pose: Pose that the robot starts in
+ * @param[in] end_pose: Pose for the robot to finish in
+ */
+static void old_calculate_trajectory(pose2d_t start_pose, pose2d_t end_pose) {
+	double drive_heading_rad = atan2(end_pose.y - start_pose.y, end_pose.x - start_pose.x);
+	motion_profile_generate(&old_profiles[OLD_INITIAL_ROTATION], survey_sim_wrap_angle(drive_heading_rad - start_pose.theta),
+			MAX_DRIVE_SPEED_MPS / (WHEEL_BASE_M / 2), MAX_DRIVE_ACCEL_MPSPS / (WHEEL_BASE_M / 2), MAX_DRIVE_JERK_MPSPSPS / (WHEEL_BASE_M / 2));
+	motion_profile_generate(&old_profiles[OLD_DRIVE], hypot(end_pose.y - start_pose.y, end_pose.x - start_pose.x),
+			MAX_DRIVE_SPEED_MPS, MAX_DRIVE_ACCEL_MPSPS, MAX_DRIVE_JERK_MPSPSPS);
+	motion_profile_generate(&old_profiles[OLD_FINAL_ROTATION], survey_sim_wrap_angle(end_pose.theta - drive_heading_rad),
+			MAX_DRIVE_SPEED_MPS / (WHEEL_BASE_M / 2), MAX_DRIVE_ACCEL_MPSPS / (WHEEL_BASE_M / 2), MAX_DRIVE_JERK_MPSPSPS / (WHEEL_BASE_M / 2));
+
+	old_start_poses[OLD_INITIAL_ROTATION] = start_pose;
+	old_start_poses[OLD_DRIVE] = start_pose;
+	old_start_poses[OLD_DRIVE].theta = drive_heading_rad;
+	old_start_poses[OLD_FINAL_ROTATION] = end_pose;
+	old_start_poses[OLD_FINAL_ROTATION].theta = drive_heading_rad;
+	old_end_poses[OLD_INITIAL_ROTATION] = old_start_poses[OLD_DRIVE];
+	old_end_poses[OLD_DRIVE] = old_start_poses[OLD_FINAL_ROTATION];
+	old_end_poses[OLD_FINAL_ROTATION] = end_pose;
+	old_sub_trajectory = OLD_INITIAL_ROTATION;
+}
+
+/**
+ * @brief Follows the rotate-drive-rotate trajectory, with the same outputs as trajectory_manager_follow_trajectory()
+ */
+static void old_follow_trajectory(pose2d_t cur_pose, double* forward_vel_mps, double* turn_vel_radps, bool* complete, bool* off_course) {
+	*complete = false;
+	*off_course = false;
+	*forward_vel_mps = 0;
+	*turn_vel_radps = 0;
+
+	bool rotating = old_sub_trajectory != OLD_DRIVE;
+	if (rotating) {
+		if (fabs(survey_sim_wrap_angle(old_end_poses[old_sub_trajectory].theta - cur_pose.theta)) < OLD_STOP_BAND_ANGLE) {
+			*complete = old_sub_trajectory == OLD_FINAL_ROTATION;
+			old_sub_trajectory++;
+			return;
+		}
+		if (hypot(old_start_poses[old_sub_trajectory].y - cur_pose.y, old_start_poses[old_sub_trajectory].x - cur_pose.x) > 2 * OLD_STOP_BAND_POSITION) {
+			*off_course = true;
+			return;
+		}
+	}
+	else {
+		if (hypot(old_end_poses[OLD_DRIVE].y - cur_pose.y, old_end_poses[OLD_DRIVE].x - cur_pose.x) < OLD_STOP_BAND_POSITION) {
+			old_sub_trajectory++;
+			return;
+		}
+		if (fabs(survey_sim_wrap_angle(old_start_poses[OLD_DRIVE].theta - cur_pose.theta)) > 2 * OLD_STOP_BAND_ANGLE) {
+			*off_course = true;
+			return;
+		}
+	}
+
+	double position;
+	pose2d_t start = old_start_poses[old_sub_trajectory];
+	if (rotating) {
+		position = survey_sim_wrap_angle(cur_pose.theta - start.theta);
+	}
+	else {
+		position = (cur_pose.x - start.x) * cos(start.theta) + (cur_pose.y - start.y) * sin(start.theta);
+	}
+	double stop_band = rotating ? OLD_STOP_BAND_ANGLE : OLD_STOP_BAND_POSITION;
+	double distance = motion_profile_get_distance(&old_profiles[old_sub_trajectory]);
+	if (position < fmin(0, distance) - stop_band || position > fmax(0, distance) + stop_band) {
+		*off_course = true;
+		return;
+	}
+
+	motion_profile_sample_t setpoint = motion_profile_lookup(&old_profiles[old_sub_trajectory], position);
+	if (rotating) {
+		*turn_vel_radps = setpoint.vel;
+	}
+	else {
+		*forward_vel_mps = setpoint.vel;
+	}
+}
+
+/**
+ * @brief Drives a whole stop-and-go survey, from the first stop to the last
+ * @param[in] planner: Planner to drive each leg with
+ * @param[in] width_m: Width of the area, across the passes
+ * @param[in] length_m: Length of each pass
+ * @param[in] num_passes: Passes across the area
+ * @param[in] stops_per_pass: Recording stops along each pass, excluding its ends
+ * @param[in] lag_s: Time constant of the robot's response to setpoints, 0 to follow them exactly
+ * @return Driving time and how the legs went
+ */
+static survey_result_t run_survey(planner_t planner, double width_m, double length_m, int num_passes, int stops_per_pass, double lag_s) {
+	survey_result_t result = {0};
+	pose2d_t start_pose = {0, 0, 0};
+	area_search_manager_generate_area(width_m, length_m, num_passes, stops_per_pass, start_pose, false, false);
+	survey_sim_robot_t robot;
+	survey_sim_init(&robot, start_pose, lag_s);
+	sim_time_ms = 0;
+	pose2d_t last_destination = start_pose;
+
+	while (!area_search_manager_is_complete()) {
+		// Plan the leg the way DriveState does: legs along a pass start from the robot projected onto the survey line
+		bool line_complete;
+		pose2d_t destination = area_search_manager_retrieve_next_destination(&line_complete);
+		if (planner == PlannerRotateDriveRotate) {
+			old_calculate_trajectory(robot.pose, destination);
+		}
+		else {
+			pose2d_t leg_start = robot.pose;
+			if (!line_complete) {
+				double along_m = (leg_start.x - last_destination.x) * cos(last_destination.theta) + (leg_start.y - last_destination.y) * sin(last_destination.theta);
+				leg_start.x = last_destination.x + along_m * cos(last_destination.theta);
+				leg_start.y = last_destination.y + along_m * sin(last_destination.theta);
+				leg_start.theta = last_destination.theta;
+			}
+			trajectory_manager_calculate_trajectory(leg_start, destination, 1.0);
+		}
+
+		double leg_start_s = robot.time_s;
+		double still_s = 0;
+		bool was_off_course = false;
+		while (true) {
+			double forward_vel_mps;
+			double turn_vel_radps;
+			bool complete;
+			bool off_course;
+			if (planner == PlannerRotateDriveRotate) {
+				old_follow_trajectory(robot.pose, &forward_vel_mps, &turn_vel_radps, &complete, &off_course);
+			}
+			else {
+				trajectory_manager_follow_trajectory(robot.pose, &forward_vel_mps, &turn_vel_radps, &complete, &off_course);
+			}
+			if (complete) {
+				break;
+			}
+			if (off_course && !was_off_course) {
+				result.num_off_course++;
+			}
+			was_off_course = off_course;
+			// The old planner has no way back to its path, so it starts the leg again from where the robot is
+			if (off_course && planner == PlannerRotateDriveRotate) {
+				old_calculate_trajectory(robot.pose, destination);
+			}
+			still_s = fabs(forward_vel_mps) < STILL_VEL && fabs(turn_vel_radps) < STILL_VEL ? still_s + SURVEY_SIM_DT_S : 0;
+			if (still_s >= STALL_TIME_S) {
+				result.num_stalls++;
+				break;
+			}
+			if (robot.time_s - leg_start_s > LEG_TIMEOUT_S) {
+				result.num_failed_legs++;
+				break;
+			}
+
+			survey_sim_step(&robot, forward_vel_mps, turn_vel_radps);
+			sim_time_ms = (uint32_t) (robot.time_s * 1000);
+
+			// How far the robot is from the survey line, away from where legs start and finish
+			if (!line_complete) {
+				double dx = robot.pose.x - destination.x;
+				double dy = robot.pose.y - destination.y;
+				double along_m = dx * cos(destination.theta) + dy * sin(destination.theta);
+				double lateral_m = fabs(-dx * sin(destination.theta) + dy * cos(destination.theta));
+				if (along_m < -0.25 && hypot(robot.pose.x - last_destination.x, robot.pose.y - last_destination.y) > 0.25) {
+					result.worst_line_error_m = fmax(result.worst_line_error_m, lateral_m);
+				}
+			}
+		}
+		survey_sim_stop(&robot);
+		last_destination = destination;
+	}
+	result.time_s = robot.time_s;
+	return result;
+}
+
+int main() {
+	// The area the planners were first compared on, a long narrow one, and a large one
+	const struct {
+		double width_m;
+		double length_m;
+		int num_passes;
+		int stops_per_pass;
+	} areas[] = {{10, 20, 11, 9}, {4, 30, 9, 2}, {20, 50, 21, 9}};
+	const double lags_s[] = {0, VELOCITY_LAG_S};
+	for (unsigned a = 0; a < sizeof(areas) / sizeof(areas[0]); a++) {
+		for (int l = 0; l < 2; l++) {
+			printf("survey: %g x %g m, %d passes, %d stops per pass, %s\n", areas[a].width_m, areas[a].length_m, areas[a].num_passes,
+					areas[a].stops_per_pass, lags_s[l] > 0 ? "50 ms velocity lag" : "ideal tracking");
+			survey_result_t results[2];
+			for (int p = 0; p < 2; p++) {
+				double t0 = bench_now_s();
+				results[p] = run_survey((planner_t) p, areas[a].width_m, areas[a].length_m, areas[a].num_passes, areas[a].stops_per_pass, lags_s[l]);
+				double t1 = bench_now_s();
+				printf("  %-20s %8.1f s driving, %3d stalls, %3d off course, %d failed legs, %.1f cm from the line at worst (%.0f ms to simulate)\n",
+						p == PlannerDubins ? "Dubins" : "rotate-drive-rotate", results[p].time_s, results[p].num_stalls, results[p].num_off_course,
+						results[p].num_failed_legs, results[p].worst_line_error_m * 100, (t1 - t0) * 1e3);
+			}
+			printf("  Dubins takes %.0f%% less time\n", 100 * (1 - results[PlannerDubins].time_s / results[PlannerRotateDriveRotate].time_s));
+		}
+	}
+	return 0;
+}
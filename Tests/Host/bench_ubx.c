@@ -0,0 +1,96 @@
+/*
+ * bench_ubx.c
+ *
+ * Cost of parsing one GPS fix: a NAV-PVT frame through the run parser and byte by byte, against the NMEA GGA sentence
+ * the GPS used to send through minmea
+ */
+
+#include "ubx.h"
+
+#include <string.h>
+
+#include "bench.h"
+#include "minmea.h"
+
+#define NUM_FRAMES		64 // Distinct frames in the stream, so no fix is parsed once and reused
+#define FRAME_LEN		(UBX_FRAME_OVERHEAD + UBX_NAV_PVT_PAYLOAD_LEN)
+#define NUM_REPEATS		(1024 * 1024)
+
+static uint8_t stream[NUM_FRAMES * FRAME_LEN];
+static char sentences[NUM_FRAMES][96];
+
+int main() {
+	// A stream of back-to-back NAV-PVT frames, each a slightly different fix, and the same fixes as GGA sentences
+	uint32_t seed = 1;
+	for (int f = 0; f < NUM_FRAMES; f++) {
+		seed = seed * 1664525u + 1013904223u;
+		int32_t lat_e7 = 423601234 + (int32_t) (seed >> 20);
+		uint8_t payload[UBX_NAV_PVT_PAYLOAD_LEN] = {0};
+		payload[20] = UBX_FIX_3D;
+		payload[21] = UBX_NAV_PVT_FLAGS_GNSS_FIX_OK;
+		payload[23] = 11;
+		memcpy(&payload[28], &lat_e7, sizeof(lat_e7));
+		ubx_build_frame(&stream[f * FRAME_LEN], FRAME_LEN, UBX_CLASS_NAV, UBX_ID_NAV_PVT, payload, sizeof(payload));
+
+		char body[80];
+		snprintf(body, sizeof(body), "GPGGA,1235%02d.00,4221.%04d,N,07105.4741,W,1,11,0.9,45.6,M,-33.0,M,,", f % 60, (int) (seed >> 20) % 10000);
+		uint8_t checksum = 0;
+		for (const char* c = body; *c; c++) {
+			checksum ^= (uint8_t) *c;
+		}
+		snprintf(sentences[f], sizeof(sentences[f]), "$%s*%02X", body, checksum);
+	}
+	printf("ubx: %d fixes, %d-byte NAV-PVT frames\n", NUM_REPEATS, FRAME_LEN);
+
+	// Frames arrive in runs of received bytes, as the GPS driver hands them over
+	ubx_parser_t parser;
+	ubx_parser_init(&parser);
+	ubx_nav_pvt_t pvt;
+	int num_fixes = 0;
+	double t0 = bench_now_s();
+	for (int i = 0; i < NUM_REPEATS / NUM_FRAMES; i++) {
+		const uint8_t* data = stream;
+		uint16_t len = sizeof(stream);
+		while (len > 0) {
+			bool frame_done;
+			uint16_t used = ubx_parser_feed_bytes(&parser, data, len, &frame_done);
+			data += used;
+			len -= used;
+			if (frame_done && ubx_decode_nav_pvt(&parser, &pvt)) {
+				bench_sink += pvt.lat_e7;
+				num_fixes++;
+			}
+		}
+	}
+	double t1 = bench_now_s();
+	double run_us = bench_report("  UBX run parser", t1 - t0, NUM_REPEATS);
+
+	ubx_parser_init(&parser);
+	t0 = bench_now_s();
+	for (int i = 0; i < NUM_REPEATS / NUM_FRAMES; i++) {
+		for (unsigned b = 0; b < sizeof(stream); b++) {
+			if (ubx_parser_feed(&parser, stream[b]) && ubx_decode_nav_pvt(&parser, &pvt)) {
+				bench_sink += pvt.lat_e7;
+				num_fixes++;
+			}
+		}
+	}
+	t1 = bench_now_s();
+	double byte_us = bench_report("  UBX byte by byte", t1 - t0, NUM_REPEATS);
+
+	t0 = bench_now_s();
+	for (int i = 0; i < NUM_REPEATS; i++) {
+		const char* sentence = sentences[i % NUM_FRAMES];
+		struct minmea_sentence_gga gga;
+		if (minmea_sentence_id(sentence, false) == MINMEA_SENTENCE_GGA && minmea_parse_gga(&gga, sentence)) {
+			bench_sink += gga.latitude.value;
+			num_fixes++;
+		}
+	}
+	t1 = bench_now_s();
+	double nmea_us = bench_report("  NMEA GGA, minmea", t1 - t0, NUM_REPEATS);
+
+	printf("ubx: %d of %d fixes parsed. Run parser is %.1fx faster than byte by byte and %.1fx faster than minmea\n",
+			num_fixes, 3 * NUM_REPEATS, byte_us / run_us, nmea_us / run_us);
+	return num_fixes == 3 * NUM_REPEATS ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+/*
+ * adc.h
+ *
+ * Host stand-in for the ADC the GPR modules use
+ */
+
+#ifndef ADC_H_
+#define ADC_H_
+
+#include "stm32f7xx_hal.h"
+
+extern ADC_HandleTypeDef hadc1;
+
+#endif /* ADC_H_ */
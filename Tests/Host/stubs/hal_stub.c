@@ -0,0 +1,178 @@
+/*
+ * hal_stub.c
+ */
+
+#include "hal_stub.h"
+
+#include "adc.h"
+#include "main.h"
+#include "spi.h"
+#include "tim.h"
+#include "timestamp.h"
+
+static TIM_TypeDef tim7_regs;
+static TIM_TypeDef tim10_regs;
+static TIM_TypeDef tim11_regs;
+
+TIM_HandleTypeDef htim7 = {.Instance = &tim7_regs, .Init = {.Prescaler = 1, .Period = 65535}};
+TIM_HandleTypeDef htim10 = {.Instance = &tim10_regs, .Init = {.Prescaler = 0, .Period = 65535}};
+TIM_HandleTypeDef htim11 = {.Instance = &tim11_regs, .Init = {.Prescaler = 0, .Period = 65535}};
+ADC_HandleTypeDef hadc1;
+SPI_HandleTypeDef hspi2;
+SPI_HandleTypeDef hspi3;
+GPIO_TypeDef hal_stub_gpiob;
+GPIO_TypeDef hal_stub_gpiod;
+RCC_TypeDef hal_stub_rcc = {.CFGR = RCC_HCLK_DIV2};
+uint32_t SystemCoreClock = 2 * HAL_STUB_PCLK1_HZ;
+
+uint64_t hal_stub_time_ns;
+uint32_t hal_stub_num_captures;
+
+static TIM_HandleTypeDef* const timers[] = {&htim7, &htim10, &htim11};
+#define NUM_TIMERS	(sizeof(timers) / sizeof(timers[0]))
+
+void hal_stub_reset(void) {
+	hal_stub_time_ns = 0;
+	hal_stub_num_captures = 0;
+	for (unsigned i = 0; i < NUM_TIMERS; i++) {
+		timers[i]->base_running = false;
+		timers[i]->oc_running = false;
+		timers[i]->num_oc_starts = 0;
+		timers[i]->oc_longest_ns = 0;
+	}
+	hadc1.running = false;
+	hspi2.num_transmits = 0;
+	hspi3.num_transmits = 0;
+}
+
+bool hal_stub_run_next(void) {
+	// Whichever ends first. A capture ending at the same time as a timer period goes first
+	TIM_HandleTypeDef* next_timer = NULL;
+	for (unsigned i = 0; i < NUM_TIMERS; i++) {
+		if (timers[i]->base_running && (!next_timer || timers[i]->due_ns < next_timer->due_ns)) {
+			next_timer = timers[i];
+		}
+	}
+	if (hadc1.running && (!next_timer || hadc1.due_ns <= next_timer->due_ns)) {
+		hal_stub_time_ns = hadc1.due_ns;
+		for (uint32_t i = 0; i < hadc1.length; i++) {
+			hadc1.destination[i] = hal_stub_tag(hal_stub_num_captures, i);
+		}
+		hal_stub_num_captures++;
+		// Circular DMA keeps going until it's stopped, so it's still running when the callback starts
+		hadc1.due_ns += hadc1.length * HAL_STUB_ADC_SAMPLE_NS;
+		if (hadc1.ConvCpltCallback) {
+			hadc1.ConvCpltCallback(&hadc1);
+		}
+		return true;
+	}
+	if (next_timer) {
+		hal_stub_time_ns = next_timer->due_ns;
+		// Update events repeat every period until the timer is stopped
+		next_timer->due_ns += (uint64_t) (next_timer->Instance->ARR + 1) * (next_timer->Init.Prescaler + 1) * 1000000000 / (2 * HAL_STUB_PCLK1_HZ);
+		if (next_timer->PeriodElapsedCallback) {
+			next_timer->PeriodElapsedCallback(next_timer);
+		}
+		return true;
+	}
+	return false;
+}
+
+uint16_t hal_stub_tag(uint32_t capture_num, uint32_t sample_num) {
+	return (uint16_t) (((capture_num & 0xF) << 12) | (sample_num & 0xFFF));
+}
+
+HAL_StatusTypeDef HAL_TIM_RegisterCallback(TIM_HandleTypeDef* htim, HAL_TIM_CallbackIDTypeDef callback_id, pTIM_CallbackTypeDef callback) {
+	if (callback_id != HAL_TIM_PERIOD_ELAPSED_CB_ID || htim->base_running) {
+		return HAL_ERROR;
+	}
+	htim->PeriodElapsedCallback = callback;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim) {
+	if (htim->base_running) {
+		return HAL_ERROR;
+	}
+	htim->base_running = true;
+	htim->due_ns = hal_stub_time_ns + (uint64_t) (htim->Instance->ARR + 1 - htim->Instance->CNT) * (htim->Init.Prescaler + 1) * 1000000000 / (2 * HAL_STUB_PCLK1_HZ);
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim) {
+	htim->base_running = false;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_OC_Start(TIM_HandleTypeDef* htim, uint32_t channel) {
+	(void) channel;
+	if (!htim->oc_running) {
+		htim->oc_running = true;
+		htim->oc_start_ns = hal_stub_time_ns;
+		htim->num_oc_starts++;
+	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_OC_Stop(TIM_HandleTypeDef* htim, uint32_t channel) {
+	(void) channel;
+	if (htim->oc_running) {
+		htim->oc_running = false;
+		uint64_t on_ns = hal_stub_time_ns - htim->oc_start_ns;
+		htim->oc_longest_ns = on_ns > htim->oc_longest_ns ? on_ns : htim->oc_longest_ns;
+	}
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_RegisterCallback(ADC_HandleTypeDef* hadc, HAL_ADC_CallbackIDTypeDef callback_id, pADC_CallbackTypeDef callback) {
+	if (callback_id != HAL_ADC_CONVERSION_COMPLETE_CB_ID || hadc->running) {
+		return HAL_ERROR;
+	}
+	hadc->ConvCpltCallback = callback;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef* hadc, uint32_t* data, uint32_t length) {
+	if (hadc->running || length == 0) {
+		return HAL_ERROR;
+	}
+	// DMA is set up for halfwords, whatever the pointer type
+	hadc->running = true;
+	hadc->destination = (uint16_t*) data;
+	hadc->length = length;
+	hadc->due_ns = hal_stub_time_ns + length * HAL_STUB_ADC_SAMPLE_NS;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef* hadc) {
+	hadc->running = false;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef* hspi, uint8_t* data, uint16_t size, uint32_t timeout) {
+	(void) data;
+	(void) size;
+	(void) timeout;
+	hspi->num_transmits++;
+	return HAL_OK;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state) {
+	if (state == GPIO_PIN_SET) {
+		port->ODR |= pin;
+	} else {
+		port->ODR &= ~pin;
+	}
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void) {
+	return HAL_STUB_PCLK1_HZ;
+}
+
+uint32_t HAL_GetTick(void) {
+	return (uint32_t) (hal_stub_time_ns / 1000000);
+}
+
+uint32_t timestamp_get_us(void) {
+	return (uint32_t) (hal_stub_time_ns / 1000);
+}
@@ -0,0 +1,39 @@
+/*
+ * hal_stub.h
+ *
+ * Controls for the host stand-in HAL. Nothing happens on its own: hal_stub_run_next() moves time on to the next timer
+ * period or ADC capture to end and runs its interrupt callback, the way the hardware would
+ * Each capture fills its destination with tags, so a test can tell which capture and sample every value came from
+ */
+
+#ifndef HAL_STUB_H_
+#define HAL_STUB_H_
+
+#include "stm32f7xx_hal.h"
+
+#define HAL_STUB_PCLK1_HZ			48000000 // APB1 on the robot. Its timers run at twice this
+#define HAL_STUB_ADC_SAMPLE_NS		750 // 1.33 MSPS
+
+extern uint64_t hal_stub_time_ns; // Simulated time since hal_stub_reset()
+extern uint32_t hal_stub_num_captures; // Captures completed since hal_stub_reset()
+
+/**
+ * @brief Stops everything and sets time and counters back to 0. Registered callbacks are kept
+ */
+void hal_stub_reset(void);
+
+/**
+ * @brief Moves time on to the next pending timer period or capture end, and runs its callback
+ * @return True if anything was pending, false if nothing will happen again
+ */
+bool hal_stub_run_next(void);
+
+/**
+ * @brief Gets the tag a capture writes to a sample
+ * @param[in] capture_num: Capture, counting from 0 since hal_stub_reset()
+ * @param[in] sample_num: Sample in the capture
+ * @return Tag: capture number in the top 4 bits, sample number in the bottom 12, like a 12-bit ADC in a halfword
+ */
+uint16_t hal_stub_tag(uint32_t capture_num, uint32_t sample_num);
+
+#endif /* HAL_STUB_H_ */
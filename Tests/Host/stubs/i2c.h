@@ -0,0 +1,12 @@
+/*
+ * i2c.h
+ *
+ * Host stand-in. The GPR modules don't use any I2C buses
+ */
+
+#ifndef I2C_H_
+#define I2C_H_
+
+#include "stm32f7xx_hal.h"
+
+#endif /* I2C_H_ */
@@ -0,0 +1,20 @@
+/*
+ * main.h
+ *
+ * Host stand-in for the pins the GPR modules use
+ */
+
+#ifndef MAIN_H_
+#define MAIN_H_
+
+#include "stm32f7xx_hal.h"
+
+extern GPIO_TypeDef hal_stub_gpiob;
+extern GPIO_TypeDef hal_stub_gpiod;
+
+#define SIG_REC_REF_LE_Pin			0x0800U
+#define SIG_REC_REF_LE_GPIO_Port	(&hal_stub_gpiob)
+#define SIG_GEN_LE_Pin				0x0004U
+#define SIG_GEN_LE_GPIO_Port		(&hal_stub_gpiod)
+
+#endif /* MAIN_H_ */
@@ -0,0 +1,15 @@
+/*
+ * spi.h
+ *
+ * Host stand-in for the SPI buses the GPR modules use
+ */
+
+#ifndef SPI_H_
+#define SPI_H_
+
+#include "stm32f7xx_hal.h"
+
+extern SPI_HandleTypeDef hspi2;
+extern SPI_HandleTypeDef hspi3;
+
+#endif /* SPI_H_ */
@@ -0,0 +1,111 @@
+/*
+ * stm32f7xx_hal.h
+ *
+ * Host stand-in for the parts of the STM32F7 HAL the GPR modules use. Handles only carry what the stand-ins in
+ * hal_stub.c need to simulate the timer, ADC DMA, and SPI, with time advanced by hal_stub_run_next() instead of a clock
+ */
+
+#ifndef STM32F7XX_HAL_H_
+#define STM32F7XX_HAL_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+	HAL_OK,
+	HAL_ERROR,
+	HAL_BUSY,
+	HAL_TIMEOUT
+} HAL_StatusTypeDef;
+
+typedef enum {
+	GPIO_PIN_RESET,
+	GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct {
+	uint32_t ODR;
+} GPIO_TypeDef;
+
+typedef struct {
+	uint32_t CFGR;
+} RCC_TypeDef;
+
+typedef struct {
+	uint32_t SR;
+	uint32_t EGR;
+	uint32_t CNT;
+	uint32_t ARR;
+} TIM_TypeDef;
+
+typedef struct {
+	uint32_t Prescaler;
+	uint32_t Period;
+} TIM_Base_InitTypeDef;
+
+typedef struct TIM_HandleTypeDef {
+	TIM_TypeDef* Instance;
+	TIM_Base_InitTypeDef Init;
+	void (*PeriodElapsedCallback)(struct TIM_HandleTypeDef* htim);
+	bool base_running; // Stand-in state
+	bool oc_running;
+	uint64_t due_ns;
+	uint32_t num_oc_starts;
+	uint64_t oc_start_ns;
+	uint64_t oc_longest_ns;
+} TIM_HandleTypeDef;
+
+typedef struct ADC_HandleTypeDef {
+	void (*ConvCpltCallback)(struct ADC_HandleTypeDef* hadc);
+	bool running; // Stand-in state
+	uint16_t* destination;
+	uint32_t length;
+	uint64_t due_ns;
+} ADC_HandleTypeDef;
+
+typedef struct {
+	uint32_t num_transmits; // Stand-in state
+} SPI_HandleTypeDef;
+
+typedef enum {
+	HAL_TIM_PERIOD_ELAPSED_CB_ID
+} HAL_TIM_CallbackIDTypeDef;
+
+typedef enum {
+	HAL_ADC_CONVERSION_COMPLETE_CB_ID
+} HAL_ADC_CallbackIDTypeDef;
+
+typedef void (*pTIM_CallbackTypeDef)(TIM_HandleTypeDef* htim);
+typedef void (*pADC_CallbackTypeDef)(ADC_HandleTypeDef* hadc);
+
+extern RCC_TypeDef hal_stub_rcc;
+#define RCC							(&hal_stub_rcc)
+#define RCC_CFGR_PPRE1				0x00001C00U
+#define RCC_HCLK_DIV1				0x00000000U
+#define RCC_HCLK_DIV2				0x00001000U
+
+#define TIM_CHANNEL_1				0x00000000U
+#define TIM_EGR_UG					0x00000001U
+#define TIM_FLAG_UPDATE				0x00000001U
+
+#define __HAL_TIM_SET_AUTORELOAD(htim, value)	((htim)->Instance->ARR = (value))
+#define __HAL_TIM_SET_COUNTER(htim, value)		((htim)->Instance->CNT = (value))
+#define __HAL_TIM_CLEAR_FLAG(htim, flag)		((htim)->Instance->SR &= ~(flag))
+
+extern uint32_t SystemCoreClock;
+
+HAL_StatusTypeDef HAL_TIM_RegisterCallback(TIM_HandleTypeDef* htim, HAL_TIM_CallbackIDTypeDef callback_id, pTIM_CallbackTypeDef callback);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef HAL_TIM_OC_Start(TIM_HandleTypeDef* htim, uint32_t channel);
+HAL_StatusTypeDef HAL_TIM_OC_Stop(TIM_HandleTypeDef* htim, uint32_t channel);
+HAL_StatusTypeDef HAL_ADC_RegisterCallback(ADC_HandleTypeDef* hadc, HAL_ADC_CallbackIDTypeDef callback_id, pADC_CallbackTypeDef callback);
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef* hadc, uint32_t* data, uint32_t length);
+HAL_StatusTypeDef HAL_ADC_Stop_DMA(ADC_HandleTypeDef* hadc);
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef* hspi, uint8_t* data, uint16_t size, uint32_t timeout);
+void HAL_GPIO_WritePin(GPIO_TypeDef* port, uint16_t pin, GPIO_PinState state);
+uint32_t HAL_RCC_GetPCLK1Freq(void);
+uint32_t HAL_GetTick(void);
+
+#endif /* STM32F7XX_HAL_H_ */
@@ -0,0 +1,16 @@
+/*
+ * tim.h
+ *
+ * Host stand-in for the timers the GPR modules use
+ */
+
+#ifndef TIM_H_
+#define TIM_H_
+
+#include "stm32f7xx_hal.h"
+
+extern TIM_HandleTypeDef htim7;
+extern TIM_HandleTypeDef htim10;
+extern TIM_HandleTypeDef htim11;
+
+#endif /* TIM_H_ */
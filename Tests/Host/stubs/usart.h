@@ -0,0 +1,12 @@
+/*
+ * usart.h
+ *
+ * Host stand-in. The GPR modules don't use any UARTs
+ */
+
+#ifndef USART_H_
+#define USART_H_
+
+#include "stm32f7xx_hal.h"
+
+#endif /* USART_H_ */
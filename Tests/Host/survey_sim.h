@@ -0,0 +1,86 @@
+/*
+ * survey_sim.h
+ *
+ * Unicycle model of the robot for the host survey simulations. Setpoints are scaled the way drive_manager scales them so
+ * neither track is asked to go faster than it can, and the robot can follow them exactly or through a first-order lag
+ * standing in for the drive control loop. Time moves on in steps of the state rate group's period.
+ */
+
+#ifndef SURVEY_SIM_H_
+#define SURVEY_SIM_H_
+
+#include <math.h>
+
+#include "drive_constants.h"
+
+#define SURVEY_SIM_DT_S		0.01 // State rate group period, 100 Hz
+
+typedef struct survey_sim_robot_t {
+	pose2d_t pose;
+	double forward_vel_mps;
+	double turn_vel_radps;
+	double lag_s; // Time constant of the robot's response to setpoints, 0 to follow them exactly
+	double time_s;
+} survey_sim_robot_t;
+
+/**
+ * @brief Wraps an angle to [-PI, PI)
+ * @param[in] angle: Angle in radians
+ * @return Wrapped angle
+ */
+static inline double survey_sim_wrap_angle(double angle) {
+	return angle - 2 * 3.14159265358979 * floor((angle + 3.14159265358979) / (2 * 3.14159265358979));
+}
+
+/**
+ * @brief Puts a robot at rest at a pose
+ * @param[out] robot: Robot to place
+ * @param[in] pose: Pose to start at
+ * @param[in] lag_s: Time constant of the robot's response to setpoints, 0 to follow them exactly
+ */
+static inline void survey_sim_init(survey_sim_robot_t* robot, pose2d_t pose, double lag_s) {
+	robot->pose = pose;
+	robot->forward_vel_mps = 0;
+	robot->turn_vel_radps = 0;
+	robot->lag_s = lag_s;
+	robot->time_s = 0;
+}
+
+/**
+ * @brief Drives the robot for one state period. Setpoints that would run a track faster than MAX_DRIVE_SPEED_MPS are
+ * scaled down keeping their curvature, as drive_manager_change_setpoint() does
+ * @param[in, out] robot: Robot to move
+ * @param[in] forward_vel_mps: Forward velocity setpoint
+ * @param[in] turn_vel_radps: Angular velocity setpoint
+ */
+static inline void survey_sim_step(survey_sim_robot_t* robot, double forward_vel_mps, double turn_vel_radps) {
+	double left_mps = forward_vel_mps - WHEEL_BASE_M * turn_vel_radps / 2;
+	double right_mps = forward_vel_mps + WHEEL_BASE_M * turn_vel_radps / 2;
+	double fastest_mps = fmax(fabs(left_mps), fabs(right_mps));
+	if (fastest_mps > MAX_DRIVE_SPEED_MPS) {
+		forward_vel_mps *= MAX_DRIVE_SPEED_MPS / fastest_mps;
+		turn_vel_radps *= MAX_DRIVE_SPEED_MPS / fastest_mps;
+	}
+
+	double response = robot->lag_s > 0 ? 1 - exp(-SURVEY_SIM_DT_S / robot->lag_s) : 1;
+	robot->forward_vel_mps += response * (forward_vel_mps - robot->forward_vel_mps);
+	robot->turn_vel_radps += response * (turn_vel_radps - robot->turn_vel_radps);
+
+	// Move along the arc the velocities trace out over the step
+	double mid_theta = robot->pose.theta + robot->turn_vel_radps * SURVEY_SIM_DT_S / 2;
+	robot->pose.x += robot->forward_vel_mps * SURVEY_SIM_DT_S * cos(mid_theta);
+	robot->pose.y += robot->forward_vel_mps * SURVEY_SIM_DT_S * sin(mid_theta);
+	robot->pose.theta = survey_sim_wrap_angle(robot->pose.theta + robot->turn_vel_radps * SURVEY_SIM_DT_S);
+	robot->time_s += SURVEY_SIM_DT_S;
+}
+
+/**
+ * @brief Stops the robot dead, as it is at a recording stop
+ * @param[in, out] robot: Robot to stop
+ */
+static inline void survey_sim_stop(survey_sim_robot_t* robot) {
+	robot->forward_vel_mps = 0;
+	robot->turn_vel_radps = 0;
+}
+
+#endif /* SURVEY_SIM_H_ */
@@ -0,0 +1,45 @@
+/*
+ * test.h
+ *
+ * Minimal checks for the host tests. Each test is its own program: a failed check prints where it failed and counts
+ * the failure, and main() returns test_result() so make stops on a failing test.
+ */
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <math.h>
+#include <stdio.h>
+
+static int test_num_checks;
+static int test_num_failures;
+
+#define TEST_CHECK(cond) do { \
+	test_num_checks++; \
+	if (!(cond)) { \
+		test_num_failures++; \
+		printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+	} \
+} while (0)
+
+#define TEST_CHECK_NEAR(actual, expected, tolerance) do { \
+	double test_actual = (actual); \
+	double test_expected = (expected); \
+	test_num_checks++; \
+	if (!(fabs(test_actual - test_expected) <= (tolerance))) { \
+		test_num_failures++; \
+		printf("%s:%d: check failed: %s = %g, expected %g +/- %g\n", __FILE__, __LINE__, #actual, test_actual, test_expected, (double) (tolerance)); \
+	} \
+} while (0)
+
+/**
+ * @brief Prints a summary of the checks run
+ * @param[in] name: Name of the test
+ * @return Exit code for main(), 0 if every check passed
+ */
+static inline int test_result(const char* name) {
+	printf("%s: %d checks, %d failed\n", name, test_num_checks, test_num_failures);
+	return test_num_failures ? 1 : 0;
+}
+
+#endif /* TEST_H_ */
@@ -0,0 +1,146 @@
+/*
+ * test_dubins_path.c
+ */
+
+#include "dubins_path.h"
+
+#include "test.h"
+
+#define PI			3.14159265358979
+#define RADIUS_M	0.5 // Turn radius the survey planner uses
+
+/**
+ * @brief Gets how far apart two headings are
+ * @param[in] a: Heading in radians
+ * @param[in] b: Heading in radians
+ * @return Difference wrapped to [0, PI]
+ */
+static double heading_error(double a, double b) {
+	return fabs(atan2(sin(a - b), cos(a - b)));
+}
+
+static void test_reaches_end() {
+	// From the origin to poses all around it, each path ends on the end pose, and is joined up between segments
+	const double headings[] = {0, PI / 2, PI, -PI / 2, 0.3, -2.5};
+	int num_planned = 0;
+	int num_bad = 0;
+	for (int ix = -4; ix <= 4; ix++) {
+		for (int iy = -4; iy <= 4; iy++) {
+			for (unsigned a = 0; a < sizeof(headings) / sizeof(headings[0]); a++) {
+				pose2d_t start_pose = {0, 0, 0.7};
+				pose2d_t end_pose = {ix * 0.6, iy * 0.6, headings[a]};
+				dubins_path_t path;
+				if (!dubins_path_plan(&path, start_pose, end_pose, RADIUS_M)) {
+					continue;
+				}
+				num_planned++;
+
+				double length = dubins_path_get_length(&path);
+				pose2d_t end = dubins_path_sample(&path, length);
+				double progress_m = 0;
+				bool joined = true;
+				for (int i = 1; i < DUBINS_PATH_NUM_SEGMENTS; i++) {
+					progress_m += path.lengths_m[i - 1];
+					pose2d_t at = dubins_path_sample(&path, progress_m);
+					joined = joined && hypot(at.x - path.start_poses[i].x, at.y - path.start_poses[i].y) < 1e-9;
+				}
+				if (hypot(end.x - end_pose.x, end.y - end_pose.y) > 1e-6 || heading_error(end.theta, end_pose.theta) > 1e-6
+						|| length < hypot(end_pose.x, end_pose.y) - 1e-9 || !joined) {
+					num_bad++;
+				}
+			}
+		}
+	}
+	TEST_CHECK(num_planned == 9 * 9 * 6);
+	TEST_CHECK(num_bad == 0);
+}
+
+static void test_known_paths() {
+	// Straight ahead along a survey line, without any arcs
+	dubins_path_t path;
+	pose2d_t start_pose = {1, 2, PI / 4};
+	pose2d_t end_pose = {1 + 3 * cos(PI / 4), 2 + 3 * sin(PI / 4), PI / 4};
+	TEST_CHECK(dubins_path_plan(&path, start_pose, end_pose, RADIUS_M));
+	TEST_CHECK_NEAR(dubins_path_get_length(&path), 3, 1e-9);
+	TEST_CHECK(!dubins_path_has_arcs(&path));
+
+	// Turning onto the next pass one diameter over is a half circle
+	pose2d_t pass_end = {0, 0, 0};
+	pose2d_t next_pass = {0, 2 * RADIUS_M, PI};
+	TEST_CHECK(dubins_path_plan(&path, pass_end, next_pass, RADIUS_M));
+	TEST_CHECK_NEAR(dubins_path_get_length(&path), PI * RADIUS_M, 1e-9);
+	TEST_CHECK(dubins_path_has_arcs(&path));
+	pose2d_t halfway = dubins_path_sample(&path, PI * RADIUS_M / 2);
+	TEST_CHECK_NEAR(halfway.x, RADIUS_M, 1e-9);
+	TEST_CHECK_NEAR(halfway.y, RADIUS_M, 1e-9);
+
+	// Past the end, samples continue straight along the final heading
+	pose2d_t past = dubins_path_sample(&path, PI * RADIUS_M + 1);
+	TEST_CHECK_NEAR(past.x, -1, 1e-9);
+	TEST_CHECK_NEAR(past.y, 2 * RADIUS_M, 1e-9);
+
+	TEST_CHECK(!dubins_path_plan(&path, pass_end, next_pass, 0));
+}
+
+static void test_project() {
+	// Along a straight line on x, left of the line is positive, and progress continues before the start and past the end
+	dubins_path_t path;
+	pose2d_t start_pose = {0, 0, 0};
+	pose2d_t end_pose = {10, 0, 0};
+	TEST_CHECK(dubins_path_plan(&path, start_pose, end_pose, RADIUS_M));
+
+	pose2d_t left = {4, 0.2, 0};
+	dubins_path_projection_t projection = dubins_path_project(&path, left, 0);
+	TEST_CHECK_NEAR(projection.progress_m, 4, 1e-9);
+	TEST_CHECK_NEAR(projection.lateral_error_m, 0.2, 1e-9);
+
+	pose2d_t right_before = {-1, -0.3, 0};
+	projection = dubins_path_project(&path, right_before, 0);
+	TEST_CHECK_NEAR(projection.progress_m, -1, 1e-9);
+	TEST_CHECK_NEAR(projection.lateral_error_m, -0.3, 1e-9);
+
+	pose2d_t past = {12, 0.1, 0};
+	projection = dubins_path_project(&path, past, 0);
+	TEST_CHECK_NEAR(projection.progress_m, 12, 1e-9);
+	TEST_CHECK_NEAR(projection.lateral_error_m, 0.1, 1e-9);
+
+	// Inside the half circle turn is to the left of it, by the radius less the distance from the center
+	pose2d_t pass_end = {0, 0, 0};
+	pose2d_t next_pass = {0, 2 * RADIUS_M, PI};
+	TEST_CHECK(dubins_path_plan(&path, pass_end, next_pass, RADIUS_M));
+	pose2d_t inside = {0.3, RADIUS_M, 0};
+	projection = dubins_path_project(&path, inside, 0);
+	TEST_CHECK_NEAR(projection.progress_m, PI * RADIUS_M / 2, 1e-9);
+	TEST_CHECK_NEAR(projection.lateral_error_m, RADIUS_M - 0.3, 1e-9);
+}
+
+static void test_transform() {
+	// Planning from the origin and moving the path gives the same path as planning from the pose
+	pose2d_t origin = {3, -2, 1.1};
+	pose2d_t local_end = {2, 1.5, -0.8};
+	pose2d_t end_pose = {
+			origin.x + local_end.x * cos(origin.theta) - local_end.y * sin(origin.theta),
+			origin.y + local_end.x * sin(origin.theta) + local_end.y * cos(origin.theta),
+			origin.theta + local_end.theta
+	};
+	pose2d_t zero = {0, 0, 0};
+	dubins_path_t moved;
+	dubins_path_t direct;
+	TEST_CHECK(dubins_path_plan(&moved, zero, local_end, RADIUS_M));
+	dubins_path_transform(&moved, origin, cos(origin.theta), sin(origin.theta));
+	TEST_CHECK(dubins_path_plan(&direct, origin, end_pose, RADIUS_M));
+	TEST_CHECK_NEAR(dubins_path_get_length(&moved), dubins_path_get_length(&direct), 1e-9);
+	for (double progress_m = 0; progress_m < dubins_path_get_length(&direct); progress_m += 0.1) {
+		pose2d_t a = dubins_path_sample(&moved, progress_m);
+		pose2d_t b = dubins_path_sample(&direct, progress_m);
+		TEST_CHECK(hypot(a.x - b.x, a.y - b.y) < 1e-9 && heading_error(a.theta, b.theta) < 1e-9);
+	}
+}
+
+int main() {
+	test_reaches_end();
+	test_known_paths();
+	test_project();
+	test_transform();
+	return test_result("dubins_path");
+}
@@ -0,0 +1,107 @@
+/*
+ * test_geodesy.c
+ */
+
+#include "geodesy.h"
+
+#include "test.h"
+
+/**
+ * @brief Converts a geodetic position to earth-centered, earth-fixed coordinates
+ * @param[in] lat_rad: Latitude
+ * @param[in] lon_rad: Longitude
+ * @param[in] height_m: Height above ellipsoid
+ * @param[out] ecef: X, Y, and Z in meters
+ */
+static void to_ecef(double lat_rad, double lon_rad, double height_m, double ecef[3]) {
+	double sin_lat = sin(lat_rad);
+	double normal_m = GEODESY_WGS84_A_M / sqrt(1 - GEODESY_WGS84_E2 * sin_lat * sin_lat);
+	ecef[0] = (normal_m + height_m) * cos(lat_rad) * cos(lon_rad);
+	ecef[1] = (normal_m + height_m) * cos(lat_rad) * sin(lon_rad);
+	ecef[2] = (normal_m * (1 - GEODESY_WGS84_E2) + height_m) * sin_lat;
+}
+
+/**
+ * @brief Exact tangent plane position: the ECEF difference from the origin rotated into east, north, and up
+ */
+static geodesy_enu_t reference_enu(int32_t lat0_e7, int32_t lon0_e7, int32_t height0_mm, int32_t lat_e7, int32_t lon_e7, int32_t height_mm) {
+	double lat0 = lat0_e7 * GEODESY_E7_TO_RAD;
+	double lon0 = lon0_e7 * GEODESY_E7_TO_RAD;
+	double origin[3];
+	double point[3];
+	to_ecef(lat0, lon0, height0_mm * 1e-3, origin);
+	to_ecef(lat_e7 * GEODESY_E7_TO_RAD, lon_e7 * GEODESY_E7_TO_RAD, height_mm * 1e-3, point);
+	double d[3] = {point[0] - origin[0], point[1] - origin[1], point[2] - origin[2]};
+
+	geodesy_enu_t enu;
+	enu.east_m = -sin(lon0) * d[0] + cos(lon0) * d[1];
+	enu.north_m = -sin(lat0) * cos(lon0) * d[0] - sin(lat0) * sin(lon0) * d[1] + cos(lat0) * d[2];
+	enu.up_m = cos(lat0) * cos(lon0) * d[0] + cos(lat0) * sin(lon0) * d[1] + sin(lat0) * d[2];
+	return enu;
+}
+
+static void test_origin() {
+	geodesy_enu_origin_t origin;
+	geodesy_enu_origin_init(&origin, 423601234, -710912345, 50000);
+	geodesy_enu_t enu = geodesy_to_enu(&origin, 423601234, -710912345, 50000);
+	TEST_CHECK(enu.east_m == 0 && enu.north_m == 0 && enu.up_m == 0);
+}
+
+static void test_error_bound() {
+	// Survey areas a kilometer either way and 20 m up or down, from the equator to high latitudes in both hemispheres
+	const double lats_deg[] = {0, 30, 42.36, 60, 75, -45};
+	const double lons_deg[] = {-71.09, 0, 179.99, -120};
+	double worst_horizontal_m = 0;
+	double worst_vertical_m = 0;
+	for (unsigned a = 0; a < sizeof(lats_deg) / sizeof(lats_deg[0]); a++) {
+		for (unsigned b = 0; b < sizeof(lons_deg) / sizeof(lons_deg[0]); b++) {
+			int32_t lat0_e7 = (int32_t) (lats_deg[a] * 1e7);
+			int32_t lon0_e7 = (int32_t) (lons_deg[b] * 1e7);
+			int32_t height0_mm = 50000;
+			geodesy_enu_origin_t origin;
+			geodesy_enu_origin_init(&origin, lat0_e7, lon0_e7, height0_mm);
+
+			double dlat_e7 = 1000 / 111000.0 * 1e7;
+			double dlon_e7 = dlat_e7 / cos(lats_deg[a] * 3.14159265358979 / 180);
+			for (int i = -10; i <= 10; i++) {
+				for (int j = -10; j <= 10; j++) {
+					for (int k = -1; k <= 1; k++) {
+						int32_t lat_e7 = lat0_e7 + (int32_t) (dlat_e7 * i / 10);
+						int32_t lon_e7 = lon0_e7 + (int32_t) (dlon_e7 * j / 10);
+						int32_t height_mm = height0_mm + k * 20000;
+						geodesy_enu_t enu = geodesy_to_enu(&origin, lat_e7, lon_e7, height_mm);
+						geodesy_enu_t ref = reference_enu(lat0_e7, lon0_e7, height0_mm, lat_e7, lon_e7, height_mm);
+						double horizontal_m = hypot(enu.east_m - ref.east_m, enu.north_m - ref.north_m);
+						double vertical_m = fabs(enu.up_m - ref.up_m);
+						worst_horizontal_m = horizontal_m > worst_horizontal_m ? horizontal_m : worst_horizontal_m;
+						worst_vertical_m = vertical_m > worst_vertical_m ? vertical_m : worst_vertical_m;
+					}
+				}
+			}
+		}
+	}
+	printf("geodesy: worst error %.2f mm horizontal, %.3f mm vertical\n", worst_horizontal_m * 1e3, worst_vertical_m * 1e3);
+	TEST_CHECK(worst_horizontal_m < 0.005);
+	TEST_CHECK(worst_vertical_m < 0.001);
+}
+
+static void test_directions() {
+	// North is along latitude, east along longitude, and up along height
+	geodesy_enu_origin_t origin;
+	geodesy_enu_origin_init(&origin, 0, 0, 0);
+	geodesy_enu_t north = geodesy_to_enu(&origin, 10000, 0, 0);
+	geodesy_enu_t east = geodesy_to_enu(&origin, 0, 10000, 0);
+	geodesy_enu_t up = geodesy_to_enu(&origin, 0, 0, 1000);
+	TEST_CHECK_NEAR(north.north_m, 110.57, 0.01);
+	TEST_CHECK_NEAR(north.east_m, 0, 1e-9);
+	TEST_CHECK_NEAR(east.east_m, 111.32, 0.01);
+	TEST_CHECK_NEAR(east.north_m, 0, 1e-9);
+	TEST_CHECK_NEAR(up.up_m, 1, 1e-9);
+}
+
+int main() {
+	test_origin();
+	test_error_bound();
+	test_directions();
+	return test_result("geodesy");
+}
@@ -0,0 +1,148 @@
+/*
+ * test_gpr_demodulator.c
+ */
+
+#include "gpr_demodulator.h"
+
+#include "test.h"
+
+#define PI					3.14159265358979
+#define IF_CYCLES_PER_SAMPLE	0.45 // As the GPR manager runs it: Nyquist with 10% headroom
+#define MID_SCALE			2048
+
+static gpr_demodulator_t demod;
+
+/**
+ * @brief Deterministic pseudo-random number
+ * @param[in, out] seed: Generator state
+ * @return Uniform from 0 to 1
+ */
+static double random_uniform(uint32_t* seed) {
+	*seed = *seed * 1664525u + 1013904223u;
+	return (*seed >> 8) / 16777216.0;
+}
+
+/**
+ * @brief Fills a step with a tone at the IF around mid-scale, plus uniform noise, quantized and clipped like the ADC
+ * @param[out] samples: Step to fill
+ * @param[in] num_samples: Samples in the step
+ * @param[in] amplitude: Tone amplitude in ADC counts
+ * @param[in] phase: Tone phase at the first sample
+ * @param[in] noise: Noise spread either way in ADC counts
+ * @param[in, out] seed: Noise generator state
+ */
+static void tone_step(uint16_t* samples, int num_samples, double amplitude, double phase, double noise, uint32_t* seed) {
+	for (int n = 0; n < num_samples; n++) {
+		double value = MID_SCALE + amplitude * cos(2 * PI * IF_CYCLES_PER_SAMPLE * n + phase) + noise * (2 * random_uniform(seed) - 1);
+		value = floor(value + 0.5);
+		samples[n] = (uint16_t) (value < 0 ? 0 : value > GPR_DEMODULATOR_ADC_MAX ? GPR_DEMODULATOR_ADC_MAX : value);
+	}
+}
+
+static void test_tones() {
+	// Tones of random amplitude and phase with a little noise come out as their amplitude and phase
+	const int sizes[] = {200, 500};
+	const double max_amplitude_errors[] = {0.005, 0.003};
+	uint32_t seed = 1;
+	for (int s = 0; s < 2; s++) {
+		int num_samples = sizes[s];
+		TEST_CHECK(gpr_demodulator_init(&demod, num_samples, IF_CYCLES_PER_SAMPLE));
+		double worst_amplitude_error = 0;
+		double worst_phase_error = 0;
+		int worst_if_percent = 100;
+		for (int trial = 0; trial < 500; trial++) {
+			double amplitude = 200 + 1700 * random_uniform(&seed);
+			double phase = 2 * PI * random_uniform(&seed) - PI;
+			uint16_t samples[GPR_DEMODULATOR_MAX_SAMPLES];
+			tone_step(samples, num_samples, amplitude, phase, 4, &seed);
+			gpr_iq_t iq;
+			gpr_demodulator_run(&demod, samples, &iq);
+
+			double amplitude_error = fabs(hypot(iq.i, iq.q) - amplitude) / amplitude;
+			double phase_error = fabs(remainder(atan2(iq.q, iq.i) - phase, 2 * PI));
+			worst_amplitude_error = amplitude_error > worst_amplitude_error ? amplitude_error : worst_amplitude_error;
+			worst_phase_error = phase_error > worst_phase_error ? phase_error : worst_phase_error;
+			worst_if_percent = iq.if_percent < worst_if_percent ? iq.if_percent : worst_if_percent;
+			TEST_CHECK(iq.dc == MID_SCALE || iq.dc == MID_SCALE - 1 || iq.dc == MID_SCALE + 1);
+			TEST_CHECK(iq.num_clipped == 0);
+		}
+		printf("gpr_demodulator: N=%d, worst amplitude error %.2f%%, worst phase error %.4f rad, lowest IF share %d%%\n",
+				num_samples, worst_amplitude_error * 100, worst_phase_error, worst_if_percent);
+		TEST_CHECK(worst_amplitude_error < max_amplitude_errors[s]);
+		TEST_CHECK(worst_phase_error < 0.01);
+		TEST_CHECK(worst_if_percent >= 98);
+	}
+}
+
+static void test_noise_only() {
+	// Noise alone leaves next to nothing at the IF. The window's bin takes about 3 / N of white noise's power on average,
+	// and the share of a single step scatters around that
+	TEST_CHECK(gpr_demodulator_init(&demod, 500, IF_CYCLES_PER_SAMPLE));
+	uint32_t seed = 2;
+	int worst_if_percent = 0;
+	int sum_if_percent = 0;
+	for (int trial = 0; trial < 100; trial++) {
+		uint16_t samples[GPR_DEMODULATOR_MAX_SAMPLES];
+		tone_step(samples, 500, 0, 0, 300, &seed);
+		gpr_iq_t iq;
+		gpr_demodulator_run(&demod, samples, &iq);
+		worst_if_percent = iq.if_percent > worst_if_percent ? iq.if_percent : worst_if_percent;
+		sum_if_percent += iq.if_percent;
+	}
+	printf("gpr_demodulator: noise only, IF share %.1f%% on average, %d%% at worst\n", sum_if_percent / 100.0, worst_if_percent);
+	TEST_CHECK(sum_if_percent <= 100);
+	TEST_CHECK(worst_if_percent <= 5);
+}
+
+static void test_dc_and_clipping() {
+	TEST_CHECK(gpr_demodulator_init(&demod, 200, IF_CYCLES_PER_SAMPLE));
+	uint16_t samples[GPR_DEMODULATOR_MAX_SAMPLES];
+	gpr_iq_t iq;
+
+	// A flat step is all mean: nothing at the IF, and no AC power to take a share of
+	for (int n = 0; n < 200; n++) {
+		samples[n] = 1234;
+	}
+	gpr_demodulator_run(&demod, samples, &iq);
+	TEST_CHECK(iq.dc == 1234);
+	TEST_CHECK_NEAR(iq.i, 0, 0.05);
+	TEST_CHECK_NEAR(iq.q, 0, 0.05);
+	TEST_CHECK(iq.if_percent == 0);
+	TEST_CHECK(iq.num_clipped == 0);
+
+	// A tone too big for the ADC is counted at both ends of the range
+	uint32_t seed = 3;
+	tone_step(samples, 200, 2500, 0.3, 0, &seed);
+	int num_clipped = 0;
+	for (int n = 0; n < 200; n++) {
+		num_clipped += samples[n] == 0 || samples[n] == GPR_DEMODULATOR_ADC_MAX;
+	}
+	gpr_demodulator_run(&demod, samples, &iq);
+	TEST_CHECK(num_clipped > 0);
+	TEST_CHECK(iq.num_clipped == num_clipped);
+
+	// The clipped count saturates instead of wrapping
+	TEST_CHECK(gpr_demodulator_init(&demod, 500, IF_CYCLES_PER_SAMPLE));
+	for (int n = 0; n < 500; n++) {
+		samples[n] = 0;
+	}
+	gpr_demodulator_run(&demod, samples, &iq);
+	TEST_CHECK(iq.num_clipped == UINT8_MAX);
+	TEST_CHECK(iq.dc == 0);
+}
+
+static void test_invalid() {
+	TEST_CHECK(!gpr_demodulator_init(&demod, 1, IF_CYCLES_PER_SAMPLE));
+	TEST_CHECK(!gpr_demodulator_init(&demod, GPR_DEMODULATOR_MAX_SAMPLES + 1, IF_CYCLES_PER_SAMPLE));
+	TEST_CHECK(!gpr_demodulator_init(&demod, 200, 0.6));
+	TEST_CHECK(!gpr_demodulator_init(&demod, 200, -0.1));
+	TEST_CHECK(!gpr_demodulator_init(NULL, 200, IF_CYCLES_PER_SAMPLE));
+}
+
+int main() {
+	test_tones();
+	test_noise_only();
+	test_dc_and_clipping();
+	test_invalid();
+	return test_result("gpr_demodulator");
+}
@@ -0,0 +1,111 @@
+/*
+ * test_gpr_manager.c
+ *
+ * Runs whole sweeps through the GPR manager, signal receiver, and signal generator against the stand-in HAL
+ */
+
+#include "gpr_manager.h"
+
+#include "hal_stub.h"
+#include "signal_receiver.h"
+#include "spi.h"
+#include "test.h"
+#include "tim.h"
+
+#define MAX_STEP_INCREMENTS		50 // As in gpr_manager.c
+#define UNWRITTEN				0xFFFF // No capture tags a sample with this
+
+/**
+ * @brief Runs a sweep to the end
+ * @param[in] num_steps: Steps in the sweep
+ * @param[in] num_samples: Samples per step
+ * @return True if the sweep finished, false if it stalled
+ */
+static bool run_sweep(int num_steps, int num_samples) {
+	hal_stub_reset();
+	gpr_manager_start_recording(1000, 2000, num_steps, num_samples);
+	for (int i = 0; i < 10 * MAX_STEP_INCREMENTS && gpr_manager_loop_recording(); i++) {
+		if (!hal_stub_run_next()) {
+			return false;
+		}
+	}
+	return !gpr_manager_loop_recording();
+}
+
+static void test_sweeps() {
+	// Every sample of every step lands in its own row, and nothing past the samples or steps captured is written
+	const int sizes[][2] = {{50, 200}, {2, 500}, {17, 1}, {50, 500}};
+	uint16_t* data;
+	double* freqs_mhz;
+	int actual_num_steps;
+	int array_samples_per_step;
+	int actual_samples_per_step;
+	for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		int num_steps = sizes[s][0];
+		int num_samples = sizes[s][1];
+		gpr_manager_get_data(&data, &freqs_mhz, &actual_num_steps, &array_samples_per_step, &actual_samples_per_step);
+		for (int i = 0; i < MAX_STEP_INCREMENTS * SIG_RECEIVER_MAX_DMA_SAMPLES; i++) {
+			data[i] = UNWRITTEN;
+		}
+		gpr_trace_info_t before;
+		gpr_manager_get_trace_info(&before);
+
+		TEST_CHECK(run_sweep(num_steps, num_samples));
+		TEST_CHECK(gpr_manager_get_data(&data, &freqs_mhz, &actual_num_steps, &array_samples_per_step, &actual_samples_per_step));
+		TEST_CHECK(actual_num_steps == num_steps);
+		TEST_CHECK(actual_samples_per_step == num_samples);
+		TEST_CHECK(array_samples_per_step == SIG_RECEIVER_MAX_DMA_SAMPLES);
+		TEST_CHECK(hal_stub_num_captures == (uint32_t) num_steps);
+		TEST_CHECK_NEAR(freqs_mhz[0], 1000, 1e-9);
+		TEST_CHECK_NEAR(freqs_mhz[num_steps - 1], 2000, 1e-9);
+
+		int num_misplaced = 0;
+		for (int row = 0; row < MAX_STEP_INCREMENTS; row++) {
+			for (int i = 0; i < SIG_RECEIVER_MAX_DMA_SAMPLES; i++) {
+				uint16_t expected = row < num_steps && i < num_samples ? hal_stub_tag(row, i) : UNWRITTEN;
+				num_misplaced += data[row * array_samples_per_step + i] != expected;
+			}
+		}
+		TEST_CHECK(num_misplaced == 0);
+
+		// One pulse per step, each stopped once the pulse time is up, with the transmitter retuned for each step
+		TEST_CHECK(htim10.num_oc_starts == (uint32_t) num_steps);
+		TEST_CHECK(!htim10.oc_running);
+		TEST_CHECK_NEAR(htim10.oc_longest_ns, 1000, 50);
+		TEST_CHECK(hspi3.num_transmits == 2 * (uint32_t) num_steps);
+		TEST_CHECK(hspi2.num_transmits == 2 * (uint32_t) num_steps);
+		TEST_CHECK(!htim11.oc_running);
+
+		gpr_trace_info_t info;
+		TEST_CHECK(gpr_manager_get_trace_info(&info));
+		TEST_CHECK(info.trace_num == before.trace_num + 1);
+		printf("gpr_manager: %dx%d sweep takes %.2f ms\n", num_steps, num_samples, hal_stub_time_ns * 1e-6);
+	}
+}
+
+static void test_rejected() {
+	// Sweeps the manager can't hold don't start, and leave the last sweep's data alone
+	gpr_trace_info_t before;
+	gpr_trace_info_t after;
+	gpr_manager_get_trace_info(&before);
+	hal_stub_reset();
+	gpr_manager_start_recording(1000, 2000, 1, 200);
+	TEST_CHECK(!gpr_manager_loop_recording());
+	gpr_manager_start_recording(1000, 2000, MAX_STEP_INCREMENTS + 1, 200);
+	TEST_CHECK(!gpr_manager_loop_recording());
+	gpr_manager_start_recording(1000, 2000, 10, SIG_RECEIVER_MAX_DMA_SAMPLES + 1);
+	TEST_CHECK(!gpr_manager_loop_recording());
+	TEST_CHECK(!hal_stub_run_next());
+	TEST_CHECK(gpr_manager_get_trace_info(&after));
+	TEST_CHECK(after.trace_num == before.trace_num);
+}
+
+int main() {
+	hal_stub_reset();
+	gpr_manager_init();
+	while (!gpr_manager_init_step()) {
+	}
+	test_sweeps();
+	test_rejected();
+	return test_result("gpr_manager");
+}
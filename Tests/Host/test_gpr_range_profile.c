@@ -0,0 +1,127 @@
+/*
+ * test_gpr_range_profile.c
+ */
+
+#include "gpr_range_profile.h"
+
+#include <stdlib.h>
+
+#include "test.h"
+
+#define PI	3.14159265358979
+
+static gpr_range_profile_t profile;
+
+/**
+ * @brief Deterministic pseudo-random amplitude
+ * @param[in, out] seed: Generator state
+ * @return Amplitude from -1000 to 1000 ADC counts
+ */
+static float random_amplitude(uint32_t* seed) {
+	*seed = *seed * 1664525u + 1013904223u;
+	return (float) ((*seed >> 8) / 16777215.0 * 2000 - 1000);
+}
+
+/**
+ * @brief Fills a sweep with a single reflector, its delay lagging the phase a little more at each step
+ * @param[out] iq: Steps to fill
+ * @param[in] num_steps: Steps in the sweep
+ * @param[in] amplitude: Reflector amplitude
+ * @param[in] lag_per_step: Phase lag added by each step, in radians
+ */
+static void reflector_sweep(gpr_iq_t* iq, int num_steps, double amplitude, double lag_per_step) {
+	for (int n = 0; n < num_steps; n++) {
+		iq[n].i = (float) (amplitude * cos(lag_per_step * n));
+		iq[n].q = (float) (-amplitude * sin(lag_per_step * n));
+		iq[n].dc = 0;
+	}
+}
+
+static void test_matches_dft() {
+	// Random sweeps against a direct inverse DFT in double precision, over a range of step counts and sizes
+	const int sizes[][2] = {{50, 64}, {33, 64}, {16, 16}, {8, 32}, {2, 2}, {1, 4}};
+	const gpr_range_window_t windows[] = {GprRangeWindowRectangular, GprRangeWindowHann};
+	uint32_t seed = 1;
+	double worst_error = 0;
+	for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (int w = 0; w < 2; w++) {
+			int num_steps = sizes[s][0];
+			int num_points = sizes[s][1];
+			TEST_CHECK(gpr_range_profile_init(&profile, num_steps, num_points, windows[w]));
+			for (int sweep = 0; sweep < 50; sweep++) {
+				gpr_iq_t iq[GPR_RANGE_PROFILE_MAX_POINTS];
+				gpr_complex_t bins[GPR_RANGE_PROFILE_MAX_POINTS];
+				for (int n = 0; n < num_steps; n++) {
+					iq[n].i = random_amplitude(&seed);
+					iq[n].q = random_amplitude(&seed);
+					iq[n].dc = 0;
+				}
+				gpr_range_profile_run(&profile, iq, bins);
+
+				double peak = 0;
+				double max_error = 0;
+				for (int k = 0; k < num_points; k++) {
+					double re = 0;
+					double im = 0;
+					for (int n = 0; n < num_steps; n++) {
+						double angle = 2 * PI * k * n / num_points;
+						re += profile.window[n] * (iq[n].i * cos(angle) - iq[n].q * sin(angle));
+						im += profile.window[n] * (iq[n].i * sin(angle) + iq[n].q * cos(angle));
+					}
+					peak = fmax(peak, hypot(re, im));
+					max_error = fmax(max_error, hypot(bins[k].re - re, bins[k].im - im));
+				}
+				worst_error = fmax(worst_error, max_error / peak);
+			}
+		}
+	}
+	printf("gpr_range_profile: worst error %.2g of peak\n", worst_error);
+	TEST_CHECK(worst_error < 1e-6);
+}
+
+static void test_reflector_peak() {
+	// A reflector on a bin peaks at its amplitude with either window, and the Hann window keeps its sidelobes much lower
+	const int num_steps = 50;
+	const int num_points = 64;
+	const int reflector_bin = 10;
+	gpr_iq_t iq[GPR_RANGE_PROFILE_MAX_POINTS];
+	gpr_complex_t bins[GPR_RANGE_PROFILE_MAX_POINTS];
+	float magnitudes[GPR_RANGE_PROFILE_MAX_POINTS];
+	reflector_sweep(iq, num_steps, 800, 2 * PI * reflector_bin / num_points);
+
+	TEST_CHECK(gpr_range_profile_init(&profile, num_steps, num_points, GprRangeWindowRectangular));
+	gpr_range_profile_run(&profile, iq, bins);
+	gpr_range_profile_magnitudes(bins, num_points, magnitudes);
+	TEST_CHECK_NEAR(magnitudes[reflector_bin], 800, 0.01);
+	float sidelobe = 0;
+	for (int k = 0; k < num_points; k++) {
+		sidelobe = abs(k - reflector_bin) > 1 && magnitudes[k] > sidelobe ? magnitudes[k] : sidelobe;
+	}
+	TEST_CHECK(20 * log10(sidelobe / 800) < -13);
+
+	TEST_CHECK(gpr_range_profile_init(&profile, num_steps, num_points, GprRangeWindowHann));
+	gpr_range_profile_run(&profile, iq, bins);
+	gpr_range_profile_magnitudes(bins, num_points, magnitudes);
+	TEST_CHECK_NEAR(magnitudes[reflector_bin], 800, 0.01);
+	sidelobe = 0;
+	for (int k = 0; k < num_points; k++) {
+		sidelobe = abs(k - reflector_bin) > 3 && magnitudes[k] > sidelobe ? magnitudes[k] : sidelobe;
+	}
+	TEST_CHECK(20 * log10(sidelobe / 800) < -31);
+}
+
+static void test_invalid_sizes() {
+	TEST_CHECK(!gpr_range_profile_init(&profile, 10, 48, GprRangeWindowHann));
+	TEST_CHECK(!gpr_range_profile_init(&profile, 10, 1, GprRangeWindowHann));
+	TEST_CHECK(!gpr_range_profile_init(&profile, 10, 2 * GPR_RANGE_PROFILE_MAX_POINTS, GprRangeWindowHann));
+	TEST_CHECK(!gpr_range_profile_init(&profile, 0, 16, GprRangeWindowHann));
+	TEST_CHECK(!gpr_range_profile_init(&profile, 17, 16, GprRangeWindowHann));
+	TEST_CHECK(!gpr_range_profile_init(NULL, 10, 16, GprRangeWindowHann));
+}
+
+int main() {
+	test_matches_dft();
+	test_reflector_peak();
+	test_invalid_sizes();
+	return test_result("gpr_range_profile");
+}
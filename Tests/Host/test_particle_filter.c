@@ -0,0 +1,147 @@
+/*
+ * test_particle_filter.c
+ */
+
+#include "particle_filter.h"
+
+#include <string.h>
+
+#include "test.h"
+
+#define PI	3.14159265
+
+static particle_filter_t pf;
+static particle_filter_t pf_ranges;
+
+/**
+ * @brief Sums the weights of the active particles
+ * @param[in] filter: Particle filter
+ * @return Sum of weights
+ */
+static double weight_sum(const particle_filter_t* filter) {
+	double sum = 0;
+	for (uint32_t i = 0; i < filter->num_particles; i++) {
+		sum += filter->weight[i];
+	}
+	return sum;
+}
+
+static void test_init() {
+	pose3d_t pose = {1, 2, 0.5f, 0.3f, 0, 0};
+	particle_filter_init(&pf, pose, 0.05f, 0.05f, 1);
+	TEST_CHECK(pf.num_particles == PARTICLE_FILTER_NUM_PARTICLES);
+	TEST_CHECK_NEAR(weight_sum(&pf), 1, 1e-4);
+
+	pose3d_t mean = particle_filter_estimate(&pf);
+	TEST_CHECK_NEAR(mean.x, 1, 0.01);
+	TEST_CHECK_NEAR(mean.y, 2, 0.01);
+	TEST_CHECK_NEAR(mean.z, 0.5, 0.01);
+	TEST_CHECK_NEAR(mean.yaw, 0.3, 0.01);
+}
+
+static void test_predict() {
+	// Without noise, every particle drives the same step, so the mean does too
+	pose3d_t pose = {0, 0, 0, (float) (PI / 2), 0, 0};
+	particle_filter_init(&pf, pose, 0, 0, 2);
+	particle_filter_predict(&pf, 1, 0.2f, 0, 0, 0);
+	pose3d_t mean = particle_filter_estimate(&pf);
+	TEST_CHECK_NEAR(mean.x, cos(PI / 2 + 0.1), 1e-5);
+	TEST_CHECK_NEAR(mean.y, sin(PI / 2 + 0.1), 1e-5);
+	TEST_CHECK_NEAR(mean.yaw, PI / 2 + 0.2, 1e-5);
+
+	// Predicting a range at a time with one step gives the same particles as predicting them all at once
+	pose3d_t start = {0, 0, 0, 0, 0, 0};
+	particle_filter_init(&pf, start, 0.1f, 0.1f, 3);
+	memcpy(&pf_ranges, &pf, sizeof(pf));
+	particle_filter_predict(&pf, 0.5f, 0.1f, 0.02f, 0.05f, 0.01f);
+	particle_filter_motion_t motion = particle_filter_motion(&pf_ranges, 0.5f, 0.1f, 0.02f, 0.05f, 0.01f);
+	for (uint32_t begin = 0; begin < pf_ranges.num_particles; begin += 100) {
+		particle_filter_predict_range(&pf_ranges, &motion, begin, begin + 100);
+	}
+	TEST_CHECK(memcmp(pf.x, pf_ranges.x, sizeof(pf.x)) == 0);
+	TEST_CHECK(memcmp(pf.yaw, pf_ranges.yaw, sizeof(pf.yaw)) == 0);
+	TEST_CHECK(memcmp(pf.roll, pf_ranges.roll, sizeof(pf.roll)) == 0);
+	TEST_CHECK(pf.seed == pf_ranges.seed);
+}
+
+static void test_weight_and_resample() {
+	// Particles spread along x, measured at x = 0.5, end up around the measurement after resampling
+	pose3d_t start = {0, 0, 0, 0, 0, 0};
+	particle_filter_init(&pf, start, 1, 0.05f, 4);
+	particle_filter_weight_position(&pf, 0.5f, 0, 0.1f);
+	float num_effective = particle_filter_normalize(&pf);
+	TEST_CHECK_NEAR(weight_sum(&pf), 1, 1e-4);
+	TEST_CHECK(num_effective > 1 && num_effective < PARTICLE_FILTER_NUM_PARTICLES / 2);
+	pose3d_t mean = particle_filter_estimate(&pf);
+	TEST_CHECK_NEAR(mean.x, 0.5, 0.05);
+
+	particle_filter_resample(&pf, 256);
+	TEST_CHECK(pf.num_particles == 256);
+	TEST_CHECK_NEAR(weight_sum(&pf), 1, 1e-4);
+	mean = particle_filter_estimate(&pf);
+	TEST_CHECK_NEAR(mean.x, 0.5, 0.05);
+
+	// Range weighing only touches the range
+	pose3d_t pose = {0, 0, 0, 0.2f, 0, 0};
+	particle_filter_init(&pf, pose, 0.05f, 0.05f, 5);
+	particle_filter_weight_orientation_range(&pf, 0.2f, 0, 0, 0.05f, 0.03f, 0, 64);
+	TEST_CHECK(pf.weight[0] < 1.0f / PARTICLE_FILTER_NUM_PARTICLES);
+	TEST_CHECK(pf.weight[64] == 1.0f / PARTICLE_FILTER_NUM_PARTICLES);
+
+	// Set size is clamped to the capacity and minimum
+	particle_filter_resample(&pf, 1);
+	TEST_CHECK(pf.num_particles == PARTICLE_FILTER_MIN_PARTICLES);
+	particle_filter_resample(&pf, 100000);
+	TEST_CHECK(pf.num_particles == PARTICLE_FILTER_NUM_PARTICLES);
+}
+
+static void test_normalize_collapse() {
+	// Every particle ruled out by a measurement far away leaves equal weights instead of dividing by zero
+	pose3d_t start = {0, 0, 0, 0, 0, 0};
+	particle_filter_init(&pf, start, 0.01f, 0.01f, 6);
+	particle_filter_weight_position(&pf, 1000, 1000, 0.01f);
+	float num_effective = particle_filter_normalize(&pf);
+	TEST_CHECK_NEAR(num_effective, PARTICLE_FILTER_NUM_PARTICLES, 1);
+	TEST_CHECK_NEAR(pf.weight[0], 1.0 / PARTICLE_FILTER_NUM_PARTICLES, 1e-9);
+}
+
+static void test_truncate() {
+	pose3d_t start = {0, 0, 0, 0, 0, 0};
+	particle_filter_init(&pf, start, 0.05f, 0.05f, 7);
+	particle_filter_truncate(&pf, 200);
+	TEST_CHECK(pf.num_particles == 200);
+	particle_filter_truncate(&pf, 500);
+	TEST_CHECK(pf.num_particles == 200);
+	particle_filter_truncate(&pf, 0);
+	TEST_CHECK(pf.num_particles == 200);
+	particle_filter_normalize(&pf);
+	TEST_CHECK_NEAR(weight_sum(&pf), 1, 1e-4);
+}
+
+static void test_kld() {
+	// A tight cloud in the middle of a bin fills only that bin, a wide one needs many more particles
+	pose3d_t start = {0.025f, 0.025f, 0, 0.04f, 0, 0};
+	particle_filter_init(&pf, start, 0.001f, 0.001f, 8);
+	TEST_CHECK(particle_filter_kld_num_particles(&pf, 0.05f, 0.0873f, 0.05f, 2.33f) == PARTICLE_FILTER_MIN_PARTICLES);
+	particle_filter_init(&pf, start, 0.5f, 0.5f, 8);
+	TEST_CHECK(particle_filter_kld_num_particles(&pf, 0.05f, 0.0873f, 0.05f, 2.33f) > PARTICLE_FILTER_NUM_PARTICLES / 2);
+}
+
+static void test_estimate_wraps() {
+	// Headings either side of +/-PI average to PI, not 0
+	pose3d_t pose = {0, 0, 0, (float) PI, 0, 0};
+	particle_filter_init(&pf, pose, 0, 0.1f, 9);
+	pose3d_t mean = particle_filter_estimate(&pf);
+	TEST_CHECK_NEAR(fabs(mean.yaw), PI, 0.02);
+}
+
+int main() {
+	test_init();
+	test_predict();
+	test_weight_and_resample();
+	test_normalize_collapse();
+	test_truncate();
+	test_kld();
+	test_estimate_wraps();
+	return test_result("particle_filter");
+}
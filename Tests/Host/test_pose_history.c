@@ -0,0 +1,173 @@
+/*
+ * test_pose_history.c
+ *
+ * Replays a synthetic drive through the pose history at the localization rate, and looks poses up at the times late
+ * measurements would have been captured
+ */
+
+#include "pose_history.h"
+
+#include <stddef.h>
+
+#include "test.h"
+
+#define PI				3.14159265358979
+#define UPDATE_US		10000 // 100 Hz localization rate
+#define SPEED_M_S		0.5
+#define TURN_RAD_S		0.8
+
+static pose_history_t history;
+
+/**
+ * @brief Pose along the synthetic drive: an arc at constant speed and turn rate, climbing a slight slope
+ * @param[in] t_s: Time since the drive started
+ * @return Pose at that time, yaw wrapped to [-PI, PI)
+ */
+static pose3d_t drive_pose(double t_s) {
+	double yaw = 3.0 + TURN_RAD_S * t_s; // Starts just short of PI, so yaw wraps soon after
+	double radius = SPEED_M_S / TURN_RAD_S;
+	pose3d_t pose;
+	pose.x = (float) (radius * (sin(yaw) - sin(3.0)));
+	pose.y = (float) (-radius * (cos(yaw) - cos(3.0)));
+	pose.z = (float) (0.05 * SPEED_M_S * t_s);
+	pose.yaw = (float) remainder(yaw, 2 * PI);
+	if (pose.yaw >= PI) {
+		pose.yaw -= (float) (2 * PI);
+	}
+	pose.pitch = 0.05f;
+	pose.roll = (float) (0.02 * sin(t_s));
+	return pose;
+}
+
+/**
+ * @brief Deterministic pseudo-random number
+ * @param[in, out] seed: Generator state
+ * @return Uniform from 0 to 1
+ */
+static double random_uniform(uint32_t* seed) {
+	*seed = *seed * 1664525u + 1013904223u;
+	return (*seed >> 8) / 16777216.0;
+}
+
+static void test_empty() {
+	// Nothing can be found before the first pose, and the newest pose answers for any later time
+	pose_history_init(&history);
+	pose3d_t pose;
+	TEST_CHECK(!pose_history_get(&history, 0, &pose));
+	TEST_CHECK(!pose_history_get(&history, 123456, &pose));
+
+	pose3d_t first = drive_pose(0);
+	pose_history_push(&history, 5000, first);
+	TEST_CHECK(pose_history_get(&history, 5000, &pose));
+	TEST_CHECK(pose.x == first.x && pose.yaw == first.yaw);
+	TEST_CHECK(pose_history_get(&history, 900000, &pose));
+	TEST_CHECK(pose.x == first.x && pose.yaw == first.yaw);
+	TEST_CHECK(!pose_history_get(&history, 4999, &pose));
+	TEST_CHECK(!pose_history_get(NULL, 5000, &pose));
+	TEST_CHECK(!pose_history_get(&history, 5000, NULL));
+}
+
+/**
+ * @brief Replays the drive with updates jittered around the localization rate, checking lookups at random past times
+ * @param[in] start_us: Timestamp of the first update
+ * @param[in] num_updates: Updates to replay
+ */
+static void replay_drive(uint32_t start_us, int num_updates) {
+	// Lookups inside the history land on the drive to within what straight-line interpolation over one update loses.
+	// Lookups older than the oldest pose kept fail
+	pose_history_init(&history);
+	uint32_t seed = start_us | 1;
+	uint32_t elapsed_us = 0;
+	uint32_t update_elapsed_us[POSE_HISTORY_LENGTH];
+	double worst_position_error = 0;
+	double worst_angle_error = 0;
+	int num_wrong = 0;
+	for (int u = 0; u < num_updates; u++) {
+		pose_history_push(&history, start_us + elapsed_us, drive_pose(elapsed_us * 1e-6));
+		update_elapsed_us[u % POSE_HISTORY_LENGTH] = elapsed_us;
+		int num_kept = u + 1 < POSE_HISTORY_LENGTH ? u + 1 : POSE_HISTORY_LENGTH;
+		uint32_t oldest_us = update_elapsed_us[(u + 1 - num_kept) % POSE_HISTORY_LENGTH];
+
+		// A measurement captured somewhere in the kept span, like a GPS fix a few hundred ms late
+		for (int q = 0; q < 4; q++) {
+			uint32_t query_us = oldest_us + (uint32_t) (random_uniform(&seed) * (elapsed_us - oldest_us));
+			pose3d_t pose;
+			if (!pose_history_get(&history, start_us + query_us, &pose)) {
+				num_wrong++;
+				continue;
+			}
+			pose3d_t truth = drive_pose(query_us * 1e-6);
+			double position_error = sqrt(pow(pose.x - truth.x, 2) + pow(pose.y - truth.y, 2) + pow(pose.z - truth.z, 2));
+			double angle_error = fabs(remainder(pose.yaw - truth.yaw, 2 * PI));
+			angle_error = fmax(angle_error, fabs(pose.pitch - truth.pitch));
+			angle_error = fmax(angle_error, fabs(pose.roll - truth.roll));
+			num_wrong += pose.yaw < -PI || pose.yaw >= PI;
+			worst_position_error = fmax(worst_position_error, position_error);
+			worst_angle_error = fmax(worst_angle_error, angle_error);
+		}
+
+		// Just older than the oldest pose kept is out of range once the history has filled
+		pose3d_t pose;
+		if (elapsed_us > 0) {
+			num_wrong += pose_history_get(&history, start_us + oldest_us - 1, &pose);
+		}
+		num_wrong += !pose_history_get(&history, start_us + elapsed_us + 50000, &pose);
+		elapsed_us += UPDATE_US - 2000 + (uint32_t) (random_uniform(&seed) * 4000);
+	}
+	printf("pose_history: %d updates from %u us, worst error %.2f mm and %.1e rad\n", num_updates, start_us,
+			worst_position_error * 1000, worst_angle_error);
+	TEST_CHECK(num_wrong == 0);
+	// Chord sag over 12 ms of a 0.625 m radius arc at 0.5 m/s is under 0.01 mm, so the rest is float rounding
+	TEST_CHECK(worst_position_error < 0.001);
+	TEST_CHECK(worst_angle_error < 0.001);
+	TEST_CHECK(history.num_entries == POSE_HISTORY_LENGTH);
+}
+
+static void test_replay() {
+	// From boot, and across the microsecond counter wrapping about 71 minutes in
+	replay_drive(0, 1000);
+	replay_drive(UINT32_MAX - 3000000, 1000);
+}
+
+static void test_repeated_timestamp() {
+	// A pose pushed again at the newest time replaces it instead of adding a zero-length span
+	pose_history_init(&history);
+	pose3d_t a = {0};
+	pose3d_t b = {0};
+	pose3d_t c = {0};
+	b.x = 1;
+	c.x = 2;
+	pose_history_push(&history, 1000, a);
+	pose_history_push(&history, 2000, b);
+	pose_history_push(&history, 2000, c);
+	TEST_CHECK(history.num_entries == 2);
+	pose3d_t pose;
+	TEST_CHECK(pose_history_get(&history, 1500, &pose));
+	TEST_CHECK_NEAR(pose.x, 1, 1e-6);
+	TEST_CHECK(pose_history_get(&history, 2000, &pose));
+	TEST_CHECK_NEAR(pose.x, 2, 1e-6);
+}
+
+static void test_yaw_wrap() {
+	// Yaw is interpolated the short way across +/-PI, not back through 0
+	pose_history_init(&history);
+	pose3d_t a = {0};
+	pose3d_t b = {0};
+	a.yaw = 3.1f;
+	b.yaw = -3.1f;
+	pose_history_push(&history, 0, a);
+	pose_history_push(&history, 1000, b);
+	pose3d_t pose;
+	TEST_CHECK(pose_history_get(&history, 250, &pose));
+	TEST_CHECK_NEAR(pose.yaw, 3.1 + 0.25 * (2 * PI - 6.2), 1e-5);
+	TEST_CHECK(pose_history_get(&history, 750, &pose));
+	TEST_CHECK_NEAR(pose.yaw, -3.1 - 0.25 * (2 * PI - 6.2), 1e-5);
+}
+
+int main() {
+	test_empty();
+	test_replay();
+	test_repeated_timestamp();
+	test_yaw_wrap();
+	return test_result("pose_history");
+}
@@ -0,0 +1,179 @@
+/*
+ * test_sample_ring.c
+ *
+ * Replays synthetic timestamped sensor streams through the ring buffer the way the localization manager queues them:
+ * samples pushed as they arrive, and drained once per update
+ */
+
+#include "sample_ring.h"
+
+#include <stddef.h>
+
+#include "test.h"
+
+#define CAPACITY		8 // As SENSOR_QUEUE_SIZE in localization_manager.c
+
+typedef struct test_sample_t {
+	uint32_t timestamp_us;
+	uint32_t value;
+} test_sample_t;
+
+static test_sample_t storage[CAPACITY];
+
+/**
+ * @brief Deterministic pseudo-random number
+ * @param[in, out] seed: Generator state
+ * @return Uniform from 0 to 2^24 - 1
+ */
+static uint32_t random_u24(uint32_t* seed) {
+	*seed = *seed * 1664525u + 1013904223u;
+	return *seed >> 8;
+}
+
+static void test_empty_and_full() {
+	// An empty ring has nothing to peek or pop, and a full one drops and counts new samples without touching the queued ones
+	sample_ring_t ring;
+	TEST_CHECK(sample_ring_init(&ring, storage, sizeof(test_sample_t), CAPACITY));
+	TEST_CHECK(sample_ring_count(&ring) == 0);
+	TEST_CHECK(sample_ring_peek(&ring) == NULL);
+	sample_ring_pop(&ring);
+	TEST_CHECK(sample_ring_count(&ring) == 0);
+
+	for (uint32_t i = 0; i < CAPACITY; i++) {
+		test_sample_t sample = {1000 * i, i};
+		TEST_CHECK(sample_ring_push(&ring, &sample));
+	}
+	TEST_CHECK(sample_ring_count(&ring) == CAPACITY);
+	test_sample_t extra = {1000 * CAPACITY, CAPACITY};
+	TEST_CHECK(!sample_ring_push(&ring, &extra));
+	TEST_CHECK(!sample_ring_push(&ring, &extra));
+	TEST_CHECK(ring.num_dropped == 2);
+	TEST_CHECK(sample_ring_count(&ring) == CAPACITY);
+
+	// Draining gets the first samples back in order, and then the ring is empty again
+	int num_out_of_order = 0;
+	for (uint32_t i = 0; i < CAPACITY; i++) {
+		const test_sample_t* sample = sample_ring_peek(&ring);
+		num_out_of_order += !sample || sample->value != i || sample->timestamp_us != 1000 * i;
+		sample_ring_pop(&ring);
+	}
+	TEST_CHECK(num_out_of_order == 0);
+	TEST_CHECK(sample_ring_count(&ring) == 0);
+	TEST_CHECK(sample_ring_peek(&ring) == NULL);
+
+	// Once there's room again, pushes go through
+	TEST_CHECK(sample_ring_push(&ring, &extra));
+	TEST_CHECK(sample_ring_count(&ring) == 1);
+	TEST_CHECK(ring.num_dropped == 2);
+}
+
+/**
+ * @brief Replays a stream of samples at random times, drained every 10 ms like a localization update
+ * @param[in, out] ring: Ring buffer to replay through
+ * @param[in] mean_period_us: Average time between samples
+ * @param[in] num_samples: Samples in the stream
+ * @param[in] seed: Stream generator seed
+ */
+static void replay_stream(sample_ring_t* ring, uint32_t mean_period_us, uint32_t num_samples, uint32_t seed) {
+	// Every sample is either popped in the order it was pushed or counted as dropped, never both, never neither
+	uint32_t next_sample_us = 0;
+	uint32_t num_pushed = 0;
+	uint32_t num_popped = 0;
+	uint32_t num_dropped = 0;
+	uint32_t next_expected = 0;
+	uint32_t num_out_of_order = 0;
+	uint32_t num_late = 0;
+	uint32_t dropped_before = ring->num_dropped;
+	for (uint32_t now_us = 0; num_pushed + num_dropped < num_samples || sample_ring_count(ring) > 0; now_us += 10000) {
+		while (num_pushed + num_dropped < num_samples && next_sample_us <= now_us) {
+			test_sample_t sample = {next_sample_us, num_pushed + num_dropped};
+			if (sample_ring_push(ring, &sample)) {
+				num_pushed++;
+			} else {
+				num_dropped++;
+			}
+			next_sample_us += random_u24(&seed) % (2 * mean_period_us) + 1;
+		}
+		const test_sample_t* sample;
+		while ((sample = sample_ring_peek(ring)) != NULL) {
+			// Dropped samples are the newest at the time, so later ones skip ahead but never go back
+			num_out_of_order += sample->value < next_expected;
+			num_late += sample->timestamp_us > now_us;
+			next_expected = sample->value + 1;
+			num_popped++;
+			sample_ring_pop(ring);
+		}
+	}
+	TEST_CHECK(num_out_of_order == 0);
+	TEST_CHECK(num_late == 0);
+	TEST_CHECK(num_popped == num_pushed);
+	TEST_CHECK(ring->num_dropped - dropped_before == num_dropped);
+	printf("sample_ring: %u samples every %u us on average, %u dropped\n", num_samples, mean_period_us, num_dropped);
+	if (mean_period_us * CAPACITY > 2 * 10000) {
+		TEST_CHECK(num_dropped == 0);
+	}
+}
+
+static void test_streams() {
+	// A 5 Hz GPS and a 100 Hz IMU never fill the ring between updates. A stream far faster than the updates does,
+	// and the excess is dropped
+	sample_ring_t ring;
+	TEST_CHECK(sample_ring_init(&ring, storage, sizeof(test_sample_t), CAPACITY));
+	replay_stream(&ring, 200000, 500, 1);
+	replay_stream(&ring, 10000, 5000, 2);
+	replay_stream(&ring, 500, 5000, 3);
+	TEST_CHECK(ring.num_dropped > 0);
+}
+
+static void test_counter_wrap() {
+	// Head and tail count every sample ever pushed and popped, so they wrap past 2^32 on a long run. Count and slot
+	// stay right across the wrap
+	sample_ring_t ring;
+	TEST_CHECK(sample_ring_init(&ring, storage, sizeof(test_sample_t), CAPACITY));
+	ring.head = UINT32_MAX - 2;
+	ring.tail = UINT32_MAX - 2;
+	uint32_t num_wrong = 0;
+	for (uint32_t i = 0; i < 4 * CAPACITY; i++) {
+		test_sample_t sample = {i, i};
+		TEST_CHECK(sample_ring_push(&ring, &sample));
+		if (i % 2 == 1) {
+			num_wrong += sample_ring_count(&ring) != 2;
+			const test_sample_t* oldest = sample_ring_peek(&ring);
+			num_wrong += !oldest || oldest->value != i - 1;
+			sample_ring_pop(&ring);
+			sample_ring_pop(&ring);
+		}
+	}
+	TEST_CHECK(num_wrong == 0);
+	TEST_CHECK(ring.head < UINT32_MAX - 2);
+	TEST_CHECK(sample_ring_count(&ring) == 0);
+
+	// Full across the wrap too
+	for (uint32_t i = 0; i < CAPACITY; i++) {
+		test_sample_t sample = {i, i};
+		TEST_CHECK(sample_ring_push(&ring, &sample));
+	}
+	test_sample_t extra = {0, 0};
+	TEST_CHECK(!sample_ring_push(&ring, &extra));
+	TEST_CHECK(sample_ring_count(&ring) == CAPACITY);
+}
+
+static void test_invalid() {
+	sample_ring_t ring;
+	TEST_CHECK(!sample_ring_init(&ring, storage, sizeof(test_sample_t), 6));
+	TEST_CHECK(!sample_ring_init(&ring, storage, sizeof(test_sample_t), 0));
+	TEST_CHECK(!sample_ring_init(&ring, storage, 0, CAPACITY));
+	TEST_CHECK(!sample_ring_init(&ring, NULL, sizeof(test_sample_t), CAPACITY));
+	TEST_CHECK(!sample_ring_init(NULL, storage, sizeof(test_sample_t), CAPACITY));
+	TEST_CHECK(!sample_ring_push(NULL, &ring));
+	TEST_CHECK(sample_ring_peek(NULL) == NULL);
+	TEST_CHECK(sample_ring_count(NULL) == 0);
+}
+
+int main() {
+	test_empty_and_full();
+	test_streams();
+	test_counter_wrap();
+	test_invalid();
+	return test_result("sample_ring");
+}
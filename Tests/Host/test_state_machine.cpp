@@ -0,0 +1,111 @@
+/*
+ * test_state_machine.cpp
+ */
+
+#include "state_machine.h"
+
+#include "test.h"
+
+class TestState : public State {
+
+	public:
+		TestState(int id): State(id) { }
+
+		end_status_t run() { return end_status_t::NoChange; }
+		void init(void) { }
+		void cleanup(void) { }
+};
+
+static TestState disabled_state(state_id::Disabled);
+static TestState drive_state(state_id::Drive);
+static TestState drive_record_state(state_id::DriveRecord);
+static TestState initialize_state(state_id::Initialize);
+static TestState record_state(state_id::Record);
+
+/**
+ * @brief Looks up whether a (state, end status) pair is in STATE_TRANSITIONS
+ * @param[in] from: State that produced the end status
+ * @param[in] end_status: End status
+ * @return Index of the transition, -1 if it isn't listed
+ */
+static int find_transition(int from, int end_status) {
+	for (int i = 0; i < NUM_STATE_TRANSITIONS; i++) {
+		if (STATE_TRANSITIONS[i].from == from && STATE_TRANSITIONS[i].end_status == end_status) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void test_register() {
+	StateMachine state_machine;
+	TestState invalid_state(state_id::NUM_STATES);
+	TestState duplicate_state(state_id::Drive);
+	TestState* states[] = {&disabled_state, &drive_state, &drive_record_state, &initialize_state, &record_state};
+	for (TestState* state : states) {
+		TEST_CHECK(state_machine.register_state(state));
+	}
+	TEST_CHECK(!state_machine.register_state(&duplicate_state));
+	TEST_CHECK(!state_machine.register_state(&invalid_state));
+	TEST_CHECK(!state_machine.register_state(NULL));
+	TEST_CHECK(state_machine.get_state(state_id::Drive) == &drive_state);
+	TEST_CHECK(state_machine.get_state(INITIAL_STATE) == &initialize_state);
+	TEST_CHECK(state_machine.get_state(state_id::UNKNOWN) == NULL);
+}
+
+static void test_transitions() {
+	StateMachine state_machine;
+	TestState* states[] = {&disabled_state, &drive_state, &drive_record_state, &initialize_state, &record_state};
+	for (TestState* state : states) {
+		state_machine.register_state(state);
+	}
+
+	// Every listed transition goes where it says, NoChange and unlisted pairs stay put
+	int num_moves = 0;
+	for (TestState* state : states) {
+		for (int end_status = 0; end_status < NUM_END_STATUSES; end_status++) {
+			State* next = state_machine.get_next_state(state, (end_status_t) end_status);
+			int i = find_transition(state->get_id(), end_status);
+			if (i >= 0) {
+				TEST_CHECK(next == state_machine.get_state(STATE_TRANSITIONS[i].to));
+				num_moves++;
+			} else {
+				TEST_CHECK(next == state);
+			}
+		}
+	}
+	TEST_CHECK(num_moves == NUM_STATE_TRANSITIONS);
+
+	// The survey loop, as the scheduler walks it
+	State* state = state_machine.get_state(INITIAL_STATE);
+	state = state_machine.get_next_state(state, end_status_t::InitializationComplete);
+	TEST_CHECK(state == &disabled_state);
+	state = state_machine.get_next_state(state, end_status_t::SystemEnabled);
+	TEST_CHECK(state == &drive_state);
+	state = state_machine.get_next_state(state, end_status_t::SurveyLineReached);
+	TEST_CHECK(state == &drive_record_state);
+	state = state_machine.get_next_state(state, end_status_t::SurveyLineComplete);
+	TEST_CHECK(state == &drive_state);
+	state = state_machine.get_next_state(state, end_status_t::TrajectoryComplete);
+	TEST_CHECK(state == &record_state);
+	state = state_machine.get_next_state(state, end_status_t::SystemDisabled);
+	TEST_CHECK(state == &disabled_state);
+
+	// Out of range end statuses stay put too
+	TEST_CHECK(state_machine.get_next_state(&drive_state, NUM_END_STATUSES) == &drive_state);
+	TEST_CHECK(state_machine.get_next_state(NULL, end_status_t::SystemEnabled) == NULL);
+}
+
+static void test_unregistered() {
+	// A transition to a state nobody registered stays put instead of returning NULL
+	StateMachine state_machine;
+	state_machine.register_state(&drive_state);
+	TEST_CHECK(state_machine.get_next_state(&drive_state, end_status_t::TrajectoryComplete) == &drive_state);
+}
+
+int main() {
+	test_register();
+	test_transitions();
+	test_unregistered();
+	return test_result("state_machine");
+}
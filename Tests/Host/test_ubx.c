@@ -0,0 +1,151 @@
+/*
+ * test_ubx.c
+ */
+
+#include "ubx.h"
+
+#include <string.h>
+
+#include "test.h"
+
+/**
+ * @brief Writes a little-endian 32-bit value
+ * @param[out] buf: Where to write
+ * @param[in] val: Value to write
+ */
+static void write_u32(uint8_t* buf, uint32_t val) {
+	for (int i = 0; i < 4; i++) {
+		buf[i] = (uint8_t) (val >> (8 * i));
+	}
+}
+
+/**
+ * @brief Builds a NAV-PVT frame with known fields
+ * @param[out] frame: Buffer for frame
+ * @param[in] frame_size: Size of buffer
+ * @return Frame length
+ */
+static uint16_t build_nav_pvt(uint8_t* frame, uint16_t frame_size) {
+	uint8_t payload[UBX_NAV_PVT_PAYLOAD_LEN] = {0};
+	write_u32(&payload[0], 123456000);
+	payload[20] = UBX_FIX_3D;
+	payload[21] = UBX_NAV_PVT_FLAGS_GNSS_FIX_OK;
+	payload[23] = 11;
+	write_u32(&payload[24], (uint32_t) -710912345);
+	write_u32(&payload[28], 423601234);
+	write_u32(&payload[32], 45678);
+	write_u32(&payload[40], 1500);
+	write_u32(&payload[48], (uint32_t) -250);
+	write_u32(&payload[64], 9000000);
+	return ubx_build_frame(frame, frame_size, UBX_CLASS_NAV, UBX_ID_NAV_PVT, payload, sizeof(payload));
+}
+
+static void test_build() {
+	// Frame bytes as documented for CFG-RATE at 10 Hz, checksum included
+	const uint8_t expected[] = {0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0x64, 0x00, 0x01, 0x00, 0x01, 0x00, 0x7A, 0x12};
+	uint8_t frame[64];
+	uint16_t len = ubx_build_cfg_rate(frame, sizeof(frame), 100);
+	TEST_CHECK(len == sizeof(expected));
+	TEST_CHECK(memcmp(frame, expected, sizeof(expected)) == 0);
+
+	TEST_CHECK(ubx_build_cfg_prt_uart(frame, sizeof(frame), 230400) == UBX_FRAME_OVERHEAD + UBX_CFG_PRT_PAYLOAD_LEN);
+	TEST_CHECK(ubx_build_cfg_msg(frame, sizeof(frame), UBX_CLASS_NAV, UBX_ID_NAV_PVT, 1) == UBX_FRAME_OVERHEAD + UBX_CFG_MSG_PAYLOAD_LEN);
+	TEST_CHECK(ubx_build_cfg_rate(frame, UBX_FRAME_OVERHEAD + UBX_CFG_RATE_PAYLOAD_LEN - 1, 100) == 0);
+}
+
+static void test_parse_nav_pvt() {
+	uint8_t frame[128];
+	uint16_t len = build_nav_pvt(frame, sizeof(frame));
+	TEST_CHECK(len == UBX_FRAME_OVERHEAD + UBX_NAV_PVT_PAYLOAD_LEN);
+
+	// Byte by byte, the frame only completes on its last byte
+	ubx_parser_t parser;
+	ubx_parser_init(&parser);
+	int num_done = 0;
+	for (uint16_t i = 0; i < len; i++) {
+		if (ubx_parser_feed(&parser, frame[i])) {
+			num_done++;
+			TEST_CHECK(i == len - 1);
+		}
+	}
+	TEST_CHECK(num_done == 1);
+
+	ubx_nav_pvt_t pvt;
+	TEST_CHECK(ubx_decode_nav_pvt(&parser, &pvt));
+	TEST_CHECK(pvt.itow_ms == 123456000);
+	TEST_CHECK(pvt.fix_type == UBX_FIX_3D);
+	TEST_CHECK(pvt.flags == UBX_NAV_PVT_FLAGS_GNSS_FIX_OK);
+	TEST_CHECK(pvt.num_satellites == 11);
+	TEST_CHECK(pvt.lon_e7 == -710912345);
+	TEST_CHECK(pvt.lat_e7 == 423601234);
+	TEST_CHECK(pvt.height_mm == 45678);
+	TEST_CHECK(pvt.h_acc_mm == 1500);
+	TEST_CHECK(pvt.vel_n_mm_s == -250);
+	TEST_CHECK(pvt.head_motion_e5 == 9000000);
+}
+
+static void test_parse_runs() {
+	// Noise, two frames back to back, then a frame with a bad checksum. Runs stop after each completed frame
+	uint8_t stream[512];
+	uint16_t len = 0;
+	stream[len++] = 0x00;
+	stream[len++] = UBX_SYNC_CHAR_1;
+	stream[len++] = 0x13;
+	len += build_nav_pvt(&stream[len], sizeof(stream) - len);
+	len += ubx_build_cfg_rate(&stream[len], sizeof(stream) - len, 200);
+	uint16_t bad_start = len;
+	len += build_nav_pvt(&stream[len], sizeof(stream) - len);
+	stream[bad_start + 30] ^= 0xFF;
+
+	ubx_parser_t parser;
+	ubx_parser_init(&parser);
+	int num_pvt = 0;
+	int num_rate = 0;
+	uint16_t offset = 0;
+	while (offset < len) {
+		bool frame_done = false;
+		uint16_t consumed = ubx_parser_feed_bytes(&parser, &stream[offset], len - offset, &frame_done);
+		TEST_CHECK(consumed > 0);
+		offset += consumed;
+		if (frame_done) {
+			ubx_nav_pvt_t pvt;
+			if (ubx_decode_nav_pvt(&parser, &pvt)) {
+				num_pvt++;
+				TEST_CHECK(pvt.lat_e7 == 423601234);
+			} else if (parser.msg_class == UBX_CLASS_CFG && parser.msg_id == UBX_ID_CFG_RATE) {
+				num_rate++;
+				TEST_CHECK(parser.payload[0] == 200);
+			}
+		}
+	}
+	TEST_CHECK(num_pvt == 1);
+	TEST_CHECK(num_rate == 1);
+	TEST_CHECK(parser.num_checksum_errors == 1);
+}
+
+static void test_parse_too_long() {
+	// A frame longer than the parser keeps is skipped, and the next one still parses
+	uint8_t payload[UBX_MAX_PAYLOAD + 20] = {0};
+	uint8_t stream[512];
+	uint16_t len = ubx_build_frame(stream, sizeof(stream), UBX_CLASS_NAV, 0x35, payload, sizeof(payload));
+	len += build_nav_pvt(&stream[len], sizeof(stream) - len);
+
+	ubx_parser_t parser;
+	ubx_parser_init(&parser);
+	int num_pvt = 0;
+	for (uint16_t i = 0; i < len; i++) {
+		ubx_nav_pvt_t pvt;
+		if (ubx_parser_feed(&parser, stream[i]) && ubx_decode_nav_pvt(&parser, &pvt)) {
+			num_pvt++;
+		}
+	}
+	TEST_CHECK(num_pvt == 1);
+}
+
+int main() {
+	test_build();
+	test_parse_nav_pvt();
+	test_parse_runs();
+	test_parse_too_long();
+	return test_result("ubx");
+}
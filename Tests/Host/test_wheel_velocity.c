@@ -0,0 +1,126 @@
+/*
+ * test_wheel_velocity.c
+ */
+
+#include "wheel_velocity.h"
+
+#include "test.h"
+
+#define CLOCK_HZ		96000000u // Capture timer rate on the robot
+#define TICKS_PER_EDGE	4
+#define UPDATE_S		0.0005 // Odometry update period on the robot (2 kHz)
+
+/**
+ * @brief Deterministic edge placement error, up to +/-0.2 tick
+ * @param[in] tick: Encoder count of the edge
+ * @return Error in ticks
+ */
+static double edge_error(int64_t tick) {
+	uint32_t x = (uint32_t) tick * 2654435761u;
+	x ^= x >> 13;
+	x *= 0x5bd1e995u;
+	x ^= x >> 15;
+	return ((x & 0xFFFF) / 65535.0 - 0.5) * 0.4;
+}
+
+/**
+ * @brief Drives a wheel at a steady speed and compares the estimate with it once settled
+ * @param[in] ticks_per_s: True speed
+ * @param[in] edge_error_ticks: Scale of edge placement error, 0 for evenly spaced edges
+ * @param[in] start_time: Capture timer value at the start, to test wrap around
+ * @param[out] rms_error: Root mean square error, relative to the speed
+ * @return Largest error, relative to the speed
+ */
+static double run_steady(double ticks_per_s, double edge_error_ticks, uint32_t start_time, double* rms_error) {
+	wheel_velocity_t wv;
+	wheel_velocity_init(&wv, CLOCK_HZ, TICKS_PER_EDGE);
+	double sum_sq = 0;
+	double max_error = 0;
+	int num = 0;
+	const double offset_ticks = 0.37;
+	for (int k = 0; k < 20000; k++) {
+		double t = k * UPDATE_S;
+		double pos = offset_ticks + fabs(ticks_per_s) * t;
+
+		// Newest captured edge is every TICKS_PER_EDGE ticks, placed with some error
+		int64_t edge_tick = TICKS_PER_EDGE * (int64_t) floor(pos / TICKS_PER_EDGE);
+		if (edge_tick + edge_error_ticks * edge_error(edge_tick) > pos) {
+			edge_tick -= TICKS_PER_EDGE;
+		}
+		double edge_t = (edge_tick + edge_error_ticks * edge_error(edge_tick) - offset_ticks) / fabs(ticks_per_s);
+		if (edge_t < 0) {
+			edge_t = 0;
+			edge_tick = 0;
+		}
+		uint32_t edge_time = start_time + (uint32_t) llround(edge_t * CLOCK_HZ);
+		uint32_t now_time = start_time + (uint32_t) llround(t * CLOCK_HZ);
+		int64_t signed_tick = ticks_per_s < 0 ? -edge_tick : edge_tick;
+
+		double estimate = wheel_velocity_update(&wv, edge_time, signed_tick, now_time);
+		if (t > 1) {
+			double error = (estimate - ticks_per_s) / fabs(ticks_per_s);
+			sum_sq += error * error;
+			max_error = fabs(error) > max_error ? fabs(error) : max_error;
+			num++;
+		}
+	}
+	*rms_error = sqrt(sum_sq / num);
+	return max_error;
+}
+
+static void test_steady() {
+	// Evenly spaced edges give the speed exactly, forward, backward, and across the capture timer wrapping
+	double rms;
+	TEST_CHECK(run_steady(5000, 0, 0, &rms) < 1e-6);
+	TEST_CHECK(run_steady(-5000, 0, 0, &rms) < 1e-6);
+	TEST_CHECK(run_steady(5000, 0, 0xFFFFFFFFu - CLOCK_HZ, &rms) < 1e-6);
+
+	// With +/-0.2 tick of edge placement error, at 0.01 to 1 m/s on the robot's wheels (8192 ticks per 0.05 m radius turn)
+	const double speeds_mps[] = {0.01, 0.05, 0.2, 1.0};
+	const double max_errors[] = {0.12, 0.04, 0.01, 0.002};
+	const double ticks_per_m = 8192 / (2 * 3.14159265358979 * 0.05);
+	for (int i = 0; i < 4; i++) {
+		double max_error = run_steady(speeds_mps[i] * ticks_per_m, 1, 12345, &rms);
+		printf("wheel_velocity: %.2f m/s, error %.2f%% rms, %.2f%% max\n", speeds_mps[i], rms * 100, max_error * 100);
+		TEST_CHECK(max_error < max_errors[i]);
+	}
+}
+
+static void test_stop() {
+	// A wheel turning at 1000 ticks per second stops dead
+	wheel_velocity_t wv;
+	wheel_velocity_init(&wv, CLOCK_HZ, TICKS_PER_EDGE);
+	uint32_t edge_time = 0;
+	int64_t edge_tick = 0;
+	double estimate = 0;
+	for (int k = 0; k <= 200; k++) {
+		uint32_t now_time = (uint32_t) (k * UPDATE_S * CLOCK_HZ);
+		while ((edge_tick + TICKS_PER_EDGE) / 1000.0 * CLOCK_HZ <= now_time) {
+			edge_tick += TICKS_PER_EDGE;
+			edge_time = (uint32_t) (edge_tick / 1000.0 * CLOCK_HZ);
+		}
+		estimate = wheel_velocity_update(&wv, edge_time, edge_tick, now_time);
+	}
+	TEST_CHECK_NEAR(estimate, 1000, 1);
+
+	// No more edges: the estimate is held under 1.5 edges over the time since the last, then zeroed
+	uint32_t last_edge_time = edge_time;
+	double stop_s = 0;
+	for (int k = 1; k < 400; k++) {
+		uint32_t now_time = last_edge_time + (uint32_t) (k * UPDATE_S * CLOCK_HZ);
+		estimate = wheel_velocity_update(&wv, edge_time, edge_tick, now_time);
+		double since_s = (double) (now_time - last_edge_time) / CLOCK_HZ;
+		TEST_CHECK(estimate <= WHEEL_VELOCITY_DECAY_EDGES * TICKS_PER_EDGE / since_s + 1e-9);
+		if (estimate == 0 && stop_s == 0) {
+			stop_s = since_s;
+		}
+	}
+	TEST_CHECK_NEAR(stop_s, WHEEL_VELOCITY_STOP_S, UPDATE_S);
+	TEST_CHECK(estimate == 0);
+}
+
+int main() {
+	test_steady();
+	test_stop();
+	return test_result("wheel_velocity");
+}